@@ -1,14 +1,81 @@
+import { memo, useState } from 'react'
+
 interface JsonPanelProps {
   title?: string
   data: unknown
   defaultOpen?: boolean
 }
 
+interface JsonNodeProps {
+  name: string
+  value: unknown
+  defaultOpen?: boolean
+}
+
+// Children of a large object or array are shown a page at a time
+const CHILD_PAGE = 100
+
+function isContainer(value: unknown): value is Record<string, unknown> | unknown[] {
+  return typeof value === 'object' && value !== null
+}
+
+function JsonLeaf({ name, value }: { name: string; value: unknown }) {
+  const kind = value === null ? 'null' : typeof value
+  return (
+    <div className="json-leaf">
+      {name ? <span className="json-key">{name}: </span> : null}
+      <span className={`json-${kind}`}>{JSON.stringify(value) ?? String(value)}</span>
+    </div>
+  )
+}
+
+// One object or array; its children are built only once it is expanded.
+// Memoized so that a refresh sharing unchanged subtrees skips them.
+const JsonNode = memo(function JsonNode({ name, value, defaultOpen = false }: JsonNodeProps) {
+  const [open, setOpen] = useState(defaultOpen)
+  const [shown, setShown] = useState(CHILD_PAGE)
+
+  if (!isContainer(value)) {
+    return <JsonLeaf name={name} value={value} />
+  }
+
+  const isArray = Array.isArray(value)
+  const size = isArray ? value.length : Object.keys(value).length
+  const entries: Array<[string, unknown]> = open
+    ? isArray
+      ? value.slice(0, shown).map((item, index) => [String(index), item])
+      : Object.entries(value).slice(0, shown)
+    : []
+
+  return (
+    <details className="json-node" open={open} onToggle={(event) => setOpen(event.currentTarget.open)}>
+      <summary>
+        {name ? <span className="json-key">{name}: </span> : null}
+        <span className="muted">{isArray ? `[${size} items]` : `{${size} keys}`}</span>
+      </summary>
+      {entries.map(([key, item]) => (
+        <JsonNode key={key} name={key} value={item} />
+      ))}
+      {open && size > shown ? (
+        <button className="button-secondary json-more" type="button" onClick={() => setShown((count) => count + CHILD_PAGE)}>
+          Show {Math.min(CHILD_PAGE, size - shown)} more of {size - shown}
+        </button>
+      ) : null}
+    </details>
+  )
+})
+
 function JsonPanel({ title = 'Raw JSON', data, defaultOpen = false }: JsonPanelProps) {
+  const [open, setOpen] = useState(defaultOpen)
+
   return (
-    <details className="raw-json" open={defaultOpen}>
+    <details className="raw-json" open={open} onToggle={(event) => setOpen(event.currentTarget.open)}>
       <summary>{title}</summary>
-      <pre>{JSON.stringify(data, null, 2)}</pre>
+      {open ? (
+        <div className="json-tree">
+          <JsonNode name="" value={data} defaultOpen />
+        </div>
+      ) : null}
     </details>
   )
 }
@@ -1,3 +1,4 @@
+import { memo, useMemo } from 'react'
 import type { RedfishResource } from '../types/redfish'
 import { pickPrimitiveFields } from '../utils/redfish'
 
@@ -6,8 +7,9 @@ interface ResourceTableProps {
   emptyLabel?: string
 }
 
+// Memoized: pages keep unchanged resources identical across refreshes
 function ResourceTable({ resource, emptyLabel = 'No primitive properties to display.' }: ResourceTableProps) {
-  const rows = pickPrimitiveFields(resource)
+  const rows = useMemo(() => pickPrimitiveFields(resource), [resource])
 
   if (rows.length === 0) {
     return <p className="muted">{emptyLabel}</p>
@@ -29,4 +31,4 @@ function ResourceTable({ resource, emptyLabel = 'No primitive properties to disp
   )
 }
 
-export default ResourceTable
+export default memo(ResourceTable)
@@ -0,0 +1,170 @@
+import { useCallback, useMemo, useState } from 'react'
+import { useAutoRefresh, useClient, useRedfishEvents } from '../state/ClientContext'
+import type { RedfishEvent, SensorHistory, SensorHistoryResolution } from '../types/redfish'
+import { eventOriginPaths, formatIsoDate, normalizeRedfishPath, shareUnchanged } from '../utils/redfish'
+
+interface SensorHistoryPanelProps {
+  sensorPath: string
+}
+
+const RESOLUTIONS: Array<{ value: SensorHistoryResolution; label: string }> = [
+  { value: 'raw', label: 'Samples' },
+  { value: '1min', label: 'Per minute' },
+  { value: '1h', label: 'Per hour' },
+]
+
+const CHART_WIDTH = 480
+const CHART_HEIGHT = 96
+
+interface ChartScale {
+  t0: number
+  t1: number
+  lo: number
+  hi: number
+}
+
+// SVG polylines for one series; a null value (no valid reading) breaks the line.
+// Raw samples hold until the next one, so they are drawn as steps.
+function toPolylines(timestamps: number[], values: Array<number | null>, scale: ChartScale, steps: boolean): string[] {
+  const x = (t: number) => (scale.t1 > scale.t0 ? ((t - scale.t0) / (scale.t1 - scale.t0)) * CHART_WIDTH : CHART_WIDTH / 2)
+  const y = (v: number) =>
+    scale.hi > scale.lo ? CHART_HEIGHT - ((v - scale.lo) / (scale.hi - scale.lo)) * CHART_HEIGHT : CHART_HEIGHT / 2
+
+  const lines: string[] = []
+  let current: string[] = []
+  let previous: number | null = null
+
+  timestamps.forEach((t, index) => {
+    const value = values[index] ?? null
+    if (value === null) {
+      if (current.length > 0) {
+        lines.push(current.join(' '))
+      }
+      current = []
+      previous = null
+      return
+    }
+
+    if (steps && previous !== null) {
+      current.push(`${x(t).toFixed(1)},${y(previous).toFixed(1)}`)
+    }
+    current.push(`${x(t).toFixed(1)},${y(value).toFixed(1)}`)
+    previous = value
+  })
+
+  if (current.length > 0) {
+    lines.push(current.join(' '))
+  }
+  return lines
+}
+
+function SensorHistoryPanel({ sensorPath }: SensorHistoryPanelProps) {
+  const { client } = useClient()
+  const [resolution, setResolution] = useState<SensorHistoryResolution>('raw')
+  const [history, setHistory] = useState<SensorHistory | null>(null)
+  const [error, setError] = useState<string | null>(null)
+
+  const refresh = useCallback(async () => {
+    try {
+      const next = await client.getSensorHistory(sensorPath, resolution)
+      setHistory((current) => shareUnchanged(current, next ?? null))
+      setError(null)
+    } catch (historyError) {
+      setError(historyError instanceof Error ? historyError.message : 'Unable to load reading history.')
+    }
+  }, [client, sensorPath, resolution])
+
+  const handleEvent = useCallback(
+    (event: RedfishEvent) => {
+      if (eventOriginPaths([event]).includes(normalizeRedfishPath(sensorPath))) {
+        void refresh()
+      }
+    },
+    [sensorPath, refresh],
+  )
+
+  useRedfishEvents(handleEvent)
+  useAutoRefresh(refresh, 5000)
+
+  const chart = useMemo(() => {
+    if (!history || history.Timestamps.length === 0) {
+      return null
+    }
+
+    // Raw: one series; rollups: min and max bounds around the average
+    const series: Array<Array<number | null>> =
+      history.Resolution === 'raw' ? [history.Values ?? []] : [history.Min ?? [], history.Max ?? [], history.Avg ?? []]
+    const numbers = series.flat().filter((value): value is number => typeof value === 'number')
+    if (numbers.length === 0) {
+      return null
+    }
+
+    const scale: ChartScale = {
+      t0: history.Timestamps[0],
+      t1: history.Timestamps[history.Timestamps.length - 1],
+      lo: Math.min(...numbers),
+      hi: Math.max(...numbers),
+    }
+    const steps = history.Resolution === 'raw'
+
+    return {
+      scale,
+      lines: series.map((values) => toPolylines(history.Timestamps, values, scale, steps)),
+      latest: series[series.length - 1].at(-1) ?? null,
+      points: history.Timestamps.length,
+    }
+  }, [history])
+
+  return (
+    <div className="sensor-history">
+      <div className="inline-meta">
+        <h3>Reading History</h3>
+        {RESOLUTIONS.map((option) => (
+          <button
+            key={option.value}
+            type="button"
+            className={resolution === option.value ? 'endpoint-button' : 'button-secondary'}
+            onClick={() => setResolution(option.value)}
+          >
+            {option.label}
+          </button>
+        ))}
+      </div>
+
+      {error ? <p className="error-banner">{error}</p> : null}
+      {!error && !chart ? <p className="muted">No readings recorded for this sensor yet.</p> : null}
+
+      {chart ? (
+        <>
+          <svg
+            className="history-chart"
+            viewBox={`0 0 ${CHART_WIDTH} ${CHART_HEIGHT}`}
+            preserveAspectRatio="none"
+            role="img"
+            aria-label="Reading history"
+          >
+            {chart.lines.map((lines, seriesIndex) =>
+              lines.map((points, lineIndex) => (
+                <polyline
+                  key={`${seriesIndex}-${lineIndex}`}
+                  className={chart.lines.length > 1 && seriesIndex < 2 ? 'history-bound' : 'history-line'}
+                  points={points}
+                />
+              )),
+            )}
+          </svg>
+          <div className="inline-meta">
+            <p>Latest: {chart.latest ?? 'N/A'}</p>
+            <p>
+              Range: {chart.scale.lo} to {chart.scale.hi}
+            </p>
+            <p>Points: {chart.points}</p>
+            <p>Since: {formatIsoDate(new Date(chart.scale.t0 * 1000).toISOString())}</p>
+          </div>
+        </>
+      ) : null}
+    </div>
+  )
+}
+
+export default SensorHistoryPanel
@@ -0,0 +1,96 @@
+import { Fragment, useEffect, useRef, useState } from 'react'
+
+interface WindowedGridProps<T> {
+  items: T[]
+  itemKey: (item: T) => string
+  renderItem: (item: T) => React.ReactNode
+  // Cards are laid out at this fixed height once the grid is windowed
+  rowHeight?: number
+  minColumnWidth?: number
+  gap?: number
+  viewportHeight?: number
+  // Shorter lists render as a plain card grid
+  windowAfter?: number
+}
+
+const OVERSCAN_ROWS = 2
+
+// A .card-grid that, past `windowAfter` items, scrolls inside a fixed-height
+// viewport and mounts only the rows in view, so a fleet of thousands of
+// resources costs a screenful of DOM nodes.
+function WindowedGrid<T>({
+  items,
+  itemKey,
+  renderItem,
+  rowHeight = 212,
+  minColumnWidth = 220,
+  gap = 12,
+  viewportHeight = 640,
+  windowAfter = 60,
+}: WindowedGridProps<T>) {
+  const viewport = useRef<HTMLDivElement>(null)
+  const [width, setWidth] = useState(0)
+  const [scrollTop, setScrollTop] = useState(0)
+  const windowed = items.length > windowAfter
+
+  useEffect(() => {
+    const element = viewport.current
+    if (!windowed || !element) {
+      return undefined
+    }
+
+    const measure = () => setWidth(element.clientWidth)
+    measure()
+    if (typeof ResizeObserver === 'undefined') {
+      return undefined
+    }
+
+    const observer = new ResizeObserver(measure)
+    observer.observe(element)
+    return () => observer.disconnect()
+  }, [windowed])
+
+  if (!windowed) {
+    return (
+      <div className="card-grid">
+        {items.map((item) => (
+          <Fragment key={itemKey(item)}>{renderItem(item)}</Fragment>
+        ))}
+      </div>
+    )
+  }
+
+  // Same column rule as the grid's repeat(auto-fit, minmax(220px, 1fr))
+  const columns = Math.max(1, Math.floor((width + gap) / (minColumnWidth + gap)))
+  const stride = rowHeight + gap
+  const rowCount = Math.ceil(items.length / columns)
+  const firstRow = Math.max(0, Math.floor(scrollTop / stride) - OVERSCAN_ROWS)
+  const lastRow = Math.min(rowCount, Math.ceil((scrollTop + viewportHeight) / stride) + OVERSCAN_ROWS)
+  const visible = items.slice(firstRow * columns, lastRow * columns)
+
+  return (
+    <div
+      ref={viewport}
+      className="windowed-viewport"
+      style={{ maxHeight: viewportHeight }}
+      onScroll={(event) => setScrollTop(event.currentTarget.scrollTop)}
+    >
+      <div style={{ height: rowCount * stride - gap }}>
+        <div
+          className="card-grid windowed-rows"
+          style={{
+            gridTemplateColumns: `repeat(${columns}, minmax(0, 1fr))`,
+            gridAutoRows: rowHeight,
+            transform: `translateY(${firstRow * stride}px)`,
+          }}
+        >
+          {visible.map((item) => (
+            <Fragment key={itemKey(item)}>{renderItem(item)}</Fragment>
+          ))}
+        </div>
+      </div>
+    </div>
+  )
+}
+
+export default WindowedGrid
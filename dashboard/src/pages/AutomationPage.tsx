@@ -1,15 +1,19 @@
-import { useCallback, useEffect, useMemo, useState } from 'react'
+import { memo, useCallback, useEffect, useMemo, useState } from 'react'
 import JsonPanel from '../components/JsonPanel'
 import ResourceTable from '../components/ResourceTable'
 import StatusPill from '../components/StatusPill'
 import SupportedActions from '../components/SupportedActions'
-import { useClient } from '../state/ClientContext'
-import type { RedfishResource } from '../types/redfish'
+import WindowedGrid from '../components/WindowedGrid'
+import { useAutoRefresh, useClient, useRedfishEvents } from '../state/ClientContext'
+import type { RedfishEvent, RedfishResource } from '../types/redfish'
 import {
+  collectionChanges,
+  eventOriginPaths,
   formatIsoDate,
   getStatusTone,
   isODataLink,
   resourceDisplayName,
+  shareUnchanged,
   toODataPath,
 } from '../utils/redfish'
 
@@ -63,6 +67,32 @@ function toNodeSummary(resource: RedfishResource): AutomationNodeSummary {
   }
 }
 
+interface NodeCardProps {
+  node: AutomationNodeSummary
+  selected: boolean
+  onSelect: (uri: string) => void
+}
+
+const NodeCard = memo(function NodeCard({ node, selected, onSelect }: NodeCardProps) {
+  return (
+    <button
+      type="button"
+      className={`resource-card selectable ${selected ? 'selected' : ''}`}
+      onClick={() => onSelect(node.uri)}
+    >
+      <div className="card-head">
+        <h4>{node.name}</h4>
+        <StatusPill tone={getStatusTone({ State: node.statusState, Health: node.health })} label={node.statusState} />
+      </div>
+      <p>Health: {node.health}</p>
+      <p>NodeState: {node.nodeState}</p>
+      <p>NodeType: {node.nodeType}</p>
+      <p>Actions: {node.actionsCount}</p>
+      <p className="resource-path">{node.uri}</p>
+    </button>
+  )
+})
+
 function AutomationPage() {
   const { client } = useClient()
 
@@ -70,8 +100,10 @@ function AutomationPage() {
   const [error, setError] = useState<string | null>(null)
   const [root, setRoot] = useState<RedfishResource | null>(null)
   const [nodes, setNodes] = useState<AutomationNodeSummary[]>([])
+  const [collectionPath, setCollectionPath] = useState<string>('')
   const [selectedNodeUri, setSelectedNodeUri] = useState<string>('')
   const [instrumentation, setInstrumentation] = useState<RedfishResource | null>(null)
+  const [instrumentationVersion, setInstrumentationVersion] = useState(0)
   const [lastUpdated, setLastUpdated] = useState<string | null>(null)
 
   const refresh = useCallback(async () => {
@@ -79,16 +111,18 @@ function AutomationPage() {
       setError(null)
 
       const nextRoot = await client.getServiceRoot()
-      const collectionPath = toODataPath(nextRoot.AutomationNodes)
-      if (!collectionPath) {
+      const nextCollectionPath = toODataPath(nextRoot.AutomationNodes)
+      if (!nextCollectionPath) {
         throw new Error('Service root did not provide an AutomationNodes collection link.')
       }
 
-      const memberResources = await client.getCollectionMembers(collectionPath)
+      const memberResources = await client.getCollectionMembers(nextCollectionPath)
       const nextNodes = memberResources.map(toNodeSummary)
 
-      setRoot(nextRoot)
-      setNodes(nextNodes)
+      // Unchanged nodes keep their objects, so their cards do not re-render
+      setRoot((current) => shareUnchanged(current, nextRoot))
+      setCollectionPath(nextCollectionPath)
+      setNodes((current) => shareUnchanged(current, nextNodes))
       setSelectedNodeUri((current) => {
         if (current.length > 0 && nextNodes.some((node) => node.uri === current)) {
           return current
@@ -104,21 +138,56 @@ function AutomationPage() {
     }
   }, [client])
 
-  useEffect(() => {
-    void refresh()
-
-    const intervalId = window.setInterval(() => {
-      void refresh()
-    }, 5000)
-
-    return () => window.clearInterval(intervalId)
-  }, [refresh])
+  const refreshMembers = useCallback(
+    async (paths: string[]) => {
+      try {
+        const resources = await Promise.all(paths.map((path) => client.getResource(path)))
+        const updated = new Map(resources.map(toNodeSummary).map((node) => [node.uri, node]))
+        setNodes((current) => shareUnchanged(current, current.map((node) => updated.get(node.uri) ?? node)))
+        setLastUpdated(new Date().toISOString())
+      } catch {
+        void refresh()
+      }
+    },
+    [client, refresh],
+  )
 
   const selectedNode = useMemo(
     () => nodes.find((node) => node.uri === selectedNodeUri) ?? null,
     [nodes, selectedNodeUri],
   )
 
+  const handleEvent = useCallback(
+    (event: RedfishEvent) => {
+      if (!collectionPath) {
+        return
+      }
+
+      const changedPaths = eventOriginPaths([event])
+      const changes = collectionChanges(
+        changedPaths,
+        collectionPath,
+        nodes.map((node) => node.uri),
+      )
+      if (changes.reloadAll) {
+        void refresh()
+      } else if (changes.members.length > 0) {
+        void refreshMembers(changes.members)
+      }
+
+      const instrumentationPath = selectedNode?.instrumentationPath
+      if (instrumentationPath && changedPaths.includes(instrumentationPath)) {
+        setInstrumentationVersion((version) => version + 1)
+      }
+    },
+    [collectionPath, nodes, selectedNode?.instrumentationPath, refresh, refreshMembers],
+  )
+
+  const eventsLive = useRedfishEvents(handleEvent)
+
+  // Also re-reads everything when the event stream (re)connects
+  useAutoRefresh(refresh, 5000)
+
   useEffect(() => {
     let active = true
 
@@ -133,7 +202,7 @@ function AutomationPage() {
       .getResource(selectedNode.instrumentationPath)
       .then((resource) => {
         if (active) {
-          setInstrumentation(resource)
+          setInstrumentation((current) => shareUnchanged(current, resource))
         }
       })
       .catch(() => {
@@ -145,7 +214,7 @@ function AutomationPage() {
     return () => {
       active = false
     }
-  }, [client, selectedNode?.instrumentationPath])
+  }, [client, selectedNode?.instrumentationPath, instrumentationVersion])
 
   return (
     <section>
@@ -157,7 +226,7 @@ function AutomationPage() {
       </header>
 
       <div className="panel inline-meta">
-        <p>Auto-refresh: every 5 seconds</p>
+        <p>{eventsLive ? 'Live updates: EventService stream' : 'Auto-refresh: every 5 seconds'}</p>
         <p>Last updated: {formatIsoDate(lastUpdated ?? undefined)}</p>
         <button className="button-secondary" type="button" onClick={() => void refresh()}>
           Refresh Now
@@ -170,26 +239,13 @@ function AutomationPage() {
       <div className="panel">
         <h3>Automation Nodes</h3>
         {nodes.length === 0 ? <p className="muted">No automation nodes were discovered.</p> : null}
-        <div className="card-grid">
-          {nodes.map((node) => (
-            <button
-              key={node.uri}
-              type="button"
-              className={`resource-card selectable ${selectedNodeUri === node.uri ? 'selected' : ''}`}
-              onClick={() => setSelectedNodeUri(node.uri)}
-            >
-              <div className="card-head">
-                <h4>{node.name}</h4>
-                <StatusPill tone={getStatusTone({ State: node.statusState, Health: node.health })} label={node.statusState} />
-              </div>
-              <p>Health: {node.health}</p>
-              <p>NodeState: {node.nodeState}</p>
-              <p>NodeType: {node.nodeType}</p>
-              <p>Actions: {node.actionsCount}</p>
-              <p className="resource-path">{node.uri}</p>
-            </button>
-          ))}
-        </div>
+        <WindowedGrid
+          items={nodes}
+          itemKey={(node) => node.uri}
+          renderItem={(node) => (
+            <NodeCard node={node} selected={selectedNodeUri === node.uri} onSelect={setSelectedNodeUri} />
+          )}
+        />
       </div>
 
       {selectedNode ? (
@@ -1,11 +1,20 @@
-import { useCallback, useEffect, useMemo, useState } from 'react'
+import { memo, useCallback, useMemo, useState } from 'react'
 import JsonPanel from '../components/JsonPanel'
 import ResourceTable from '../components/ResourceTable'
 import StatusPill from '../components/StatusPill'
 import SupportedActions from '../components/SupportedActions'
-import { useClient } from '../state/ClientContext'
-import type { RedfishResource } from '../types/redfish'
-import { formatIsoDate, getStatusTone, resourceDisplayName, toODataPath } from '../utils/redfish'
+import WindowedGrid from '../components/WindowedGrid'
+import { useAutoRefresh, useClient, useRedfishEvents } from '../state/ClientContext'
+import type { RedfishEvent, RedfishResource } from '../types/redfish'
+import {
+  collectionChanges,
+  eventOriginPaths,
+  formatIsoDate,
+  getStatusTone,
+  resourceDisplayName,
+  shareUnchanged,
+  toODataPath,
+} from '../utils/redfish'
 
 interface ChassisSummary {
   id: string
@@ -49,6 +58,32 @@ function toChassisSummary(resource: RedfishResource): ChassisSummary {
   }
 }
 
+interface ChassisCardProps {
+  item: ChassisSummary
+  selected: boolean
+  onSelect: (uri: string) => void
+}
+
+const ChassisCard = memo(function ChassisCard({ item, selected, onSelect }: ChassisCardProps) {
+  return (
+    <button
+      type="button"
+      className={`resource-card selectable ${selected ? 'selected' : ''}`}
+      onClick={() => onSelect(item.uri)}
+    >
+      <div className="card-head">
+        <h4>{item.name}</h4>
+        <StatusPill tone={getStatusTone({ State: item.state, Health: item.health })} label={item.state} />
+      </div>
+      <p>Health: {item.health}</p>
+      <p>Type: {item.chassisType}</p>
+      <p>Power: {item.powerState}</p>
+      <p>Actions: {item.actionsCount}</p>
+      <p className="resource-path">{item.uri}</p>
+    </button>
+  )
+})
+
 function ChassisPage() {
   const { client } = useClient()
 
@@ -56,6 +91,7 @@ function ChassisPage() {
   const [error, setError] = useState<string | null>(null)
   const [root, setRoot] = useState<RedfishResource | null>(null)
   const [chassis, setChassis] = useState<ChassisSummary[]>([])
+  const [collectionPath, setCollectionPath] = useState<string>('')
   const [selectedChassisUri, setSelectedChassisUri] = useState<string>('')
   const [lastUpdated, setLastUpdated] = useState<string | null>(null)
 
@@ -64,16 +100,18 @@ function ChassisPage() {
       setError(null)
 
       const nextRoot = await client.getServiceRoot()
-      const collectionPath = toODataPath(nextRoot.Chassis)
-      if (!collectionPath) {
+      const nextCollectionPath = toODataPath(nextRoot.Chassis)
+      if (!nextCollectionPath) {
         throw new Error('Service root did not provide a Chassis collection link.')
       }
 
-      const memberResources = await client.getCollectionMembers(collectionPath)
+      const memberResources = await client.getCollectionMembers(nextCollectionPath)
       const nextChassis = memberResources.map(toChassisSummary)
 
-      setRoot(nextRoot)
-      setChassis(nextChassis)
+      // Unchanged chassis keep their objects, so their cards do not re-render
+      setRoot((current) => shareUnchanged(current, nextRoot))
+      setCollectionPath(nextCollectionPath)
+      setChassis((current) => shareUnchanged(current, nextChassis))
       setSelectedChassisUri((current) => {
         if (current.length > 0 && nextChassis.some((item) => item.uri === current)) {
           return current
@@ -89,15 +127,44 @@ function ChassisPage() {
     }
   }, [client])
 
-  useEffect(() => {
-    void refresh()
+  const refreshMembers = useCallback(
+    async (paths: string[]) => {
+      try {
+        const resources = await Promise.all(paths.map((path) => client.getResource(path)))
+        const updated = new Map(resources.map(toChassisSummary).map((item) => [item.uri, item]))
+        setChassis((current) => shareUnchanged(current, current.map((item) => updated.get(item.uri) ?? item)))
+        setLastUpdated(new Date().toISOString())
+      } catch {
+        void refresh()
+      }
+    },
+    [client, refresh],
+  )
+
+  const handleEvent = useCallback(
+    (event: RedfishEvent) => {
+      if (!collectionPath) {
+        return
+      }
+
+      const changes = collectionChanges(
+        eventOriginPaths([event]),
+        collectionPath,
+        chassis.map((item) => item.uri),
+      )
+      if (changes.reloadAll) {
+        void refresh()
+      } else if (changes.members.length > 0) {
+        void refreshMembers(changes.members)
+      }
+    },
+    [collectionPath, chassis, refresh, refreshMembers],
+  )
 
-    const intervalId = window.setInterval(() => {
-      void refresh()
-    }, 5000)
+  const eventsLive = useRedfishEvents(handleEvent)
 
-    return () => window.clearInterval(intervalId)
-  }, [refresh])
+  // Also re-reads everything when the event stream (re)connects
+  useAutoRefresh(refresh, 5000)
 
   const selectedChassis = useMemo(
     () => chassis.find((item) => item.uri === selectedChassisUri) ?? null,
@@ -114,7 +181,7 @@ function ChassisPage() {
       </header>
 
       <div className="panel inline-meta">
-        <p>Auto-refresh: every 5 seconds</p>
+        <p>{eventsLive ? 'Live updates: EventService stream' : 'Auto-refresh: every 5 seconds'}</p>
         <p>Last updated: {formatIsoDate(lastUpdated ?? undefined)}</p>
         <button className="button-secondary" type="button" onClick={() => void refresh()}>
           Refresh Now
@@ -127,26 +194,13 @@ function ChassisPage() {
       <div className="panel">
         <h3>Chassis Collection</h3>
         {chassis.length === 0 ? <p className="muted">No chassis members were discovered.</p> : null}
-        <div className="card-grid">
-          {chassis.map((item) => (
-            <button
-              key={item.uri}
-              type="button"
-              className={`resource-card selectable ${selectedChassisUri === item.uri ? 'selected' : ''}`}
-              onClick={() => setSelectedChassisUri(item.uri)}
-            >
-              <div className="card-head">
-                <h4>{item.name}</h4>
-                <StatusPill tone={getStatusTone({ State: item.state, Health: item.health })} label={item.state} />
-              </div>
-              <p>Health: {item.health}</p>
-              <p>Type: {item.chassisType}</p>
-              <p>Power: {item.powerState}</p>
-              <p>Actions: {item.actionsCount}</p>
-              <p className="resource-path">{item.uri}</p>
-            </button>
-          ))}
-        </div>
+        <WindowedGrid
+          items={chassis}
+          itemKey={(item) => item.uri}
+          renderItem={(item) => (
+            <ChassisCard item={item} selected={selectedChassisUri === item.uri} onSelect={setSelectedChassisUri} />
+          )}
+        />
       </div>
 
       {selectedChassis ? (
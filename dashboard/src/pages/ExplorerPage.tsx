@@ -2,6 +2,7 @@ import { type FormEvent, useCallback, useEffect, useMemo, useState } from 'react
 import { useSearchParams } from 'react-router-dom'
 import JsonPanel from '../components/JsonPanel'
 import ResourceTable from '../components/ResourceTable'
+import SensorHistoryPanel from '../components/SensorHistoryPanel'
 import { useClient } from '../state/ClientContext'
 import type { RedfishResource } from '../types/redfish'
 import {
@@ -53,6 +54,8 @@ function ExplorerPage() {
     return resource.Members
   }, [resource])
 
+  const isSensor = typeof resource?.['@odata.type'] === 'string' && resource['@odata.type'].startsWith('#Sensor.')
+
   const relatedLinks = useMemo(() => {
     if (!resource) {
       return []
@@ -143,6 +146,12 @@ function ExplorerPage() {
             </div>
           </article>
 
+          {isSensor ? (
+            <article className="panel two-column-span">
+              <SensorHistoryPanel sensorPath={currentPath} />
+            </article>
+          ) : null}
+
           <article className="panel two-column-span">
             <JsonPanel title="Resource JSON" data={resource} />
           </article>
@@ -1,17 +1,21 @@
-import { type FormEvent, useCallback, useEffect, useMemo, useState } from 'react'
+import { type FormEvent, memo, useCallback, useEffect, useMemo, useState } from 'react'
 import { Link } from 'react-router-dom'
 import JsonPanel from '../components/JsonPanel'
 import ResourceTable from '../components/ResourceTable'
 import StatusPill from '../components/StatusPill'
 import SupportedActions from '../components/SupportedActions'
-import { useClient } from '../state/ClientContext'
-import type { ODataLink, RedfishResource } from '../types/redfish'
+import WindowedGrid from '../components/WindowedGrid'
+import { useAutoRefresh, useClient, useRedfishEvents } from '../state/ClientContext'
+import type { ODataLink, RedfishEvent, RedfishResource } from '../types/redfish'
 import {
+  collectionChanges,
+  eventOriginPaths,
   extractSupportedActions,
   formatIsoDate,
   getStatusTone,
   isODataLink,
   resourceDisplayName,
+  shareUnchanged,
   toODataPath,
 } from '../utils/redfish'
 
@@ -198,6 +202,33 @@ function castParameterValue(field: JobDocumentField, input: string): unknown {
   return input
 }
 
+interface JobCardProps {
+  job: JobSummary
+  selected: boolean
+  onSelect: (uri: string) => void
+}
+
+const JobCard = memo(function JobCard({ job, selected, onSelect }: JobCardProps) {
+  return (
+    <button
+      type="button"
+      className={`resource-card selectable ${selected ? 'selected' : ''}`}
+      onClick={() => onSelect(job.uri)}
+      disabled={job.uri.length === 0}
+    >
+      <div className="card-head">
+        <h4>{job.name}</h4>
+        <StatusPill tone={getStatusTone({ State: job.state, Health: job.status })} label={job.state} />
+      </div>
+      <p>JobStatus: {job.status}</p>
+      <p>PercentComplete: {job.percentComplete ?? 'N/A'}</p>
+      <p>Created: {formatIsoDate(job.createdAt)}</p>
+      <p>Started: {formatIsoDate(job.startTime)}</p>
+      <p className="resource-path">{job.uri}</p>
+    </button>
+  )
+})
+
 function JobsPage() {
   const { client } = useClient()
 
@@ -242,10 +273,11 @@ function JobsPage() {
       ])
       const nextJobs = jobsResources.map(toJobSummary)
 
-      setJobService(jobService)
-      setJobDocuments(documents)
+      // Unchanged jobs and documents keep their objects across refreshes
+      setJobService((current) => shareUnchanged(current, jobService))
+      setJobDocuments((current) => shareUnchanged(current, documents))
       setJobsCollectionPath(nextJobsPath)
-      setJobs(nextJobs)
+      setJobs((current) => shareUnchanged(current, nextJobs))
 
       setSelectedDocumentUri((current) => {
         if (current.length > 0 && documents.some((document) => document['@odata.id'] === current)) {
@@ -285,7 +317,7 @@ function JobsPage() {
     try {
       const jobsResources = await client.getCollectionMembers(jobsCollectionPath)
       const nextJobs = jobsResources.map(toJobSummary)
-      setJobs(nextJobs)
+      setJobs((current) => shareUnchanged(current, nextJobs))
       setSelectedJobUri((current) => {
         if (current.length > 0 && nextJobs.some((job) => job.uri === current)) {
           return current
@@ -298,17 +330,28 @@ function JobsPage() {
     }
   }, [client, jobsCollectionPath])
 
-  useEffect(() => {
-    if (!jobsCollectionPath) {
-      return
-    }
+  const handleEvent = useCallback(
+    (event: RedfishEvent) => {
+      if (!jobsCollectionPath) {
+        return
+      }
+
+      const changes = collectionChanges(
+        eventOriginPaths([event]),
+        jobsCollectionPath,
+        jobs.map((job) => job.uri),
+      )
+      if (changes.reloadAll || changes.members.length > 0) {
+        void refreshJobs()
+      }
+    },
+    [jobsCollectionPath, jobs, refreshJobs],
+  )
 
-    const intervalId = window.setInterval(() => {
-      void refreshJobs()
-    }, 5000)
+  useRedfishEvents(handleEvent)
 
-    return () => window.clearInterval(intervalId)
-  }, [refreshJobs, jobsCollectionPath])
+  // Catches up on anything missed while the stream was down
+  useAutoRefresh(refreshJobs, 5000, Boolean(jobsCollectionPath))
 
   const selectedDocument = useMemo(
     () => jobDocuments.find((document) => document['@odata.id'] === selectedDocumentUri) ?? null,
@@ -691,32 +734,11 @@ function JobsPage() {
         <h3>Jobs Collection</h3>
         {jobs.length === 0 ? <p className="muted">No jobs currently listed.</p> : null}
 
-        <div className="card-grid">
-          {jobs.map((job) => {
-            const cardKey = job.uri.length > 0 ? job.uri : `${job.id}-${job.createdAt ?? 'n/a'}`
-            const selected = selectedJobUri === job.uri
-
-            return (
-            <button
-              type="button"
-              key={cardKey}
-              className={`resource-card selectable ${selected ? 'selected' : ''}`}
-              onClick={() => setSelectedJobUri(job.uri)}
-              disabled={job.uri.length === 0}
-            >
-              <div className="card-head">
-                <h4>{job.name}</h4>
-                <StatusPill tone={getStatusTone({ State: job.state, Health: job.status })} label={job.state} />
-              </div>
-              <p>JobStatus: {job.status}</p>
-              <p>PercentComplete: {job.percentComplete ?? 'N/A'}</p>
-              <p>Created: {formatIsoDate(job.createdAt)}</p>
-              <p>Started: {formatIsoDate(job.startTime)}</p>
-              <p className="resource-path">{job.uri}</p>
-            </button>
-            )
-          })}
-        </div>
+        <WindowedGrid
+          items={jobs}
+          itemKey={(job) => (job.uri.length > 0 ? job.uri : `${job.id}-${job.createdAt ?? 'n/a'}`)}
+          renderItem={(job) => <JobCard job={job} selected={selectedJobUri === job.uri} onSelect={setSelectedJobUri} />}
+        />
       </article>
 
       {selectedJob ? (
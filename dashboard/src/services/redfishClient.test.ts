@@ -115,4 +115,171 @@ describe('RedfishClient', () => {
     expect(tasks[0].status).toBe('OK')
     expect(tasks[0].messages).toEqual(['The task completed successfully.'])
   })
+
+  it('discovers the EventService Server-Sent Event URI', async () => {
+    const fetchMock = vi
+      .fn()
+      .mockResolvedValueOnce(jsonResponse({ EventService: { '@odata.id': '/redfish/v1/EventService' } }))
+      .mockResolvedValueOnce(jsonResponse({ Id: 'EventService', ServerSentEventUri: '/redfish/v1/EventService/SSE' }))
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1' })
+
+    await expect(client.getServerSentEventUri()).resolves.toBe('/redfish/v1/EventService/SSE')
+    const [url] = fetchMock.mock.calls[1] as [string]
+    expect(url).toBe('/redfish/v1/EventService')
+  })
+
+  it('loads expanded collection members in a single request', async () => {
+    const fetchMock = vi.fn().mockResolvedValue(
+      jsonResponse({
+        Members: [
+          { '@odata.id': '/redfish/v1/Chassis/1U/Sensors/Temp', Id: 'Temp', Reading: 41 },
+          { '@odata.id': '/redfish/v1/Chassis/1U/Sensors/Fan', Id: 'Fan', Reading: 2200 },
+        ],
+      }),
+    )
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1' })
+    const sensors = await client.getCollectionMembers('/redfish/v1/Chassis/1U/Sensors')
+
+    expect(fetchMock).toHaveBeenCalledTimes(1)
+    const [url] = fetchMock.mock.calls[0] as [string]
+    expect(url).toBe('/redfish/v1/Chassis/1U/Sensors?$expand=.($levels=1)')
+    expect(sensors.map((sensor) => sensor.Id)).toEqual(['Temp', 'Fan'])
+  })
+
+  it('revalidates cached bodies with If-None-Match', async () => {
+    const fetchMock = vi
+      .fn()
+      .mockResolvedValueOnce(jsonResponse({ Id: '1U', Status: { State: 'Enabled' } }, { headers: { ETag: '"g-3"' } }))
+      .mockResolvedValueOnce(new Response(null, { status: 304, headers: { ETag: '"g-3"' } }))
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1', cacheTtlMs: 0 })
+    await client.getResource('/redfish/v1/Chassis/1U')
+    const resource = await client.getResource('/redfish/v1/Chassis/1U')
+
+    const [, secondInit] = fetchMock.mock.calls[1] as [string, RequestInit]
+    expect(new Headers(secondInit.headers).get('If-None-Match')).toBe('"g-3"')
+    expect(resource.Id).toBe('1U')
+  })
+
+  it('shares one request between concurrent reads of the same resource', async () => {
+    const fetchMock = vi.fn().mockResolvedValue(jsonResponse({ Id: '1U' }))
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1' })
+    const [first, second] = await Promise.all([
+      client.getResource('/redfish/v1/Chassis/1U'),
+      client.getResource('/redfish/v1/Chassis/1U'),
+    ])
+
+    expect(fetchMock).toHaveBeenCalledTimes(1)
+    expect(first.Id).toBe('1U')
+    expect(second.Id).toBe('1U')
+  })
+
+  it('serves fresh bodies from memory until they expire or are invalidated', async () => {
+    const now = vi.spyOn(Date, 'now').mockReturnValue(1000)
+    const fetchMock = vi.fn().mockImplementation(() => Promise.resolve(jsonResponse({ Id: '1U' })))
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1', cacheTtlMs: 2000 })
+    await client.getResource('/redfish/v1/Chassis/1U')
+    await client.getResource('/redfish/v1/Chassis/1U')
+    expect(fetchMock).toHaveBeenCalledTimes(1)
+
+    client.invalidate(['/redfish/v1/Chassis/1U/Sensors/Temp'])
+    await client.getResource('/redfish/v1/Chassis/1U')
+    expect(fetchMock).toHaveBeenCalledTimes(2)
+
+    now.mockReturnValue(3000)
+    await client.getResource('/redfish/v1/Chassis/1U')
+    expect(fetchMock).toHaveBeenCalledTimes(3)
+  })
+
+  it('keeps expanded collection members as fresh resources', async () => {
+    const fetchMock = vi.fn().mockResolvedValue(
+      jsonResponse({
+        Members: [{ '@odata.id': '/redfish/v1/Chassis/1U/Sensors/Temp', Id: 'Temp', Reading: 41 }],
+      }),
+    )
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1' })
+    await client.getCollectionMembers('/redfish/v1/Chassis/1U/Sensors')
+    const sensor = await client.getResource('/redfish/v1/Chassis/1U/Sensors/Temp')
+
+    expect(fetchMock).toHaveBeenCalledTimes(1)
+    expect(sensor.Reading).toBe(41)
+  })
+
+  it('drops fresh bodies under a resource after changing it', async () => {
+    const fetchMock = vi.fn().mockImplementation(() => Promise.resolve(jsonResponse({ Id: '1U' })))
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1' })
+    await client.getResource('/redfish/v1/Chassis/1U')
+    await client.patchResource('/redfish/v1/Chassis/1U', { AssetTag: 'rack-7' })
+    await client.getResource('/redfish/v1/Chassis/1U')
+
+    expect(fetchMock).toHaveBeenCalledTimes(3)
+  })
+
+  it('limits the number of requests in flight', async () => {
+    let inFlight = 0
+    let peak = 0
+    const fetchMock = vi.fn().mockImplementation(async (url: string) => {
+      inFlight += 1
+      peak = Math.max(peak, inFlight)
+      await new Promise((resolve) => setTimeout(resolve, 1))
+      inFlight -= 1
+      return jsonResponse({ '@odata.id': url, Id: url.split('/').pop() })
+    })
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1', maxConcurrentRequests: 2 })
+    const sensors = await Promise.all(
+      ['A', 'B', 'C', 'D', 'E'].map((id) => client.getResource(`/redfish/v1/Chassis/1U/Sensors/${id}`)),
+    )
+
+    expect(fetchMock).toHaveBeenCalledTimes(5)
+    expect(peak).toBe(2)
+    expect(sensors.map((sensor) => sensor.Id)).toEqual(['A', 'B', 'C', 'D', 'E'])
+  })
+
+  it('reads sensor history through the TelemetryService link', async () => {
+    const fetchMock = vi
+      .fn()
+      .mockResolvedValueOnce(jsonResponse({ TelemetryService: { '@odata.id': '/redfish/v1/TelemetryService' } }))
+      .mockResolvedValueOnce(
+        jsonResponse({
+          Id: 'TelemetryService',
+          Oem: { IoTFoundry: { SensorHistory: { '@odata.id': '/redfish/v1/TelemetryService/Oem/IoTFoundry/SensorHistory' } } },
+        }),
+      )
+      .mockResolvedValueOnce(
+        jsonResponse({
+          Sensor: '/redfish/v1/Chassis/1U/Sensors/Temp',
+          Resolution: '1min',
+          Period: 60,
+          Timestamps: [600],
+          Min: [40],
+          Max: [42],
+          Avg: [41],
+        }),
+      )
+    vi.stubGlobal('fetch', fetchMock)
+
+    const client = new RedfishClient({ baseUrl: '/redfish/v1' })
+    const history = await client.getSensorHistory('/redfish/v1/Chassis/1U/Sensors/Temp', '1min')
+
+    const [url] = fetchMock.mock.calls[2] as [string]
+    expect(url).toBe(
+      '/redfish/v1/TelemetryService/Oem/IoTFoundry/SensorHistory?Sensor=%2Fredfish%2Fv1%2FChassis%2F1U%2FSensors%2FTemp&Resolution=1min',
+    )
+    expect(history?.Avg).toEqual([41])
+  })
 })
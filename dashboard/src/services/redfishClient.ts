@@ -1,7 +1,10 @@
 import type {
   CreateSessionResult,
   RedfishCollection,
+  RedfishEvent,
   RedfishResource,
+  SensorHistory,
+  SensorHistoryResolution,
   TaskSummary,
 } from '../types/redfish'
 import { isCollection, isODataLink, normalizeRedfishPath, resourceDisplayName, toODataPath } from '../utils/redfish'
@@ -9,6 +12,10 @@ import { isCollection, isODataLink, normalizeRedfishPath, resourceDisplayName, t
 interface RedfishClientOptions {
   baseUrl: string
   getToken?: () => string | undefined
+  // GET bodies younger than this are served from memory; 0 always asks the service
+  cacheTtlMs?: number
+  // Requests sent at once; further ones wait their turn
+  maxConcurrentRequests?: number
 }
 
 interface RequestOptions {
@@ -18,6 +25,12 @@ interface RequestOptions {
   allowErrorStatus?: boolean
 }
 
+export interface EventStreamHandlers {
+  onEvent: (event: RedfishEvent) => void
+  onOpen?: () => void
+  onError?: () => void
+}
+
 interface RequestResult<T> {
   status: number
   headers: Headers
@@ -74,6 +87,33 @@ function normalizeBaseUrl(baseUrl: string): string {
   return normalizeRedfishPath(trimmed)
 }
 
+const EXPAND_MEMBERS_QUERY = '$expand=.($levels=1)'
+const ETAG_CACHE_LIMIT = 500
+const FRESH_TTL_MS = 2000
+const MAX_CONCURRENT_REQUESTS = 6
+
+interface CachedBody {
+  etag: string
+  data: unknown
+}
+
+interface FreshBody {
+  path: string
+  data: unknown
+  expires: number
+}
+
+// Path of a request URL without its query, for comparing against event origins
+function resourcePath(url: string): string {
+  return normalizeRedfishPath(url).split('?')[0]
+}
+
+// True when one path is the other or lies below it: a change to either can
+// change the other's body (expanded members, embedded links)
+function pathsOverlap(a: string, b: string): boolean {
+  return a === b || a.startsWith(`${b}/`) || b.startsWith(`${a}/`)
+}
+
 export class RedfishRequestError extends Error {
   readonly status: number
   readonly body: unknown
@@ -89,10 +129,53 @@ export class RedfishRequestError extends Error {
 export class RedfishClient {
   private readonly baseUrl: string
   private readonly getToken?: () => string | undefined
+  private readonly cacheTtlMs: number
+  private readonly maxConcurrentRequests: number
+  // GET bodies by URL, revalidated with If-None-Match; oldest first
+  private readonly etagCache = new Map<string, CachedBody>()
+  // Recent GET bodies by URL, shared by every page using this client
+  private readonly freshCache = new Map<string, FreshBody>()
+  // GETs on the wire by URL; identical requests made meanwhile share them
+  private readonly inflight = new Map<string, Promise<RequestResult<unknown>>>()
+  // Bumped by invalidate(); a GET sent before then is not kept as fresh
+  private generation = 0
+  private activeRequests = 0
+  private readonly waitingRequests: Array<() => void> = []
 
   constructor(options: RedfishClientOptions) {
     this.baseUrl = normalizeBaseUrl(options.baseUrl)
     this.getToken = options.getToken
+    this.cacheTtlMs = options.cacheTtlMs ?? FRESH_TTL_MS
+    this.maxConcurrentRequests = Math.max(1, options.maxConcurrentRequests ?? MAX_CONCURRENT_REQUESTS)
+  }
+
+  // Forgets fresh bodies that a change to any of `paths` may have made stale:
+  // the resources themselves, the collections embedding them and anything
+  // below them. Their ETags are kept, so the next read is a cheap revalidation.
+  invalidate(paths: string[]): void {
+    const changed = paths.map(resourcePath)
+    if (changed.length === 0) {
+      return
+    }
+
+    this.generation += 1
+    const stale = (path: string) => changed.some((changedPath) => pathsOverlap(path, changedPath))
+    for (const [url, entry] of this.freshCache) {
+      if (stale(entry.path)) {
+        this.freshCache.delete(url)
+      }
+    }
+    for (const [url] of this.inflight) {
+      if (stale(resourcePath(url))) {
+        this.inflight.delete(url)
+      }
+    }
+  }
+
+  invalidateAll(): void {
+    this.generation += 1
+    this.freshCache.clear()
+    this.inflight.clear()
   }
 
   private buildUrl(path: string): string {
@@ -129,9 +212,106 @@ export class RedfishClient {
     return `/${joinedPath}`
   }
 
+  // GETs without extra headers are answered from the fresh cache or joined to
+  // an identical request in flight; everything else goes to the service.
   private async request<T>(path: string, options: RequestOptions = {}): Promise<RequestResult<T>> {
+    const method = options.method ?? 'GET'
+    const url = this.buildUrl(path)
+    let result: RequestResult<T>
+
+    if (method === 'GET' && options.headers === undefined) {
+      const fresh = this.freshBody(url)
+      if (fresh !== undefined) {
+        return { status: 200, headers: new Headers(), data: fresh as T | null }
+      }
+
+      let pending = this.inflight.get(url) as Promise<RequestResult<T>> | undefined
+      if (!pending) {
+        const sent = this.send<T>(url, options)
+        const forget = () => {
+          if (this.inflight.get(url) === sent) {
+            this.inflight.delete(url)
+          }
+        }
+        sent.then(forget, forget)
+        this.inflight.set(url, sent)
+        pending = sent
+      }
+      result = await pending
+    } else {
+      result = await this.send<T>(url, options)
+      if (method !== 'GET') {
+        this.invalidate([path])
+      }
+    }
+
+    if ((result.status < 200 || result.status >= 300) && !options.allowErrorStatus) {
+      throw new RedfishRequestError(`Redfish request failed with status ${result.status}`, result.status, result.data)
+    }
+
+    return result
+  }
+
+  private freshBody(url: string): unknown {
+    const entry = this.freshCache.get(url)
+    if (!entry) {
+      return undefined
+    }
+    if (entry.expires <= Date.now()) {
+      this.freshCache.delete(url)
+      return undefined
+    }
+    return entry.data
+  }
+
+  private rememberFresh(url: string, data: unknown): void {
+    if (this.cacheTtlMs <= 0) {
+      return
+    }
+
+    this.freshCache.delete(url)
+    this.freshCache.set(url, { path: resourcePath(url), data, expires: Date.now() + this.cacheTtlMs })
+    if (this.freshCache.size > ETAG_CACHE_LIMIT) {
+      const oldest = this.freshCache.keys().next()
+      if (!oldest.done) {
+        this.freshCache.delete(oldest.value)
+      }
+    }
+  }
+
+  private async acquireSlot(): Promise<void> {
+    if (this.activeRequests < this.maxConcurrentRequests) {
+      this.activeRequests += 1
+      return
+    }
+    await new Promise<void>((resolve) => this.waitingRequests.push(resolve))
+  }
+
+  private releaseSlot(): void {
+    const next = this.waitingRequests.shift()
+    if (next) {
+      // The slot passes straight to the next request
+      next()
+    } else {
+      this.activeRequests -= 1
+    }
+  }
+
+  // One request on the wire, within the concurrency limit. Error statuses are
+  // returned, not thrown, so that callers sharing a GET can each decide.
+  private async send<T>(url: string, options: RequestOptions): Promise<RequestResult<T>> {
+    await this.acquireSlot()
+    try {
+      return await this.fetchOnce<T>(url, options)
+    } finally {
+      this.releaseSlot()
+    }
+  }
+
+  private async fetchOnce<T>(url: string, options: RequestOptions): Promise<RequestResult<T>> {
     const method = options.method ?? 'GET'
     const headers = new Headers(options.headers)
+    const generation = this.generation
 
     if (!headers.has('Accept')) {
       headers.set('Accept', 'application/json')
@@ -146,12 +326,30 @@ export class RedfishClient {
       headers.set('X-Auth-Token', token)
     }
 
-    const response = await fetch(this.buildUrl(path), {
+    const cached = method === 'GET' ? this.etagCache.get(url) : undefined
+    if (cached && !headers.has('If-None-Match')) {
+      headers.set('If-None-Match', cached.etag)
+    }
+
+    const response = await fetch(url, {
       method,
       headers,
       body: options.bodyJson !== undefined ? JSON.stringify(options.bodyJson) : undefined,
     })
 
+    if (response.status === 304 && cached) {
+      this.etagCache.delete(url)
+      this.etagCache.set(url, cached)
+      if (this.generation === generation) {
+        this.rememberFresh(url, cached.data)
+      }
+      return {
+        status: 200,
+        headers: response.headers,
+        data: cached.data as T | null,
+      }
+    }
+
     const textPayload = response.status === 204 ? '' : await response.text()
     let data: unknown = null
 
@@ -168,8 +366,12 @@ export class RedfishClient {
       }
     }
 
-    if (!response.ok && !options.allowErrorStatus) {
-      throw new RedfishRequestError(`Redfish request failed with status ${response.status}`, response.status, data)
+    if (method === 'GET') {
+      this.rememberBody(url, response, data)
+      if (response.ok && this.generation === generation) {
+        this.rememberFresh(url, data)
+        this.rememberMembers(data)
+      }
     }
 
     return {
@@ -179,6 +381,37 @@ export class RedfishClient {
     }
   }
 
+  private rememberBody(url: string, response: Response, data: unknown): void {
+    const etag = response.headers.get('ETag')
+    this.etagCache.delete(url)
+
+    if (!response.ok || !etag) {
+      return
+    }
+
+    this.etagCache.set(url, { etag, data })
+    if (this.etagCache.size > ETAG_CACHE_LIMIT) {
+      const oldest = this.etagCache.keys().next()
+      if (!oldest.done) {
+        this.etagCache.delete(oldest.value)
+      }
+    }
+  }
+
+  // Members inlined by $expand are also what a GET of each would return, so
+  // they are kept as fresh under their own URLs
+  private rememberMembers(data: unknown): void {
+    if (!isCollection(data)) {
+      return
+    }
+
+    data.Members.forEach((member) => {
+      if (isODataLink(member) && Object.keys(member).length > 1) {
+        this.rememberFresh(this.buildUrl(member['@odata.id']), member)
+      }
+    })
+  }
+
   async getServiceRoot(): Promise<RedfishResource> {
     return this.getResource('/redfish/v1')
   }
@@ -241,8 +474,10 @@ export class RedfishClient {
     return result.status
   }
 
+  // Asks for the members inline ($expand); any the service leaves as bare
+  // links are fetched one request each, at most maxConcurrentRequests at a time.
   async getCollectionMembers(path: string, limit?: number): Promise<RedfishResource[]> {
-    const collection = await this.getResource<RedfishCollection>(path)
+    const collection = await this.getExpandedCollection(path)
     if (!isCollection(collection)) {
       return []
     }
@@ -250,6 +485,10 @@ export class RedfishClient {
     const members = typeof limit === 'number' ? collection.Members.slice(0, limit) : collection.Members
     const resources = await Promise.all(
       members.map(async (member) => {
+        if (Object.keys(member).length > 1) {
+          const expanded: RedfishResource = { ...member }
+          return expanded
+        }
         try {
           return await this.getResource(member['@odata.id'])
         } catch {
@@ -261,6 +500,22 @@ export class RedfishClient {
     return resources.filter((item): item is RedfishResource => item !== null)
   }
 
+  private async getExpandedCollection(path: string): Promise<RedfishCollection> {
+    const expandedPath = `${normalizeRedfishPath(path)}${path.includes('?') ? '&' : '?'}${EXPAND_MEMBERS_QUERY}`
+    const response = await this.request<RedfishCollection>(expandedPath, { allowErrorStatus: true })
+
+    // Services without query support may reject the option instead of ignoring it
+    if (response.status === 400 || response.status === 501) {
+      return this.getResource<RedfishCollection>(path)
+    }
+
+    if (response.status >= 400) {
+      throw new RedfishRequestError(`Redfish request failed with status ${response.status}`, response.status, response.data)
+    }
+
+    return response.data ?? {}
+  }
+
   async pollTasks(): Promise<TaskSummary[]> {
     const taskService = await this.getResource('/TaskService')
     const tasksPath = toODataPath(taskService.Tasks)
@@ -301,6 +556,79 @@ export class RedfishClient {
     })
   }
 
+  async getServerSentEventUri(): Promise<string | undefined> {
+    const root = await this.getServiceRoot()
+    const eventServicePath = toODataPath(root.EventService)
+    if (!eventServicePath) {
+      return undefined
+    }
+
+    const eventService = await this.getResource(eventServicePath)
+    return typeof eventService.ServerSentEventUri === 'string' ? eventService.ServerSentEventUri : undefined
+  }
+
+  // Recorded readings of one Sensor, or undefined when the service keeps no
+  // history (no TelemetryService, or nothing recorded for the sensor yet)
+  async getSensorHistory(
+    sensorPath: string,
+    resolution: SensorHistoryResolution = 'raw',
+    since?: number,
+  ): Promise<SensorHistory | undefined> {
+    const root = await this.getServiceRoot()
+    const telemetryPath = toODataPath(root.TelemetryService)
+    if (!telemetryPath) {
+      return undefined
+    }
+
+    const telemetry = await this.getResource(telemetryPath)
+    const oem = isRecord(telemetry.Oem) && isRecord(telemetry.Oem.IoTFoundry) ? telemetry.Oem.IoTFoundry : undefined
+    const historyPath = toODataPath(oem?.SensorHistory)
+    if (!historyPath) {
+      return undefined
+    }
+
+    const query = new URLSearchParams({ Sensor: normalizeRedfishPath(sensorPath), Resolution: resolution })
+    if (since !== undefined) {
+      query.set('Since', String(since))
+    }
+    const response = await this.request<SensorHistory>(`${historyPath}?${query.toString()}`, { allowErrorStatus: true })
+    if (response.status === 404) {
+      return undefined
+    }
+    if (response.status >= 400) {
+      throw new RedfishRequestError(`Redfish request failed with status ${response.status}`, response.status, response.data)
+    }
+
+    return response.data ?? undefined
+  }
+
+  // EventSource cannot send X-Auth-Token, so the stream relies on the service
+  // accepting unauthenticated SSE (as the demo server does).
+  openEventStream(uri: string, handlers: EventStreamHandlers): () => void {
+    if (typeof EventSource === 'undefined') {
+      handlers.onError?.()
+      return () => undefined
+    }
+
+    const source = new EventSource(this.buildUrl(uri))
+    source.onopen = () => handlers.onOpen?.()
+    source.onerror = () => handlers.onError?.()
+    source.onmessage = (message: MessageEvent<string>) => {
+      let payload: unknown
+      try {
+        payload = JSON.parse(message.data) as unknown
+      } catch {
+        return
+      }
+
+      if (isRecord(payload) && Array.isArray(payload.Events)) {
+        handlers.onEvent(payload as unknown as RedfishEvent)
+      }
+    }
+
+    return () => source.close()
+  }
+
   async loadSystemAndChassisResources(): Promise<{
     root: RedfishResource
     systems: RedfishResource[]
@@ -1,14 +1,17 @@
 /* eslint-disable react-refresh/only-export-components */
-import { createContext, useCallback, useContext, useEffect, useMemo, useState } from 'react'
+import { createContext, useCallback, useContext, useEffect, useMemo, useRef, useState } from 'react'
 import { DEFAULT_REDFISH_BASE } from '../config'
 import { RedfishClient } from '../services/redfishClient'
-import type { AuthSession } from '../types/redfish'
+import type { AuthSession, RedfishEvent } from '../types/redfish'
+import { eventOriginPaths } from '../utils/redfish'
 
 interface LoginResult {
   mode: 'server' | 'local'
   message: string
 }
 
+type RedfishEventListener = (event: RedfishEvent) => void
+
 interface ClientContextValue {
   baseUrl: string
   setBaseUrl: (nextUrl: string) => void
@@ -17,6 +20,9 @@ interface ClientContextValue {
   client: RedfishClient
   login: (username: string, password: string) => Promise<LoginResult>
   logout: () => Promise<void>
+  eventsLive: boolean
+  pageVisible: boolean
+  subscribeEvents: (listener: RedfishEventListener) => () => void
 }
 
 const SESSION_STORAGE_KEY = 'redfish-dashboard-session'
@@ -86,6 +92,10 @@ function readStoredSession(): AuthSession | null {
   }
 }
 
+function isPageVisible(): boolean {
+  return typeof document === 'undefined' || document.visibilityState !== 'hidden'
+}
+
 function makeLocalToken(): string {
   return `demo-${Math.random().toString(36).slice(2, 12)}`
 }
@@ -93,6 +103,9 @@ function makeLocalToken(): string {
 export function ClientProvider({ children }: { children: React.ReactNode }) {
   const [baseUrl, setBaseUrlState] = useState(readStoredBaseUrl)
   const [session, setSession] = useState<AuthSession | null>(readStoredSession)
+  const [eventsLive, setEventsLive] = useState(false)
+  const [pageVisible, setPageVisible] = useState(isPageVisible)
+  const eventListeners = useRef(new Set<RedfishEventListener>())
 
   const client = useMemo(
     () =>
@@ -110,6 +123,65 @@ export function ClientProvider({ children }: { children: React.ReactNode }) {
     window.localStorage.setItem(BASE_URL_STORAGE_KEY, baseUrl)
   }, [baseUrl])
 
+  useEffect(() => {
+    if (typeof document === 'undefined') {
+      return
+    }
+
+    const onVisibilityChange = () => setPageVisible(isPageVisible())
+    document.addEventListener('visibilitychange', onVisibilityChange)
+    return () => document.removeEventListener('visibilitychange', onVisibilityChange)
+  }, [])
+
+  // One EventService stream shared by every page; pages poll while it is down.
+  // A hidden tab gives its stream back to the service, which serves only a few.
+  useEffect(() => {
+    let active = true
+    let closeStream: (() => void) | undefined
+
+    setEventsLive(false)
+    if (!pageVisible) {
+      return undefined
+    }
+
+    void client
+      .getServerSentEventUri()
+      .then((uri) => {
+        if (!active || !uri) {
+          return
+        }
+
+        closeStream = client.openEventStream(uri, {
+          // Changes made while disconnected went unseen, so nothing cached is trusted
+          onOpen: () => {
+            client.invalidateAll()
+            setEventsLive(true)
+          },
+          onError: () => setEventsLive(false),
+          onEvent: (event) => {
+            client.invalidate(eventOriginPaths([event]))
+            eventListeners.current.forEach((listener) => listener(event))
+          },
+        })
+      })
+      .catch(() => {
+        // No EventService on this target; pages keep polling.
+      })
+
+    return () => {
+      active = false
+      closeStream?.()
+      setEventsLive(false)
+    }
+  }, [client, pageVisible])
+
+  const subscribeEvents = useCallback((listener: RedfishEventListener) => {
+    eventListeners.current.add(listener)
+    return () => {
+      eventListeners.current.delete(listener)
+    }
+  }, [])
+
   useEffect(() => {
     if (typeof window === 'undefined') {
       return
@@ -193,8 +265,11 @@ export function ClientProvider({ children }: { children: React.ReactNode }) {
       client,
       login,
       logout,
+      eventsLive,
+      pageVisible,
+      subscribeEvents,
     }),
-    [baseUrl, setBaseUrl, session, client, login, logout],
+    [baseUrl, setBaseUrl, session, client, login, logout, eventsLive, pageVisible, subscribeEvents],
   )
 
   return <ClientContext.Provider value={value}>{children}</ClientContext.Provider>
@@ -207,3 +282,38 @@ export function useClient(): ClientContextValue {
   }
   return value
 }
+
+// Delivers EventService events to `listener` and reports whether the stream is
+// live; callers fall back to polling while it is not.
+export function useRedfishEvents(listener: RedfishEventListener): boolean {
+  const { eventsLive, subscribeEvents } = useClient()
+
+  useEffect(() => subscribeEvents(listener), [subscribeEvents, listener])
+
+  return eventsLive
+}
+
+// Keeps a page current: `refresh` runs when the page mounts, whenever the event
+// stream connects or drops and when the tab comes back into view, and every
+// `intervalMs` while there is no stream. Nothing runs while the tab is hidden.
+export function useAutoRefresh(refresh: () => unknown, intervalMs: number, enabled = true): boolean {
+  const { eventsLive, pageVisible } = useClient()
+
+  useEffect(() => {
+    if (!enabled || !pageVisible) {
+      return undefined
+    }
+
+    void refresh()
+    if (eventsLive) {
+      return undefined
+    }
+
+    const intervalId = window.setInterval(() => {
+      void refresh()
+    }, intervalMs)
+    return () => window.clearInterval(intervalId)
+  }, [refresh, intervalMs, enabled, eventsLive, pageVisible])
+
+  return eventsLive
+}
@@ -48,3 +48,31 @@ export interface TaskSummary {
   messages: string[]
   raw: RedfishResource
 }
+
+export interface RedfishEventRecord {
+  EventId?: string
+  EventTimestamp?: string
+  MessageId: string
+  OriginOfCondition?: ODataLink
+  Oem?: Record<string, unknown>
+}
+
+export interface RedfishEvent {
+  Id?: string
+  Events: RedfishEventRecord[]
+}
+
+export type SensorHistoryResolution = 'raw' | '1min' | '1h'
+
+// Columnar answer of the server's TelemetryService/Oem/IoTFoundry/SensorHistory;
+// Timestamps are epoch seconds
+export interface SensorHistory {
+  Sensor: string
+  Resolution: SensorHistoryResolution
+  Period?: number
+  Timestamps: number[]
+  Values?: Array<number | null>
+  Min?: number[]
+  Max?: number[]
+  Avg?: number[]
+}
@@ -1,5 +1,12 @@
 import { describe, expect, it } from 'vitest'
-import { extractLinkedResources, getStatusTone, normalizeRedfishPath } from './redfish'
+import {
+  collectionChanges,
+  eventOriginPaths,
+  extractLinkedResources,
+  getStatusTone,
+  normalizeRedfishPath,
+  shareUnchanged,
+} from './redfish'
 
 describe('redfish utilities', () => {
   it('normalizes absolute and relative resource paths', () => {
@@ -29,4 +36,54 @@ describe('redfish utilities', () => {
     expect(getStatusTone({ Health: 'Warning', State: 'Enabled' })).toBe('warning')
     expect(getStatusTone({ Health: 'Critical', State: 'Enabled' })).toBe('critical')
   })
+
+  it('collects distinct event origins', () => {
+    const paths = eventOriginPaths([
+      {
+        Events: [
+          { MessageId: 'ResourceEvent.1.0.ResourceChanged', OriginOfCondition: { '@odata.id': '/redfish/v1/Chassis/1U/' } },
+          { MessageId: 'ResourceEvent.1.0.ResourceChanged', OriginOfCondition: { '@odata.id': '/redfish/v1/Chassis/1U' } },
+          { MessageId: 'IoTFoundry.1.0.ReadingChanged' },
+        ],
+      },
+    ])
+
+    expect(paths).toEqual(['/redfish/v1/Chassis/1U'])
+  })
+
+  it('limits collection re-fetches to changed members', () => {
+    const members = ['/redfish/v1/Chassis/1U', '/redfish/v1/Chassis/2U']
+
+    expect(collectionChanges(['/redfish/v1/Chassis/2U'], '/redfish/v1/Chassis', members)).toEqual({
+      reloadAll: false,
+      members: ['/redfish/v1/Chassis/2U'],
+    })
+    expect(collectionChanges(['/redfish/v1/Chassis/1U/Sensors/Temp'], '/redfish/v1/Chassis', members)).toEqual({
+      reloadAll: false,
+      members: [],
+    })
+    expect(collectionChanges(['/redfish/v1/Chassis/3U'], '/redfish/v1/Chassis', members).reloadAll).toBe(true)
+    expect(collectionChanges(['/redfish/v1'], '/redfish/v1/Chassis', members).reloadAll).toBe(true)
+  })
+
+  it('keeps unchanged refresh results identical', () => {
+    const previous = [
+      { uri: '/redfish/v1/Chassis/A', Status: { State: 'Enabled' } },
+      { uri: '/redfish/v1/Chassis/B', Status: { State: 'Enabled' } },
+    ]
+
+    const same = shareUnchanged(previous, JSON.parse(JSON.stringify(previous)) as typeof previous)
+    expect(same).toBe(previous)
+
+    const next = shareUnchanged(previous, [
+      { uri: '/redfish/v1/Chassis/New', Status: { State: 'Starting' } },
+      { uri: '/redfish/v1/Chassis/A', Status: { State: 'Enabled' } },
+      { uri: '/redfish/v1/Chassis/B', Status: { State: 'UnavailableOffline' } },
+    ])
+    expect(next).not.toBe(previous)
+    expect(next[1]).toBe(previous[0])
+    expect(next[2]).not.toBe(previous[1])
+    expect(next[2].uri).toBe(previous[1].uri)
+    expect(next[2].Status.State).toBe('UnavailableOffline')
+  })
 })
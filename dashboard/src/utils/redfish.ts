@@ -1,4 +1,4 @@
-import type { ODataLink, RedfishResource, RedfishStatus } from '../types/redfish'
+import type { ODataLink, RedfishEvent, RedfishResource, RedfishStatus } from '../types/redfish'
 
 const REDFISH_ROOT = '/redfish/v1'
 
@@ -197,3 +197,127 @@ export function formatIsoDate(value: string | undefined): string {
 
   return parsed.toLocaleString()
 }
+
+export function eventOriginPaths(events: RedfishEvent[]): string[] {
+  const paths = new Set<string>()
+
+  events.forEach((event) => {
+    event.Events.forEach((record) => {
+      const origin = toODataPath(record.OriginOfCondition)
+      if (origin) {
+        paths.add(normalizeRedfishPath(origin))
+      }
+    })
+  })
+
+  return [...paths]
+}
+
+export interface CollectionChanges {
+  reloadAll: boolean
+  members: string[]
+}
+
+// Decides what a collection view must re-fetch for a set of changed resources:
+// only the members that changed, unless the collection itself (or something
+// above it, such as the service root after a mockup reload) changed.
+export function collectionChanges(
+  changedPaths: string[],
+  collectionPath: string,
+  memberPaths: string[],
+): CollectionChanges {
+  const collection = normalizeRedfishPath(collectionPath)
+  const members = new Set(memberPaths.map(normalizeRedfishPath))
+  const changedMembers = new Set<string>()
+  let reloadAll = false
+
+  changedPaths.map(normalizeRedfishPath).forEach((path) => {
+    if (path === collection || collection.startsWith(`${path}/`)) {
+      reloadAll = true
+      return
+    }
+
+    if (members.has(path)) {
+      changedMembers.add(path)
+    } else if (path.startsWith(`${collection}/`) && path.split('/').length === collection.split('/').length + 1) {
+      // A member the view has not seen yet
+      reloadAll = true
+    }
+  })
+
+  return { reloadAll, members: reloadAll ? [] : [...changedMembers] }
+}
+
+function isPlainRecord(value: unknown): value is Record<string, unknown> {
+  if (!isRecord(value) || Array.isArray(value)) {
+    return false
+  }
+  const prototype = Object.getPrototypeOf(value) as unknown
+  return prototype === Object.prototype || prototype === null
+}
+
+function memberKey(value: unknown): string | undefined {
+  if (!isRecord(value)) {
+    return undefined
+  }
+  const key = value.uri ?? value['@odata.id']
+  return typeof key === 'string' && key.length > 0 ? key : undefined
+}
+
+function shareArray(previous: unknown[], next: unknown[]): unknown[] {
+  const byKey = new Map<string, unknown>()
+  previous.forEach((item) => {
+    const key = memberKey(item)
+    if (key !== undefined) {
+      byKey.set(key, item)
+    }
+  })
+
+  let changed = previous.length !== next.length
+  const merged = next.map((item, index) => {
+    const key = memberKey(item)
+    const match = key !== undefined ? byKey.get(key) : previous[index]
+    const shared = match === undefined ? item : shareUnchanged(match, item)
+    if (shared !== previous[index]) {
+      changed = true
+    }
+    return shared
+  })
+
+  return changed ? merged : previous
+}
+
+function shareRecord(previous: Record<string, unknown>, next: Record<string, unknown>): Record<string, unknown> {
+  const nextKeys = Object.keys(next)
+  let changed = Object.keys(previous).length !== nextKeys.length
+  const merged: Record<string, unknown> = {}
+
+  nextKeys.forEach((key) => {
+    const known = Object.hasOwn(previous, key)
+    const shared = known ? shareUnchanged(previous[key], next[key]) : next[key]
+    if (!known || shared !== previous[key]) {
+      changed = true
+    }
+    merged[key] = shared
+  })
+
+  return changed ? merged : previous
+}
+
+// Returns `next` with every part that is deep-equal to `previous` replaced by
+// the previous object, or `previous` itself when nothing changed. Array items
+// carrying a `uri` or `@odata.id` are matched by it, others by position.
+// Refresh results stored this way keep unchanged rows identical, so React
+// skips re-rendering them and bails out of state updates that change nothing.
+export function shareUnchanged<T>(previous: T, next: T): T {
+  if (Object.is(previous, next)) {
+    return previous
+  }
+  if (Array.isArray(previous) && Array.isArray(next)) {
+    return shareArray(previous, next) as T
+  }
+  if (isPlainRecord(previous) && isPlainRecord(next)) {
+    return shareRecord(previous, next) as T
+  }
+  return next
+}
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+Control write latency benchmark.
+
+Runs the Redfish server, the agent's sensor sampler and its ControlWriter in
+one process against simulated endpoints (sim_endpoint.SimEndpoint), loads
+each link with sensor polling, and measures the time from sending a Control
+PATCH to receiving the 200 that follows the device's completion code.
+
+The SLO checked by default is p99 <= 50 ms at 115200 baud with 32 sensors
+per endpoint polled every 100 ms. On a 115200 link one sensor round trip is
+about 3 ms, so a write waits for at most the sensor requests already in
+flight (max_outstanding) plus its own round trip and three local HTTP hops.
+
+Usage:
+  python3 demo/bench/control_latency.py [--writes 300] [--baud 115200] ...
+
+Exits with status 1 if the measured p99 exceeds --target-p99.
+"""
+import sys
+import time
+import random
+import argparse
+import tempfile
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+
+import requests  # noqa: E402
+
+from harness import BenchServer, percentile, quiet_logger, write_resource  # noqa: E402
+import redfish_server  # noqa: E402
+from port_broker import TransportBroker  # noqa: E402
+from sensor_poller import SamplerSettings, SensorSampler  # noqa: E402
+from control_writer import ControlWriter  # noqa: E402
+from sim_endpoint import SimEndpoint, sim_serial_port_cls  # noqa: E402
+from pldm_mapping_wizard.discovery.request_engine import PLDMRequestEngine  # noqa: E402
+from pldm_mapping_wizard.discovery.pldm_commands import PDLMCommandEncoder  # noqa: E402
+
+NUMERIC_EFFECTER_ID = 4
+STATE_EFFECTER_ID = 1
+SETTING_MAX = 1000
+
+
+def build_mockup(root: Path, endpoints: int, sensors: int):
+    """Minimal tree: per endpoint one Chassis with Sensors and two Controls."""
+    v1 = root / 'redfish' / 'v1'
+    write_resource(v1, {'@odata.id': '/redfish/v1', 'Chassis': {'@odata.id': '/redfish/v1/Chassis'}})
+    write_resource(v1 / 'Chassis', {'@odata.id': '/redfish/v1/Chassis',
+                                    'Members': [{'@odata.id': f'/redfish/v1/Chassis/N{n}'} for n in range(endpoints)]})
+    for n in range(endpoints):
+        chassis = v1 / 'Chassis' / f'N{n}'
+        write_resource(chassis, {'@odata.id': f'/redfish/v1/Chassis/N{n}', 'Id': f'N{n}'})
+        for sid in range(sensors):
+            write_resource(chassis / 'Sensors' / f'SENSOR_ID_{sid}',
+                           {'@odata.id': f'/redfish/v1/Chassis/N{n}/Sensors/SENSOR_ID_{sid}', 'Reading': None})
+        write_resource(chassis / 'Controls' / f'EFFECTER_ID_{NUMERIC_EFFECTER_ID}',
+                       {'@odata.id': f'/redfish/v1/Chassis/N{n}/Controls/EFFECTER_ID_{NUMERIC_EFFECTER_ID}',
+                        'SetPoint': None, 'SettingMin': 0, 'SettingMax': SETTING_MAX, 'Status': {'State': 'Enabled'}})
+        write_resource(chassis / 'Controls' / f'EFFECTER_ID_{STATE_EFFECTER_ID}',
+                       {'@odata.id': f'/redfish/v1/Chassis/N{n}/Controls/EFFECTER_ID_{STATE_EFFECTER_ID}',
+                        'SetPoint': None, 'Status': {'State': 'Enabled'}})
+
+
+def effecter_specs(resource_id: str):
+    base = f'/redfish/v1/Chassis/{resource_id}/Controls'
+    return [
+        {'effecter_id': NUMERIC_EFFECTER_ID, 'kind': 'numeric', 'path': f'{base}/EFFECTER_ID_{NUMERIC_EFFECTER_ID}',
+         'data_size': 2, 'resolution': 0.5, 'offset': 0.0, 'min': 0, 'max': 2 * SETTING_MAX},
+        {'effecter_id': STATE_EFFECTER_ID, 'kind': 'state', 'path': f'{base}/EFFECTER_ID_{STATE_EFFECTER_ID}',
+         'composite_count': 1},
+    ]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--endpoints', type=int, default=2, help='simulated endpoints')
+    parser.add_argument('--sensors', type=int, default=32, help='sensors polled per endpoint')
+    parser.add_argument('--interval', type=float, default=0.1, help='sensor update interval (s)')
+    parser.add_argument('--baud', type=int, default=115200, help='simulated link rate')
+    parser.add_argument('--latency', type=float, default=0.001, help='device processing time per request (s)')
+    parser.add_argument('--writes', type=int, default=300, help='PATCHes to time')
+    parser.add_argument('--gap', type=float, default=0.02, help='pause between PATCHes (s)')
+    parser.add_argument('--target-p99', type=float, default=50.0, help='p99 SLO in ms')
+    args = parser.parse_args()
+
+    quiet = quiet_logger()
+
+    mockup = Path(tempfile.mkdtemp(prefix='control-bench-'))
+    build_mockup(mockup, args.endpoints, args.sensors)
+    server = BenchServer(mockup, quiet)
+    server_url = server.url
+
+    devices = {}
+    for n in range(args.endpoints):
+        devices[f'/dev/sim{n}'] = SimEndpoint(
+            baudrate=args.baud, latency=args.latency,
+            numeric={sid: (lambda: random.randrange(1024)) for sid in range(args.sensors)},
+            numeric_effecters={NUMERIC_EFFECTER_ID: (2, 0, 2 * SETTING_MAX)},
+            state_effecters={STATE_EFFECTER_ID: 1},
+        )
+    transport = TransportBroker(serial_cls=sim_serial_port_cls(devices))
+    transport.exclusive = False
+    for device in devices:
+        transport.port(device).baudrate = args.baud
+
+    settings = SamplerSettings()
+    settings.max_requests_per_second = 0  # the load is what --interval asks for
+    samplers = []
+    writer = ControlWriter(None, quiet, server_url, transport)
+    for n, device in enumerate(devices):
+        specs = [{'sensor_id': sid, 'kind': 'numeric', 'interval': args.interval, 'resolution': None, 'offset': None,
+                  'path': f'/redfish/v1/Chassis/N{n}/Sensors/SENSOR_ID_{sid}'} for sid in range(args.sensors)]
+        sampler = SensorSampler(f'N{n}', device, specs, settings, transport, PLDMRequestEngine,
+                                PDLMCommandEncoder, server_url, quiet)
+        samplers.append(sampler)
+        sampler.start()
+        writer.attach(f'N{n}', device, effecter_specs(f'N{n}'))
+    writer.start()
+
+    session = requests.Session()
+    deadline = time.monotonic() + 10
+    while not redfish_server.RedfishHandler.controls.agent_present() and time.monotonic() < deadline:
+        time.sleep(0.05)
+    time.sleep(0.5)  # let sampling reach steady state
+
+    latencies, failures = [], 0
+    for i in range(args.writes):
+        n = i % args.endpoints
+        if i % 4 == 3:
+            path = f'/redfish/v1/Chassis/N{n}/Controls/EFFECTER_ID_{STATE_EFFECTER_ID}'
+            set_point = (i // 4) % 2 + 1
+        else:
+            path = f'/redfish/v1/Chassis/N{n}/Controls/EFFECTER_ID_{NUMERIC_EFFECTER_ID}'
+            set_point = random.randrange(SETTING_MAX)
+        start = time.perf_counter()
+        response = session.patch(f'{server_url}{path}', json={'SetPoint': set_point}, timeout=5)
+        elapsed = (time.perf_counter() - start) * 1000.0
+        if response.status_code == 200:
+            latencies.append(elapsed)
+        else:
+            failures += 1
+        time.sleep(args.gap)
+
+    sensor_stats = [s.stats for s in samplers]
+    for sampler in samplers:
+        sampler.stop()
+    writer.stop()
+    for sampler in samplers:
+        sampler.join(timeout=2)
+    server.close()
+    transport.close_all()
+
+    if not latencies:
+        print(f"No successful writes ({failures} failed)")
+        return 1
+    p99 = percentile(latencies, 99)
+    print(f"Control PATCH latency over {len(latencies)} writes "
+          f"({args.endpoints} endpoints, {args.sensors} sensors @ {args.interval:g}s, {args.baud} baud):")
+    print(f"  p50={percentile(latencies, 50):.1f}ms p95={percentile(latencies, 95):.1f}ms "
+          f"p99={p99:.1f}ms max={max(latencies):.1f}ms, {failures} failed")
+    print(f"  sensor readings during run: {sum(s['readings'] for s in sensor_stats)}, "
+          f"writer: {writer.stats}")
+    ok = p99 <= args.target_p99 and failures == 0
+    print(f"  SLO p99 <= {args.target_p99:g}ms: {'PASS' if ok else 'FAIL'}")
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,64 @@
+"""
+Helpers shared by the benchmarks: an in-process Redfish server, mockup
+writing and percentiles.
+"""
+import sys
+import json
+import logging
+import threading
+from pathlib import Path
+
+DEMO_ROOT = Path(__file__).resolve().parents[1]
+for _path in (DEMO_ROOT / 'parts', DEMO_ROOT / 'pldm_tools'):
+    if str(_path) not in sys.path:
+        sys.path.insert(0, str(_path))
+
+import redfish_server  # noqa: E402
+
+
+def quiet_logger(name: str = 'bench') -> logging.Logger:
+    """A logger that drops everything below WARNING and never propagates."""
+    logger = logging.getLogger(name)
+    if not logger.handlers:
+        logger.addHandler(logging.NullHandler())
+    logger.setLevel(logging.WARNING)
+    logger.propagate = False
+    return logger
+
+
+def write_resource(path: Path, data: dict):
+    path.mkdir(parents=True, exist_ok=True)
+    (path / 'index.json').write_text(json.dumps(data))
+
+
+def percentile(samples, p: float) -> float:
+    ordered = sorted(samples)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p / 100.0))]
+
+
+class BenchServer:
+    """The Redfish mockup server on an ephemeral localhost port, in a thread."""
+
+    def __init__(self, mockup: Path, logger: logging.Logger, workers: int = 16, control_timeout: float = 2.0):
+        store = redfish_server.ResourceStore(mockup, logger)
+        store.load()
+        redfish_server.RedfishHandler.store = store
+        redfish_server.RedfishHandler.logger = logger
+        redfish_server.RedfishHandler.controls = redfish_server.ControlWriteQueue(timeout=control_timeout)
+        self.store = store
+        self.httpd = redfish_server.PooledHTTPServer(('127.0.0.1', 0), redfish_server.RedfishHandler, workers)
+        self.httpd.timeout = 0.2
+        self.url = f'http://127.0.0.1:{self.httpd.server_address[1]}'
+        self._running = threading.Event()
+        self._running.set()
+        self._thread = threading.Thread(target=self._serve, name='bench-redfish', daemon=True)
+        self._thread.start()
+
+    def _serve(self):
+        while self._running.is_set():
+            self.httpd.handle_request()
+
+    def close(self):
+        self._running.clear()
+        self._thread.join(timeout=2)
+        self.httpd.server_close()
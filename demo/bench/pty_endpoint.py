@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Pseudo-terminal PLDM endpoints.
+
+PtyEndpoint serves a SimEndpoint on a pty, so the collector, the probe tools
+and the runtime agent open it by device path through pyserial exactly as they
+open a /dev/ttyUSB* adapter. Wire time is modelled at the speed the client
+set on its side of the pty (the master sees the slave's termios), so baud
+rate negotiation behaves as it does on a real link.
+
+Run as a script to serve a capture for manual testing:
+
+  python3 demo/bench/pty_endpoint.py /tmp/pdr_and_fru_records.json --baud 460800
+  python3 demo/pldm_tools/collect_endpoints.py    # enter the printed /dev/pts/N
+
+Without a capture file one generated endpoint is served.
+"""
+import os
+import sys
+import tty
+import time
+import select
+import signal
+import termios
+import argparse
+import threading
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+from sim_endpoint import SimEndpoint, load_capture, make_endpoints, synthetic_capture  # noqa: E402
+
+# termios speed constant -> bits per second
+LINE_SPEEDS = {getattr(termios, f'B{rate}'): rate
+               for rate in (9600, 19200, 38400, 57600, 115200, 230400, 460800, 500000, 576000,
+                            921600, 1000000, 1152000, 1500000, 2000000)
+               if hasattr(termios, f'B{rate}')}
+
+# Standard rates an emulated device accepts, up to its configured maximum
+STANDARD_RATES = (115200, 230400, 460800, 921600)
+
+
+class PtyEndpoint:
+    """A SimEndpoint reachable at `path`, a pty slave device."""
+
+    def __init__(self, sim: SimEndpoint):
+        self.sim = sim
+        self._master, self._slave = os.openpty()
+        # Raw from the start; the slave stays open here so the pty survives
+        # clients closing and reopening it
+        tty.setraw(self._slave)
+        self.path = os.ttyname(self._slave)
+        self._stop = threading.Event()
+        self._thread = threading.Thread(target=self._serve, name=f'pty-endpoint-{self.path}', daemon=True)
+
+    def start(self) -> 'PtyEndpoint':
+        self._thread.start()
+        return self
+
+    def close(self):
+        self._stop.set()
+        self._thread.join(timeout=1)
+        for fd in (self._master, self._slave):
+            try:
+                os.close(fd)
+            except OSError:
+                pass
+
+    def _line_speed(self) -> int:
+        try:
+            return LINE_SPEEDS.get(termios.tcgetattr(self._master)[4], self.sim.baudrate)
+        except termios.error:
+            return self.sim.baudrate
+
+    def _serve(self):
+        # Replies are collected without blocking
+        self.sim.timeout = 0
+        while not self._stop.is_set():
+            ready = self.sim.next_ready()
+            wait = 0.05 if ready is None else min(0.05, max(0.0, ready - time.monotonic()))
+            try:
+                readable, _, _ = select.select([self._master], [], [], wait)
+                if readable:
+                    data = os.read(self._master, 4096)
+                    if data:
+                        self.sim.baudrate = self._line_speed()
+                        self.sim.write(data)
+                reply = self.sim.read(65536)
+                if reply:
+                    os.write(self._master, reply)
+            except OSError:
+                if self._stop.is_set():
+                    return
+                time.sleep(0.01)
+
+
+def device_rates(max_baud: int):
+    """Rates a device with maximum `max_baud` answers at."""
+    return [r for r in STANDARD_RATES if r <= max_baud] or [max_baud]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('capture', nargs='?', help='pdr_and_fru_records.json or endpoint store to serve')
+    parser.add_argument('--count', type=int, default=None, help='endpoints to serve (default: one per captured endpoint)')
+    parser.add_argument('--baud', type=int, default=460800, help='fastest rate the endpoints accept')
+    parser.add_argument('--latency', type=float, default=0.001, help='device processing time per request (s)')
+    parser.add_argument('--error-rate', type=float, default=0.0, help='fraction of reply packets with a bad FCS')
+    args = parser.parse_args()
+
+    captured = load_capture(args.capture) if args.capture else [synthetic_capture()]
+    if not captured:
+        print(f"No endpoints with PDRs in {args.capture}")
+        return 1
+    endpoints = []
+    for sim in make_endpoints(captured, args.count or len(captured), baud_rates=device_rates(args.baud),
+                              latency=args.latency, error_rate=args.error_rate):
+        endpoints.append(PtyEndpoint(sim).start())
+        print(f"{endpoints[-1].path}: {len(sim.pdrs)} PDRs, {len(sim.fru or b'')}-byte FRU, "
+              f"up to {args.baud} baud")
+
+    stop = threading.Event()
+    signal.signal(signal.SIGINT, lambda *_: stop.set())
+    signal.signal(signal.SIGTERM, lambda *_: stop.set())
+    print("Serving; Ctrl+C to stop")
+    while not stop.wait(0.5):
+        pass
+    for endpoint in endpoints:
+        endpoint.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
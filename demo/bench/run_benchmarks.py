@@ -0,0 +1,556 @@
+#!/usr/bin/env python3
+"""
+Benchmark suite on simulated PLDM endpoints.
+
+Each endpoint is a SimEndpoint serving the PDRs and FRU of a captured
+endpoint (--capture: a pdr_and_fru_records.json or an endpoint store; one
+generated endpoint otherwise), on its own pty (pty_endpoint.PtyEndpoint), so
+the collector and the agent run unmodified through pyserial and a tty.
+
+  discovery  collect_endpoints.fetch_endpoint on --endpoints endpoints in
+             parallel, link negotiation included: wall time and mean
+             negotiation time
+  pdr        one GetPDR chain download at 255- and at 1024-byte parts,
+             115200 baud, bounded by GetPDRRepositoryInfo as the collector
+             does: KiB/s, and the speed-up over speculate=False (an error
+             when speculation makes the walk slower)
+  cache      collect_endpoints.fetch_endpoint with a PDR cache: cold and
+             warm-start PDR time; after one PDR changes (on an endpoint
+             with a clock, and on one without whose PDR changes size) the
+             warm start must walk the chain again and return the new PDR
+  hotplug    the runtime agent with a simulated bus in place of sysfs and
+             netlink: --hotplug-endpoints ports plugged at once until their
+             Chassis is Enabled, then unplugged until it is UnavailableOffline
+  redfish    GET of Sensors and PATCH of Status from --clients clients:
+             requests/s and p99
+
+Link time is modelled (10 bits per byte at the line rate plus --latency per
+request), so results track the code under test rather than the machine; the
+Redfish figures are the exception and are CPU-bound. Results are compared
+with baselines.json when it was recorded with the same settings, and a metric
+more than --tolerance worse than its baseline fails the run (exit status 1).
+The CPU-bound metrics vary with the machine and its load, so they are only
+reported unless --cpu-tolerance is given.
+--update-baselines records the current results instead.
+
+Usage:
+  python3 demo/bench/run_benchmarks.py [--only discovery,pdr] [--capture FILE] ...
+"""
+import os
+import sys
+import json
+import time
+import base64
+import random
+import struct
+import signal
+import asyncio
+import argparse
+import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+
+import requests  # noqa: E402
+
+from harness import BenchServer, percentile, quiet_logger, write_resource  # noqa: E402
+from sim_endpoint import load_capture, make_endpoints, synthetic_capture  # noqa: E402
+from pty_endpoint import PtyEndpoint, device_rates  # noqa: E402
+from endpoint_db import write_endpoint_db  # noqa: E402
+from pdr_cache import PDRCache  # noqa: E402
+from pldm_mapping_wizard.serial_transport import SerialPort  # noqa: E402
+from pldm_mapping_wizard.discovery.link_negotiation import BAUD_RATES, TRANSFER_SIZES  # noqa: E402
+
+BASELINES = Path(__file__).resolve().parent / 'baselines.json'
+BENCHMARKS = ('discovery', 'pdr', 'cache', 'hotplug', 'redfish')
+
+# metric -> (unit, which way is better)
+METRICS = {
+    'discovery_wall_s': ('s', 'lower'),
+    'discovery_link_s': ('s', 'lower'),
+    'pdr_255_kib_per_s': ('KiB/s', 'higher'),
+    'pdr_1024_kib_per_s': ('KiB/s', 'higher'),
+    'pdr_255_spec_gain': ('x', 'higher'),
+    'pdr_1024_spec_gain': ('x', 'higher'),
+    'cache_cold_pdr_s': ('s', 'lower'),
+    'cache_warm_pdr_s': ('s', 'lower'),
+    'hotplug_enable_p50_ms': ('ms', 'lower'),
+    'hotplug_enable_p95_ms': ('ms', 'lower'),
+    'hotplug_remove_p50_ms': ('ms', 'lower'),
+    'redfish_get_rps': ('req/s', 'higher'),
+    'redfish_get_p99_ms': ('ms', 'lower'),
+    'redfish_patch_rps': ('req/s', 'higher'),
+    'redfish_patch_p99_ms': ('ms', 'lower'),
+}
+# Measured in real time on this machine rather than modelled link time
+CPU_BOUND = frozenset(m for m in METRICS if m.startswith('redfish_'))
+
+SENSORS_PER_CHASSIS = 16
+# The default (speculative) chain walk may trail speculate=False by this
+# fraction before the pdr benchmark reports an error
+SPECULATION_SLACK = 0.05
+
+
+class Serving:
+    """SimEndpoints on ptys for the duration of a `with` block."""
+
+    def __init__(self, sims):
+        self.sims = sims
+        self.ptys = []
+
+    def __enter__(self):
+        self.ptys = [PtyEndpoint(sim).start() for sim in self.sims]
+        return [pty.path for pty in self.ptys]
+
+    def __exit__(self, *exc):
+        for pty in self.ptys:
+            pty.close()
+
+
+def load_export_module():
+    import builtins
+    import collect_endpoints
+    # The export module routes print() through its debug log; keep ours
+    saved = builtins.print
+    try:
+        return collect_endpoints, collect_endpoints.load_export_module()
+    finally:
+        builtins.print = saved
+
+
+def build_mockup(root: Path, endpoints: int, state: str = 'Enabled'):
+    """Per endpoint an AutomationNode and a Chassis with Sensors, all carrying Status."""
+    v1 = root / 'redfish' / 'v1'
+    ids = [f'N{n}' for n in range(endpoints)]
+    write_resource(v1, {'@odata.id': '/redfish/v1', 'Chassis': {'@odata.id': '/redfish/v1/Chassis'},
+                        'AutomationNodes': {'@odata.id': '/redfish/v1/AutomationNodes'}})
+    for collection in ('Chassis', 'AutomationNodes'):
+        write_resource(v1 / collection, {'@odata.id': f'/redfish/v1/{collection}',
+                                         'Members': [{'@odata.id': f'/redfish/v1/{collection}/{i}'} for i in ids]})
+    for i in ids:
+        chassis = f'/redfish/v1/Chassis/{i}'
+        write_resource(v1 / 'AutomationNodes' / i, {'@odata.id': f'/redfish/v1/AutomationNodes/{i}', 'Id': i,
+                                                    'Status': {'State': state}})
+        write_resource(v1 / 'Chassis' / i, {'@odata.id': chassis, 'Id': i, 'Status': {'State': state},
+                                            'Sensors': {'@odata.id': f'{chassis}/Sensors'}})
+        sensors = [f'{chassis}/Sensors/SENSOR_ID_{sid}' for sid in range(SENSORS_PER_CHASSIS)]
+        write_resource(v1 / 'Chassis' / i / 'Sensors', {'@odata.id': f'{chassis}/Sensors',
+                                                        'Members': [{'@odata.id': s} for s in sensors]})
+        for sid, path in enumerate(sensors):
+            write_resource(v1 / 'Chassis' / i / 'Sensors' / f'SENSOR_ID_{sid}',
+                           {'@odata.id': path, 'Id': f'SENSOR_ID_{sid}', 'Reading': sid,
+                            'Status': {'State': state, 'Health': 'OK'}})
+    return ids
+
+
+def bench_discovery(args, captured):
+    collect_endpoints, mod = load_export_module()
+    sims = make_endpoints(captured, args.endpoints, baud_rates=device_rates(args.baud),
+                          latency=args.latency, error_rate=args.error_rate, seed=args.seed)
+    link_options = {'baud_rates': list(BAUD_RATES), 'transfer_sizes': list(TRANSFER_SIZES)}
+    with Serving(sims) as paths:
+        start = time.monotonic()
+        with ThreadPoolExecutor(max_workers=len(paths)) as pool:
+            fetched = list(pool.map(lambda path: collect_endpoints.fetch_endpoint(
+                {'path': path}, mod, SerialPort, None, link_options=link_options), paths))
+        wall = time.monotonic() - start
+    errors = []
+    for sim, (ep, pdrs, fru) in zip(sims, fetched):
+        if ep['error'] or len(pdrs) != len(sim.pdrs) or not fru or fru['actual_table'] != sim.fru:
+            errors.append(f"{ep['dev']}: {ep['error'] or f'{len(pdrs)}/{len(sim.pdrs)} PDRs, FRU mismatch'}")
+    link = sum(ep['timing']['link_s'] for ep, _, _ in fetched) / len(fetched)
+    return {'discovery_wall_s': wall, 'discovery_link_s': link}, errors
+
+
+def bench_pdr(args, captured):
+    _, mod = load_export_module()
+    sim, = make_endpoints(captured[:1], 1, baud_rates=[115200], latency=args.latency,
+                          error_rate=args.error_rate, seed=args.seed)
+    total = sum(len(r) for r in sim.pdrs.values())
+    results, errors = {}, []
+    with Serving([sim]) as (path,):
+        port = SerialPort(path, baudrate=115200, timeout=1.0)
+        if not port.open():
+            return {}, [f'{path}: failed to open']
+        try:
+            # The collector's path: the chain walk bounded by GetPDRRepositoryInfo
+            info, err = mod.get_pdr_repository_info(port)
+            if err:
+                return {}, [f'GetPDRRepositoryInfo: {err}']
+            for size in (255, 1024):
+                medians = {}
+                for speculate in (True, False):
+                    rates = []
+                    for _ in range(args.repeat):
+                        start = time.monotonic()
+                        records, err = mod.get_pdr_chain(port, request_count=size, speculate=speculate,
+                                                         expected_records=info['record_count'] or None,
+                                                         largest_record=info['largest_record_size'] or None)
+                        elapsed = time.monotonic() - start
+                        if err or len(records) != len(sim.pdrs):
+                            errors.append(f'{size}-byte parts: {err or f"{len(records)}/{len(sim.pdrs)} PDRs"}')
+                            break
+                        rates.append(total / 1024.0 / elapsed)
+                    if rates:
+                        medians[speculate] = percentile(rates, 50)
+                if True in medians:
+                    results[f'pdr_{size}_kib_per_s'] = medians[True]
+                if len(medians) == 2:
+                    gain = medians[True] / medians[False]
+                    results[f'pdr_{size}_spec_gain'] = gain
+                    if gain < 1.0 - SPECULATION_SLACK:
+                        errors.append(f'{size}-byte parts: speculation is slower than none '
+                                      f'({medians[True]:.2f} vs {medians[False]:.2f} KiB/s)')
+        finally:
+            port.close()
+    return results, errors
+
+
+def bench_cache(args, captured):
+    collect_endpoints, mod = load_export_module()
+    results, errors = {}, []
+    for clock in (True, False):
+        sim, = make_endpoints(captured[:1], 1, baud_rates=[115200], latency=args.latency,
+                              error_rate=args.error_rate, seed=args.seed, clock=clock)
+        label = 'clock' if clock else 'no clock'
+        with tempfile.TemporaryDirectory() as cache_dir, Serving([sim]) as (path,):
+            cache = PDRCache(cache_dir)
+
+            def fetch():
+                walked = sim.commands.get((2, 0x51), 0)
+                ep, pdrs, _ = collect_endpoints.fetch_endpoint({'path': path}, mod, SerialPort, cache)
+                chain = [sim.pdrs[h] for h in sim._chain]
+                if ep['error'] or [bytes(r['pdr_data']) for r in pdrs] != chain:
+                    errors.append(f"{label}: {ep['error'] or f'{len(pdrs)}/{len(chain)} PDRs or stale data'}")
+                return ep['timing']['pdr_s'], sim.commands.get((2, 0x51), 0) > walked
+
+            cold, walked = fetch()
+            if not walked:
+                errors.append(f'{label}: cold start did not walk the PDR chain')
+            warm, walked = fetch()
+            if walked:
+                errors.append(f'{label}: warm start walked an unchanged PDR chain')
+            if clock:
+                results['cache_cold_pdr_s'], results['cache_warm_pdr_s'] = cold, warm
+
+            # Change one PDR: same size with a clock (only UpdateTime moves),
+            # longer without one (only RecordCount/RepositorySize can tell)
+            handle = sim._chain[len(sim._chain) // 2]
+            record = bytearray(sim.pdrs[handle])
+            if clock:
+                record[-1] ^= 0xFF
+            else:
+                record += b'\x00' * 4
+                record[8:10] = struct.pack('<H', len(record) - 10)
+            sim.replace_pdr(handle, bytes(record))
+            _, walked = fetch()
+            if not walked:
+                errors.append(f'{label}: warm start served stale PDRs after a PDR changed')
+    return results, errors
+
+
+class SimBus:
+    """Stands in for sysfs and netlink: ports the agent takes for USB serial adapters.
+
+    install() replaces the agent's uevent listener and its sysfs scan;
+    plug() and unplug() deliver add and remove uevents to its event loop.
+    """
+
+    def __init__(self, agent_module):
+        self.agent = agent_module
+        self.plugged = {}  # port id -> device path
+        self.ready = threading.Event()
+        self._loop = None
+        self._callback = None
+        self._saved = None
+
+    def install(self):
+        bus = self
+
+        class Listener:
+            def __init__(self, logger, callback, tty_prefixes=('ttyUSB',)):
+                bus._callback = callback
+
+            def open(self):
+                return True
+
+            def attach(self, loop):
+                bus._loop = loop
+
+            def close(self):
+                pass
+
+        class Monitor(self.agent.USBPortMonitor):
+            def scan_usb_ports(self):
+                for port, device in bus.plugged.items():
+                    self.port_to_device[port] = device
+                bus.ready.set()
+                return dict(bus.plugged)
+
+        self._saved = (self.agent.UeventListener, self.agent.USBPortMonitor)
+        self.agent.UeventListener, self.agent.USBPortMonitor = Listener, Monitor
+
+    def uninstall(self):
+        if self._saved:
+            self.agent.UeventListener, self.agent.USBPortMonitor = self._saved
+            self._saved = None
+
+    def plug(self, port: str, device: str):
+        self.plugged[port] = device
+        self._loop.call_soon_threadsafe(self._callback, 'add', port, device)
+
+    def unplug(self, port: str):
+        device = self.plugged.pop(port)
+        self._loop.call_soon_threadsafe(self._callback, 'remove', port, device)
+
+
+def _wait_for_state(store, paths, state, started, timeout=10.0):
+    """Milliseconds from `started` until each path's Status.State is `state`."""
+    pending, done = set(paths), {}
+    deadline = started + timeout
+    while pending and time.monotonic() < deadline:
+        for path in list(pending):
+            found = store.lookup(path)
+            if found and json.loads(found[0]).get('Status', {}).get('State') == state:
+                done[path] = (time.monotonic() - started) * 1000.0
+                pending.discard(path)
+        time.sleep(0.002)
+    return done, pending
+
+
+def bench_hotplug(args, captured):
+    import runtime_agent
+    from shared import ConfigManager
+
+    logger = quiet_logger('bench.agent')
+    count = args.hotplug_endpoints
+    sims = make_endpoints(captured, count, latency=args.latency, error_rate=args.error_rate, seed=args.seed)
+    work = Path(tempfile.mkdtemp(prefix='hotplug-bench-'))
+    ids = build_mockup(work / 'mockup', count, state='UnavailableOffline')
+    server = BenchServer(work / 'mockup', logger)
+    ports = [f'9-1.{n + 1}' for n in range(count)]
+    chassis = [f'/redfish/v1/Chassis/{i}' for i in ids]
+    enable_ms, remove_ms, errors = [], [], []
+    bus = SimBus(runtime_agent)
+
+    with Serving(sims) as paths:
+        write_endpoint_db(work / 'endpoints.db', [{
+            'dev': path, 'bus_port': port, 'resource_id': rid,
+            'resource_path': f'/redfish/v1/AutomationNodes/{rid}',
+            'raw_fru_data': base64.b64encode(sim.fru).decode('ascii'),
+            'pdr_records': [{'handle': h, 'pdr_data': data.hex()} for h, data in sim.pdrs.items()],
+        } for path, port, rid, sim in zip(paths, ports, ids, sims)])
+        (work / 'agent.ini').write_text(
+            f"[server]\nhost = 127.0.0.1\nport = {server.url.rsplit(':', 1)[1]}\n"
+            f"[configurator]\npdr_output = {work / 'endpoints.db'}\n"
+            "[agent]\npoll_interval = 1\nhotplug_backend = netlink\nhotplug_resync_interval = 3600\n"
+            "state_file =\nmetrics_interval = 0\n"
+            f"[probe]\nworkers = {min(4, count)}\ntimeout = 1\n"
+            "[sensors]\nenabled = false\n[controls]\nenabled = false\n")
+        config = ConfigManager(work / 'agent.ini')
+        config.load()
+
+        def drive():
+            try:
+                if not bus.ready.wait(10):
+                    errors.append('agent did not start')
+                    return
+                for _ in range(args.cycles):
+                    started = time.monotonic()
+                    for sim, port, path in zip(sims, ports, paths):
+                        sim.online = True
+                        bus.plug(port, path)
+                    done, pending = _wait_for_state(server.store, chassis, 'Enabled', started)
+                    enable_ms.extend(done.values())
+                    errors.extend(f'{p} not Enabled' for p in sorted(pending))
+                    started = time.monotonic()
+                    for sim, port in zip(sims, ports):
+                        sim.online = False
+                        bus.unplug(port)
+                    done, pending = _wait_for_state(server.store, chassis, 'UnavailableOffline', started)
+                    remove_ms.extend(done.values())
+                    errors.extend(f'{p} not UnavailableOffline' for p in sorted(pending))
+            except Exception as e:
+                errors.append(f'driver: {e}')
+            finally:
+                # The agent stops on SIGINT, as it does under start.sh
+                os.kill(os.getpid(), signal.SIGINT)
+
+        bus.install()
+        driver = threading.Thread(target=drive, name='hotplug-driver', daemon=True)
+        try:
+            driver.start()
+            # GracefulShutdown installs signal handlers, so the agent needs the main thread
+            asyncio.run(runtime_agent.run_agent(config, logger))
+        finally:
+            bus.uninstall()
+            signal.signal(signal.SIGINT, signal.default_int_handler)
+            signal.signal(signal.SIGTERM, signal.SIG_DFL)
+            driver.join(timeout=5)
+            server.close()
+
+    results = {}
+    if enable_ms:
+        results['hotplug_enable_p50_ms'] = percentile(enable_ms, 50)
+        results['hotplug_enable_p95_ms'] = percentile(enable_ms, 95)
+    if remove_ms:
+        results['hotplug_remove_p50_ms'] = percentile(remove_ms, 50)
+    return results, errors
+
+
+def _load(server_url, clients, duration, request):
+    """Run `request(session, rng)` from `clients` threads for `duration` s: (req/s, latencies, failures)."""
+    latencies, failures = [], [0]
+    lock = threading.Lock()
+    stop = time.monotonic() + duration
+
+    def client(n):
+        session, rng, mine, failed = requests.Session(), random.Random(n), [], 0
+        while time.monotonic() < stop:
+            start = time.perf_counter()
+            if request(session, rng).status_code == 200:
+                mine.append((time.perf_counter() - start) * 1000.0)
+            else:
+                failed += 1
+        with lock:
+            latencies.extend(mine)
+            failures[0] += failed
+
+    started = time.monotonic()
+    with ThreadPoolExecutor(max_workers=clients) as pool:
+        list(pool.map(client, range(clients)))
+    return len(latencies) / (time.monotonic() - started), latencies, failures[0]
+
+
+def bench_redfish(args, captured):
+    logger = quiet_logger('bench.redfish')
+    work = Path(tempfile.mkdtemp(prefix='redfish-bench-'))
+    ids = build_mockup(work / 'mockup', args.endpoints)
+    sensors = [f'/redfish/v1/Chassis/{i}/Sensors/SENSOR_ID_{sid}' for i in ids for sid in range(SENSORS_PER_CHASSIS)]
+    server = BenchServer(work / 'mockup', logger, workers=max(16, args.clients))
+    results, errors = {}, []
+    try:
+        url = server.url
+        rps, latencies, failed = _load(url, args.clients, args.duration,
+                                       lambda s, rng: s.get(url + rng.choice(sensors), timeout=5))
+        results.update(redfish_get_rps=rps, redfish_get_p99_ms=percentile(latencies, 99) if latencies else None)
+        if failed:
+            errors.append(f'{failed} GETs failed')
+        states = ('Enabled', 'StandbyOffline')
+        rps, latencies, failed = _load(url, args.clients, args.duration, lambda s, rng: s.patch(
+            url + rng.choice(sensors), json={'Status': {'State': rng.choice(states)}}, timeout=5))
+        results.update(redfish_patch_rps=rps, redfish_patch_p99_ms=percentile(latencies, 99) if latencies else None)
+        if failed:
+            errors.append(f'{failed} PATCHes failed')
+    finally:
+        server.close()
+    return {k: v for k, v in results.items() if v is not None}, errors
+
+
+RUNNERS = {'discovery': bench_discovery, 'pdr': bench_pdr, 'cache': bench_cache, 'hotplug': bench_hotplug,
+           'redfish': bench_redfish}
+
+
+def compare(results: dict, baseline: dict, tolerance: float, cpu_tolerance: float = None):
+    """[(metric, value, baseline value, relative change, regressed)] in METRICS order.
+
+    CPU_BOUND metrics are held to `cpu_tolerance`, and never regress when it is None.
+    """
+    rows = []
+    for metric in METRICS:
+        if metric not in results:
+            continue
+        value, base = results[metric], baseline.get(metric)
+        if not base:
+            rows.append((metric, value, None, None, False))
+            continue
+        change = (value - base) / base
+        allowed = cpu_tolerance if metric in CPU_BOUND else tolerance
+        if allowed is None:
+            worse = False
+        else:
+            worse = change > allowed if METRICS[metric][1] == 'lower' else change < -allowed
+        rows.append((metric, value, base, change, worse))
+    return rows
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--only', default=','.join(BENCHMARKS), help='comma-separated benchmarks to run')
+    parser.add_argument('--capture', default=None, help='pdr_and_fru_records.json or endpoint store to serve')
+    parser.add_argument('--endpoints', type=int, default=4, help='endpoints discovered / Chassis served')
+    parser.add_argument('--baud', type=int, default=460800, help='fastest rate the endpoints accept')
+    parser.add_argument('--latency', type=float, default=0.001, help='device processing time per request (s)')
+    parser.add_argument('--error-rate', type=float, default=0.0, help='fraction of reply packets with a bad FCS')
+    parser.add_argument('--seed', type=int, default=1, help='seed for injected errors')
+    parser.add_argument('--repeat', type=int, default=3, help='PDR downloads per part size')
+    parser.add_argument('--hotplug-endpoints', type=int, default=4, help='ports plugged at once')
+    parser.add_argument('--cycles', type=int, default=5, help='plug/unplug cycles')
+    parser.add_argument('--clients', type=int, default=8, help='concurrent Redfish clients')
+    parser.add_argument('--duration', type=float, default=2.0, help='seconds per Redfish load')
+    parser.add_argument('--tolerance', type=float, default=0.3, help='allowed regression vs. baseline (fraction)')
+    parser.add_argument('--cpu-tolerance', type=float, default=None,
+                        help='allowed regression of the CPU-bound redfish metrics (default: not gated)')
+    parser.add_argument('--baselines', default=str(BASELINES), help='baseline file')
+    parser.add_argument('--update-baselines', action='store_true', help='record these results as the baseline')
+    parser.add_argument('--json', default=None, help='also write the results to this file')
+    args = parser.parse_args()
+
+    selected = [b.strip() for b in args.only.split(',') if b.strip()]
+    unknown = [b for b in selected if b not in RUNNERS]
+    if unknown:
+        parser.error(f"unknown benchmark(s): {', '.join(unknown)}")
+    captured = load_capture(args.capture) if args.capture else [synthetic_capture()]
+    if not captured:
+        print(f"No endpoints with PDRs in {args.capture}")
+        return 1
+    settings = {
+        'capture': Path(args.capture).name if args.capture else 'synthetic',
+        'endpoints': args.endpoints, 'baud': args.baud, 'latency': args.latency,
+        'error_rate': args.error_rate, 'hotplug_endpoints': args.hotplug_endpoints,
+        'clients': args.clients,
+    }
+
+    results, failures = {}, []
+    for name in selected:
+        start = time.monotonic()
+        measured, errors = RUNNERS[name](args, captured)
+        results.update(measured)
+        failures.extend(f'{name}: {e}' for e in errors)
+        print(f"  {name} done in {time.monotonic() - start:.1f}s" + (f", {len(errors)} errors" if errors else ''))
+
+    baseline_path = Path(args.baselines)
+    stored = json.loads(baseline_path.read_text()) if baseline_path.exists() else {}
+    comparable = stored.get('settings') == settings
+    rows = compare(results, stored.get('metrics', {}) if comparable else {}, args.tolerance, args.cpu_tolerance)
+    print(f"\nBenchmarks ({settings['capture']} capture, {args.baud} baud max, {args.latency * 1000:g} ms latency, "
+          f"error rate {args.error_rate:g}):")
+    for metric, value, base, change, worse in rows:
+        unit = METRICS[metric][0]
+        against = f"baseline {base:.3f} ({change:+.0%})" if base else 'no baseline'
+        if base and metric in CPU_BOUND and args.cpu_tolerance is None:
+            against += ', not gated'
+        print(f"  {metric:24} {value:10.3f} {unit:6} {against}{'  REGRESSION' if worse else ''}")
+    for failure in failures:
+        print(f"  ERROR {failure}")
+    if stored and not comparable and not args.update_baselines:
+        print(f"  (baseline in {baseline_path.name} was recorded with other settings; not compared)")
+
+    if args.json:
+        Path(args.json).write_text(json.dumps({'settings': settings, 'metrics': results, 'errors': failures}, indent=2))
+    if args.update_baselines:
+        if failures:
+            print("Not updating baselines: the run had errors")
+            return 1
+        metrics = dict(stored.get('metrics', {})) if comparable else {}
+        metrics.update({k: round(v, 3) for k, v in results.items()})
+        baseline_path.write_text(json.dumps({'settings': settings, 'metrics': metrics}, indent=2) + '\n')
+        print(f"Baselines written to {baseline_path}")
+        return 0
+    return 1 if failures or any(row[4] for row in rows) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,444 @@
+#!/usr/bin/env python3
+"""
+In-memory PLDM endpoint for benchmarks.
+
+SimEndpoint stands in for the pyserial object behind a SerialPort: it decodes
+the MCTP serial frames written to it and answers the PLDM commands the
+collector and the runtime agent issue: GetTID, NegotiateTransferParameters,
+GetPDRRepositoryInfo, GetPDR, GetFRURecordTableMetadata, GetFRURecordTable,
+GetSensorReading, GetStateSensorReadings, SetNumericEffecterValue and
+SetStateEffecterStates. PDRs and the FRU record table usually come from a
+captured endpoint (see from_capture() and load_capture()).
+
+Replies become readable after the time the request and response take on the
+wire at `baudrate` (10 bits per byte) plus `latency` seconds of device
+processing, so link contention between subsystems is reproduced without
+hardware. An endpoint given `baud_rates` stays silent at any other rate, the
+way a device does when the line speeds disagree, and `error_rate` corrupts
+that fraction of reply packets so their FCS fails.
+
+GetPDRRepositoryInfo reports the repository's UpdateTime, which
+replace_pdr() advances; an endpoint created with clock=False has no
+real-time clock and keeps a zero UpdateTime, as many small devices do.
+
+pty_endpoint.PtyEndpoint serves a SimEndpoint on a pseudo-terminal for tools
+that open a device path.
+"""
+import sys
+import json
+import time
+import datetime
+import zlib
+import base64
+import heapq
+import random
+import struct
+import itertools
+import threading
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parents[1] / 'pldm_tools'))
+from endpoint_db import load_endpoints  # noqa: E402
+from pldm_mapping_wizard.serial_transport import MCTPFramer, MCTPFrameDecoder, SerialPort  # noqa: E402
+from pldm_mapping_wizard.discovery import fru_reader  # noqa: E402
+
+# PLDM completion codes (DSP0240 generic codes, DSP0248 command-specific codes)
+CC_SUCCESS = 0x00
+CC_ERROR_INVALID_DATA = 0x02
+CC_ERROR_UNSUPPORTED_PLDM_CMD = 0x05
+CC_INVALID_EFFECTER_ID = 0x80
+CC_INVALID_SENSOR_ID = 0x80
+CC_INVALID_RECORD_HANDLE = 0x82
+CC_INVALID_DATA_TRANSFER_HANDLE = 0x80
+CC_NO_FRU_DATA_STRUCTURE_TABLE = 0x83
+
+BITS_PER_BYTE = 10
+
+# effecterDataSize -> struct format (DSP0248 Table 88)
+DATA_SIZE_FORMATS = {0: '<B', 1: '<b', 2: '<H', 3: '<h', 4: '<I', 5: '<i'}
+
+# GetPDRRepositoryInfo RepositoryState (DSP0248 Table 68)
+REPOSITORY_AVAILABLE = 0
+# Reported DataTransferHandleTimeout (seconds)
+DATA_TRANSFER_HANDLE_TIMEOUT = 5
+
+# GetPDR transferFlag (DSP0248 Table 69) and GetFRURecordTable transferFlag (DSP0257)
+PDR_START, PDR_MIDDLE, PDR_END, PDR_START_AND_END = 0x00, 0x01, 0x04, 0x05
+FRU_START, FRU_MIDDLE, FRU_END, FRU_START_AND_END = 0x01, 0x02, 0x04, 0x05
+
+PLDM_TYPE_FRU = 4
+
+# GetFRURecordTable part size before NegotiateTransferParameters; fru_part_size
+# is the largest part the endpoint agrees to, which can span several packets
+DEFAULT_FRU_PART = 128
+
+
+class SimEndpoint:
+    """Serial-like object answering PLDM requests with modelled link timing."""
+
+    def __init__(self, baudrate: int = 115200, latency: float = 0.001, numeric=None, state=None,
+                 numeric_effecters=None, state_effecters=None, eid: int = 0, pdrs=None, fru: bytes = None,
+                 baud_rates=None, error_rate: float = 0.0, pdr_part_size: int = 1024,
+                 fru_part_size: int = 1024, seed=None, clock: bool = True):
+        self.is_open = True
+        self.timeout = 1.0
+        self.baudrate = baudrate
+        self.latency = latency
+        self.eid = eid
+        self.numeric = dict(numeric or {})            # sensorID -> uint16 reading (or callable)
+        self.state = dict(state or {})                # sensorID -> state (or callable)
+        self.numeric_effecters = dict(numeric_effecters or {})  # effecterID -> (dataSize, min, max)
+        self.state_effecters = dict(state_effecters or {})      # effecterID -> compositeCount
+        self.effecter_values = {}
+        self.commands = {}
+        # Records in chain order, each with its common header; handles from the header
+        self.pdrs = {struct.unpack_from('<I', r)[0]: bytes(r) for r in (pdrs or []) if len(r) >= 10}
+        self._chain = list(self.pdrs)
+        self.clock = clock
+        self.update_time = timestamp104() if clock else bytes(13)
+        self.fru = bytes(fru) if fru else None
+        self.baud_rates = frozenset(int(r) for r in baud_rates) if baud_rates else None
+        self.error_rate = float(error_rate)
+        self.pdr_part_size = max(1, int(pdr_part_size))
+        self.fru_part_size = max(1, int(fru_part_size))
+        self._fru_part = min(DEFAULT_FRU_PART, self.fru_part_size)
+        self.online = True  # False: present on the bus but not answering (unplugged)
+        self.stats = {'requests': 0, 'replies': 0, 'corrupted': 0, 'ignored': 0}
+        self._random = random.Random(seed)
+        self._decoder = MCTPFrameDecoder()
+        self._out = []  # heap of (ready_time, seq, frame)
+        self._seq = itertools.count()
+        self._buf = bytearray()
+        self._line_free = 0.0
+        self._cond = threading.Condition()
+
+    @classmethod
+    def from_capture(cls, endpoint: dict, **kwargs) -> 'SimEndpoint':
+        """An endpoint serving the PDRs and FRU of a captured endpoint dict."""
+        pdrs, fru = capture_records(endpoint)
+        return cls(pdrs=pdrs, fru=fru, **kwargs)
+
+    def _wire(self, n: int) -> float:
+        return n * BITS_PER_BYTE / float(self.baudrate)
+
+    def _corrupt(self, frame: bytes) -> bytes:
+        # Flip a bit of the FCS, avoiding the framing and escape characters
+        frame = bytearray(frame)
+        i = len(frame) - 2
+        frame[i] ^= 0x01 if frame[i] ^ 0x01 not in (MCTPFramer.FRAME_CHAR, MCTPFramer.ESCAPE_CHAR) else 0x02
+        return bytes(frame)
+
+    def write(self, data: bytes):
+        now = time.monotonic()
+        with self._cond:
+            for raw in self._decoder.feed(data):
+                packet = MCTPFramer.parse_frame(raw)
+                if not packet or not packet['fcs_ok']:
+                    continue
+                self.stats['requests'] += 1
+                if not self.online or (self.baud_rates is not None and self.baudrate not in self.baud_rates):
+                    self.stats['ignored'] += 1
+                    continue
+                reply = self.handle(packet)
+                if reply is None:
+                    continue
+                self.stats['replies'] += 1
+                if len(reply) + 1 > MCTPFramer.MAX_PACKET_PAYLOAD:
+                    frames = MCTPFramer.build_frames(reply, packet['src'], self.eid, tag_owner=False)
+                else:
+                    frames = [MCTPFramer.build_frame(reply, packet['src'], self.eid)]
+                # Request arrives, is processed, then the reply occupies the line
+                self._line_free = max(now + self._wire(len(raw)) + self.latency, self._line_free)
+                for frame in frames:
+                    if self.error_rate and self._random.random() < self.error_rate:
+                        self.stats['corrupted'] += 1
+                        frame = self._corrupt(frame)
+                    self._line_free += self._wire(len(frame))
+                    heapq.heappush(self._out, (self._line_free, next(self._seq), frame))
+            self._cond.notify_all()
+        return len(data)
+
+    def flush(self):
+        pass
+
+    def handle(self, packet):
+        """PLDM reply bytes for one request packet (None to stay silent)."""
+        pldm_type, cmd, extra = packet['type'], packet['cmd_code'], packet['extra']
+        self.commands[(pldm_type, cmd)] = self.commands.get((pldm_type, cmd), 0) + 1
+        header = bytes([packet['instance'] & 0x1F, pldm_type, cmd])
+        if pldm_type == 0 and cmd == 0x02:  # GetTID
+            return header + bytes([CC_SUCCESS, 1])
+        if pldm_type == 0 and cmd == 0x07:  # NegotiateTransferParameters
+            return header + self._negotiate_transfer_parameters(extra)
+        if pldm_type == PLDM_TYPE_FRU:
+            return header + self._fru_command(cmd, extra)
+        if pldm_type == 2 and cmd == 0x50:  # GetPDRRepositoryInfo
+            return header + self._repository_info()
+        if pldm_type == 2 and cmd == 0x51:  # GetPDR
+            return header + self._get_pdr(extra)
+        if pldm_type != 2 or len(extra) < 2:
+            return header + bytes([CC_ERROR_UNSUPPORTED_PLDM_CMD])
+        ident = struct.unpack_from('<H', extra)[0]
+        if cmd == 0x11:  # GetSensorReading
+            if ident not in self.numeric:
+                return header + bytes([CC_INVALID_SENSOR_ID])
+            value = self.numeric[ident]
+            value = value() if callable(value) else value
+            return header + bytes([CC_SUCCESS, 0x02, 0, 0, 1, 1, 0]) + struct.pack('<H', int(value) & 0xFFFF)
+        if cmd == 0x21:  # GetStateSensorReadings
+            if ident not in self.state:
+                return header + bytes([CC_INVALID_SENSOR_ID])
+            value = self.state[ident]
+            value = value() if callable(value) else value
+            return header + bytes([CC_SUCCESS, 1, 0, value, value, 0])
+        if cmd == 0x31:  # SetNumericEffecterValue
+            if ident not in self.numeric_effecters:
+                return header + bytes([CC_INVALID_EFFECTER_ID])
+            data_size, low, high = self.numeric_effecters[ident]
+            fmt = DATA_SIZE_FORMATS.get(extra[2]) if len(extra) > 2 else None
+            if extra[2:3] != bytes([data_size]) or fmt is None or len(extra) < 3 + struct.calcsize(fmt):
+                return header + bytes([CC_ERROR_INVALID_DATA])
+            value = struct.unpack_from(fmt, extra, 3)[0]
+            if not low <= value <= high:
+                return header + bytes([CC_ERROR_INVALID_DATA])
+            self.effecter_values[ident] = value
+            return header + bytes([CC_SUCCESS])
+        if cmd == 0x39:  # SetStateEffecterStates
+            count = self.state_effecters.get(ident)
+            if count is None:
+                return header + bytes([CC_INVALID_EFFECTER_ID])
+            if len(extra) < 3 or extra[2] != count or len(extra) < 3 + 2 * count:
+                return header + bytes([CC_ERROR_INVALID_DATA])
+            states = [extra[4 + 2 * i] if extra[3 + 2 * i] else None for i in range(count)]
+            self.effecter_values[ident] = states
+            return header + bytes([CC_SUCCESS])
+        return header + bytes([CC_ERROR_UNSUPPORTED_PLDM_CMD])
+
+    def _negotiate_transfer_parameters(self, extra: bytes) -> bytes:
+        if len(extra) < 10:
+            return bytes([CC_ERROR_INVALID_DATA])
+        part_size, support = struct.unpack_from('<HQ', extra)
+        if support & (1 << PLDM_TYPE_FRU) and self.fru:
+            self._fru_part = max(1, min(part_size, self.fru_part_size))
+            support = 1 << PLDM_TYPE_FRU
+        else:
+            support = 0
+        return bytes([CC_SUCCESS]) + struct.pack('<HQ', self._fru_part, support)
+
+    def replace_pdr(self, handle: int, record: bytes):
+        """Change one PDR in place (keeping its chain position), as a firmware update would."""
+        if handle not in self.pdrs:
+            raise KeyError(handle)
+        with self._cond:
+            self.pdrs[handle] = bytes(record)
+            if self.clock:
+                self.update_time = timestamp104()
+
+    def _repository_info(self) -> bytes:
+        # DSP0248 Table 68; OEMUpdateTime is left unset
+        sizes = [len(r) for r in self.pdrs.values()]
+        return (bytes([CC_SUCCESS, REPOSITORY_AVAILABLE]) + self.update_time + bytes(13)
+                + struct.pack('<IIIB', len(sizes), sum(sizes), max(sizes, default=0), DATA_TRANSFER_HANDLE_TIMEOUT))
+
+    def _get_pdr(self, extra: bytes) -> bytes:
+        if len(extra) < 13:
+            return bytes([CC_ERROR_INVALID_DATA])
+        handle, transfer_handle, op_flag, count, _ = struct.unpack_from('<IIBHH', extra)
+        if handle == 0 and self._chain:
+            handle = self._chain[0]
+        record = self.pdrs.get(handle)
+        if record is None:
+            return bytes([CC_INVALID_RECORD_HANDLE])
+        # GetFirstPart (0x01) starts at 0; GetNextPart carries the offset as transfer handle
+        offset = 0 if op_flag == 0x01 else transfer_handle
+        if offset >= len(record):
+            return bytes([CC_INVALID_DATA_TRANSFER_HANDLE])
+        part = record[offset:offset + min(count, self.pdr_part_size)]
+        end = offset + len(part)
+        index = self._chain.index(handle)
+        next_handle = self._chain[index + 1] if index + 1 < len(self._chain) else 0
+        if end >= len(record):
+            flag, next_transfer = (PDR_START_AND_END if offset == 0 else PDR_END), 0
+        else:
+            flag, next_transfer = (PDR_START if offset == 0 else PDR_MIDDLE), end
+        return bytes([CC_SUCCESS]) + struct.pack('<IIBH', next_handle, next_transfer, flag, len(part)) + part
+
+    def _fru_command(self, cmd: int, extra: bytes) -> bytes:
+        if self.fru is None:
+            return bytes([CC_NO_FRU_DATA_STRUCTURE_TABLE if cmd in (0x01, 0x02) else CC_ERROR_UNSUPPORTED_PLDM_CMD])
+        if cmd == 0x01:  # GetFRURecordTableMetadata
+            stream = fru_reader.FRUTableStream()
+            stream.feed(self.fru)
+            stream.finish()
+            return bytes([CC_SUCCESS, 1, 0]) + struct.pack(
+                '<IIHHI', len(self.fru), len(self.fru), len({r[0] for r in stream.records}),
+                len(stream.records), zlib.crc32(self.fru) & 0xFFFFFFFF)
+        if cmd == 0x02:  # GetFRURecordTable
+            if len(extra) < 5:
+                return bytes([CC_ERROR_INVALID_DATA])
+            transfer_handle, operation = struct.unpack_from('<IB', extra)
+            offset = 0 if operation == 0x00 else transfer_handle
+            if offset >= len(self.fru):
+                return bytes([CC_INVALID_DATA_TRANSFER_HANDLE])
+            part = self.fru[offset:offset + self._fru_part]
+            end = offset + len(part)
+            if end >= len(self.fru):
+                flag, next_transfer = (FRU_START_AND_END if offset == 0 else FRU_END), 0
+            else:
+                flag, next_transfer = (FRU_START if offset == 0 else FRU_MIDDLE), end
+            return bytes([CC_SUCCESS]) + struct.pack('<IB', next_transfer, flag) + part
+        return bytes([CC_ERROR_UNSUPPORTED_PLDM_CMD])
+
+    def next_ready(self):
+        """Monotonic time at which the next queued reply byte arrives, or None."""
+        with self._cond:
+            return self._out[0][0] if self._out else None
+
+    def _pump(self):
+        now = time.monotonic()
+        while self._out and self._out[0][0] <= now:
+            self._buf += heapq.heappop(self._out)[2]
+
+    @property
+    def in_waiting(self) -> int:
+        with self._cond:
+            self._pump()
+            return len(self._buf)
+
+    def read(self, size: int = 1) -> bytes:
+        deadline = time.monotonic() + (self.timeout or 0)
+        with self._cond:
+            while True:
+                self._pump()
+                now = time.monotonic()
+                if self._buf or now >= deadline:
+                    break
+                ready = self._out[0][0] if self._out else deadline
+                self._cond.wait(max(0.0, min(ready, deadline) - now))
+            data = bytes(self._buf[:size])
+            del self._buf[:size]
+            return data
+
+    def reset_input_buffer(self):
+        with self._cond:
+            self._buf.clear()
+
+    def close(self):
+        self.is_open = False
+
+
+def sim_serial_port_cls(endpoints):
+    """A SerialPort subclass whose open() attaches endpoints[device] instead of a tty."""
+
+    class SimSerialPort(SerialPort):
+        def open(self) -> bool:
+            endpoint = endpoints.get(self.port)
+            if endpoint is None:
+                return False
+            endpoint.is_open = True
+            endpoint.baudrate = self.baudrate
+            endpoint.timeout = self.timeout
+            self.serial = endpoint
+            return True
+
+    return SimSerialPort
+
+
+def timestamp104(when: datetime.datetime = None) -> bytes:
+    """DSP0240 timestamp104 of `when` (default now) with a zero UTC offset."""
+    when = when or datetime.datetime.now(datetime.timezone.utc)
+    return (struct.pack('<h', 0) + when.microsecond.to_bytes(3, 'little')
+            + bytes([when.second, when.minute, when.hour, when.day, when.month])
+            + struct.pack('<H', when.year) + bytes([0]))
+
+
+def capture_records(endpoint: dict):
+    """(PDRs in chain order, raw FRU record table) of a captured endpoint dict.
+
+    Accepts the collector's JSON layout (hex pdr_data, base64 raw_fru_data)
+    and endpoints read back from an endpoint store.
+    """
+    pdrs = []
+    for record in endpoint.get('pdr_records') or []:
+        data = record.get('pdr_data') if isinstance(record, dict) else None
+        if isinstance(data, str):
+            data = bytes.fromhex(data)
+        if data:
+            pdrs.append(bytes(data))
+    fru = endpoint.get('raw_fru_data')
+    return pdrs, (base64.b64decode(fru) if fru else None)
+
+
+def load_capture(path) -> list:
+    """Endpoints of a pdr_and_fru_records.json capture (or endpoint store)."""
+    return [ep for ep in load_endpoints(path) if isinstance(ep, dict) and ep.get('pdr_records')]
+
+
+def with_serial(fru: bytes, serial: str) -> bytes:
+    """`fru` with its General record Serial Number replaced by `serial`.
+
+    Lets one captured FRU stand in for several distinct devices. A table
+    without a serial number is returned unchanged.
+    """
+    stream = fru_reader.FRUTableStream()
+    stream.feed(fru)
+    stream.finish()
+    if fru_reader.SERIAL_NUMBER not in stream.fields:
+        return fru
+    value = serial.encode('ascii')[:255]
+    out, replaced = bytearray(), False
+    for set_id, record_type, num_fields, encoding, fields in stream.records:
+        out += fru_reader.RECORD_HEADER.pack(set_id, record_type, num_fields, encoding)
+        for field_type, _, start, end in fields:
+            data = fru[start:end]
+            if not replaced and (record_type, field_type) == fru_reader.SERIAL_NUMBER:
+                data, replaced = value, True
+            out += bytes([field_type, len(data)]) + data
+    return bytes(out) + fru[stream.consumed:]
+
+
+def make_endpoints(captured: list, count: int, **kwargs) -> list:
+    """`count` SimEndpoints cycling through the captured endpoints.
+
+    When there are more endpoints than captures, each gets its own serial
+    number so the agent can tell the copies apart by FRU.
+    """
+    endpoints = []
+    for n in range(count):
+        sim = SimEndpoint.from_capture(captured[n % len(captured)], **kwargs)
+        if count > len(captured) and sim.fru:
+            sim.fru = with_serial(sim.fru, f'SIM{n:04d}')
+        endpoints.append(sim)
+    return endpoints
+
+
+def synthetic_capture(pdr_count: int = 60, serial: str = 'SIM0001', seed: int = 1) -> dict:
+    """A captured-endpoint dict with generated PDRs and a General FRU record.
+
+    The PDRs are OEM PDRs (type 127) of 20 to 600 bytes, so at 255-byte parts
+    about one in three needs a multi-part GetPDR, and the FRU record table is
+    larger than one serial packet. Used when no capture file
+    is given; the same arguments always give the same bytes.
+    """
+    rng = random.Random(seed)
+    records = []
+    for n in range(pdr_count):
+        handle = n + 1
+        body = bytes(rng.randrange(256) for _ in range(rng.choice((20, 40, 80, 160, 320, 600))))
+        records.append({'handle': handle, 'next_handle': handle + 1 if n + 1 < pdr_count else 0,
+                        'pdr_data': (struct.pack('<IBBHH', handle, 1, 127, 0, len(body)) + body).hex()})
+    fields = [(2, b'SIM-NODE'), (3, b'PICMG-SIM-01'), (4, serial.encode('ascii')), (5, b'PICMG'),
+              (8, b'Simulated PLDM endpoint'), (10, b'1.0'),
+              (12, b'Software endpoint for the benchmark suite; serves generated PDRs and this FRU'),
+              (14, b'Padding so that the table (about 420 bytes) is larger than one serial packet: a '
+                   b'negotiated FRU part of 512 or 1024 bytes then arrives as a multi-packet response, '
+                   b'which the collector has to reassemble before it sees the whole table.')]
+    fru = fru_reader.RECORD_HEADER.pack(1, 1, len(fields), 1) + b''.join(
+        bytes([t, len(v)]) + v for t, v in fields)
+    return {'dev': 'sim', 'pdr_records': records, 'raw_fru_data': base64.b64encode(fru).decode('ascii'),
+            'fru_records': [], 'link': None}
+
+
+def write_capture(path, endpoints: list):
+    """Save endpoints in the collector's pdr_and_fru_records.json layout."""
+    Path(path).write_text(json.dumps({'endpoints': endpoints}, indent=2))
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Crash-safe checkpoint of the runtime agent's port state.
+
+The agent checkpoints which detected USB port is mapped to which known
+endpoint. Each mapping is saved together with:
+
+- the FRU fingerprint the endpoint was matched by;
+- the device node;
+- the USB identity the kernel reports for the port (idVendor, idProduct and
+  serial from sysfs).
+
+The file is replaced atomically (write, fsync, rename), so a crash mid-write
+leaves the previous checkpoint in place.
+
+On restart the agent restores a port without a FRU read, provided the first
+hotplug scan still shows it with the same device node and USB identity, and
+the endpoint store still holds an endpoint with the same FRU fingerprint.
+Such an endpoint's resources were already Enabled, so they are not touched
+again. Checkpointed ports that are gone from the scan are disabled. Every
+other port goes through normal FRU matching.
+"""
+import os
+import json
+import time
+import tempfile
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+
+STATE_VERSION = 1
+
+# sysfs attributes of a USB device that identify the adapter in a port
+USB_IDENTITY_ATTRS = ('idVendor', 'idProduct', 'serial')
+
+
+def usb_identity(device_path: Optional[str], port_id: Optional[str]) -> Optional[dict]:
+    """idVendor/idProduct/serial of USB device `port_id` behind a tty node.
+
+    None when the node has no USB device in sysfs (e.g. /dev/pts).
+    """
+    if not device_path or not port_id:
+        return None
+    path = Path(os.path.realpath(f'/sys/class/tty/{Path(device_path).name}'))
+    for parent in (path, *path.parents):
+        if parent.name == port_id:
+            identity = {}
+            for attr in USB_IDENTITY_ATTRS:
+                try:
+                    identity[attr] = (parent / attr).read_text().strip()
+                except OSError:
+                    pass
+            return identity or None
+    return None
+
+
+class AgentState:
+    """Port → endpoint checkpoint, saved atomically at most every `interval` seconds."""
+
+    def __init__(self, path: Optional[Path], logger, interval: float = 10.0):
+        self.path = Path(path) if path else None
+        self.logger = logger
+        self.interval = max(0.0, float(interval))
+        self.ports: Dict[str, dict] = {}  # port id -> {endpoint, device, fru_sha256, usb}
+        self._saved = None
+        self._last_save = 0.0
+
+    def load(self) -> Dict[str, dict]:
+        """Checkpointed ports, or {} if there is no usable checkpoint."""
+        if self.path is None or not self.path.exists():
+            return {}
+        try:
+            data = json.loads(self.path.read_text())
+        except (OSError, ValueError) as e:
+            self.logger.warning(f"[STATE] Ignoring unreadable checkpoint {self.path}: {e}")
+            return {}
+        if not isinstance(data, dict) or data.get('version') != STATE_VERSION or not isinstance(data.get('ports'), dict):
+            self.logger.warning(f"[STATE] Ignoring checkpoint {self.path} (unknown format)")
+            return {}
+        ports = {p: e for p, e in data['ports'].items() if isinstance(e, dict) and e.get('endpoint')}
+        self.logger.info(f"[STATE] Loaded checkpoint of {len(ports)} ports "
+                         f"({time.time() - data.get('saved', time.time()):.0f}s old)")
+        self.ports = dict(ports)
+        self._saved = dict(ports)
+        return ports
+
+    def revalidate(self, present: Dict[str, Optional[str]], endpoints: Dict[str, dict],
+                   by_fingerprint: Dict[str, List[str]]) -> Tuple[Dict[str, str], Dict[str, str]]:
+        """Check the loaded checkpoint against the current scan.
+
+        `present` maps each port id in the scan to its device node. Returns
+        (restored, gone) as port id -> endpoint. Restored ports still show the
+        checkpointed device node and USB identity, and their endpoint still
+        has the checkpointed FRU fingerprint. Gone ports are no longer in the
+        scan. Other checkpointed ports are dropped and matched afresh.
+        """
+        restored, gone = {}, {}
+        for port, entry in list(self.ports.items()):
+            endpoint = entry['endpoint']
+            if port not in present:
+                if endpoint in endpoints:
+                    gone[port] = endpoint
+                self.drop_port(port)
+                continue
+            device = present[port]
+            if (endpoint in endpoints and device == entry.get('device')
+                    and usb_identity(device, port) == entry.get('usb')
+                    and endpoint in by_fingerprint.get(entry.get('fru_sha256'), ())):
+                restored[port] = endpoint
+            else:
+                self.logger.info(f"[STATE] {port} changed since the checkpoint; matching it again")
+                self.drop_port(port)
+        return restored, gone
+
+    def set_port(self, port: str, endpoint: str, device: Optional[str], fru_sha256: Optional[str],
+                 usb: Optional[dict]):
+        self.ports[port] = {'endpoint': endpoint, 'device': device, 'fru_sha256': fru_sha256, 'usb': usb}
+
+    def drop_port(self, port: str):
+        self.ports.pop(port, None)
+
+    def maybe_save(self):
+        """Save if anything changed and the last save is `interval` seconds old."""
+        if self.ports != self._saved and time.monotonic() - self._last_save >= self.interval:
+            self.save()
+
+    def save(self) -> bool:
+        if self.path is None or self.ports == self._saved:
+            return True
+        data = {'version': STATE_VERSION, 'saved': time.time(), 'ports': self.ports}
+        tmp = None
+        try:
+            self.path.parent.mkdir(parents=True, exist_ok=True)
+            fd, tmp = tempfile.mkstemp(dir=self.path.parent, prefix=f'.{self.path.name}.', suffix='.tmp')
+            with os.fdopen(fd, 'w') as f:
+                json.dump(data, f, indent=1, sort_keys=True)
+                f.flush()
+                os.fsync(f.fileno())
+            os.replace(tmp, self.path)
+            tmp = None
+        except OSError as e:
+            self.logger.warning(f"[STATE] Could not write checkpoint {self.path}: {e}")
+            return False
+        finally:
+            if tmp is not None:
+                try:
+                    os.unlink(tmp)
+                except OSError:
+                    pass
+        self._saved = {p: dict(e) for p, e in self.ports.items()}
+        self._last_save = time.monotonic()
+        self.logger.debug(f"[STATE] Checkpointed {len(self.ports)} ports to {self.path}")
+        return True
@@ -0,0 +1,676 @@
+#!/usr/bin/env python3
+"""
+Part 4: Redfish Aggregator - one Redfish service over several shards.
+
+A fleet too large for one agent process, or for one host's USB topology, is
+split into shards. Each shard is a runtime agent and Redfish server pair with
+its own config file (DEMO_CONFIG), mockup and endpoint store; `[agent] ports`
+selects the USB ports it owns. The aggregator serves a single service root
+for all of them and is a Redfish client of each shard, as an IoT.2 bridged
+service is of its lower-level services.
+
+Members of the top-level collections in `[aggregator] collections` are merged.
+A member with Id "N0" on shard "a" is served as "a_N0", and every @odata.id
+at or below it is rewritten the same way, so each path belongs to exactly
+one shard and maps back to it. Other resources (SessionService, ...) come
+from the first shard that answers, except that a TelemetryService MetricReport
+carries the MetricValues of every shard and a SensorHistory query goes to the
+shard owning its Sensor. PATCH and POST go to the shard that owns the path;
+SetSubtreeState is routed by its ResourceId. Shard events are
+relayed, with rewritten paths, on the aggregator's own EventService SSE
+stream. /redfish/v1/AggregationService lists the shards and whether they
+currently answer.
+"""
+import re
+import sys
+import json
+import time
+import queue
+import socket
+import threading
+import http.client
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from http.server import BaseHTTPRequestHandler
+from urllib.parse import parse_qsl, urlencode, urlparse, urlsplit
+
+import requests
+
+from shared import ConfigManager, LogManager, GracefulShutdown, demo_config_path
+from redfish_server import EventBroker, PooledHTTPServer, RedfishHandler, ResourceStore, RESOURCE_CHANGED
+from sensor_history import REPORTS, SENSOR_HISTORY
+from pldm_mapping_wizard.metrics import METRICS, render_prometheus  # pldm_tools is put on sys.path by redfish_server
+
+# Shard names prefix member Ids ("<name>_<Id>"), so they may not contain "_"
+SHARD_NAME_RE = re.compile(r'^[A-Za-z0-9]+$')
+ID_SEPARATOR = '_'
+DEFAULT_COLLECTIONS = 'Chassis, AutomationNodes, Managers, Systems, Cables'
+
+AGGREGATION_SERVICE = 'redfish/v1/AggregationService'
+AGGREGATION_SOURCES = AGGREGATION_SERVICE + '/AggregationSources'
+
+
+class ShardUnavailable(Exception):
+    """A shard did not answer (connection refused, reset or timed out)."""
+
+    def __init__(self, shard: 'Shard', error: Exception):
+        super().__init__(f"Shard {shard.name} unavailable: {error}")
+        self.timeout = isinstance(error, requests.Timeout) or isinstance(error, socket.timeout)
+
+
+class Shard:
+    """One shard's Redfish server and the mapping of its paths into the aggregate."""
+
+    def __init__(self, name: str, url: str, collections, timeout: float = 5.0):
+        self.name = name
+        self.url = url.rstrip('/')
+        self.prefix = name + ID_SEPARATOR
+        self.collections = frozenset(collections)
+        self.timeout = timeout
+        # None until first contact; then whether the last request got an answer
+        self.reachable = None
+        self.last_error = None
+        self._local = threading.local()
+
+    def _session(self) -> requests.Session:
+        session = getattr(self._local, 'session', None)
+        if session is None:
+            session = self._local.session = requests.Session()
+        return session
+
+    def request(self, method: str, path: str, body: bytes = None, headers: dict = None) -> requests.Response:
+        """Send a request to the shard; raises ShardUnavailable if it does not answer."""
+        start = time.perf_counter()
+        try:
+            response = self._session().request(method, self.url + path, data=body, headers=headers,
+                                               timeout=self.timeout)
+        except Exception as e:
+            self.mark(False, str(e))
+            METRICS.inc('redfish_aggregator_shard_errors_total', shard=self.name)
+            raise ShardUnavailable(self, e)
+        METRICS.observe('redfish_aggregator_shard_seconds', time.perf_counter() - start, shard=self.name)
+        self.mark(True)
+        return response
+
+    def mark(self, reachable: bool, error: str = None):
+        self.reachable = reachable
+        self.last_error = error
+
+    def outward(self, path: str) -> str:
+        """Shard path -> aggregate path ("/redfish/v1/Chassis/N0/..." -> ".../Chassis/a_N0/...")."""
+        base, sep, fragment = path.partition('#')
+        parts = base.split('/', 5)
+        if len(parts) >= 5 and parts[1:3] == ['redfish', 'v1'] and parts[3] in self.collections and parts[4]:
+            parts[4] = self.prefix + parts[4]
+            return '/'.join(parts) + sep + fragment
+        return path
+
+    def rewrite(self, value):
+        """Map every /redfish/v1 path in a decoded body to the aggregate namespace.
+
+        A collection member's own Id is prefixed too, so it keeps matching
+        the last segment of its @odata.id.
+        """
+        if isinstance(value, str):
+            return self.outward(value) if value.startswith('/redfish/v1/') else value
+        if isinstance(value, list):
+            return [self.rewrite(v) for v in value]
+        if not isinstance(value, dict):
+            return value
+        out = {k: self.rewrite(v) for k, v in value.items()}
+        odata_id = value.get('@odata.id')
+        if isinstance(odata_id, str) and isinstance(value.get('Id'), str) and out['@odata.id'] != odata_id:
+            if len(odata_id.rstrip('/').split('/')) == 5:
+                out['Id'] = self.prefix + value['Id']
+        return out
+
+
+class Aggregator:
+    """The shards behind one service root, and the routing between them."""
+
+    # Seconds between reconnect attempts of a shard's event relay
+    RELAY_RETRY = 2.0
+    # A relayed stream with no data (not even keep-alives) for this long is reopened
+    RELAY_READ_TIMEOUT = 45.0
+
+    def __init__(self, shards, logger, events: EventBroker = None):
+        self.shards = list(shards)
+        self.by_prefix = {s.prefix: s for s in self.shards}
+        self.collections = frozenset().union(*(s.collections for s in self.shards)) if self.shards else frozenset()
+        self.logger = logger
+        self.events = events
+        self._pool = ThreadPoolExecutor(max_workers=max(1, len(self.shards)) * 4, thread_name_prefix='aggregator')
+        self._stop = threading.Event()
+        self._relays = []
+        self._relay_conns = {}
+
+    def _inward(self, path: str):
+        """Aggregate path -> (shard, shard path) below an aggregated collection.
+
+        (None, path) if the path is outside those collections, None if its
+        member Id names no shard.
+        """
+        parts = path.split('/', 5)
+        if not (len(parts) >= 5 and parts[1:3] == ['redfish', 'v1'] and parts[3] in self.collections and parts[4]):
+            return None, path
+        prefix, sep, rest = parts[4].partition(ID_SEPARATOR)
+        shard = self.by_prefix.get(prefix + sep)
+        if shard is None or not rest:
+            return None
+        parts[4] = rest
+        return shard, '/'.join(parts)
+
+    def resolve(self, path: str):
+        """Aggregate path -> (shard, shard path), or None if no shard owns it.
+
+        Paths outside the aggregated collections belong to the first shard.
+        The query string, if any, is kept; a SensorHistory query goes to the
+        shard owning its Sensor, with that path mapped back too.
+        """
+        url = urlsplit(path)
+        query = url.query
+        if url.path.strip('/') == SENSOR_HISTORY:
+            params = parse_qsl(url.query, keep_blank_values=True)
+            sensor = dict(params).get('Sensor')
+            target = self._inward('/' + sensor.lstrip('/')) if sensor else (None, None)
+            if target is None:
+                return None
+            if target[0] is not None:
+                query = urlencode([(k, target[1] if k == 'Sensor' else v) for k, v in params])
+                return target[0], f'{url.path}?{query}'
+            # No Sensor, or one outside the collections: the first shard answers
+        target = self._inward(url.path)
+        if target is None:
+            return None
+        shard, shard_path = target
+        if shard is None:
+            if not self.shards:
+                return None
+            shard = self.shards[0]
+        return shard, shard_path + (f'?{query}' if query else '')
+
+    def is_collection(self, key: str) -> bool:
+        parts = key.split('/')
+        return len(parts) == 3 and parts[:2] == ['redfish', 'v1'] and parts[2] in self.collections
+
+    def _fetch(self, shard: Shard, path: str):
+        """A shard's decoded body for path, or None if it has none (or is down)."""
+        try:
+            response = shard.request('GET', path)
+        except ShardUnavailable as e:
+            self.logger.warning(str(e))
+            return None
+        if response.status_code != 200:
+            return None
+        try:
+            return shard.rewrite(json.loads(response.content))
+        except ValueError:
+            self.logger.warning(f"Shard {shard.name}: GET {path} returned invalid JSON")
+            return None
+
+    def collection(self, path: str):
+        """Merge one collection (with any $expand/$select) across all shards.
+
+        Returns None if no shard has it. Members keep shard order, and the
+        remaining properties are the first shard's.
+        """
+        bodies = [b for b in self._pool.map(lambda s: self._fetch(s, path), self.shards) if isinstance(b, dict)]
+        if not bodies:
+            return None
+        merged = dict(bodies[0])
+        merged['Members'] = [m for b in bodies for m in b.get('Members', [])]
+        merged['Members@odata.count'] = len(merged['Members'])
+        return merged
+
+    def metric_report(self, path: str):
+        """One TelemetryService MetricReport with the MetricValues of every shard.
+
+        Returns None if no shard has it; the other properties are the first shard's.
+        """
+        bodies = [b for b in self._pool.map(lambda s: self._fetch(s, path), self.shards) if isinstance(b, dict)]
+        if not bodies:
+            return None
+        merged = dict(bodies[0])
+        merged['MetricValues'] = [v for b in bodies for v in b.get('MetricValues', [])]
+        return merged
+
+    def service_root(self):
+        """The first shard's service root, with the AggregationService added."""
+        for shard in self.shards:
+            root = self._fetch(shard, '/redfish/v1')
+            if isinstance(root, dict):
+                root['AggregationService'] = {'@odata.id': '/' + AGGREGATION_SERVICE}
+                return root
+        return None
+
+    def aggregation_resource(self, key: str):
+        """AggregationService, its AggregationSources collection, or one source."""
+        if key == AGGREGATION_SERVICE:
+            healthy = all(s.reachable is not False for s in self.shards)
+            return {
+                '@odata.id': '/' + AGGREGATION_SERVICE,
+                '@odata.type': '#AggregationService.v1_0_3.AggregationService',
+                'Id': 'AggregationService',
+                'Name': 'Aggregation Service',
+                'ServiceEnabled': True,
+                'Status': {'State': 'Enabled', 'Health': 'OK' if healthy else 'Warning'},
+                'AggregationSources': {'@odata.id': '/' + AGGREGATION_SOURCES},
+            }
+        if key == AGGREGATION_SOURCES:
+            members = [{'@odata.id': f'/{AGGREGATION_SOURCES}/{s.name}'} for s in self.shards]
+            return {
+                '@odata.id': '/' + AGGREGATION_SOURCES,
+                '@odata.type': '#AggregationSourceCollection.AggregationSourceCollection',
+                'Name': 'Aggregation Sources',
+                'Members': members,
+                'Members@odata.count': len(members),
+            }
+        name = key[len(AGGREGATION_SOURCES) + 1:] if key.startswith(AGGREGATION_SOURCES + '/') else None
+        shard = next((s for s in self.shards if s.name == name), None)
+        if shard is None:
+            return None
+        state = {True: 'Enabled', False: 'UnavailableOffline', None: 'Starting'}[shard.reachable]
+        source = {
+            '@odata.id': f'/{AGGREGATION_SOURCES}/{shard.name}',
+            '@odata.type': '#AggregationSource.v1_4_0.AggregationSource',
+            'Id': shard.name,
+            'Name': f'Shard {shard.name}',
+            'HostName': shard.url,
+            'Status': {'State': state, 'Health': 'Critical' if shard.reachable is False else 'OK'},
+            'Oem': {'IoTFoundry': {'IdPrefix': shard.prefix}},
+        }
+        if shard.last_error:
+            source['Oem']['IoTFoundry']['LastError'] = shard.last_error
+        return source
+
+    def shard_for_resource_id(self, resource_id: str):
+        """(shard, shard-local Id) for an aggregate member Id such as "a_N0"."""
+        prefix, sep, rest = resource_id.partition(ID_SEPARATOR)
+        shard = self.by_prefix.get(prefix + sep)
+        return (shard, rest) if shard is not None and rest else (None, None)
+
+    # --- Event relay -----------------------------------------------------
+
+    def start(self):
+        """Start relaying each shard's events, if there is an EventBroker."""
+        if self.events is None:
+            return
+        for shard in self.shards:
+            thread = threading.Thread(target=self._relay, args=(shard,), name=f'relay-{shard.name}', daemon=True)
+            thread.start()
+            self._relays.append(thread)
+
+    def stop(self):
+        self._stop.set()
+        for conn in list(self._relay_conns.values()):
+            try:
+                conn.sock.shutdown(socket.SHUT_RDWR)
+            except (AttributeError, OSError):
+                pass
+        for thread in self._relays:
+            thread.join(timeout=2)
+        self._pool.shutdown(wait=False)
+
+    def _relay(self, shard: Shard):
+        url = urlparse(shard.url)
+        connected_before = False
+        while not self._stop.is_set():
+            conn = http.client.HTTPConnection(url.hostname, url.port or 80, timeout=self.RELAY_READ_TIMEOUT)
+            self._relay_conns[shard.name] = conn
+            try:
+                conn.request('GET', ResourceStore.SSE_URI, headers={'Accept': 'text/event-stream'})
+                response = conn.getresponse()
+                if response.status != 200:
+                    raise http.client.HTTPException(f"event stream returned {response.status}")
+                shard.mark(True)
+                self.logger.info(f"Relaying events from shard {shard.name}")
+                if connected_before:
+                    # Changes made while the stream was down were missed; have
+                    # clients re-read the shard's collections
+                    self.events.publish([(RESOURCE_CHANGED, f'/redfish/v1/{c}', None)
+                                         for c in sorted(shard.collections)])
+                connected_before = True
+                self._read_events(shard, response)
+            except (OSError, http.client.HTTPException) as e:
+                if self._stop.is_set():
+                    break
+                if shard.reachable is not False:
+                    self.logger.warning(f"Event stream from shard {shard.name} lost: {e}")
+                shard.mark(False, str(e))
+            finally:
+                conn.close()
+            self._stop.wait(self.RELAY_RETRY)
+
+    def _read_events(self, shard: Shard, response):
+        data = []
+        for raw in response:
+            if self._stop.is_set():
+                return
+            line = raw.decode('utf-8', 'replace').rstrip('\r\n')
+            if line.startswith('data:'):
+                data.append(line[5:].lstrip())
+            elif not line and data:
+                self._forward(shard, '\n'.join(data))
+                data = []
+
+    def _forward(self, shard: Shard, data: str):
+        try:
+            message = json.loads(data)
+        except ValueError:
+            return
+        records = []
+        for event in message.get('Events', []) if isinstance(message, dict) else []:
+            origin = (event.get('OriginOfCondition') or {}).get('@odata.id')
+            if isinstance(origin, str):
+                records.append((event.get('MessageId'), shard.outward(origin),
+                                (event.get('Oem') or {}).get('IoTFoundry')))
+        if records:
+            self.events.publish(records)
+
+
+class AggregatorHandler(BaseHTTPRequestHandler):
+    """HTTP handler for the aggregated service root."""
+
+    protocol_version = 'HTTP/1.1'
+    timeout = 5
+    disable_nagle_algorithm = True
+
+    aggregator = None
+    events = None
+    logger = None
+    shutdown = None
+
+    SUBTREE_STATE_ACTION = 'redfish/v1/Actions/Oem/IoTFoundry.SetSubtreeState'
+    METRICS_URI = 'metrics'
+    SSE_KEEPALIVE_INTERVAL = 15.0
+    # Request headers passed on to the shard
+    FORWARD_HEADERS = ('Content-Type', 'If-None-Match', 'If-Match', 'Accept')
+
+    def send_response(self, code, message=None):
+        self._status = code
+        super().send_response(code, message)
+
+    def _route(self) -> str:
+        """Route template for metrics: member and sub-member Ids become {id}."""
+        parts = ResourceStore.key_for(self.path).split('/')
+        if len(parts) > 3 and self.aggregator.is_collection('/'.join(parts[:3])):
+            parts = [('{id}' if i >= 3 and i % 2 == 1 else p) for i, p in enumerate(parts)]
+        return '/' + '/'.join(parts)
+
+    def _record(self, start: float):
+        elapsed = time.perf_counter() - start
+        route = self._route()
+        status = getattr(self, '_status', 0)
+        METRICS.inc('redfish_http_requests_total', method=self.command, route=route, code=status)
+        METRICS.observe('redfish_http_request_seconds', elapsed, method=self.command, route=route)
+
+    def do_GET(self):
+        key = ResourceStore.key_for(self.path)
+        if key == ResourceStore.SSE_URI.strip('/'):
+            self._stream_events()
+            return
+        start = time.perf_counter()
+        try:
+            if key == self.METRICS_URI:
+                self._send_bytes(200, render_prometheus({'aggregator': METRICS.snapshot()}).encode('utf-8'),
+                                 'text/plain; version=0.0.4; charset=utf-8')
+            elif key == 'redfish/v1':
+                self._send_composed(self.aggregator.service_root())
+            elif key == AGGREGATION_SERVICE or key.startswith(AGGREGATION_SERVICE + '/'):
+                self._send_composed(self.aggregator.aggregation_resource(key))
+            elif self.aggregator.is_collection(key):
+                self._send_composed(self.aggregator.collection(self.path))
+            elif key.startswith(REPORTS + '/'):
+                self._send_composed(self.aggregator.metric_report(self.path))
+            else:
+                self._forward()
+        finally:
+            self._record(start)
+
+    def do_PATCH(self):
+        start = time.perf_counter()
+        try:
+            self._forward(self._read_body())
+        finally:
+            self._record(start)
+
+    def do_POST(self):
+        start = time.perf_counter()
+        try:
+            body = self._read_body()
+            key = ResourceStore.key_for(self.path)
+            if key in RedfishHandler.AGENT_ACTIONS:
+                # Never relayed: to its shard the aggregator is a trusted local client
+                self.send_error(403, "Agent actions are not served through the aggregator")
+                self.logger.warning(f"POST {self.path} from {self.client_address[0]} → 403")
+            elif key == self.SUBTREE_STATE_ACTION:
+                self._subtree_state(body)
+            elif self.aggregator.is_collection('/'.join(key.split('/')[:3])):
+                self._forward(body)
+            else:
+                # The agents' own actions (readings, control writes, metrics)
+                # go to their shard's server, not through the aggregator
+                self.send_error(404, "Not found")
+        finally:
+            self._record(start)
+
+    def _read_body(self) -> bytes:
+        length = int(self.headers.get('Content-Length', 0) or 0)
+        return self.rfile.read(length) if length else b''
+
+    def _send_bytes(self, code: int, body: bytes, content_type: str = 'application/json', etag: str = None):
+        self.send_response(code)
+        if body or code != 304:
+            self.send_header('Content-Type', content_type)
+            self.send_header('Content-Length', str(len(body)))
+        if etag:
+            self.send_header('ETag', etag)
+        self.end_headers()
+        if body:
+            self.wfile.write(body)
+
+    def _send_composed(self, obj):
+        """A body assembled here; its ETag is a digest of the bytes."""
+        if obj is None:
+            self.send_error(404 if any(s.reachable for s in self.aggregator.shards) else 503, "Not found")
+            self.logger.info(f"{self.command} {self.path} → {self._status}")
+            return
+        body = json.dumps(obj).encode('utf-8')
+        etag = ResourceStore.view_etag(body)
+        if self._etag_matches(etag):
+            self._send_bytes(304, b'', etag=etag)
+        else:
+            self._send_bytes(200, body, etag=etag)
+
+    def _etag_matches(self, etag: str) -> bool:
+        header = self.headers.get('If-None-Match')
+        if not header:
+            return False
+        tags = {t.strip() for t in header.split(',')}
+        tags = {t[2:] if t.startswith('W/') else t for t in tags}
+        return '*' in tags or etag in tags
+
+    def _forward(self, body: bytes = None):
+        """Pass the request to the shard owning its path and map the reply back."""
+        target = self.aggregator.resolve(self.path)
+        if target is None:
+            self.send_error(404, "Not found")
+            self.logger.info(f"{self.command} {self.path} → 404")
+            return
+        shard, path = target
+        headers = {h: self.headers[h] for h in self.FORWARD_HEADERS if self.headers.get(h)}
+        self._relay_response(shard, self._shard_request(shard, self.command, path, body, headers))
+
+    def _shard_request(self, shard: Shard, method: str, path: str, body, headers):
+        try:
+            return shard.request(method, path, body, headers)
+        except ShardUnavailable as e:
+            self.send_error(504 if e.timeout else 503, str(e))
+            self.logger.warning(f"{method} {self.path} → {self._status}: {e}")
+            return None
+
+    def _relay_response(self, shard: Shard, response, transform=None):
+        if response is None:
+            return
+        etag = response.headers.get('ETag')
+        content_type = response.headers.get('Content-Type') or 'application/json'
+        content = response.content or b''
+        if response.status_code == 304:
+            self._send_bytes(304, b'', etag=etag)
+            return
+        if content_type.startswith('application/json') and content:
+            try:
+                data = shard.rewrite(json.loads(content))
+                content = json.dumps(transform(data) if transform else data).encode('utf-8')
+            except ValueError:
+                pass
+        self._send_bytes(response.status_code, content, content_type, etag)
+        self.logger.info(f"{self.command} {self.path} → {shard.name} {response.status_code}")
+
+    def _subtree_state(self, body: bytes):
+        try:
+            payload = json.loads(body.decode('utf-8')) if body else {}
+        except ValueError as e:
+            self.send_error(400, f"Invalid JSON: {e}")
+            return
+        resource_id = payload.get('ResourceId') if isinstance(payload, dict) else None
+        shard, local_id = self.aggregator.shard_for_resource_id(resource_id) if isinstance(resource_id, str) else (None, None)
+        if shard is None:
+            self.send_error(404, f"No resource with Id {resource_id}")
+            self.logger.info(f"POST {self.path} ({resource_id}) → 404")
+            return
+        payload = dict(payload, ResourceId=local_id)
+        response = self._shard_request(shard, 'POST', '/' + self.SUBTREE_STATE_ACTION,
+                                       json.dumps(payload).encode('utf-8'), {'Content-Type': 'application/json'})
+        self._relay_response(shard, response, lambda data: dict(data, ResourceId=resource_id)
+                             if isinstance(data, dict) and 'ResourceId' in data else data)
+
+    def _stream_events(self):
+        """The merged EventService stream of all shards."""
+        q = self.events.subscribe() if self.events is not None else None
+        if q is None:
+            self.send_error(503, "Too many event streams")
+            return
+        self.close_connection = True
+        try:
+            self.send_response(200)
+            self.send_header('Content-Type', 'text/event-stream')
+            self.send_header('Cache-Control', 'no-cache')
+            self.send_header('Connection', 'close')
+            self.end_headers()
+            self.wfile.write(b"retry: 2000\n\n")
+            idle_since = time.monotonic()
+            while self.shutdown is None or self.shutdown.is_running():
+                try:
+                    frame = q.get(timeout=1.0)
+                except queue.Empty:
+                    if time.monotonic() - idle_since < self.SSE_KEEPALIVE_INTERVAL:
+                        continue
+                    frame = b": keep-alive\n\n"
+                if frame is EventBroker.CLOSE:
+                    break
+                self.wfile.write(frame)
+                idle_since = time.monotonic()
+        except OSError:
+            pass
+        finally:
+            self.events.unsubscribe(q)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def parse_members(value: str, collections, timeout: float):
+    """Shards from "name=url, name=url"; raises ValueError for a bad entry."""
+    shards = []
+    for entry in (e.strip() for e in (value or '').split(',')):
+        if not entry:
+            continue
+        name, sep, url = (p.strip() for p in entry.partition('='))
+        if not sep or not SHARD_NAME_RE.match(name) or not url.startswith(('http://', 'https://')):
+            raise ValueError(f"Bad shard entry {entry!r}; expected name=http://host:port "
+                             f"with a letters-and-digits name")
+        if any(s.name == name for s in shards):
+            raise ValueError(f"Shard name {name} used twice")
+        shards.append(Shard(name, url, collections, timeout))
+    return shards
+
+
+def start_aggregator(config: ConfigManager, logger, shutdown):
+    """Serve the aggregated service root until shutdown."""
+    host = config.get('aggregator', 'host', '127.0.0.1')
+    port = config.getint('aggregator', 'port', 8080)
+    workers = config.getint('aggregator', 'workers', 16)
+    timeout = float(config.get('aggregator', 'timeout', '5'))
+    collections = [c.strip() for c in config.get('aggregator', 'collections', DEFAULT_COLLECTIONS).split(',')
+                   if c.strip()]
+    try:
+        shards = parse_members(config.get('aggregator', 'members', ''), collections, timeout)
+    except ValueError as e:
+        logger.error(str(e))
+        return False
+    if not shards:
+        logger.error("No shards configured; set [aggregator] members = name=http://host:port, ...")
+        return False
+    for shard in shards:
+        logger.info(f"Shard {shard.name}: {shard.url} (Ids prefixed {shard.prefix})")
+    logger.info(f"Aggregated collections: {', '.join(collections)}")
+
+    # Each relayed shard stream holds one worker on that shard; ours hold one here
+    max_event_streams = min(config.getint('aggregator', 'max_event_streams', 4), max(0, workers - 1))
+    events = EventBroker(max_event_streams)
+    aggregator = Aggregator(shards, logger, events)
+    aggregator.start()
+
+    AggregatorHandler.aggregator = aggregator
+    AggregatorHandler.events = events
+    AggregatorHandler.logger = logger
+    AggregatorHandler.shutdown = shutdown
+    AggregatorHandler.timeout = float(config.get('server', 'keepalive_timeout', '5'))
+
+    try:
+        httpd = PooledHTTPServer((host, port), AggregatorHandler, workers)
+        httpd.timeout = 0.5
+        logger.info(f"Aggregator listening on {host}:{port}")
+        while shutdown.is_running():
+            httpd.handle_request()
+        httpd.server_close()
+        logger.info("Aggregator stopped gracefully")
+        return True
+    except Exception as e:
+        logger.error(f"Aggregator error: {e}", exc_info=True)
+        return False
+    finally:
+        events.close()
+        aggregator.stop()
+
+
+def main():
+    """Main entry point for aggregator.py."""
+    try:
+        demo_root = Path(__file__).parents[1]
+        config = ConfigManager(demo_config_path(demo_root))
+        config.load()
+
+        log_level = config.get('logging', 'log_level', 'INFO')
+        log_dir = config.get('logging', 'log_dir', str(demo_root / 'logs'))
+        logger = LogManager('aggregator', log_dir, log_level).get_logger()
+
+        logger.info("=" * 60)
+        logger.info("Redfish Aggregator - shards behind one service root")
+        logger.info("=" * 60)
+
+        shutdown = GracefulShutdown(logger)
+        success = start_aggregator(config, logger, shutdown)
+        logger.info("Redfish Aggregator terminated")
+        sys.exit(0 if success else 1)
+
+    except Exception as e:
+        print(f"FATAL ERROR: {e}", file=sys.stderr)
+        import traceback
+        traceback.print_exc(file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -7,12 +7,16 @@ import sys
 import json
 import subprocess
 from pathlib import Path
-from shared import ConfigManager, LogManager, ProcessManager, GracefulShutdown
+from shared import ConfigManager, LogManager, ProcessManager, GracefulShutdown, demo_config_path
+
+sys.path.insert(0, str(Path(__file__).parents[1] / 'pldm_tools'))
+from endpoint_db import EndpointDB, is_endpoint_db
 
 
 def add_resource_ids(pdr_file: Path, mockup_dir: Path, logger):
     """
-    Post-process PDR JSON to add resource_id mapping for each endpoint.
+    Post-process the endpoint store (or legacy PDR JSON) to add a
+    resource_id mapping for each endpoint.
     resource_id will be the Redfish resource ID from the generated mockup.
     """
     if not pdr_file.exists():
@@ -24,7 +28,16 @@ def add_resource_ids(pdr_file: Path, mockup_dir: Path, logger):
         return False
     
     try:
-        data = json.loads(pdr_file.read_text())
+        use_db = is_endpoint_db(pdr_file)
+        if use_db:
+            # Only the fields the mapping needs; PDRs stay in the store
+            with EndpointDB(pdr_file) as db:
+                data = {'endpoints': [
+                    {'_id': row['id'], 'dev': row['dev'], 'fru_records': row['meta'].get('fru_records')}
+                    for row in db.index(with_meta=True)
+                ]}
+        else:
+            data = json.loads(pdr_file.read_text())
         
         if not isinstance(data, dict) or 'endpoints' not in data:
             logger.error("Invalid PDR format: missing 'endpoints' key")
@@ -168,8 +181,13 @@ def add_resource_ids(pdr_file: Path, mockup_dir: Path, logger):
                 endpoint['resource_id'] = f"Device_{device_name}"
                 logger.warning(f"No AutomationNode available for endpoint {device_path}, using: {endpoint['resource_id']}")
         
-        # Write back to file
-        pdr_file.write_text(json.dumps(data, indent=2))
+        # Write back to file (the store is updated per row)
+        if use_db:
+            with EndpointDB(pdr_file) as db:
+                for endpoint in data['endpoints']:
+                    db.set_resource(endpoint['_id'], endpoint.get('resource_id'), endpoint.get('resource_path'))
+        else:
+            pdr_file.write_text(json.dumps(data, indent=2))
         logger.info(f"Added resource_id mappings to {len(data['endpoints'])} endpoints")
         return True
         
@@ -191,13 +209,23 @@ def run_configurator(config: ConfigManager, logger):
         return False
     
     # Config values
-    pdr_output = config.get('configurator', 'pdr_output', '/tmp/pdr_and_fru_records.json')
+    pdr_output = config.get('configurator', 'pdr_output', '/tmp/pdr_and_fru_records.db')
     dest_mockup = config.get('configurator', 'dest_mockup', '/tmp/generated_mockup')
     auto_select = config.getbool('configurator', 'auto_select', True)
+    pdr_cache_dir = config.get('configurator', 'pdr_cache_dir', '')
+    discovery_workers = config.getint('configurator', 'discovery_workers', 8)
+    link_negotiation = config.getbool('configurator', 'link_negotiation', True)
+    link_baud_rates = config.get('configurator', 'link_baud_rates', '')
+    link_transfer_sizes = config.get('configurator', 'link_transfer_sizes', '')
+    # A shard collects only the USB ports its agent owns
+    ports = config.get('agent', 'ports', '')
     
     logger.info(f"PDR output: {pdr_output}")
+    logger.info(f"PDR cache: {pdr_cache_dir or 'disabled'}")
     logger.info(f"Destination mockup: {dest_mockup}")
     logger.info(f"Auto-select devices: {auto_select}")
+    if ports:
+        logger.info(f"Shard ports: {ports}")
     
     # Build command
     cmd = [
@@ -206,12 +234,25 @@ def run_configurator(config: ConfigManager, logger):
         'scan-and-generate',
         '-c', pdr_output,
         '-d', dest_mockup,
+        '-j', str(discovery_workers),
     ]
     
     if auto_select:
         cmd.append('--auto-select')
     else:
         cmd.append('--no-auto-select')
+
+    if pdr_cache_dir:
+        cmd.extend(['--pdr-cache', pdr_cache_dir])
+
+    if not link_negotiation:
+        cmd.append('--no-link-negotiation')
+    if link_baud_rates:
+        cmd.extend(['--baud-rates', link_baud_rates])
+    if link_transfer_sizes:
+        cmd.extend(['--transfer-sizes', link_transfer_sizes])
+    if ports:
+        cmd.extend(['--ports', ports])
     
     logger.info(f"Running: {' '.join(cmd)}")
     
@@ -244,7 +285,7 @@ def main():
     """Main entry point for configurator.py."""
     # Load config
     demo_root = Path(__file__).parents[1]
-    config_path = demo_root / 'configs' / 'demo.ini'
+    config_path = demo_config_path(demo_root)
     config = ConfigManager(config_path)
     config.load()
     
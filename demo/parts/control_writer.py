@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Redfish Control writes for the runtime agent.
+
+A PATCH of a Control's SetPoint is held by the Redfish server until the
+device has answered. The ControlWriter long-polls the server's
+IoTFoundry.TakeControlWrites action for such writes, translates each one
+with the effecter PDR behind the Control into SetNumericEffecterValue
+(numeric effecters) or SetStateEffecterStates (state effecters), sends it
+on a PRIORITY_CONTROL lease of the endpoint's port, and reports the PLDM
+completion code through IoTFoundry.CompleteControlWrites.
+
+Control leases are granted ahead of sensor batches and FRU discovery, and a
+running sensor batch stops issuing requests as soon as one is waiting, so a
+write waits at most for the sensor requests already in flight. Writes for
+different devices are carried out in parallel; writes for one device are
+sent in the order they were PATCHed.
+"""
+import sys
+import math
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Dict, List, Optional
+
+import requests
+
+from port_broker import PRIORITY_CONTROL
+from shared import AGENT_TOKEN_HEADER, agent_token
+
+
+TAKE_CONTROL_WRITES_ACTION = "/redfish/v1/Actions/Oem/IoTFoundry.TakeControlWrites"
+COMPLETE_CONTROL_WRITES_ACTION = "/redfish/v1/Actions/Oem/IoTFoundry.CompleteControlWrites"
+
+# Completion code for a value the writer refuses before it reaches the
+# device, as the device itself would (DSP0240 ERROR_INVALID_DATA)
+ERROR_INVALID_DATA = 0x02
+
+# DSP0248 PDR types
+PDR_TYPE_NUMERIC_EFFECTER = 9
+PDR_TYPE_STATE_EFFECTER = 11
+
+
+def effecter_specs_from_pdrs(pdr_records, resource_id: str) -> List[dict]:
+    """Build write specs from an endpoint's PDR records.
+
+    Records are either {'decoded': {...}} dicts (collector output) or
+    pdr_decoder.LazyPDR objects. Control resources are created by
+    generate_controls.create_control at
+    /redfish/v1/Chassis/<resource_id>/Controls/EFFECTER_ID_<effecterID>.
+    """
+    specs = []
+    if not isinstance(pdr_records, list) or not resource_id:
+        return specs
+    for rec in pdr_records:
+        if hasattr(rec, 'field'):
+            pdr_type, get = rec.pdr_type, rec.field
+        else:
+            dec = rec.get('decoded') if isinstance(rec, dict) else None
+            if not isinstance(dec, dict):
+                continue
+            pdr_type, get = dec.get('PDRType'), dec.get
+        if pdr_type == PDR_TYPE_NUMERIC_EFFECTER:
+            kind = 'numeric'
+        elif pdr_type == PDR_TYPE_STATE_EFFECTER:
+            kind = 'state'
+        else:
+            continue
+        eid = get('effecterID')
+        if eid is None:
+            continue
+        eid = int(eid)
+        spec = {
+            'effecter_id': eid,
+            'kind': kind,
+            'path': f'/redfish/v1/Chassis/{resource_id}/Controls/EFFECTER_ID_{eid}',
+        }
+        if kind == 'numeric':
+            spec.update({
+                'data_size': get('effecterDataSize'),
+                'resolution': get('resolution'),
+                'offset': get('offset'),
+                'min': get('minSettable'),
+                'max': get('maxSettable'),
+            })
+        else:
+            spec['composite_count'] = get('compositeEffecterCount') or 1
+        specs.append(spec)
+    return specs
+
+
+def _finite(value) -> Optional[float]:
+    try:
+        value = float(value)
+    except (TypeError, ValueError):
+        return None
+    return value if math.isfinite(value) else None
+
+
+def raw_effecter_value(set_point, spec: dict) -> int:
+    """Invert the PDR linear conversion Y = resolution * X + offset.
+
+    Raises ValueError if the result lies outside the PDR's settable range.
+    """
+    resolution = _finite(spec.get('resolution'))
+    offset = _finite(spec.get('offset')) or 0.0
+    value = float(set_point)
+    if resolution:
+        value = (value - offset) / resolution
+    raw = int(round(value))
+    low, high = _finite(spec.get('min')), _finite(spec.get('max'))
+    if (low is not None and raw < low) or (high is not None and raw > high):
+        raise ValueError(f"raw value {raw} outside settable range [{spec.get('min')}, {spec.get('max')}]")
+    return raw
+
+
+class ControlSettings:
+    """[controls] configuration."""
+
+    def __init__(self, config=None):
+        get = (lambda key, default: float(config.get('controls', key, str(default)))) if config else (lambda key, default: default)
+        self.enabled = config.getbool('controls', 'enabled', True) if config else True
+        self.device_timeout = get('device_timeout', 0.25)
+        self.retries = config.getint('controls', 'retries', 1) if config else 1
+        self.poll_wait = get('poll_wait', 1.0)
+        self.workers = config.getint('controls', 'workers', 4) if config else 4
+
+
+class ControlWriter(threading.Thread):
+    """Carries out Control PATCHes queued on the Redfish server."""
+
+    # Pause after a failed TakeControlWrites before polling again
+    RETRY_DELAY = 1.0
+
+    def __init__(self, config, logger, server_url: str, transport):
+        super().__init__(name='control-writer', daemon=True)
+        self.logger = logger
+        self.server_url = server_url
+        self.transport = transport
+        self.settings = ControlSettings(config)
+        self.token = agent_token(config)
+        self.controls: Dict[str, tuple] = {}  # Control @odata.id -> (endpoint, device, spec)
+        self.stats = {'writes': 0, 'rejected': 0, 'errors': 0}
+        self._lock = threading.Lock()
+        self._stop_event = threading.Event()
+        self._local = threading.local()
+        self._classes = None
+        # Devices with a batch being written -> writes taken for them meanwhile
+        self._busy: Dict[Optional[str], List[dict]] = {}
+
+    def attach(self, endpoint: str, device: Optional[str], effecters: List[dict]):
+        """Route writes for an endpoint's Controls to `device`."""
+        if not device or not effecters:
+            return
+        with self._lock:
+            for spec in effecters:
+                self.controls[spec['path']] = (endpoint, device, spec)
+        self.logger.debug(f"[CONTROLS] {endpoint}: {len(effecters)} controls on {device}")
+
+    def detach(self, endpoint: str):
+        with self._lock:
+            self.controls = {p: c for p, c in self.controls.items() if c[0] != endpoint}
+
+    def stop(self):
+        self._stop_event.set()
+
+    def _load_classes(self):
+        if self._classes is None:
+            pldm_tools_dir = str(Path(__file__).parents[1] / 'pldm_tools')
+            if pldm_tools_dir not in sys.path:
+                sys.path.insert(0, pldm_tools_dir)
+            from pldm_mapping_wizard.discovery.request_engine import PLDMRequestEngine
+            from pldm_mapping_wizard.discovery.pldm_commands import PDLMCommandEncoder
+            self._classes = (PLDMRequestEngine, PDLMCommandEncoder)
+        return self._classes
+
+    def _session(self) -> requests.Session:
+        session = getattr(self._local, 'session', None)
+        if session is None:
+            session = self._local.session = requests.Session()
+            if self.token:
+                session.headers[AGENT_TOKEN_HEADER] = self.token
+        return session
+
+    def run(self):
+        if not self.settings.enabled:
+            return
+        try:
+            self._load_classes()
+        except ImportError as e:
+            self.logger.warning(f"[CONTROLS] Control writes unavailable: {e}")
+            return
+        self.logger.info("[CONTROLS] Waiting for Control writes")
+        with ThreadPoolExecutor(max_workers=max(1, self.settings.workers), thread_name_prefix='control') as pool:
+            while not self._stop_event.is_set():
+                writes = self._take()
+                if writes is None:
+                    self._stop_event.wait(self.RETRY_DELAY)
+                    continue
+                by_device: Dict[Optional[str], List[dict]] = {}
+                for write in writes:
+                    with self._lock:
+                        target = self.controls.get(write.get('Path'))
+                    by_device.setdefault(target[1] if target else None, []).append(write)
+                for device, batch in by_device.items():
+                    self._dispatch(pool, device, batch)
+        self.logger.info(f"[CONTROLS] Stopped ({self.stats})")
+
+    def _dispatch(self, pool: ThreadPoolExecutor, device: Optional[str], batch: List[dict]):
+        """Start a device's writes, or queue them behind its running batch."""
+        with self._lock:
+            if device in self._busy:
+                self._busy[device].extend(batch)
+                return
+            self._busy[device] = []
+        pool.submit(self._drain, device, batch)
+
+    def _drain(self, device: Optional[str], batch: List[dict]):
+        # At most one task per device, so its writes go out in PATCH order
+        while batch:
+            try:
+                self._write_all(batch)
+            except Exception as e:
+                self.logger.error(f"[CONTROLS] {device}: writes failed: {e}", exc_info=True)
+            with self._lock:
+                batch = self._busy.pop(device)
+                if batch:
+                    self._busy[device] = []
+
+    def _take(self) -> Optional[List[dict]]:
+        try:
+            response = self._session().post(
+                f"{self.server_url}{TAKE_CONTROL_WRITES_ACTION}",
+                json={'Wait': self.settings.poll_wait},
+                timeout=self.settings.poll_wait + 5,
+            )
+            if response.status_code != 200:
+                self.logger.debug(f"[CONTROLS] TakeControlWrites → {response.status_code}")
+                return None
+            return response.json().get('Writes', [])
+        except Exception as e:
+            self.logger.debug(f"[CONTROLS] TakeControlWrites failed: {e}")
+            return None
+
+    def _write_all(self, writes: List[dict]):
+        results = []
+        for write in writes:
+            try:
+                result = self.write(write.get('Path'), write.get('SetPoint'))
+            except Exception as e:
+                self.logger.error(f"[CONTROLS] {write.get('Path')}: write failed: {e}", exc_info=True)
+                result = {'Error': str(e)}
+            result['Id'] = write.get('Id')
+            results.append(result)
+        try:
+            self._session().post(
+                f"{self.server_url}{COMPLETE_CONTROL_WRITES_ACTION}",
+                json={'Results': results},
+                timeout=2,
+            )
+        except Exception as e:
+            self.logger.warning(f"[CONTROLS] CompleteControlWrites failed: {e}")
+
+    def write(self, path: str, set_point) -> dict:
+        """Send one SetPoint to its effecter: {"CompletionCode": n} or {"Error": "..."}."""
+        with self._lock:
+            target = self.controls.get(path)
+        if target is None:
+            self.stats['errors'] += 1
+            return {'Error': 'Control is not on a connected endpoint'}
+        endpoint, device, spec = target
+        engine_cls, encoder = self._load_classes()
+        try:
+            if spec['kind'] == 'numeric':
+                msg = encoder.encode_set_numeric_effecter_value(
+                    effecter_id=spec['effecter_id'],
+                    effecter_data_size=spec['data_size'],
+                    value=raw_effecter_value(set_point, spec),
+                )
+            else:
+                # SetPoint drives the first effecter of a composite; the rest keep their state
+                states = (int(set_point),) + (None,) * (int(spec['composite_count']) - 1)
+                msg = encoder.encode_set_state_effecter_states(effecter_id=spec['effecter_id'], states=states)
+        except (TypeError, ValueError) as e:
+            self.stats['rejected'] += 1
+            self.logger.debug(f"[CONTROLS] {endpoint}: effecter {spec['effecter_id']} ← {set_point} refused: {e}")
+            return {'CompletionCode': ERROR_INVALID_DATA}
+
+        with self.transport.lease(device, PRIORITY_CONTROL, timeout=self.settings.device_timeout) as port:
+            if port is None:
+                self.stats['errors'] += 1
+                return {'Error': f'{device} is not available'}
+            engine = engine_cls(port, max_outstanding=1, timeout=self.settings.device_timeout,
+                                retries=self.settings.retries)
+            req = engine.request(msg)
+        if not req.ok:
+            self.stats['errors'] += 1
+            return {'Error': req.error or 'No response'}
+        decoded = encoder.decode_completion_code_response(req.response.get('extra', b''))
+        if 'error' in decoded:
+            self.stats['errors'] += 1
+            return {'Error': decoded['error']}
+        cc = decoded['completion_code']
+        self.stats['writes' if cc == 0 else 'rejected'] += 1
+        self.logger.debug(f"[CONTROLS] {endpoint}: effecter {spec['effecter_id']} ← {set_point} (CC={cc})")
+        return {'CompletionCode': cc}
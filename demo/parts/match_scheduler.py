@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+Bounded scheduling of FRU matches for hotplugged ports.
+
+When a hub re-enumerates, many ports appear in one scan. Each added port is
+submitted to the MatchScheduler, which runs at most `workers` matches at a
+time and gives each one `deadline` seconds. Ports are matched in the
+background; the agent's poll loop keeps running meanwhile, and the result of
+each match is handed to `on_result(port, endpoint)` as soon as it is known.
+
+A port removed while its match is queued or running is cancelled. Serial
+work already started in a thread finishes on its own, and ends promptly
+because the device is gone. A port that is added again is submitted afresh.
+
+metrics() reports the queue depth and match latency for the status log;
+the same figures are recorded in METRICS (agent_fru_match_*).
+"""
+import sys
+import time
+import asyncio
+from collections import deque
+from pathlib import Path
+from typing import Awaitable, Callable, Dict, Optional
+
+PLDM_TOOLS_DIR = str(Path(__file__).parents[1] / 'pldm_tools')
+if PLDM_TOOLS_DIR not in sys.path:
+    sys.path.insert(0, PLDM_TOOLS_DIR)
+from pldm_mapping_wizard.metrics import METRICS  # noqa: E402
+
+
+class MatchScheduler:
+    """Runs one FRU match per added port, `workers` at a time."""
+
+    # Recent match latencies kept for percentiles
+    LATENCY_WINDOW = 256
+
+    def __init__(self, match: Callable[[str], Awaitable[Optional[str]]],
+                 on_result: Callable[[str, Optional[str]], Awaitable[None]],
+                 workers: int = 4, deadline: float = 5.0, logger=None):
+        self.match = match
+        self.on_result = on_result
+        self.workers = max(1, int(workers))
+        self.deadline = max(0.1, float(deadline))
+        self.logger = logger
+        self.tasks: Dict[str, asyncio.Task] = {}
+        self.queued = 0
+        self.running = 0
+        self.stats = {'submitted': 0, 'matched': 0, 'unmatched': 0, 'timeouts': 0, 'cancelled': 0, 'errors': 0}
+        self._latencies = deque(maxlen=self.LATENCY_WINDOW)
+        self._slots = None
+
+    def submit(self, port: str):
+        """Schedule a match for `port`, replacing any match still pending for it."""
+        if self._slots is None:
+            # Created lazily so the semaphore binds to the running loop
+            self._slots = asyncio.Semaphore(self.workers)
+        self.cancel(port)
+        self.stats['submitted'] += 1
+        self.tasks[port] = asyncio.get_running_loop().create_task(self._run(port), name=f'fru-match-{port}')
+
+    def cancel(self, port: str) -> bool:
+        """Cancel the queued or running match for `port`; True if there was one."""
+        task = self.tasks.pop(port, None)
+        if task is None or task.done():
+            return False
+        task.cancel()
+        return True
+
+    async def close(self):
+        tasks = list(self.tasks.values())
+        self.tasks.clear()
+        for task in tasks:
+            task.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+
+    async def _run(self, port: str):
+        submitted = time.monotonic()
+        self.queued += 1
+        queued = True
+        try:
+            async with self._slots:
+                self.queued -= 1
+                queued = False
+                self.running += 1
+                self._gauges()
+                try:
+                    endpoint = await asyncio.wait_for(self.match(port), self.deadline)
+                    result = 'matched' if endpoint else 'unmatched'
+                except asyncio.TimeoutError:
+                    self.stats['timeouts'] += 1
+                    if self.logger:
+                        self.logger.warning(f"  [FRU] Match for {port} exceeded its {self.deadline:g}s deadline")
+                    endpoint, result = None, 'timeout'
+                finally:
+                    self.running -= 1
+                    self._gauges()
+            self._latencies.append(time.monotonic() - submitted)
+            METRICS.observe('agent_fru_match_seconds', self._latencies[-1], result=result)
+            self.stats['matched' if endpoint else 'unmatched'] += 1
+            # Still cancellable here: a port removed while its endpoint is
+            # being attached must not end up attached
+            await self.on_result(port, endpoint)
+        except asyncio.CancelledError:
+            self.stats['cancelled'] += 1
+            if self.logger:
+                self.logger.info(f"  [FRU] Match for {port} cancelled")
+            raise
+        except Exception as e:
+            self.stats['errors'] += 1
+            if self.logger:
+                self.logger.error(f"  [FRU] Match for {port} failed: {e}", exc_info=True)
+        finally:
+            if queued:
+                self.queued -= 1
+                self._gauges()
+            if self.tasks.get(port) is asyncio.current_task():
+                del self.tasks[port]
+
+    def _gauges(self):
+        METRICS.set('agent_fru_match_queued', self.queued)
+        METRICS.set('agent_fru_match_running', self.running)
+
+    def metrics(self) -> dict:
+        """Queue depth, in-flight matches, outcome counters and latency percentiles (ms)."""
+        latencies = sorted(self._latencies)
+
+        def pct(p):
+            return round(latencies[min(len(latencies) - 1, int(len(latencies) * p))] * 1000.0, 1) if latencies else None
+
+        metrics = dict(self.stats)
+        metrics.update({
+            'queued': self.queued,
+            'running': self.running,
+            'p50_ms': pct(0.50),
+            'p95_ms': pct(0.95),
+            'max_ms': round(latencies[-1] * 1000.0, 1) if latencies else None,
+        })
+        return metrics
@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+Shared serial transport for the runtime agent.
+
+Every subsystem that talks to an endpoint (FRU matching, sensor sampling,
+control requests) goes through one TransportBroker. It keeps a single
+SerialPort open per device for as long as the device is present, so the
+open/configure cost and the DTR pulse that comes with opening a USB serial
+adapter are paid once per connection rather than once per operation.
+
+Access is by lease: a subsystem holds the port exclusively for one logical
+operation (a FRU transfer, one sensor batch) and hands it back. Waiting
+leases are granted by priority, then in arrival order; long holders check
+preempted() between requests and hand the port back early when a more
+urgent lease is waiting:
+
+  PRIORITY_CONTROL    requests issued on behalf of a Redfish client
+  PRIORITY_SENSOR     periodic sensor batches
+  PRIORITY_DISCOVERY  FRU probes and reads while matching a hotplugged device
+
+Ports open at 115200, which every endpoint accepts, so a hotplugged device
+can be identified; apply_link() then moves a recognised endpoint to the baud
+rate negotiated when it was collected.
+
+Ports are opened with an exclusive lock (pyserial exclusive=True) unless
+[transport] exclusive is false, so a configurator run cannot interleave its
+own traffic with the agent's on the same device.
+"""
+import sys
+import time
+import heapq
+import itertools
+import threading
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Dict, Optional
+
+
+PLDM_TOOLS_DIR = str(Path(__file__).parents[1] / 'pldm_tools')
+if PLDM_TOOLS_DIR not in sys.path:
+    sys.path.insert(0, PLDM_TOOLS_DIR)
+from pldm_mapping_wizard.metrics import METRICS  # noqa: E402
+
+PRIORITY_CONTROL = 0
+PRIORITY_SENSOR = 1
+PRIORITY_DISCOVERY = 2
+
+# Metrics label per priority
+PRIORITY_NAMES = {PRIORITY_CONTROL: 'control', PRIORITY_SENSOR: 'sensor', PRIORITY_DISCOVERY: 'discovery'}
+
+BAUDRATE = 115200
+
+
+def load_serial_port_cls():
+    """pldm_mapping_wizard.serial_transport.SerialPort, imported on demand."""
+    from pldm_mapping_wizard.serial_transport import SerialPort
+    return SerialPort
+
+
+class PortBroker:
+    """Owns one device's SerialPort and leases it out one holder at a time."""
+
+    def __init__(self, device: str, serial_cls, exclusive: bool = True, logger=None):
+        self.device = device
+        self.serial_cls = serial_cls
+        self.exclusive = exclusive
+        self.logger = logger
+        self.baudrate = BAUDRATE
+        self.port = None
+        self.closed = False
+        self.stats = {'opens': 0, 'leases': 0, 'waits': 0}
+        self._cond = threading.Condition()
+        self._waiting = []  # heap of (priority, seq)
+        self._seq = itertools.count()
+        self._held = False
+
+    def _acquire(self, priority: int, wait: Optional[float]) -> bool:
+        with self._cond:
+            if self.closed:
+                return False
+            ticket = (priority, next(self._seq))
+            heapq.heappush(self._waiting, ticket)
+            start = time.monotonic()
+            if self._held:
+                self.stats['waits'] += 1
+            granted = self._cond.wait_for(
+                lambda: self.closed or (not self._held and self._waiting[0] == ticket), wait)
+            if not granted or self.closed:
+                self._waiting.remove(ticket)
+                heapq.heapify(self._waiting)
+                self._cond.notify_all()
+                return False
+            heapq.heappop(self._waiting)
+            self._held = True
+            self.stats['leases'] += 1
+        METRICS.observe('pldm_port_wait_seconds', time.monotonic() - start, endpoint=self.device,
+                        priority=PRIORITY_NAMES.get(priority, str(priority)))
+        return True
+
+    def _release(self, broken: bool):
+        with self._cond:
+            if broken or self.closed:
+                self._close_port()
+            self._held = False
+            self._cond.notify_all()
+
+    def _open_port(self):
+        if self.port is not None and self.port.is_open():
+            return self.port
+        self._close_port()
+        port = self.serial_cls(self.device, self.baudrate, exclusive=self.exclusive)
+        if not port.open():
+            return None
+        self.port = port
+        self.stats['opens'] += 1
+        if self.logger:
+            self.logger.debug(f"[TRANSPORT] Opened {self.device} (open #{self.stats['opens']})")
+        return port
+
+    def _close_port(self):
+        if self.port is not None:
+            try:
+                self.port.close()
+            except Exception:
+                pass
+            self.port = None
+
+    @contextmanager
+    def lease(self, priority: int = PRIORITY_DISCOVERY, timeout: Optional[float] = None,
+              wait: Optional[float] = None):
+        """Hold the open port for the duration of the block.
+
+        Yields the SerialPort, with its read timeout set to `timeout` when
+        given and any input left over from the previous holder discarded,
+        or None when the port cannot be opened, the broker has been closed,
+        or no lease was granted within `wait` seconds.
+        """
+        if not self._acquire(priority, wait):
+            yield None
+            return
+        broken = True
+        try:
+            port = self._open_port()
+            if port is not None:
+                if timeout is not None:
+                    port.set_timeout(timeout)
+                port.reset_input()
+            yield port
+            broken = port is None or not port.is_open()
+        finally:
+            self._release(broken)
+
+    def preempted(self, priority: int) -> bool:
+        """True if a lease of higher priority than `priority` is waiting."""
+        with self._cond:
+            return bool(self._waiting) and self._waiting[0][0] < priority
+
+    def close(self):
+        """Close the port now, or as soon as the current holder is done."""
+        with self._cond:
+            self.closed = True
+            if not self._held:
+                self._close_port()
+            self._cond.notify_all()
+
+
+class TransportBroker:
+    """One PortBroker per device path, shared by all agent subsystems."""
+
+    def __init__(self, config=None, logger=None, serial_cls=None):
+        self.logger = logger
+        self.exclusive = config.getbool('transport', 'exclusive', True) if config else True
+        self.serial_cls = serial_cls
+        self.ports: Dict[str, PortBroker] = {}
+        self._lock = threading.Lock()
+
+    def port(self, device: str) -> Optional[PortBroker]:
+        """The broker for `device`, created on first use (None if SerialPort cannot be loaded)."""
+        with self._lock:
+            broker = self.ports.get(device)
+            if broker is None:
+                if self.serial_cls is None:
+                    try:
+                        self.serial_cls = load_serial_port_cls()
+                    except ImportError as e:
+                        if self.logger:
+                            self.logger.warning(f"[TRANSPORT] Serial transport unavailable: {e}")
+                        return None
+                broker = self.ports[device] = PortBroker(device, self.serial_cls, self.exclusive, self.logger)
+            return broker
+
+    @contextmanager
+    def lease(self, device: str, priority: int = PRIORITY_DISCOVERY, timeout: Optional[float] = None,
+              wait: Optional[float] = None):
+        """PortBroker.lease for `device`; yields None if there is no transport."""
+        broker = self.port(device) if device else None
+        if broker is None:
+            yield None
+            return
+        with broker.lease(priority, timeout, wait) as port:
+            yield port
+
+    def preempted(self, device: Optional[str], priority: int) -> bool:
+        """PortBroker.preempted for `device` (False if it has no broker)."""
+        broker = self.ports.get(device) if device else None
+        return broker is not None and broker.preempted(priority)
+
+    def apply_link(self, device: Optional[str], link: Optional[dict], timeout: float = 0.25) -> Optional[int]:
+        """Switch `device` to the baud rate in `link` if the endpoint confirms it.
+
+        Returns the rate in use, or None if the port is unavailable.
+        """
+        broker = self.port(device) if device and link else None
+        if broker is None:
+            return None
+        from pldm_mapping_wizard.discovery.link_negotiation import apply_link
+        with broker.lease(PRIORITY_DISCOVERY) as port:
+            if port is None:
+                return None
+            broker.baudrate = apply_link(port, link, timeout)
+            return broker.baudrate
+
+    def release(self, device: Optional[str]):
+        """Forget a device (unplugged or not ours) and close its port."""
+        with self._lock:
+            broker = self.ports.pop(device, None) if device else None
+        if broker is not None:
+            broker.close()
+            if self.logger:
+                self.logger.debug(f"[TRANSPORT] Released {device} ({broker.stats})")
+
+    def close_all(self):
+        for device in list(self.ports):
+            self.release(device)
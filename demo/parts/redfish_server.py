@@ -1,94 +1,1055 @@
 #!/usr/bin/env python3
 """
 Part 1: Redfish Mockup Server - serves Redfish resources from generated mockup.
-Handles GET (static files) and PATCH (modify Status.State).
+Handles GET (served from an in-memory copy of the mockup), PATCH (modify
+Status.State, persisted to the mockup files in the background; a Control's
+SetPoint is written to the device through the runtime agent first) and the
+IoTFoundry OEM actions: SetSubtreeState (bulk Status.State for an endpoint),
+UpdateReadings (live sensor values from the runtime agent) and
+TakeControlWrites/CompleteControlWrites (the agent's side of Control
+PATCHes). Every change is pushed to clients of the EventService Server-Sent
+Event stream.
+
+GET /metrics serves Prometheus text: the server's HTTP latency by route plus
+the transport and agent metrics the runtime agent reports with the
+PushMetrics action.
+
+Readings are also kept in a bounded per-sensor history (sensor_history),
+served as TelemetryService MetricReports and a compact per-sensor query.
 """
 import os
+import re
 import sys
 import json
+import time
+import queue
+import hmac
+import hashlib
+import ipaddress
+import tempfile
 import threading
+from collections import deque
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from http.server import BaseHTTPRequestHandler, HTTPServer
-from urllib.parse import urlparse
+from datetime import datetime, timezone
+from urllib.parse import parse_qsl, urlparse
+
+from shared import (AGENT_TOKEN_HEADER, ConfigManager, LogManager, ProcessManager, GracefulShutdown,
+                    agent_token, demo_config_path)
+import sensor_history
+from sensor_history import HistorySettings, HistoryStore
+
+PLDM_TOOLS_DIR = str(Path(__file__).parents[1] / 'pldm_tools')
+if PLDM_TOOLS_DIR not in sys.path:
+    sys.path.insert(0, PLDM_TOOLS_DIR)
+from pldm_mapping_wizard.metrics import METRICS, check_snapshot, render_prometheus  # noqa: E402
+
+
+# MessageIds of the events published for store changes
+RESOURCE_CHANGED = 'ResourceEvent.1.0.ResourceChanged'
+READING_CHANGED = 'IoTFoundry.1.0.ReadingChanged'
+
+# $expand=<mode>[($levels=n)]: "." subordinate links, "~" Links only, "*" both
+EXPAND_MAX_LEVELS = 6
+_EXPAND_RE = re.compile(r'^([.*~])(?:\(\$levels=(\d+)\))?$')
+# Properties kept by $select regardless of the list
+SELECT_ALWAYS = ('@odata.id', '@odata.type', '@odata.context', '@odata.etag')
+PROTOCOL_FEATURES = {
+    'ExpandQuery': {'ExpandAll': True, 'Levels': True, 'Links': True, 'NoLinks': True,
+                    'MaxLevels': EXPAND_MAX_LEVELS},
+    'SelectQuery': True,
+}
+
+
+def parse_odata_query(url_path: str):
+    """Parse the $expand and $select options of a request URL.
+
+    Returns (expand, levels, select): expand is None or one of ".", "~", "*";
+    select is None or a list of property paths ("Status/State").
+    Raises ValueError for a malformed option and NotImplementedError for any
+    other $ option. Non-$ parameters are ignored, as before.
+    """
+    expand, levels, select = None, 1, None
+    for name, value in parse_qsl(urlparse(url_path).query, keep_blank_values=True):
+        if name == '$expand':
+            m = _EXPAND_RE.match(value.strip())
+            if not m:
+                raise ValueError(f"Unsupported $expand value: {value}")
+            expand = m.group(1)
+            levels = int(m.group(2)) if m.group(2) else 1
+            if not 1 <= levels <= EXPAND_MAX_LEVELS:
+                raise ValueError(f"$levels must be between 1 and {EXPAND_MAX_LEVELS}")
+        elif name == '$select':
+            select = [p.strip() for p in value.split(',') if p.strip()]
+            if not select:
+                raise ValueError("$select needs at least one property")
+        elif name.startswith('$'):
+            raise NotImplementedError(f"Query parameter {name} is not supported")
+    return expand, levels, select
+
+
+class ResourceStore:
+    """In-memory view of the mockup tree with write-behind persistence.
+
+    Every file under the mockup directory is loaded once and kept as the
+    exact bytes to send, keyed by URL path. A directory's index.json is also
+    registered under the directory URL. PATCHes update the parsed resource
+    and re-serialize the body right away. Changed files go to disk from a
+    background thread every `flush_interval` seconds, and again on shutdown.
+
+    If the mockup is regenerated while the server runs (for example by
+    re-running the configurator), the tree is reloaded and any unsaved
+    changes are dropped. A regeneration is detected when the root index.json
+    is replaced or touched; the generator touches it whenever it changes
+    any file.
+
+    Changes are published to `events` (an EventBroker), if one is attached.
 
-from shared import ConfigManager, LogManager, ProcessManager, GracefulShutdown
+    Each resource carries a version counter, bumped whenever its body
+    changes, from which its ETag is derived. ETags also include a per-load
+    generation, so a reloaded tree or a restarted server never matches a tag
+    handed out before.
+    """
+
+    ROOT_INDEX = ('redfish', 'v1', 'index.json')
+    RELOAD_CHECK_INTERVAL = 1.0
+    EVENT_SERVICE = 'redfish/v1/EventService'
+    SSE_URI = '/redfish/v1/EventService/SSE'
+
+    def __init__(self, mockup_dir: Path, logger, flush_interval: float = 1.0):
+        self.mockup_dir = Path(mockup_dir).resolve()
+        self.logger = logger
+        self.flush_interval = max(0.05, float(flush_interval))
+        self._lock = threading.RLock()
+        self._reload_lock = threading.Lock()
+        self._entries = {}   # url key -> {'file': Path, 'body': bytes, 'data': dict|None, 'version': int}
+        self._dirty = set()  # file Paths awaiting flush
+        self._root_stat = None
+        self._generation = ''
+        self._routes = {}    # url key -> route template, for metrics
+        self._changed_stat = None
+        self._last_reload_check = 0.0
+        self._stop = threading.Event()
+        self._flusher = None
+        self.events = None
+        # Links added to the service root for services served outside the tree
+        self.root_links = {}
+
+    @staticmethod
+    def key_for(url_path: str) -> str:
+        """Normalize a request path to a store key ("" and "redfish/v1" are the root)."""
+        key = urlparse(url_path).path.strip('/')
+        return key or 'redfish/v1'
+
+    def _stat_root(self):
+        try:
+            st = (self.mockup_dir.joinpath(*self.ROOT_INDEX)).stat()
+            return (st.st_ino, st.st_mtime_ns, st.st_size)
+        except OSError:
+            return None
+
+    def load(self) -> int:
+        """(Re)load every file in the mockup tree. Returns the resource count."""
+        entries = {}
+        for file_path in self.mockup_dir.rglob('*'):
+            # .tmp: write-behind in progress; dotfiles: generator bookkeeping
+            if not file_path.is_file() or file_path.suffix == '.tmp' or file_path.name.startswith('.'):
+                continue
+            try:
+                body = file_path.read_bytes()
+            except OSError as e:
+                self.logger.warning(f"Skipping unreadable mockup file {file_path}: {e}")
+                continue
+            rel = file_path.relative_to(self.mockup_dir).as_posix()
+            entry = {'file': file_path, 'body': body, 'data': None, 'version': 0}
+            entries[rel] = entry
+            if file_path.name == 'index.json':
+                entries[rel[:-len('index.json')].rstrip('/')] = entry
+        # Advertised in memory only; the mockup files are left as generated
+        self._advertise(entries.get('redfish/v1'), {'ProtocolFeaturesSupported': PROTOCOL_FEATURES, **self.root_links})
+        self._advertise(entries.get(self.EVENT_SERVICE), {'ServerSentEventUri': self.SSE_URI})
+        with self._lock:
+            reloaded = bool(self._entries)
+            self._generation = f'{time.time_ns():x}'
+            self._entries = entries
+            self._routes = {}
+            self._dirty.clear()
+            self._root_stat = self._stat_root()
+        resources = sum(1 for k in entries if k.endswith('index.json'))
+        self.logger.info(f"Loaded {resources} resources into memory from {self.mockup_dir}")
+        if reloaded:
+            # Anything may have changed; clients re-read from the service root
+            self._publish([(RESOURCE_CHANGED, '/redfish/v1', None)])
+        return resources
+
+    def _advertise(self, entry, properties: dict):
+        """Merge service capabilities into a resource without marking it dirty."""
+        data = self._data(entry) if entry else None
+        if data is None or all(data.get(k) == v for k, v in properties.items()):
+            return
+        data.update(properties)
+        self._update_body(entry, data)
+
+    @staticmethod
+    def _update_body(entry: dict, data: dict):
+        # Body before version: a reader that sees the new version (and ETag)
+        # is then guaranteed to also see the new body
+        entry['body'] = json.dumps(data, indent=2).encode('utf-8')
+        entry['version'] += 1
+
+    def _publish(self, records):
+        if self.events is not None and records:
+            self.events.publish(records)
+
+    def _maybe_reload(self):
+        now = time.monotonic()
+        if now - self._last_reload_check < self.RELOAD_CHECK_INTERVAL:
+            return
+        # One handler thread checks; the others keep serving the current tree
+        if not self._reload_lock.acquire(blocking=False):
+            return
+        try:
+            self._check_reload(now)
+        finally:
+            self._reload_lock.release()
+
+    def _check_reload(self, now: float):
+        self._last_reload_check = now
+        current = self._stat_root()
+        if current is None or current == self._root_stat:
+            self._changed_stat = None
+            return
+        # Reload only once the replacement has been stable for a full check
+        # interval, so a generator still writing the tree is not caught midway
+        if current != self._changed_stat:
+            self._changed_stat = current
+            return
+        self.logger.info("Mockup tree changed on disk, reloading")
+        self._changed_stat = None
+        self.load()
+
+    def get(self, url_path: str):
+        """Return the serialized body for a URL path, or None if unknown."""
+        found = self.lookup(url_path)
+        return found[0] if found else None
+
+    def lookup(self, url_path: str):
+        """Return (body, etag) for a URL path, or None if unknown."""
+        self._maybe_reload()
+        entry = self._entries.get(self.key_for(url_path))
+        if entry is None:
+            return None
+        # Tag first: if a change lands in between, the body is newer than
+        # the tag, so the client simply refetches on its next request
+        etag = f'"{self._generation}-{entry["version"]}"'
+        return entry['body'], etag
+
+    def route(self, url_path: str):
+        """Path template of a resource for metrics, or None if unknown.
+
+        Members of a collection are replaced by {id}, so
+        /redfish/v1/Chassis/N0/Sensors/S1 is /redfish/v1/Chassis/{id}/Sensors/{id}.
+        """
+        key = self.key_for(url_path)
+        route = self._routes.get(key)
+        if route is None:
+            if key not in self._entries:
+                return None
+            parts = key.split('/')
+            out = []
+            with self._lock:
+                for i, part in enumerate(parts):
+                    parent = self._entries.get('/'.join(parts[:i]))
+                    data = self._data(parent) if parent else None
+                    out.append('{id}' if isinstance(data, dict) and 'Members' in data else part)
+            route = self._routes[key] = '/' + '/'.join(out)
+        return route
+
+    def etag(self, url_path: str):
+        """Current ETag of a resource, or None if unknown."""
+        found = self.lookup(url_path)
+        return found[1] if found else None
+
+    @staticmethod
+    def view_etag(body: bytes) -> str:
+        """ETag for a composed ($expand/$select) response: a digest of its bytes."""
+        return f'"v-{hashlib.blake2b(body, digest_size=8).hexdigest()}"'
+
+    def get_view(self, url_path: str, expand=None, levels: int = 1, select=None):
+        """Return the body with $expand/$select applied, or None if unknown.
+
+        Expanded references are replaced by the referenced resources from the
+        store; references to unknown resources, and any that would loop back
+        to a resource already being expanded, are left as links. For a
+        collection, $select applies to each expanded member.
+        """
+        self._maybe_reload()
+        with self._lock:
+            key = self.key_for(url_path)
+            entry = self._entries.get(key)
+            if entry is None:
+                return None
+            data = self._data(entry)
+            if data is None:
+                return entry['body']
+            if expand:
+                data = self._expand(data, expand, levels, {key}, False)
+            if select:
+                if isinstance(data.get('Members'), list):
+                    data = dict(data)
+                    data['Members'] = [
+                        self._select(m, select) if isinstance(m, dict) and len(m) > 1 else m
+                        for m in data['Members']
+                    ]
+                else:
+                    data = self._select(data, select)
+            # Serialized under the lock: the view shares objects with the store
+            return json.dumps(data, indent=2).encode('utf-8')
+
+    def _expand(self, value, mode: str, levels: int, seen: set, in_links: bool):
+        if levels <= 0:
+            return value
+        if isinstance(value, list):
+            return [self._expand(v, mode, levels, seen, in_links) for v in value]
+        if not isinstance(value, dict):
+            return value
+        if len(value) == 1 and '@odata.id' in value:
+            if mode != '*' and (mode == '~') != in_links:
+                return value
+            key = self.key_for(value['@odata.id'])
+            entry = self._entries.get(key)
+            data = self._data(entry) if entry and key not in seen else None
+            if data is None:
+                return value
+            return self._expand(data, mode, levels - 1, seen | {key}, False)
+        return {k: self._expand(v, mode, levels, seen, in_links or k == 'Links') for k, v in value.items()}
+
+    @staticmethod
+    def _select(resource: dict, paths) -> dict:
+        out = {k: resource[k] for k in SELECT_ALWAYS if k in resource}
+        for path in paths:
+            parts = path.split('/')
+            src, dst = resource, out
+            for i, part in enumerate(parts):
+                if not isinstance(src, dict) or part not in src:
+                    break
+                if i == len(parts) - 1:
+                    dst[part] = src[part]
+                    break
+                node = dst.get(part)
+                if node is src[part]:
+                    break  # already selected whole; never write into store data
+                if not isinstance(node, dict):
+                    node = dst[part] = {}
+                src, dst = src[part], node
+        return out
+
+    @staticmethod
+    def _data(entry: dict):
+        """Parsed resource for an entry (cached), or None if not a JSON object."""
+        if entry['data'] is None:
+            try:
+                data = json.loads(entry['body'].decode('utf-8'))
+            except (ValueError, UnicodeDecodeError):
+                return None
+            if not isinstance(data, dict):
+                return None
+            entry['data'] = data
+        return entry['data']
+
+    def _set_status(self, entry: dict, status: dict) -> dict:
+        resource = entry['data']
+        if not isinstance(resource.get('Status'), dict):
+            resource['Status'] = {}
+        resource['Status'].update(status)
+        self._update_body(entry, resource)
+        self._dirty.add(entry['file'])
+        return dict(resource['Status'])
+
+    def patch_status(self, url_path: str, status: dict):
+        """Merge `status` into the resource's Status and schedule a flush.
+
+        Returns the updated Status dict, or None if the resource is unknown.
+        Raises ValueError if the stored body is not a JSON object.
+        """
+        self._maybe_reload()
+        with self._lock:
+            entry = self._entries.get(self.key_for(url_path))
+            if entry is None:
+                return None
+            if self._data(entry) is None:
+                raise ValueError("resource is not a JSON object")
+            updated = self._set_status(entry, status)
+        self._publish([(RESOURCE_CHANGED, '/' + self.key_for(url_path), {'Status': updated})])
+        return updated
+
+    def resource(self, url_path: str):
+        """A copy of the parsed resource, or None if unknown or not a JSON object."""
+        self._maybe_reload()
+        with self._lock:
+            entry = self._entries.get(self.key_for(url_path))
+            data = self._data(entry) if entry else None
+            return dict(data) if data is not None else None
+
+    def set_properties(self, url_path: str, properties: dict):
+        """Merge top-level `properties` into a resource and schedule a flush.
+
+        Returns False if the resource is unknown or not a JSON object.
+        """
+        self._maybe_reload()
+        with self._lock:
+            entry = self._entries.get(self.key_for(url_path))
+            data = self._data(entry) if entry else None
+            if data is None:
+                return False
+            data.update(properties)
+            self._update_body(entry, data)
+            self._dirty.add(entry['file'])
+        self._publish([(RESOURCE_CHANGED, '/' + self.key_for(url_path), properties)])
+        return True
+
+    def find_member(self, collection_path: str, resource_id: str):
+        """Return the @odata.id of the collection member whose Id matches."""
+        with self._lock:
+            collection = self._entries.get(self.key_for(collection_path))
+            collection = self._data(collection) if collection else None
+            if not collection:
+                return None
+            for member in collection.get('Members', []):
+                if not (isinstance(member, dict) and '@odata.id' in member):
+                    continue
+                entry = self._entries.get(self.key_for(member['@odata.id']))
+                data = self._data(entry) if entry else None
+                if data and data.get('Id') == resource_id:
+                    return member['@odata.id']
+        return None
+
+    def set_subtree_state(self, roots, state: str):
+        """Set Status.State on each root and every resource beneath it.
+
+        Resources beneath a root are those whose URL is prefixed by the root's
+        URL. Instrumentation linked from a root (which the agent's tree walk
+        also visits) is included. Only resources that already carry
+        Status.State are changed. Returns the list of updated URLs.
+        """
+        self._maybe_reload()
+        updated = []
+        records = []
+        with self._lock:
+            keys = [self.key_for(r) for r in roots]
+            for key in list(keys):
+                entry = self._entries.get(key)
+                data = self._data(entry) if entry else None
+                for link in ('AutomationInstrumentation', 'Instrumentation'):
+                    ref = data.get(link) if data else None
+                    if isinstance(ref, dict) and '@odata.id' in ref:
+                        keys.append(self.key_for(ref['@odata.id']))
+            prefixes = tuple(k + '/' for k in keys)
+            seen = set()
+            for key, entry in self._entries.items():
+                # Directory keys only; "<dir>/index.json" aliases the same entry
+                if key.endswith('index.json') or id(entry) in seen:
+                    continue
+                if key not in keys and not key.startswith(prefixes):
+                    continue
+                seen.add(id(entry))
+                data = self._data(entry)
+                status = data.get('Status') if data else None
+                if isinstance(status, dict) and 'State' in status:
+                    if status.get('State') != state:
+                        new_status = self._set_status(entry, {'State': state})
+                        records.append((RESOURCE_CHANGED, '/' + key, {'Status': new_status}))
+                    updated.append('/' + key)
+        self._publish(records)
+        return sorted(updated)
+
+    def set_readings(self, readings: dict):
+        """Apply live sensor values: {"<Sensor @odata.id>": value, ...}.
+
+        Readings are volatile and are not scheduled for flushing; they reach
+        disk only if the same resource is later flushed for another reason.
+        Returns (changed_count, unknown_paths).
+        """
+        self._maybe_reload()
+        changed = []
+        unknown = []
+        with self._lock:
+            for path, value in readings.items():
+                entry = self._entries.get(self.key_for(path))
+                data = self._data(entry) if entry else None
+                if data is None or 'Reading' not in data:
+                    unknown.append(path)
+                    continue
+                if data['Reading'] == value:
+                    continue
+                data['Reading'] = value
+                self._update_body(entry, data)
+                changed.append((READING_CHANGED, '/' + self.key_for(path), {'Reading': value}))
+        self._publish(changed)
+        return len(changed), unknown
+
+    def flush(self) -> int:
+        """Write all dirty resources to disk. Returns the number written.
+
+        Writes never race a reload: while they run, request threads skip the
+        reload check. If the generator has rewritten the tree since it was
+        loaded, the pending changes belong to the old tree and are dropped
+        instead of being written over the new files; the reload follows.
+        """
+        with self._reload_lock:
+            return self._flush_dirty()
+
+    def _flush_dirty(self) -> int:
+        with self._lock:
+            if not self._dirty:
+                return 0
+            by_file = {e['file']: e['body'] for e in self._entries.values() if e['file'] in self._dirty}
+            self._dirty.clear()
+            loaded_stat = self._root_stat
+        root_index = self.mockup_dir.joinpath(*self.ROOT_INDEX)
+        written = 0
+        for file_path, body in by_file.items():
+            if self._stat_root() != loaded_stat:
+                self.logger.info("Mockup tree regenerated on disk; dropping unsaved changes to the old tree")
+                break
+            if not file_path.parent.is_dir():
+                # Pruned by a regeneration; there is nothing left to update
+                self.logger.warning(f"Not persisting {file_path}: its directory no longer exists")
+                continue
+            tmp = None
+            try:
+                fd, tmp = tempfile.mkstemp(dir=str(file_path.parent), suffix='.tmp')
+                with os.fdopen(fd, 'wb') as f:
+                    f.write(body)
+                os.replace(tmp, file_path)
+                written += 1
+            except Exception as e:
+                self.logger.error(f"Failed to persist {file_path}: {e}")
+                if tmp:
+                    try:
+                        os.unlink(tmp)
+                    except OSError:
+                        pass
+                with self._lock:
+                    self._dirty.add(file_path)
+                continue
+            if file_path == root_index:
+                # Our own write of the root index must not look like a regeneration
+                loaded_stat = self._stat_root()
+                with self._lock:
+                    self._root_stat = loaded_stat
+        if written:
+            self.logger.debug(f"Flushed {written} resource(s) to disk")
+        return written
+
+    def start(self):
+        """Start the background flush thread."""
+        if self._flusher is not None:
+            return
+        self._stop.clear()
+        self._flusher = threading.Thread(target=self._flush_loop, name='redfish-flush', daemon=True)
+        self._flusher.start()
+
+    def stop(self):
+        """Stop the flush thread and persist anything outstanding."""
+        self._stop.set()
+        if self._flusher is not None:
+            self._flusher.join(timeout=5)
+            self._flusher = None
+        self.flush()
+
+    def _flush_loop(self):
+        while not self._stop.wait(self.flush_interval):
+            try:
+                self.flush()
+            except Exception as e:
+                self.logger.error(f"Write-behind flush failed: {e}")
+
+
+class EventBroker:
+    """Fan-out of resource changes to EventService Server-Sent Event streams.
+
+    Each publish() becomes one Redfish Event (with one entry per changed
+    resource) that is serialized once and queued to every open stream. A
+    stream that falls QUEUE_SIZE events behind is closed; on reconnect the
+    client re-reads what it shows, which is cheaper than replaying a backlog.
+    Streams hold a worker thread each, so their number is capped.
+    """
+
+    QUEUE_SIZE = 256
+    CLOSE = None
+
+    def __init__(self, max_streams: int = 4):
+        self.max_streams = max(0, int(max_streams))
+        self._lock = threading.Lock()
+        self._streams = set()
+        self._next_id = 0
+
+    def subscribe(self):
+        """Register a stream. Returns its queue, or None if at the cap."""
+        with self._lock:
+            if len(self._streams) >= self.max_streams:
+                return None
+            q = queue.Queue(self.QUEUE_SIZE)
+            self._streams.add(q)
+            return q
+
+    def unsubscribe(self, q):
+        with self._lock:
+            self._streams.discard(q)
+
+    def publish(self, records):
+        """Queue an Event for records of (MessageId, @odata.id, Oem properties)."""
+        with self._lock:
+            if not self._streams:
+                return
+            self._next_id += 1
+            event_id = self._next_id
+            streams = list(self._streams)
+        timestamp = datetime.now(timezone.utc).isoformat(timespec='milliseconds')
+        events = []
+        for n, (message_id, path, properties) in enumerate(records, 1):
+            record = {
+                'EventId': f'{event_id}.{n}',
+                'EventTimestamp': timestamp,
+                'MessageId': message_id,
+                'OriginOfCondition': {'@odata.id': path},
+            }
+            if properties:
+                record['Oem'] = {'IoTFoundry': properties}
+            events.append(record)
+        message = {
+            '@odata.type': '#Event.v1_7_0.Event',
+            'Id': str(event_id),
+            'Name': 'Resource Events',
+            'Events': events,
+        }
+        frame = f"id: {event_id}\ndata: {json.dumps(message)}\n\n".encode('utf-8')
+        for q in streams:
+            try:
+                q.put_nowait(frame)
+            except queue.Full:
+                self._drop(q)
+
+    def _drop(self, q):
+        self.unsubscribe(q)
+        try:
+            while True:
+                q.get_nowait()
+        except queue.Empty:
+            pass
+        q.put_nowait(self.CLOSE)
+
+    def close(self):
+        """End every open stream (server shutdown)."""
+        with self._lock:
+            streams = list(self._streams)
+        for q in streams:
+            self._drop(q)
+
+
+class ControlWriteQueue:
+    """Control PATCHes waiting to be carried out on a device by the agent.
+
+    A PATCH handler submits a write and blocks on it; the runtime agent
+    long-polls take() for pending writes and reports each PLDM completion
+    code back through complete(), which wakes the handler. The agent counts
+    as present while it has polled within AGENT_TIMEOUT seconds, so a PATCH
+    fails fast rather than waiting on nobody.
+    """
+
+    AGENT_TIMEOUT = 5.0
+
+    def __init__(self, timeout: float = 2.0):
+        self.timeout = timeout
+        self._cond = threading.Condition()
+        self._pending = deque()
+        self._writes = {}  # Id -> write, until completed or abandoned
+        self._next_id = 0
+        self._last_poll = None
+
+    def agent_present(self) -> bool:
+        with self._cond:
+            return self._last_poll is not None and time.monotonic() - self._last_poll < self.AGENT_TIMEOUT
+
+    def submit(self, path: str, set_point):
+        """Queue a write; returns it for wait()."""
+        with self._cond:
+            self._next_id += 1
+            write = {'Id': self._next_id, 'Path': path, 'SetPoint': set_point,
+                     'done': threading.Event(), 'result': None}
+            self._writes[write['Id']] = write
+            self._pending.append(write)
+            self._cond.notify_all()
+            return write
+
+    def wait(self, write: dict):
+        """The agent's result ({"CompletionCode": n} or {"Error": "..."}), or None on timeout."""
+        done = write['done'].wait(self.timeout)
+        with self._cond:
+            self._writes.pop(write['Id'], None)
+            if not done:
+                # Not yet taken: drop it so the device never sees a write the client gave up on
+                try:
+                    self._pending.remove(write)
+                except ValueError:
+                    pass
+        return write['result'] if done else None
+
+    def take(self, wait: float):
+        """Pending writes, waiting up to `wait` seconds for the first one."""
+        with self._cond:
+            self._last_poll = time.monotonic()
+            self._cond.wait_for(lambda: self._pending, wait)
+            writes = [{k: w[k] for k in ('Id', 'Path', 'SetPoint')} for w in self._pending]
+            self._pending.clear()
+            self._last_poll = time.monotonic()
+            return writes
+
+    def complete(self, results) -> int:
+        """Record agent results [{"Id": n, "CompletionCode": n | "Error": "..."}]."""
+        completed = 0
+        with self._cond:
+            for result in results:
+                write = self._writes.get(result.get('Id')) if isinstance(result, dict) else None
+                if write is None:
+                    continue
+                write['result'] = {k: result[k] for k in ('CompletionCode', 'Error') if k in result}
+                write['done'].set()
+                completed += 1
+        return completed
+
+
+class ServerStats:
+    """Request latency/throughput counters, reported once per interval."""
+
+    WINDOW = 10000
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._latencies = deque(maxlen=self.WINDOW)
+        self._count = 0
+        self._errors = 0
+        self._window_start = time.monotonic()
+        self.total = 0
+
+    def record(self, seconds: float, status: int):
+        with self._lock:
+            self._latencies.append(seconds)
+            self._count += 1
+            self.total += 1
+            if status >= 500:
+                self._errors += 1
+
+    def snapshot(self, reset: bool = True) -> dict:
+        """Return count, rate and latency percentiles (ms) for this window."""
+        with self._lock:
+            now = time.monotonic()
+            elapsed = max(now - self._window_start, 1e-9)
+            samples = sorted(self._latencies)
+            count, errors = self._count, self._errors
+            if reset:
+                self._latencies.clear()
+                self._count = 0
+                self._errors = 0
+                self._window_start = now
+
+        def pct(p):
+            if not samples:
+                return 0.0
+            return samples[min(len(samples) - 1, int(p * len(samples)))] * 1000.0
+
+        return {
+            'requests': count,
+            'errors': errors,
+            'rps': count / elapsed,
+            'p50_ms': pct(0.50),
+            'p95_ms': pct(0.95),
+            'p99_ms': pct(0.99),
+            'max_ms': samples[-1] * 1000.0 if samples else 0.0,
+        }
+
+
+class PooledHTTPServer(HTTPServer):
+    """HTTPServer that handles each connection on a bounded worker pool.
+
+    A connection occupies one worker for as long as it is kept alive, so
+    `workers` is also the limit on concurrent persistent connections. When
+    every worker is busy the accept loop waits up to `busy_wait` seconds for
+    one to free up, leaving further connections in the listen backlog; a
+    connection still without a worker after that is answered 503 and closed.
+    """
+
+    request_queue_size = 128
+    allow_reuse_address = True
+    busy_wait = 0.5
+
+    BUSY_RESPONSE = (
+        b"HTTP/1.1 503 Service Unavailable\r\n"
+        b"Content-Type: text/plain\r\n"
+        b"Content-Length: 20\r\n"
+        b"Retry-After: 1\r\n"
+        b"Connection: close\r\n"
+        b"\r\n"
+        b"All workers are busy"
+    )
+
+    def __init__(self, server_address, handler_cls, workers: int = 16):
+        super().__init__(server_address, handler_cls)
+        self.workers = max(1, int(workers))
+        self.pool = ThreadPoolExecutor(max_workers=self.workers, thread_name_prefix='redfish-http')
+        self._slots = threading.BoundedSemaphore(self.workers)
+
+    def process_request(self, request, client_address):
+        if not self._slots.acquire(timeout=self.busy_wait):
+            METRICS.inc('redfish_http_busy_rejections_total')
+            self._reject(request)
+            return
+        try:
+            self.pool.submit(self._process_request_worker, request, client_address)
+        except RuntimeError:
+            # Pool already shut down by server_close()
+            self._slots.release()
+            self.shutdown_request(request)
+
+    def _reject(self, request):
+        try:
+            request.settimeout(1.0)
+            request.sendall(self.BUSY_RESPONSE)
+        except OSError:
+            pass
+        self.shutdown_request(request)
+
+    def _process_request_worker(self, request, client_address):
+        try:
+            self.finish_request(request, client_address)
+        except Exception:
+            self.handle_error(request, client_address)
+        finally:
+            self.shutdown_request(request)
+            self._slots.release()
+
+    def server_close(self):
+        super().server_close()
+        self.pool.shutdown(wait=False)
 
 
 class RedfishHandler(BaseHTTPRequestHandler):
     """HTTP request handler for Redfish API."""
     
+    # HTTP/1.1 keeps connections open between requests; every response
+    # therefore carries Content-Length. Idle connections are dropped after
+    # `timeout` seconds so they do not pin a worker.
+    protocol_version = 'HTTP/1.1'
+    timeout = 5
+    # Headers and body are separate writes; without TCP_NODELAY a kept-alive
+    # connection stalls ~40ms per response on Nagle/delayed-ACK interaction
+    disable_nagle_algorithm = True
+    
     # Class variables to share state
     mockup_dir = None
+    store = None
+    events = None
+    controls = None
+    history = None
+    stats = None
     logger = None
     shutdown = None
+    # [server] agent_token; when empty, agent-only actions are accepted from loopback clients only
+    agent_token = ''
+    # Latest PushMetrics snapshot per reporting process
+    pushed_metrics = {}
+    
+    METRICS_URI = 'metrics'
+    
+    def send_response(self, code, message=None):
+        self._status = code
+        super().send_response(code, message)
+    
+    def _route(self) -> str:
+        key = ResourceStore.key_for(self.path)
+        if key in self.ACTIONS or key == self.METRICS_URI:
+            return '/' + key
+        telemetry = sensor_history.telemetry_route(key) if self.history is not None else None
+        if telemetry:
+            return telemetry
+        return (self.store.route(self.path) if self.store is not None else None) or 'unknown'
+    
+    def _record(self, start: float):
+        elapsed = time.perf_counter() - start
+        status = getattr(self, '_status', 0)
+        if self.stats is not None:
+            self.stats.record(elapsed, status)
+        route = self._route()
+        METRICS.inc('redfish_http_requests_total', method=self.command, route=route, code=status)
+        METRICS.observe('redfish_http_request_seconds', elapsed, method=self.command, route=route)
     
     def do_GET(self):
-        """Handle GET requests - serve static JSON files."""
-        # Parse the path
-        parsed_path = urlparse(self.path)
-        rel_path = parsed_path.path.lstrip('/')
-        
-        # Map to file path
-        if rel_path == '' or rel_path == 'redfish/v1':
-            file_path = self.mockup_dir / 'redfish' / 'v1' / 'index.json'
-        else:
-            file_path = self.mockup_dir / rel_path
-        
-        # Security: prevent path traversal
+        """Handle GET requests - serve resources from the in-memory store."""
+        key = ResourceStore.key_for(self.path)
+        if key == ResourceStore.SSE_URI.strip('/'):
+            # Long-lived; kept out of the latency stats
+            self._stream_events()
+            return
+        start = time.perf_counter()
         try:
-            file_path = file_path.resolve()
-            if not str(file_path).startswith(str(self.mockup_dir)):
-                self.send_error(403, "Access denied")
+            if key == self.METRICS_URI:
+                self._serve_metrics()
+            elif self.history is not None and key.startswith(sensor_history.TELEMETRY_SERVICE):
+                self._serve_telemetry(key)
+            else:
+                self._do_GET()
+        finally:
+            self._record(start)
+    
+    def do_PATCH(self):
+        """Handle PATCH requests - modify resource state."""
+        start = time.perf_counter()
+        try:
+            self._do_PATCH()
+        finally:
+            self._record(start)
+    
+    def do_POST(self):
+        """Handle POST requests - OEM actions."""
+        start = time.perf_counter()
+        try:
+            self._do_POST()
+        finally:
+            self._record(start)
+    
+    def _serve_metrics(self):
+        snapshots = dict(self.pushed_metrics)
+        snapshots['server'] = METRICS.snapshot()
+        body = render_prometheus(snapshots).encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/plain; version=0.0.4; charset=utf-8')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+    
+    def _serve_telemetry(self, key: str):
+        """TelemetryService resources and the SensorHistory query, built per request."""
+        if key == sensor_history.SENSOR_HISTORY:
+            query = dict(parse_qsl(urlparse(self.path).query))
+            sensor = query.get('Sensor')
+            resolution = query.get('Resolution', 'raw')
+            try:
+                since = float(query.get('Since', 0))
+            except ValueError:
+                since = None
+            if not sensor or resolution not in sensor_history.RESOLUTIONS or since is None:
+                self.send_error(400, "Sensor, Resolution (raw, 1min, 1h) and numeric Since are expected")
+                self.logger.info(f"GET {self.path} → 400")
                 return
-        except Exception as e:
-            self.send_error(400, f"Invalid path: {e}")
+            resource = self.history.query('/' + ResourceStore.key_for(sensor), resolution, since)
+        else:
+            resource = sensor_history.telemetry_resource(key, self.history)
+        if resource is None:
+            self.send_error(404, "Not found")
+            self.logger.info(f"GET {self.path} → 404")
             return
-        
-        # If path is a directory, serve index.json
-        if file_path.is_dir():
-            file_path = file_path / 'index.json'
-        
-        # Serve the file
-        if file_path.exists() and file_path.is_file():
-            try:
-                with open(file_path, 'r') as f:
-                    content = f.read()
-                
-                self.send_response(200)
-                self.send_header('Content-Type', 'application/json')
-                self.end_headers()
-                self.wfile.write(content.encode('utf-8'))
-                self.logger.info(f"GET {self.path} → 200")
-            except Exception as e:
-                self.send_error(500, f"Error reading file: {e}")
-                self.logger.error(f"GET {self.path} → 500: {e}")
+        content = json.dumps(resource).encode('utf-8')
+        etag = ResourceStore.view_etag(content)
+        if self._etag_matches(etag):
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.end_headers()
+            self.logger.info(f"GET {self.path} → 304")
+            return
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(content)))
+        self.send_header('ETag', etag)
+        self.end_headers()
+        self.wfile.write(content)
+        self.logger.info(f"GET {self.path} → 200")
+    
+    def _do_GET(self):
+        try:
+            expand, levels, select = parse_odata_query(self.path)
+        except ValueError as e:
+            self.send_error(400, str(e))
+            self.logger.info(f"GET {self.path} → 400")
+            return
+        except NotImplementedError as e:
+            self.send_error(501, str(e))
+            self.logger.info(f"GET {self.path} → 501")
+            return
+        if expand or select:
+            content = self.store.get_view(self.path, expand, levels, select)
+            etag = ResourceStore.view_etag(content) if content is not None else None
+        else:
+            found = self.store.lookup(self.path)
+            content, etag = found if found else (None, None)
+        if content is not None and self._etag_matches(etag):
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.end_headers()
+            self.logger.info(f"GET {self.path} → 304")
+        elif content is not None:
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(content)))
+            self.send_header('ETag', etag)
+            self.end_headers()
+            self.wfile.write(content)
+            self.logger.info(f"GET {self.path} → 200")
         else:
             self.send_error(404, "Not found")
             self.logger.info(f"GET {self.path} → 404")
     
-    def do_PATCH(self):
-        """Handle PATCH requests - modify resource state."""
-        # Parse the path
-        parsed_path = urlparse(self.path)
-        rel_path = parsed_path.path.lstrip('/')
-        
-        # Map to file path
-        file_path = self.mockup_dir / rel_path
-        if file_path.is_dir():
-            file_path = file_path / 'index.json'
-        
+    def _etag_matches(self, etag: str) -> bool:
+        """True if the request's If-None-Match names `etag` (weak comparison)."""
+        header = self.headers.get('If-None-Match')
+        if not header or not etag:
+            return False
+        tags = {t.strip() for t in header.split(',')}
+        tags = {t[2:] if t.startswith('W/') else t for t in tags}
+        return '*' in tags or etag in tags
+    
+    # Comment line sent on an idle event stream so proxies and clients
+    # notice a dead connection
+    SSE_KEEPALIVE_INTERVAL = 15.0
+    
+    def _stream_events(self):
+        """Serve the EventService Server-Sent Event stream until the client leaves."""
+        q = self.events.subscribe() if self.events is not None else None
+        if q is None:
+            self.send_error(503, "Too many event streams")
+            self.logger.info(f"GET {self.path} → 503")
+            return
+        # The body has no length, so the connection ends with the stream
+        self.close_connection = True
+        self.logger.info(f"GET {self.path} → event stream opened")
+        try:
+            self.send_response(200)
+            self.send_header('Content-Type', 'text/event-stream')
+            self.send_header('Cache-Control', 'no-cache')
+            self.send_header('Connection', 'close')
+            self.end_headers()
+            self.wfile.write(b"retry: 2000\n\n")
+            idle_since = time.monotonic()
+            while self.shutdown is None or self.shutdown.is_running():
+                try:
+                    frame = q.get(timeout=1.0)
+                except queue.Empty:
+                    if time.monotonic() - idle_since < self.SSE_KEEPALIVE_INTERVAL:
+                        continue
+                    frame = b": keep-alive\n\n"
+                if frame is EventBroker.CLOSE:
+                    break
+                self.wfile.write(frame)
+                idle_since = time.monotonic()
+        except OSError:
+            pass
+        finally:
+            self.events.unsubscribe(q)
+            self.logger.info(f"GET {self.path} → event stream closed")
+    
+    def _do_PATCH(self):
         try:
-            # Security: prevent path traversal
-            file_path = file_path.resolve()
-            if not str(file_path).startswith(str(self.mockup_dir)):
-                self.send_error(403, "Access denied")
-                return
-            
-            if not file_path.exists():
-                self.send_error(404, "Not found")
-                self.logger.info(f"PATCH {self.path} → 404")
-                return
-            
             # Read request body
             content_length = int(self.headers.get('Content-Length', 0))
             if content_length == 0:
@@ -98,36 +1059,264 @@ class RedfishHandler(BaseHTTPRequestHandler):
             body_data = self.rfile.read(content_length)
             patch_payload = json.loads(body_data.decode('utf-8'))
             
-            # Read current resource
-            with open(file_path, 'r') as f:
-                resource = json.load(f)
-            
-            # Apply patch (simple merge for Status.State)
-            if 'Status' in patch_payload:
-                if 'Status' not in resource:
-                    resource['Status'] = {}
-                resource['Status'].update(patch_payload['Status'])
-                self.logger.info(f"PATCH {self.path}: Updated Status.State → {patch_payload['Status'].get('State', '?')}")
+            if (isinstance(patch_payload, dict) and 'SetPoint' in patch_payload
+                    and self.CONTROL_RE.match(ResourceStore.key_for(self.path))):
+                self._patch_control(patch_payload)
+                return
             
-            # Write back to file
-            with open(file_path, 'w') as f:
-                json.dump(resource, f, indent=2)
+            # Apply patch (simple merge for Status.State); persisted by the store
+            status_patch = patch_payload.get('Status') if isinstance(patch_payload, dict) else None
+            status = self.store.patch_status(self.path, status_patch if isinstance(status_patch, dict) else {})
+            if status is None:
+                self.send_error(404, "Not found")
+                self.logger.info(f"PATCH {self.path} → 404")
+                return
+            if isinstance(status_patch, dict):
+                self.logger.info(f"PATCH {self.path}: Updated Status.State → {status_patch.get('State', '?')}")
             
             # Return 200 OK
+            response = json.dumps({"Status": status}).encode('utf-8')
             self.send_response(200)
             self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(response)))
+            etag = self.store.etag(self.path)
+            if etag:
+                self.send_header('ETag', etag)
             self.end_headers()
-            response = {"Status": resource.get("Status", {})}
-            self.wfile.write(json.dumps(response).encode('utf-8'))
+            self.wfile.write(response)
             self.logger.info(f"PATCH {self.path} → 200 OK")
             
         except json.JSONDecodeError as e:
             self.send_error(400, f"Invalid JSON: {e}")
             self.logger.error(f"PATCH {self.path} → 400: {e}")
         except Exception as e:
+            # The body may not have been consumed; don't reuse the connection
+            self.close_connection = True
             self.send_error(500, f"Error processing PATCH: {e}")
             self.logger.error(f"PATCH {self.path} → 500: {e}")
     
+    # Controls whose SetPoint is written through to the device by the agent
+    CONTROL_RE = re.compile(r'^redfish/v1/Chassis/[^/]+/Controls/[^/]+$')
+    
+    def _patch_control(self, payload: dict):
+        """Write a Control's SetPoint to its effecter; 200 once the device accepts it."""
+        control = self.store.resource(self.path)
+        if control is None:
+            self.send_error(404, "Not found")
+            self.logger.info(f"PATCH {self.path} → 404")
+            return
+        set_point = payload['SetPoint']
+        if isinstance(set_point, bool) or not isinstance(set_point, (int, float)):
+            self.send_error(400, "SetPoint must be a number")
+            self.logger.info(f"PATCH {self.path} → 400")
+            return
+        low, high = control.get('SettingMin'), control.get('SettingMax')
+        if (isinstance(low, (int, float)) and set_point < low) or (isinstance(high, (int, float)) and set_point > high):
+            self.send_error(400, f"SetPoint {set_point} outside [{low}, {high}]")
+            self.logger.info(f"PATCH {self.path} → 400")
+            return
+        if self.controls is None or not self.controls.agent_present():
+            self.send_error(503, "No runtime agent is connected to carry out the write")
+            self.logger.info(f"PATCH {self.path} → 503")
+            return
+        
+        result = self.controls.wait(self.controls.submit('/' + ResourceStore.key_for(self.path), set_point))
+        if result is None:
+            self.send_error(504, "The device did not acknowledge the write in time")
+            self.logger.warning(f"PATCH {self.path}: SetPoint → {set_point} timed out")
+            return
+        if 'Error' in result:
+            self.send_error(502, f"Write failed: {result['Error']}")
+            self.logger.warning(f"PATCH {self.path}: SetPoint → {set_point} failed: {result['Error']}")
+            return
+        cc = result.get('CompletionCode')
+        if cc != 0:
+            self.send_error(400, f"Device rejected SetPoint (completion code {cc})")
+            self.logger.info(f"PATCH {self.path}: SetPoint → {set_point} rejected, CC={cc}")
+            return
+        
+        self.store.set_properties(self.path, {'SetPoint': set_point})
+        response = {"SetPoint": set_point}
+        status_patch = payload.get('Status')
+        if isinstance(status_patch, dict):
+            response["Status"] = self.store.patch_status(self.path, status_patch)
+        self.logger.info(f"PATCH {self.path}: SetPoint → {set_point}")
+        
+        body = json.dumps(response).encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        etag = self.store.etag(self.path)
+        if etag:
+            self.send_header('ETag', etag)
+        self.end_headers()
+        self.wfile.write(body)
+    
+    # Bulk state change for one endpoint's Chassis + AutomationNode subtrees.
+    # Body: {"ResourceId": "<Id>", "State": "Enabled" | "UnavailableOffline" | ...}
+    SUBTREE_STATE_ACTION = 'redfish/v1/Actions/Oem/IoTFoundry.SetSubtreeState'
+    SUBTREE_COLLECTIONS = ('/redfish/v1/Chassis', '/redfish/v1/AutomationNodes')
+    
+    # Batched live sensor values from the runtime agent.
+    # Body: {"Readings": {"/redfish/v1/Chassis/<id>/Sensors/<sid>": <value>, ...}}
+    UPDATE_READINGS_ACTION = 'redfish/v1/Actions/Oem/IoTFoundry.UpdateReadings'
+    
+    # Control writes for the runtime agent, long-polled.
+    # Body: {"Wait": <seconds>}; reply: {"Writes": [{"Id": n, "Path": "...", "SetPoint": v}, ...]}
+    TAKE_CONTROL_WRITES_ACTION = 'redfish/v1/Actions/Oem/IoTFoundry.TakeControlWrites'
+    # Body: {"Results": [{"Id": n, "CompletionCode": n} | {"Id": n, "Error": "..."}, ...]}
+    COMPLETE_CONTROL_WRITES_ACTION = 'redfish/v1/Actions/Oem/IoTFoundry.CompleteControlWrites'
+    # Upper bound on one TakeControlWrites long-poll
+    MAX_CONTROL_WAIT = 2.0
+    
+    # Metrics of another process, served with the server's own at /metrics.
+    # Body: {"Process": "agent", "Metrics": <pldm_mapping_wizard.metrics snapshot>}
+    PUSH_METRICS_ACTION = 'redfish/v1/Actions/Oem/IoTFoundry.PushMetrics'
+    # Processes that push metrics; one snapshot is kept per name
+    PUSH_METRICS_PROCESSES = frozenset(('agent',))
+    
+    ACTIONS = frozenset((SUBTREE_STATE_ACTION, UPDATE_READINGS_ACTION, TAKE_CONTROL_WRITES_ACTION,
+                         COMPLETE_CONTROL_WRITES_ACTION, PUSH_METRICS_ACTION))
+    # Only the runtime agent may call these; see _agent_authorized()
+    AGENT_ACTIONS = frozenset((UPDATE_READINGS_ACTION, TAKE_CONTROL_WRITES_ACTION, COMPLETE_CONTROL_WRITES_ACTION,
+                               PUSH_METRICS_ACTION))
+    
+    def _agent_authorized(self) -> bool:
+        """True if the request comes from the runtime agent.
+
+        With [server] agent_token set, the request must carry it in the
+        X-IoTFoundry-Agent-Token header. Without one, only loopback clients
+        are trusted, which fits the default single-host deployment.
+        """
+        if self.agent_token:
+            presented = self.headers.get(AGENT_TOKEN_HEADER) or ''
+            return hmac.compare_digest(presented.encode('utf-8'), self.agent_token.encode('utf-8'))
+        try:
+            return ipaddress.ip_address(self.client_address[0]).is_loopback
+        except (ValueError, IndexError, TypeError):
+            return False
+    
+    def _send_json(self, obj):
+        response = json.dumps(obj).encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(response)))
+        self.end_headers()
+        self.wfile.write(response)
+    
+    def _do_POST(self):
+        try:
+            content_length = int(self.headers.get('Content-Length', 0))
+            body_data = self.rfile.read(content_length) if content_length else b''
+            
+            action = ResourceStore.key_for(self.path)
+            if action in self.AGENT_ACTIONS and not self._agent_authorized():
+                self.send_error(403, "Agent credential required")
+                self.logger.warning(f"POST {self.path} from {self.client_address[0]} → 403")
+                return
+            if action == self.UPDATE_READINGS_ACTION:
+                self._update_readings(body_data)
+                return
+            if action in (self.TAKE_CONTROL_WRITES_ACTION, self.COMPLETE_CONTROL_WRITES_ACTION):
+                self._control_writes(action, body_data)
+                return
+            if action == self.PUSH_METRICS_ACTION:
+                self._push_metrics(body_data)
+                return
+            if action != self.SUBTREE_STATE_ACTION:
+                self.send_error(404, "Not found")
+                self.logger.info(f"POST {self.path} → 404")
+                return
+            
+            payload = json.loads(body_data.decode('utf-8')) if body_data else {}
+            resource_id = payload.get('ResourceId') if isinstance(payload, dict) else None
+            state = payload.get('State') if isinstance(payload, dict) else None
+            if not isinstance(resource_id, str) or not isinstance(state, str) or not state:
+                self.send_error(400, "ResourceId and State are required")
+                self.logger.info(f"POST {self.path} → 400")
+                return
+            
+            roots = [p for p in (self.store.find_member(c, resource_id) for c in self.SUBTREE_COLLECTIONS) if p]
+            if not roots:
+                self.send_error(404, f"No resource with Id {resource_id}")
+                self.logger.info(f"POST {self.path} ({resource_id}) → 404")
+                return
+            
+            updated = self.store.set_subtree_state(roots, state)
+            self.logger.info(f"POST {self.path}: {resource_id} State → {state} ({len(updated)} resources)")
+            
+            self._send_json({
+                "ResourceId": resource_id,
+                "State": state,
+                "Roots": roots,
+                "Updated": updated,
+            })
+            
+        except json.JSONDecodeError as e:
+            self.send_error(400, f"Invalid JSON: {e}")
+            self.logger.error(f"POST {self.path} → 400: {e}")
+        except Exception as e:
+            self.close_connection = True
+            self.send_error(500, f"Error processing POST: {e}")
+            self.logger.error(f"POST {self.path} → 500: {e}")
+    
+    def _update_readings(self, body_data: bytes):
+        payload = json.loads(body_data.decode('utf-8')) if body_data else {}
+        readings = payload.get('Readings') if isinstance(payload, dict) else None
+        if not isinstance(readings, dict):
+            self.send_error(400, "Readings object is required")
+            self.logger.info(f"POST {self.path} → 400")
+            return
+        changed, unknown = self.store.set_readings(readings)
+        if self.history is not None:
+            missing = set(unknown)
+            tracked = self.history.record({'/' + ResourceStore.key_for(p): v for p, v in readings.items()
+                                           if p not in missing})
+            METRICS.set('redfish_history_sensors', tracked)
+        # Readings arrive continuously; keep them out of the INFO log
+        self.logger.debug(f"POST {self.path}: {len(readings)} readings, {changed} changed, {len(unknown)} unknown")
+        self._send_json({"Changed": changed, "Unknown": unknown})
+    
+    def _push_metrics(self, body_data: bytes):
+        payload = json.loads(body_data.decode('utf-8')) if body_data else {}
+        process = payload.get('Process') if isinstance(payload, dict) else None
+        snapshot = payload.get('Metrics') if isinstance(payload, dict) else None
+        if not isinstance(process, str) or process not in self.PUSH_METRICS_PROCESSES:
+            self.send_error(400, f"Process must be one of: {', '.join(sorted(self.PUSH_METRICS_PROCESSES))}")
+            self.logger.info(f"POST {self.path} → 400")
+            return
+        try:
+            check_snapshot(snapshot)
+        except ValueError as e:
+            self.send_error(400, f"Invalid Metrics: {e}")
+            self.logger.info(f"POST {self.path} → 400: {e}")
+            return
+        self.pushed_metrics[process] = snapshot
+        self.logger.debug(f"POST {self.path}: metrics from {process}")
+        self._send_json({"Process": process})
+    
+    def _control_writes(self, action: str, body_data: bytes):
+        if self.controls is None:
+            self.send_error(404, "Not found")
+            return
+        payload = json.loads(body_data.decode('utf-8')) if body_data else {}
+        if not isinstance(payload, dict):
+            self.send_error(400, "JSON object is required")
+            return
+        if action == self.TAKE_CONTROL_WRITES_ACTION:
+            try:
+                wait = min(max(float(payload.get('Wait', 0)), 0.0), self.MAX_CONTROL_WAIT)
+            except (TypeError, ValueError):
+                self.send_error(400, "Wait must be a number")
+                return
+            self._send_json({"Writes": self.controls.take(wait)})
+            return
+        results = payload.get('Results')
+        if not isinstance(results, list):
+            self.send_error(400, "Results array is required")
+            return
+        self._send_json({"Completed": self.controls.complete(results)})
+    
     def log_message(self, format, *args):
         """Suppress default HTTP server logging."""
         pass  # We're using our own logger
@@ -151,19 +1340,70 @@ def start_server(config: ConfigManager, logger, shutdown):
     logger.info(f"Server listening on {host}:{port}")
     logger.info("Press Ctrl+C to stop...")
     
+    # Load the mockup tree once; GETs are served from memory
+    flush_interval = float(config.get('server', 'flush_interval', '1.0'))
+    store = ResourceStore(mockup_path, logger, flush_interval)
+    
+    # Reading history, bounded per sensor
+    history_settings = HistorySettings(config)
+    history = HistoryStore(history_settings, logger) if history_settings.enabled else None
+    if history is not None:
+        store.root_links['TelemetryService'] = {'@odata.id': '/' + sensor_history.TELEMETRY_SERVICE}
+        per_sensor = history_settings.bytes_per_sensor()
+        logger.info(f"Sensor history: {per_sensor} bytes per sensor, up to {history_settings.max_sensors} sensors "
+                    f"({per_sensor * history_settings.max_sensors / 2**20:.1f} MiB)")
+    store.load()
+    store.start()
+    
+    workers = config.getint('server', 'workers', 16)
+    keepalive_timeout = float(config.get('server', 'keepalive_timeout', '5'))
+    stats_interval = config.getint('server', 'stats_interval', 60)
+    logger.info(f"Worker threads: {workers}, keep-alive timeout: {keepalive_timeout}s")
+    
+    # Event streams each hold a worker; keep some for ordinary requests
+    max_event_streams = min(config.getint('server', 'max_event_streams', 4), max(0, workers - 1))
+    events = EventBroker(max_event_streams)
+    store.events = events
+    logger.info(f"Event streams: up to {max_event_streams} at {ResourceStore.SSE_URI}")
+    
+    # Control PATCHes wait this long for the agent to report the device's reply
+    controls = ControlWriteQueue(float(config.get('controls', 'timeout', '2.0')))
+    
     # Set class variables
+    stats = ServerStats()
     RedfishHandler.mockup_dir = mockup_path
+    RedfishHandler.store = store
+    RedfishHandler.events = events
+    RedfishHandler.controls = controls
+    RedfishHandler.history = history
+    RedfishHandler.stats = stats
+    RedfishHandler.timeout = keepalive_timeout
     RedfishHandler.logger = logger
     RedfishHandler.shutdown = shutdown
+    RedfishHandler.agent_token = agent_token(config)
     
     try:
         # Create and start HTTP server
         server_address = (host, port)
-        httpd = HTTPServer(server_address, RedfishHandler)
+        httpd = PooledHTTPServer(server_address, RedfishHandler, workers)
+        # Wake periodically so shutdown and stats reporting are not blocked
+        # waiting for the next connection
+        httpd.timeout = 0.5
         
-        # Run server until shutdown signal
+        # Run server until shutdown signal; connections are handled on the pool
+        last_report = time.monotonic()
         while shutdown.is_running():
-            httpd.handle_request()  # Handle one request at a time
+            httpd.handle_request()
+            if stats_interval > 0 and time.monotonic() - last_report >= stats_interval:
+                last_report = time.monotonic()
+                snap = stats.snapshot()
+                if snap['requests']:
+                    logger.info(
+                        f"HTTP stats: {snap['requests']} req ({snap['rps']:.1f}/s), "
+                        f"p50={snap['p50_ms']:.2f}ms p95={snap['p95_ms']:.2f}ms "
+                        f"p99={snap['p99_ms']:.2f}ms max={snap['max_ms']:.2f}ms, "
+                        f"{snap['errors']} errors"
+                    )
         
         httpd.server_close()
         logger.info("Server stopped gracefully")
@@ -175,6 +1415,9 @@ def start_server(config: ConfigManager, logger, shutdown):
     except Exception as e:
         logger.error(f"Server error: {e}", exc_info=True)
         return False
+    finally:
+        events.close()
+        store.stop()
 
 
 def main():
@@ -182,7 +1425,7 @@ def main():
     try:
         # Load config
         demo_root = Path(__file__).parents[1]
-        config_path = demo_root / 'configs' / 'demo.ini'
+        config_path = demo_config_path(demo_root)
         config = ConfigManager(config_path)
         config.load()
         
@@ -2,26 +2,153 @@
 """
 Part 3: Runtime Agent - monitors USB port connectivity and manages resource state.
 """
+import os
 import sys
 import json
+import time
+import errno
+import socket
 import base64
+import hashlib
 import asyncio
+import functools
+import threading
 import subprocess
 import importlib.util
 import requests
 import io
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
-from typing import Dict, Set, Tuple, Optional
-from shared import ConfigManager, LogManager, ProcessManager, GracefulShutdown
+from typing import Dict, List, Set, Tuple, Optional
+from shared import (AGENT_TOKEN_HEADER, ConfigManager, LogManager, ProcessManager, GracefulShutdown,
+                    agent_token, demo_config_path)
+from sensor_poller import SensorPollManager, sensor_specs_from_pdrs
+from control_writer import ControlWriter, effecter_specs_from_pdrs
+from port_broker import TransportBroker, PRIORITY_DISCOVERY, load_serial_port_cls
+from agent_state import AgentState, usb_identity
+from match_scheduler import MatchScheduler
+from pldm_mapping_wizard.metrics import METRICS  # pldm_tools is put on sys.path by port_broker
+from port_filter import PortFilter
+
+
+@functools.lru_cache(maxsize=None)
+def fru_reader():
+    """The pldm_tools streaming FRU parser module."""
+    pldm_tools_dir = str(Path(__file__).parents[1] / 'pldm_tools')
+    if pldm_tools_dir not in sys.path:
+        sys.path.insert(0, pldm_tools_dir)
+    from pldm_mapping_wizard.discovery import fru_reader as module
+    return module
+
+
+def fru_serial_end(table: bytes) -> Optional[int]:
+    """Offset just past the first General record's Serial Number field.
+
+    Returns None if the table (or the prefix received so far) does not
+    contain a complete serial number field.
+    """
+    reader = fru_reader()
+    stream = reader.FRUTableStream(want=[reader.SERIAL_NUMBER])
+    stream.feed(table)
+    return stream.end_of(reader.SERIAL_NUMBER)
+
+
+def fru_fingerprint(table: bytes) -> str:
+    """Fingerprint of a whole (padding/CRC-stripped) FRU record table."""
+    return hashlib.sha256(bytes(table)).hexdigest()
+
+
+def fru_probe_key(table: bytes, end: Optional[int] = None) -> Optional[str]:
+    """Fingerprint of the table up to and including the serial number.
+
+    A device can be identified by this key after reading only the first
+    part(s) of its FRU table. None when the table carries no serial. `end`
+    is the serial's end offset when the caller has already parsed it.
+    """
+    if end is None:
+        end = fru_serial_end(table)
+    return hashlib.sha256(memoryview(table)[:end]).hexdigest() if end else None
+
+
+class FRUIndex:
+    """Known endpoints indexed by FRU fingerprint for O(1) re-identification."""
+
+    def __init__(self, endpoints: Dict[str, Dict]):
+        self.source = endpoints
+        self.by_fingerprint: Dict[str, List[str]] = {}
+        self.by_probe_key: Dict[str, List[str]] = {}
+        for bus_port, ep in endpoints.items():
+            fru = ep.get('fru_data')
+            if not fru:
+                continue
+            self.by_fingerprint.setdefault(fru_fingerprint(fru), []).append(bus_port)
+            key = fru_probe_key(fru)
+            if key:
+                self.by_probe_key.setdefault(key, []).append(bus_port)
+
+    @staticmethod
+    def _candidates(bus_ports: List[str], new_port: str, any_port: bool) -> List[str]:
+        # Physical USB ports may only match the endpoint at the same address
+        return list(bus_ports) if any_port else [p for p in bus_ports if p == new_port]
+
+    def lookup(self, fru: bytes, new_port: str, any_port: bool) -> List[str]:
+        """Known endpoints whose whole FRU table equals `fru`."""
+        return self._candidates(self.by_fingerprint.get(fru_fingerprint(fru), ()), new_port, any_port)
+
+    def lookup_probe(self, key: str, new_port: str, any_port: bool) -> List[str]:
+        """Known endpoints whose FRU prefix through the serial matches `key`."""
+        return self._candidates(self.by_probe_key.get(key, ()), new_port, any_port)
+
+
+class EndpointPDRs:
+    """Raw PDRs of one known endpoint, fetched and decoded only when used.
+
+    `loader` returns the endpoint's raw PDR bytes. It runs on first access
+    (typically when the endpoint connects and its sensors are needed), and
+    the records are interned in the shared PDRCache as LazyPDRs, so only
+    the fields that are read get decoded.
+    """
+
+    def __init__(self, loader, cache, resource_id: Optional[str]):
+        self._loader = loader
+        self._cache = cache
+        self._resource_id = resource_id
+        self._records = None
+        self._sensors = None
+        self._effecters = None
+        self._lock = threading.Lock()
+
+    def records(self) -> list:
+        if self._records is None:
+            with self._lock:
+                if self._records is None:
+                    self._records = [self._cache.intern(raw) for raw in self._loader()]
+                    self._loader = None
+        return self._records
+
+    def sensors(self) -> List[dict]:
+        """Sampling specs for the endpoint's sensors (see sensor_specs_from_pdrs)."""
+        if self._sensors is None:
+            self._sensors = sensor_specs_from_pdrs(self.records(), self._resource_id)
+        return self._sensors
+
+    def effecters(self) -> List[dict]:
+        """Write specs for the endpoint's Controls (see effecter_specs_from_pdrs)."""
+        if self._effecters is None:
+            self._effecters = effecter_specs_from_pdrs(self.records(), self._resource_id)
+        return self._effecters
 
 
 class FRUMatcher:
     """Matches endpoints by comparing FRU data byte-for-byte."""
     
-    def __init__(self, logger):
+    def __init__(self, logger, transport: Optional[TransportBroker] = None):
         self.logger = logger
-        self.serial_port_cls = None
+        self.transport = transport or TransportBroker(logger=logger)
         self.export_mod = self._load_export_module()
+        # Thread pool for the blocking serial reads (None: asyncio's default)
+        self.executor = None
     
     def _load_export_module(self):
         """Dynamically load export_pdrs_to_json module for FRU retrieval."""
@@ -46,8 +173,8 @@ class FRUMatcher:
             
             # Load SerialPort for PLDM communication
             try:
-                from pldm_mapping_wizard.serial_transport import SerialPort
-                self.serial_port_cls = SerialPort
+                if self.transport.serial_cls is None:
+                    self.transport.serial_cls = load_serial_port_cls()
                 self.logger.debug("SerialPort class loaded successfully")
             except ImportError as ie:
                 self.logger.warning(f"Could not import SerialPort: {ie}")
@@ -75,7 +202,7 @@ class FRUMatcher:
             loop = asyncio.get_running_loop()
             # Run in thread pool to avoid blocking
             fru_data = await loop.run_in_executor(
-                None,
+                self.executor,
                 self._get_fru_data_sync,
                 port
             )
@@ -96,7 +223,7 @@ class FRUMatcher:
         try:
             loop = asyncio.get_running_loop()
             ok = await loop.run_in_executor(
-                None,
+                self.executor,
                 self._probe_fru_sync,
                 port
             )
@@ -105,23 +232,34 @@ class FRUMatcher:
             self.logger.debug(f"FRU probe failed for {port}: {e}")
             return False
 
+    async def get_fru_probe_key_async(self, port: str) -> Optional[str]:
+        """Probe key of the FRU prefix through the serial number (in thread pool)."""
+        if not self.export_mod:
+            return None
+
+        try:
+            loop = asyncio.get_running_loop()
+            return await loop.run_in_executor(self.executor, self._get_fru_probe_key_sync, port)
+        except Exception as e:
+            self.logger.debug(f"FRU probe key read failed for {port}: {e}")
+            return None
+
     def _probe_fru_sync(self, port: str) -> bool:
         """Synchronous probe implementation that calls get_fru_record_table_metadata.
 
         Returns True on success, False on failure.
         """
         try:
-            if not self.export_mod or not self.serial_port_cls:
+            if not self.export_mod or not self.transport.serial_cls:
                 self.logger.debug(f"  [PROBE SYNC] Export module or SerialPort not loaded for {port}")
                 return False
 
-            self.logger.debug(f"  [PROBE SYNC] Opening PLDM port {port} for metadata probe...")
-            pldm_port = self.serial_port_cls(port=port, baudrate=115200, timeout=1)
-            if not pldm_port.open():
-                self.logger.debug(f"  [PROBE SYNC] Failed to open port {port} for probe")
-                return False
+            self.logger.debug(f"  [PROBE SYNC] Leasing PLDM port {port} for metadata probe...")
+            with self.transport.lease(port, PRIORITY_DISCOVERY, timeout=1) as pldm_port:
+                if pldm_port is None:
+                    self.logger.debug(f"  [PROBE SYNC] Failed to open port {port} for probe")
+                    return False
 
-            try:
                 metadata, ferr = self.export_mod.get_fru_record_table_metadata(pldm_port)
                 if ferr or not metadata:
                     self.logger.debug(f"  [PROBE SYNC] Probe failed on {port}, ferr={ferr}")
@@ -143,8 +281,6 @@ class FRUMatcher:
 
                 self.logger.debug(f"  [PROBE SYNC] Probe reported empty FRU for {port}: num_records={num_records} table_len={table_len}")
                 return False
-            finally:
-                pldm_port.close()
 
         except Exception as e:
             self.logger.debug(f"  [PROBE SYNC] Exception during probe on {port}: {e}")
@@ -160,20 +296,18 @@ class FRUMatcher:
             FRU data bytes or None if retrieval fails
         """
         try:
-            if not self.export_mod or not self.serial_port_cls:
+            if not self.export_mod or not self.transport.serial_cls:
                 self.logger.warning(f"  [FRU SYNC] Export module or SerialPort not loaded for {port}")
                 return None
             
-            self.logger.debug(f"  [FRU SYNC] Opening PLDM port {port}...")
+            self.logger.debug(f"  [FRU SYNC] Leasing PLDM port {port}...")
             
             # Use the same approach as the export module
-            pldm_port = self.serial_port_cls(port=port, baudrate=115200, timeout=2)
-            
-            if not pldm_port.open():
-                self.logger.warning(f"  [FRU SYNC] Failed to open port {port}")
-                return None
-            
-            try:
+            with self.transport.lease(port, PRIORITY_DISCOVERY, timeout=2) as pldm_port:
+                if pldm_port is None:
+                    self.logger.warning(f"  [FRU SYNC] Failed to open port {port}")
+                    return None
+
                 # Probe metadata first to learn expected FRU length so we can
                 # trim padding/CRC exactly the same way the configurator/builder does.
                 metadata, ferr_meta = None, None
@@ -189,21 +323,19 @@ class FRUMatcher:
                     except Exception:
                         expected_len = None
 
-                # Request FRU table with expected_length hint so export logic can trim
-                table_data, ferr = self.export_mod.get_fru_record_table(pldm_port, transfer_context=0, expected_length=expected_len)
+                # Request FRU table with expected_length hint so export logic can trim;
+                # the stream finds the record boundaries as the parts arrive
+                stream = fru_reader().FRUTableStream(total_length=expected_len)
+                table_data, ferr = self.export_mod.get_fru_record_table(
+                    pldm_port, transfer_context=0, expected_length=expected_len, stream=stream
+                )
 
                 if ferr or not table_data:
                     self.logger.warning(f"  [FRU SYNC] Failed to get FRU table from {port}, ferr={ferr}")
                     return None
 
-                # Use parser to determine how many bytes were actually consumed (strip padding/CRC)
-                try:
-                    if expected_len is not None:
-                        parsed_records, consumed = self.export_mod.parse_fru_record_table(table_data, expected_len)
-                    else:
-                        parsed_records, consumed = self.export_mod.parse_fru_record_table(table_data)
-                except Exception:
-                    parsed_records, consumed = [], 0
+                # Bytes taken by whole records (strips padding/CRC); no field dicts are built
+                consumed = stream.finish()
 
                 # If parser consumed nothing, try to use expected_len or fall back to full length
                 if not consumed:
@@ -219,9 +351,6 @@ class FRUMatcher:
                 self.logger.info(f"  [FRU SYNC] Retrieved {len(actual_table)} bytes from {port}")
                 return actual_table
                 
-            finally:
-                pldm_port.close()
-                
         except FileNotFoundError:
             self.logger.warning(f"  [FRU SYNC] Device not found: {port}")
             return None
@@ -232,28 +361,281 @@ class FRUMatcher:
             self.logger.warning(f"  [FRU SYNC] Exception on {port}: {type(e).__name__}: {e}")
             return None
     
+    def _get_fru_probe_key_sync(self, port: str) -> Optional[str]:
+        """Read the FRU table only as far as the serial number and return its probe key.
+
+        The GetFRURecordTable transfer is abandoned as soon as the serial
+        field has arrived; the next request starts a fresh transfer.
+        """
+        try:
+            if not self.export_mod or not self.transport.serial_cls:
+                return None
+            reader = fru_reader()
+            stream = reader.FRUTableStream(want=[reader.SERIAL_NUMBER])
+            with self.transport.lease(port, PRIORITY_DISCOVERY, timeout=2) as pldm_port:
+                if pldm_port is None:
+                    self.logger.debug(f"  [FRU KEY] Failed to open port {port}")
+                    return None
+                prefix, ferr = self.export_mod.get_fru_record_table(pldm_port, transfer_context=0, stream=stream)
+            if ferr or not prefix:
+                self.logger.debug(f"  [FRU KEY] Partial FRU read failed on {port}, ferr={ferr}")
+                return None
+            end = stream.end_of(reader.SERIAL_NUMBER)
+            key = fru_probe_key(prefix, end) if end else None
+            self.logger.debug(f"  [FRU KEY] {port}: read {len(prefix)} bytes, key={'none' if key is None else key[:16]}")
+            return key
+        except Exception as e:
+            self.logger.debug(f"  [FRU KEY] Exception on {port}: {type(e).__name__}: {e}")
+            return None
+
     def compare_fru(self, fru1: bytes, fru2: bytes) -> bool:
         """Compare two FRU data blocks byte-for-byte."""
         return fru1 == fru2
 
 
+class UeventListener:
+    """Kernel uevent listener for tty hotplug (NETLINK_KOBJECT_UEVENT).
+
+    Receives the kernel's own broadcast group, so no udev daemon or pyudev is
+    required. Only tty add/remove events for the watched device prefixes are
+    reported; each is passed to `callback(action, port_id, device_path)`.
+    """
+
+    NETLINK_KOBJECT_UEVENT = 15
+    KERNEL_GROUP = 1
+    RCVBUF = 1 << 20
+
+    def __init__(self, logger, callback, tty_prefixes=('ttyUSB',)):
+        self.logger = logger
+        self.callback = callback
+        self.tty_prefixes = tuple(tty_prefixes)
+        self.sock = None
+        self.overflowed = False
+        self._loop = None
+
+    def open(self) -> bool:
+        """Open and bind the netlink socket. Returns False if unavailable."""
+        if not hasattr(socket, 'AF_NETLINK'):
+            return False
+        try:
+            sock = socket.socket(socket.AF_NETLINK, socket.SOCK_DGRAM, self.NETLINK_KOBJECT_UEVENT)
+            try:
+                sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, self.RCVBUF)
+            except OSError:
+                pass
+            sock.bind((0, self.KERNEL_GROUP))
+            sock.setblocking(False)
+        except OSError as e:
+            self.logger.debug(f"netlink uevent socket unavailable: {e}")
+            return False
+        self.sock = sock
+        return True
+
+    def attach(self, loop: asyncio.AbstractEventLoop):
+        """Register the socket with the event loop so events are pushed."""
+        self._loop = loop
+        loop.add_reader(self.sock.fileno(), self._on_readable)
+
+    def close(self):
+        if self.sock is None:
+            return
+        if self._loop is not None:
+            try:
+                self._loop.remove_reader(self.sock.fileno())
+            except Exception:
+                pass
+        self.sock.close()
+        self.sock = None
+
+    def _on_readable(self):
+        while self.sock is not None:
+            try:
+                data = self.sock.recv(65536)
+            except BlockingIOError:
+                return
+            except OSError as e:
+                if e.errno == errno.ENOBUFS:
+                    # Kernel dropped events; caller must resync with a scan
+                    self.overflowed = True
+                    self.callback('resync', None, None)
+                    continue
+                self.logger.debug(f"uevent recv failed: {e}")
+                return
+            self._handle(data)
+
+    def _handle(self, data: bytes):
+        event = self.parse(data)
+        if not event:
+            return
+        action = event.get('ACTION')
+        if action not in ('add', 'remove') or event.get('SUBSYSTEM') != 'tty':
+            return
+        devname = event.get('DEVNAME', '')
+        tty_name = devname.rsplit('/', 1)[-1]
+        if not tty_name.startswith(self.tty_prefixes):
+            return
+        port_id = USBPortMonitor.port_id_from_path(event.get('DEVPATH'))
+        if not port_id:
+            return
+        self.callback(action, port_id, f"/dev/{tty_name}")
+
+    @staticmethod
+    def parse(data: bytes) -> Optional[Dict[str, str]]:
+        """Decode a kernel uevent: "action@devpath\\0KEY=VALUE\\0...".
+
+        Messages from udevd ("libudev" binary header) are ignored.
+        """
+        if data.startswith(b'libudev'):
+            return None
+        fields = data.split(b'\0')
+        if not fields or b'@' not in fields[0]:
+            return None
+        event = {}
+        for field in fields[1:]:
+            key, sep, value = field.partition(b'=')
+            if sep:
+                event[key.decode('ascii', 'replace')] = value.decode('utf-8', 'replace')
+        return event
+
+
 class USBPortMonitor:
     """Monitors USB port connectivity."""
     
-    def __init__(self, logger):
+    def __init__(self, logger, transport: Optional[TransportBroker] = None):
         self.logger = logger
         self.connected_ports = set()
         self.endpoint_map = {}
         self.port_to_device = {}  # Maps port ID (e.g., "1-1") to device path (e.g., "/dev/ttyUSB0")
-        self.fru_matcher = FRUMatcher(logger)
+        self.fru_matcher = FRUMatcher(logger, transport)
+        self.transport = self.fru_matcher.transport
+        self.fru_index: Optional[FRUIndex] = None
+        self.pdr_cache = None  # pdr_decoder.PDRCache, created with the first endpoint load
         self.probe_failed_ports = set()
+        # Ports this agent owns when the fleet is sharded ([agent] ports)
+        self.port_filter = PortFilter()
+        # Hotplug (uevent) state; None means the periodic scan is used
+        self.hotplug = None
+        self.hotplug_ports = {}
+        self.resync_interval = 60.0
+        self.settle_time = 0.25
+        self._last_resync = 0.0
+        self._resync_needed = True
+        self._pending_nodes = False
+        self._wake = None
+
+    def start_hotplug(self, backend: str = 'auto', resync_interval: float = 60.0, settle_time: float = 0.25) -> bool:
+        """Switch to uevent-driven change detection.
+
+        backend: 'auto' (netlink with scan fallback), 'netlink' (uevents
+        required), or 'poll'. Must be called from within the running event
+        loop. Returns True if uevents are active; otherwise detection keeps
+        using the scan. Raises RuntimeError if backend is 'netlink' and the
+        uevent socket cannot be opened.
+        """
+        backend = (backend or 'auto').strip().lower()
+        if backend == 'poll':
+            self.logger.info("Hotplug backend: poll (periodic sysfs scan)")
+            return False
+        listener = UeventListener(self.logger, self._on_uevent)
+        if not listener.open():
+            if backend == 'netlink':
+                raise RuntimeError("hotplug_backend = netlink, but the uevent socket cannot be opened "
+                                   "(use auto to fall back to the periodic sysfs scan)")
+            self.logger.info("Hotplug backend: netlink unavailable, falling back to periodic sysfs scan")
+            return False
+        self._wake = asyncio.Event()
+        listener.attach(asyncio.get_running_loop())
+        self.hotplug = listener
+        self.resync_interval = max(1.0, float(resync_interval))
+        self.settle_time = max(0.0, float(settle_time))
+        self._resync_needed = True
+        self.logger.info(f"Hotplug backend: netlink uevents (resync every {self.resync_interval:.0f}s)")
+        return True
+
+    def stop_hotplug(self):
+        if self.hotplug is not None:
+            self.hotplug.close()
+            self.hotplug = None
+
+    def _on_uevent(self, action: str, port_id: Optional[str], device_path: Optional[str]):
+        if action in ('add', 'remove') and not self.port_filter.owns(port_id):
+            return
+        if action == 'resync':
+            self.logger.warning("uevent buffer overflow, scheduling full rescan")
+            self._resync_needed = True
+        elif action == 'add':
+            self.logger.debug(f"uevent add: {port_id} → {device_path}")
+            self.hotplug_ports[port_id] = device_path
+            self.port_to_device[port_id] = device_path
+        elif action == 'remove':
+            self.logger.debug(f"uevent remove: {port_id} ({device_path})")
+            # A re-enumerated port may already carry a new tty; only drop ours
+            if self.hotplug_ports.get(port_id) in (device_path, None):
+                self.hotplug_ports.pop(port_id, None)
+        if self._wake is not None:
+            self._wake.set()
+
+    async def wait_for_change(self, poll_interval: float):
+        """Sleep until the next detection pass is due.
+
+        With uevents active this returns shortly after an event (the settle
+        delay coalesces the burst a USB insert produces), when a device node
+        is still waiting for udev, or when the periodic resync is due.
+        Otherwise it simply sleeps for poll_interval. Idle waits are still
+        capped at poll_interval so shutdown stays responsive; those wakeups
+        do not rescan.
+        """
+        if self.hotplug is None:
+            await asyncio.sleep(poll_interval)
+            return
+        if self._pending_nodes:
+            timeout = max(self.settle_time, 0.1)
+        else:
+            timeout = max(0.0, self._last_resync + self.resync_interval - time.monotonic())
+            timeout = min(timeout, poll_interval)
+        try:
+            await asyncio.wait_for(self._wake.wait(), timeout)
+        except asyncio.TimeoutError:
+            return
+        if self.settle_time:
+            await asyncio.sleep(self.settle_time)
+        self._wake.clear()
+
+    @staticmethod
+    def port_id_from_path(path: Optional[str]) -> Optional[str]:
+        """Return the leaf-most USB port ID (e.g. "3-5.4") in a sysfs path."""
+        if not path:
+            return None
+        for part in reversed(path.strip().split('/')):
+            if part and part[0].isdigit() and '-' in part:
+                # Drop interface suffix like "1-1:1.0"
+                return part.split(':', 1)[0]
+        return None
     
     def load_pdr_endpoints(self, pdr_file: Path) -> Dict[str, Dict]:
-        """Load known endpoints from PDR JSON file, with decoded FRU data and resource_id."""
+        """Load known endpoints from the endpoint store (or a legacy PDR JSON
+        file), with decoded FRU data and resource_id, and index their FRUs."""
+        endpoints = self._read_pdr_endpoints(pdr_file)
+        self.fru_index = FRUIndex(endpoints)
+        self.logger.debug(f"FRU index: {len(self.fru_index.by_fingerprint)} fingerprints, "
+                          f"{len(self.fru_index.by_probe_key)} probe keys")
+        return endpoints
+
+    def _read_pdr_endpoints(self, pdr_file: Path) -> Dict[str, Dict]:
         if not pdr_file.exists():
             self.logger.warning(f"PDR file not found: {pdr_file}")
             return {}
         
+        pldm_tools_dir = str(Path(__file__).parents[1] / 'pldm_tools')
+        if pldm_tools_dir not in sys.path:
+            sys.path.insert(0, pldm_tools_dir)
+        from endpoint_db import EndpointDB, is_endpoint_db
+        from pldm_mapping_wizard.discovery.pdr_decoder import PDRCache
+        if self.pdr_cache is None:
+            self.pdr_cache = PDRCache()
+        if is_endpoint_db(pdr_file):
+            return self._load_db_endpoints(pdr_file, EndpointDB)
+        
         try:
             data = json.loads(pdr_file.read_text())
             endpoints = {}
@@ -295,11 +677,19 @@ class USBPortMonitor:
                             except Exception as e:
                                 self.logger.debug(f"Failed to decode FRU for {bus_port}: {e}")
 
+                        # Keep the raw PDRs only; the decoded dicts are dropped with the JSON
+                        records = [
+                            self.pdr_cache.intern(bytes.fromhex(rec["pdr_data"]))
+                            for rec in ep.get("pdr_records") or []
+                            if isinstance(rec, dict) and isinstance(rec.get("pdr_data"), str)
+                        ]
                         endpoints[bus_port] = {
                             "device": ep.get("device"),
                             "resource_id": ep.get("resource_id", f"unknown_{bus_port}"),
                             "resource_path": ep.get("resource_path", f"/redfish/v1/AutomationNodes/{ep.get('resource_id', 'unknown')}"),
-                            "fru_data": fru_bytes
+                            "fru_data": fru_bytes,
+                            "link": ep.get("link"),
+                            "pdrs": EndpointPDRs(lambda records=records: records, self.pdr_cache, ep.get("resource_id")),
                         }
                     except Exception as e:
                         # Skip this endpoint but continue processing others
@@ -311,6 +701,44 @@ class USBPortMonitor:
             self.logger.error(f"Failed to load PDR endpoints: {e}")
             return {}
 
+    def _load_db_endpoints(self, pdr_file: Path, db_cls) -> Dict[str, Dict]:
+        """Load the endpoint index only; PDRs are read when an endpoint is used."""
+        try:
+            endpoints = {}
+            with db_cls(pdr_file) as db:
+                for row in db.index(with_meta=True):
+                    bus_port = row["bus_port"]
+                    if not bus_port:
+                        continue
+                    loader = functools.partial(self._read_db_pdrs, pdr_file, db_cls, bus_port, row["fru_sha256"])
+                    endpoints[bus_port] = {
+                        "device": row["meta"].get("device"),
+                        "resource_id": row["resource_id"] or f"unknown_{bus_port}",
+                        "resource_path": row["resource_path"] or f"/redfish/v1/AutomationNodes/{row['resource_id'] or 'unknown'}",
+                        "fru_data": row["fru_data"],
+                        "link": row["link"],
+                        "pdrs": EndpointPDRs(loader, self.pdr_cache, row["resource_id"]),
+                    }
+            self.logger.debug(f"Loaded {len(endpoints)} endpoints from endpoint store {pdr_file}")
+            return endpoints
+        except Exception as e:
+            self.logger.error(f"Failed to load endpoint store {pdr_file}: {e}")
+            return {}
+
+    def _read_db_pdrs(self, pdr_file: Path, db_cls, bus_port: str, fru_sha256: Optional[str]) -> List[bytes]:
+        """Raw PDRs of one endpoint from the store.
+
+        The endpoint is looked up by bus_port and FRU rather than row id, since
+        the collector may have rewritten the store since it was indexed.
+        """
+        try:
+            with db_cls(pdr_file) as db:
+                ids = db.find(bus_port=bus_port, fru_sha256=fru_sha256)
+                return db.raw_pdrs(ids[0]) if ids else []
+        except Exception as e:
+            self.logger.error(f"Failed to read PDRs of {bus_port} from {pdr_file}: {e}")
+            return []
+
     def _extract_bus_port(self, sysfs_path: Optional[str]) -> Optional[str]:
         """Extract a bus/port key like "1-1" from a sysfs path."""
         if not sysfs_path:
@@ -377,7 +805,7 @@ class USBPortMonitor:
                             port_id = part.split(":", 1)[0]  # Drop :1.0 suffix if present
                             break
                     
-                    if port_id:
+                    if port_id and self.port_filter.owns(port_id):
                         current_ports[port_id] = sysfs_line
                         self.port_to_device[port_id] = device_path
                         self.logger.debug(f"  Mapped {port_id} → {device_path}")
@@ -391,7 +819,21 @@ class USBPortMonitor:
     
     def detect_changes(self, known_endpoints: Dict[str, Dict]) -> Tuple[Set[str], Set[str]]:
         """Detect added and removed ports."""
-        current = self.scan_usb_ports()
+        if self.hotplug is None:
+            current = self.scan_usb_ports()
+        elif self._resync_needed or time.monotonic() - self._last_resync >= self.resync_interval:
+            # Full scan at startup, after overflow, and periodically in case a
+            # uevent was missed; it also re-seeds the event-maintained set.
+            current = self.scan_usb_ports()
+            self.hotplug_ports = {p: self.port_to_device.get(p) for p in current}
+            self._last_resync = time.monotonic()
+            self._resync_needed = False
+            self._pending_nodes = False
+        else:
+            # Kernel uevents precede udev creating /dev nodes; hold an added
+            # port back until its node exists so the FRU probe can open it.
+            current = {p: d for p, d in self.hotplug_ports.items() if not d or os.path.exists(d)}
+            self._pending_nodes = len(current) != len(self.hotplug_ports)
         current_ports = set(current.keys())
         
         # Get previously connected ports
@@ -435,10 +877,12 @@ class USBPortMonitor:
         # Probe settings (configurable)
         probe_enabled = True
         probe_timeout = 1
+        partial_fru = True
         try:
             if config:
                 probe_enabled = config.getbool('probe', 'enabled', True)
                 probe_timeout = config.getint('probe', 'timeout', 1)
+                partial_fru = config.getbool('probe', 'partial_fru', True)
         except Exception:
             pass
 
@@ -457,102 +901,92 @@ class USBPortMonitor:
                 self.logger.info(f"  [PROBE] Quick probe failed for {new_port} ({device_path}); excluding until next scan")
                 self.probe_failed_ports.add(new_port)
                 return None
-        
+
+        # pts devices may match any known endpoint; physical USB ports only the
+        # known endpoint at the same hardware address (bus/port id == new_port)
+        is_pts = bool(device_path and device_path.startswith('/dev/pts'))
+        index = self.fru_index
+        if index is None or index.source is not known_endpoints:
+            index = self.fru_index = FRUIndex(known_endpoints)
+        if not index.by_fingerprint:
+            self.logger.warning(f"  [FRU] No known endpoints with FRU data to match {new_port} against")
+            return None
+
+        # Identify by the FRU prefix through the serial number when that is
+        # unambiguous, so the rest of the table never crosses the link
+        if partial_fru and index.by_probe_key:
+            key = await self.fru_matcher.get_fru_probe_key_async(device_path)
+            if key:
+                matches = index.lookup_probe(key, new_port, is_pts)
+                if len(matches) == 1:
+                    self.logger.info(f"  ✓ FRU match! {new_port} matches known endpoint {matches[0]} (serial prefix)")
+                    return self._record_fru_match(new_port, matches[0], known_endpoints[matches[0]], device_path)
+                self.logger.debug(f"  [FRU] Serial prefix of {new_port} matches {len(matches)} known endpoints; reading full table")
+
         # Get FRU data from new port
-        #new_fru = await self.fru_matcher.get_fru_data_async(device_path)
-        # TODO debug reliability issues with async FRU retrieval - for now use sync version to ensure we get data for matching
-        new_fru = self.fru_matcher._get_fru_data_sync(device_path)  # Use sync version for simplicity in this example
+        new_fru = await self.fru_matcher.get_fru_data_async(device_path)
         if not new_fru:
             self.logger.warning(f"  [FRU] Could not retrieve FRU from {new_port} ({device_path})")
             return None
         
         self.logger.info(f"  [FRU] Retrieved {len(new_fru)} bytes from {new_port} ({device_path})")
-        try:
-            prefix = new_fru[:128].hex()
-        except Exception:
-            prefix = '<unavailable>'
-        self.logger.info(f"  [FRU] New FRU hex prefix (len={len(new_fru)}): {prefix}")
-        try:
-            full_hex = new_fru.hex()
-        except Exception:
-            full_hex = '<unavailable>'
-        self.logger.info(f"  [FRU] New FRU full hex (len={len(new_fru)}): {full_hex}")
-        
-        # Compare against known endpoints.
-        # For physical USB ports: only compare against known endpoints that have the same
-        # hardware address (bus/port id == new_port).
-        # For pts devices: compare against any known endpoint FRU.
-        try:
-            known_list = []
-            for k, v in known_endpoints.items():
-                has = bool(v.get('fru_data'))
-                known_list.append(f"{k}:fru={has}")
-            self.logger.info(f"  [FRU] Known endpoints: {', '.join(known_list)}")
-        except Exception:
-            pass
+        self.logger.debug(f"  [FRU] New FRU hex (len={len(new_fru)}): {new_fru.hex()}")
 
-        # Decide if this is a pts device; prefer device_path as the indicator when available
-        is_pts = False
-        try:
-            if device_path and device_path.startswith('/dev/pts'):
-                is_pts = True
-        except Exception:
-            is_pts = False
+        for bus_port in index.lookup(new_fru, new_port, is_pts):
+            ep_data = known_endpoints[bus_port]
+            # The fingerprint narrows to one candidate; confirm byte-for-byte
+            if self.fru_matcher.compare_fru(new_fru, ep_data.get("fru_data")):
+                self.logger.info(f"  ✓ FRU match! {new_port} matches known endpoint {bus_port}")
+                return self._record_fru_match(new_port, bus_port, ep_data, device_path)
 
-        candidates = []
-        if is_pts:
-            # Any known endpoint with FRU data is a candidate
-            candidates = [(k, v) for k, v in known_endpoints.items() if v.get('fru_data')]
-        else:
-            # Only compare against known endpoint keyed by the same hardware address
-            if new_port in known_endpoints and known_endpoints[new_port].get('fru_data'):
-                candidates = [(new_port, known_endpoints[new_port])]
+        self.logger.warning(f"  [FRU] No FRU match found for {new_port} (is_pts={is_pts})")
+        return None
 
-        if not candidates:
-            self.logger.warning(f"  [FRU] No candidate known endpoints to compare for {new_port} (is_pts={is_pts})")
-            return None
+    def _record_fru_match(self, new_port: str, bus_port: str, ep_data: Dict, device_path: str) -> str:
+        # Update in-memory device path for the known endpoint so later operations use it
+        ep_data['device'] = device_path
+        # Remember which known endpoint is mapped to this detected port
+        self.endpoint_map[new_port] = bus_port
+        return bus_port
 
-        for bus_port, ep_data in candidates:
-            known_fru = ep_data.get("fru_data")
-            if not known_fru:
-                self.logger.debug(f"  [FRU] Skipping {bus_port}: no FRU data available")
-                continue
 
-            self.logger.debug(f"  [FRU] Comparing {new_port} ({len(new_fru)} bytes) vs {bus_port} ({len(known_fru)} bytes)...")
-            try:
-                kprefix = known_fru[:128].hex()
-            except Exception:
-                kprefix = '<unavailable>'
-            self.logger.info(f"    [FRU] Known FRU hex prefix (len={len(known_fru)}): {kprefix}")
-            try:
-                kfull = known_fru.hex()
-            except Exception:
-                kfull = '<unavailable>'
-            self.logger.info(f"    [FRU] Known FRU full hex (len={len(known_fru)}): {kfull}")
+class ConditionalGetCache:
+    """GETs that revalidate the last response for a URL with If-None-Match.
 
-            # Compare byte-for-byte
-            match_result = self.fru_matcher.compare_fru(new_fru, known_fru)
-            if match_result:
-                self.logger.info(f"  ✓ FRU match! {new_port} matches known endpoint {bus_port}")
-
-                # Update in-memory device path for the known endpoint so later operations use it
-                try:
-                    ep_data['device'] = device_path
-                except Exception:
-                    pass
-
-                # Remember which known endpoint is mapped to this detected port
-                try:
-                    self.endpoint_map[new_port] = bus_port
-                except Exception:
-                    pass
+    When the server answers 304 the cached response is returned, so an
+    unchanged resource costs a header exchange instead of its full body.
+    """
 
-                return bus_port
+    def __init__(self, max_entries: int = 512):
+        self.max_entries = max_entries
+        self._lock = threading.Lock()
+        self._responses = OrderedDict()  # (url, params) -> last 200 response
+        self.revalidated = 0
+
+    def get(self, url: str, params: Optional[dict] = None, timeout: float = 5):
+        key = (url, tuple(sorted(params.items())) if params else ())
+        with self._lock:
+            cached = self._responses.get(key)
+        etag = cached.headers.get('ETag') if cached is not None else None
+        response = requests.get(url, params=params, timeout=timeout,
+                                headers={'If-None-Match': etag} if etag else None)
+        with self._lock:
+            if response.status_code == 304 and cached is not None:
+                self._responses.move_to_end(key)
+                self.revalidated += 1
+                return cached
+            if response.status_code == 200 and response.headers.get('ETag'):
+                self._responses[key] = response
+                self._responses.move_to_end(key)
+                while len(self._responses) > self.max_entries:
+                    self._responses.popitem(last=False)
             else:
-                self.logger.debug(f"    → Mismatch: {bus_port} (comparing {len(new_fru)} vs {len(known_fru)} bytes)")
+                self._responses.pop(key, None)
+        return response
 
-        self.logger.warning(f"  [FRU] No FRU match found for {new_port}")
-        return None
+
+# Shared by the resource lookups and tree walks below
+_http_cache = ConditionalGetCache()
 
 
 def disable_resources(port: str, resource_id: str, resource_path: str, logger, server_url: str = "http://localhost:8000"):
@@ -563,6 +997,9 @@ def disable_resources(port: str, resource_id: str, resource_path: str, logger, s
     """
     logger.info(f"[DISABLE] Starting for resource_id={resource_id}, port={port}...")
     
+    if _set_subtree_state(resource_id, "UnavailableOffline", logger, server_url):
+        return
+    
     try:
         # Find matches in both collections so we can update both trees when IDs overlap.
         logger.info(f"[DISABLE] Searching Chassis collection for ID={resource_id}...")
@@ -584,7 +1021,7 @@ def disable_resources(port: str, resource_id: str, resource_path: str, logger, s
             return
 
         if chassis_path:
-            resp = requests.get(f"{server_url}{chassis_path}", timeout=5)
+            resp = _http_cache.get(f"{server_url}{chassis_path}", timeout=5)
             if resp.status_code == 200:
                 logger.info(f"[DISABLE] Disabling chassis subtree at {chassis_path}...")
                 _disable_resource_tree(resp.json(), chassis_path, resource_id, logger, server_url)
@@ -592,7 +1029,7 @@ def disable_resources(port: str, resource_id: str, resource_path: str, logger, s
                 logger.warning(f"[DISABLE] Failed to fetch chassis {chassis_path}: {resp.status_code}")
 
         if node_path:
-            resp = requests.get(f"{server_url}{node_path}", timeout=5)
+            resp = _http_cache.get(f"{server_url}{node_path}", timeout=5)
             if resp.status_code == 200:
                 logger.info(f"[DISABLE] Disabling AutomationNode subtree at {node_path}...")
                 _disable_resource_tree(resp.json(), node_path, resource_id, logger, server_url)
@@ -613,6 +1050,9 @@ def re_enable_resources(port: str, resource_id: str, resource_path: str, logger,
     """
     logger.info(f"[ENABLE] Starting for resource_id={resource_id}, port={port}...")
     
+    if _set_subtree_state(resource_id, "Enabled", logger, server_url):
+        return
+    
     try:
         # Find matches in both collections so we can update both trees when IDs overlap.
         logger.info(f"[ENABLE] Searching Chassis collection for ID={resource_id}...")
@@ -631,7 +1071,7 @@ def re_enable_resources(port: str, resource_id: str, resource_path: str, logger,
             return
 
         if chassis_path:
-            resp = requests.get(f"{server_url}{chassis_path}", timeout=5)
+            resp = _http_cache.get(f"{server_url}{chassis_path}", timeout=5)
             if resp.status_code == 200:
                 logger.info(f"[ENABLE] Enabling chassis subtree at {chassis_path}...")
                 _enable_resource_tree(resp.json(), chassis_path, resource_id, logger, server_url)
@@ -639,7 +1079,7 @@ def re_enable_resources(port: str, resource_id: str, resource_path: str, logger,
                 logger.warning(f"[ENABLE] Failed to fetch chassis {chassis_path}: {resp.status_code}")
 
         if node_path:
-            resp = requests.get(f"{server_url}{node_path}", timeout=5)
+            resp = _http_cache.get(f"{server_url}{node_path}", timeout=5)
             if resp.status_code == 200:
                 logger.info(f"[ENABLE] Enabling AutomationNode subtree at {node_path}...")
                 _enable_resource_tree(resp.json(), node_path, resource_id, logger, server_url)
@@ -652,14 +1092,60 @@ def re_enable_resources(port: str, resource_id: str, resource_path: str, logger,
         logger.error(f"[ENABLE] Error re-enabling resources: {e}", exc_info=True)
 
 
+SUBTREE_STATE_ACTION = "/redfish/v1/Actions/Oem/IoTFoundry.SetSubtreeState"
+
+
+def _set_subtree_state(resource_id: str, state: str, logger, server_url: str) -> bool:
+    """
+    Set Status.State on an endpoint's Chassis and AutomationNode subtrees in one
+    request using the server's IoTFoundry.SetSubtreeState action.
+    Returns False if the action is unavailable or failed, so callers can fall
+    back to walking the tree with per-resource PATCHes.
+    """
+    tag = "[DISABLE]" if state != "Enabled" else "[ENABLE]"
+    try:
+        response = requests.post(
+            f"{server_url}{SUBTREE_STATE_ACTION}",
+            json={"ResourceId": resource_id, "State": state},
+            timeout=5,
+        )
+        if response.status_code == 200:
+            result = response.json()
+            updated = result.get("Updated", [])
+            logger.info(f"{tag} {resource_id}: State={state} on {len(updated)} resources "
+                        f"under {result.get('Roots', [])} ✓")
+            for path in updated:
+                logger.debug(f"  {path}")
+            return True
+        if response.status_code == 404 and "No resource" in response.text:
+            # The action exists but the ID is unknown; a tree walk won't find it either
+            logger.warning(f"{tag} Could not find resource with ID={resource_id} in any collection")
+            return True
+        logger.debug(f"{tag} Bulk state action unavailable ({response.status_code}), walking tree")
+    except Exception as e:
+        logger.debug(f"{tag} Bulk state action failed ({e}), walking tree")
+    return False
+
+
+# Expand collection members in place, keeping only what the lookup needs
+EXPAND_MEMBER_IDS = {'$expand': '.($levels=1)', '$select': 'Id'}
+
+
 def _find_resource_in_collection(collection_url: str, resource_id: str, logger, server_url: str) -> Optional[str]:
     """
     Search a collection for a resource with the given ID.
     Returns the full path to the resource, or None if not found.
+    
+    The collection is requested with $expand/$select so a server that
+    supports them answers in one request; members it leaves as bare links
+    are fetched one by one.
     """
     try:
         logger.debug(f"[FIND] Fetching collection: {collection_url}")
-        response = requests.get(collection_url, timeout=5)
+        response = _http_cache.get(collection_url, params=EXPAND_MEMBER_IDS, timeout=5)
+        if response.status_code in (400, 501):
+            # Query options rejected; ask for the plain collection
+            response = _http_cache.get(collection_url, timeout=5)
         
         if response.status_code != 200:
             logger.debug(f"[FIND] Collection not accessible: {response.status_code}")
@@ -673,10 +1159,15 @@ def _find_resource_in_collection(collection_url: str, resource_id: str, logger,
         for member in members:
             if isinstance(member, dict) and "@odata.id" in member:
                 member_path = member["@odata.id"]
+                if "Id" in member:
+                    if member["Id"] == resource_id:
+                        logger.info(f"[FIND] ✓ Found resource ID={resource_id} at {member_path}")
+                        return member_path
+                    continue
                 logger.debug(f"[FIND] Checking member: {member_path}")
                 
                 try:
-                    member_response = requests.get(f"{server_url}{member_path}", timeout=5)
+                    member_response = _http_cache.get(f"{server_url}{member_path}", timeout=5)
                     if member_response.status_code == 200:
                         member_data = member_response.json()
                         member_id = member_data.get("Id")
@@ -721,7 +1212,7 @@ def _disable_resource_tree(resource: dict, resource_path: str, resource_id: str,
             if isinstance(collection_data, dict) and "@odata.id" in collection_data:
                 collection_path = collection_data["@odata.id"]
                 if collection_name in ("AutomationInstrumentation", "Instrumentation"):
-                    member_response = requests.get(f"{server_url}{collection_path}", timeout=5)
+                    member_response = _http_cache.get(f"{server_url}{collection_path}", timeout=5)
                     if member_response.status_code == 200:
                         member_data = member_response.json()
                         # Preserve the original resource_path as the root for
@@ -763,7 +1254,7 @@ def _enable_resource_tree(resource: dict, resource_path: str, resource_id: str,
             if isinstance(collection_data, dict) and "@odata.id" in collection_data:
                 collection_path = collection_data["@odata.id"]
                 if collection_name in ("AutomationInstrumentation", "Instrumentation"):
-                    member_response = requests.get(f"{server_url}{collection_path}", timeout=5)
+                    member_response = _http_cache.get(f"{server_url}{collection_path}", timeout=5)
                     if member_response.status_code == 200:
                         member_data = member_response.json()
                         # Preserve the original resource_path as the root for
@@ -787,7 +1278,7 @@ def _disable_collection(collection_path: str, resource_id: str, root_resource_pa
     top-level collections when we intend to touch a single resource subtree.
     """
     try:
-        response = requests.get(f"{server_url}{collection_path}", timeout=5)
+        response = _http_cache.get(f"{server_url}{collection_path}", timeout=5)
         if response.status_code != 200:
             logger.debug(f"  Could not fetch collection {collection_path}: {response.status_code}")
             return
@@ -807,7 +1298,7 @@ def _disable_collection(collection_path: str, resource_id: str, root_resource_pa
                 logger.debug(f"  Skipping unrelated member {member_path} (not under {root})")
                 continue
 
-            member_response = requests.get(f"{server_url}{member_path}", timeout=5)
+            member_response = _http_cache.get(f"{server_url}{member_path}", timeout=5)
             if member_response.status_code == 200:
                 member_data = member_response.json()
                 if "Status" in member_data and isinstance(member_data["Status"], dict) and "State" in member_data["Status"]:
@@ -825,7 +1316,7 @@ def _enable_collection(collection_path: str, resource_id: str, root_resource_pat
     top-level resources when enabling a subtree.
     """
     try:
-        response = requests.get(f"{server_url}{collection_path}", timeout=5)
+        response = _http_cache.get(f"{server_url}{collection_path}", timeout=5)
         if response.status_code != 200:
             logger.debug(f"  Could not fetch collection {collection_path}: {response.status_code}")
             return
@@ -845,7 +1336,7 @@ def _enable_collection(collection_path: str, resource_id: str, root_resource_pat
                 logger.debug(f"  Skipping unrelated member {member_path} (not under {root})")
                 continue
 
-            member_response = requests.get(f"{server_url}{member_path}", timeout=5)
+            member_response = _http_cache.get(f"{server_url}{member_path}", timeout=5)
             if member_response.status_code == 200:
                 member_data = member_response.json()
                 if "Status" in member_data and isinstance(member_data["Status"], dict) and "State" in member_data["Status"]:
@@ -877,12 +1368,47 @@ def _set_resource_state(resource_path: str, state: str, logger, server_url: str)
         logger.error(f"[PATCH] Error patching {resource_path}: {e}")
 
 
+def _server_url(config: ConfigManager) -> str:
+    """Redfish server URL for agent requests.
+
+    If the server is bound to 0.0.0.0 (all interfaces) use localhost so we
+    connect via loopback instead of the wildcard address.
+    """
+    server_host = config.get('server', 'host', 'localhost')
+    server_port = config.get('server', 'port', '8000')
+    connect_host = server_host
+    if server_host == '0.0.0.0' or server_host == '::':
+        connect_host = 'localhost'
+    return f"http://{connect_host}:{server_port}"
+
+
+PUSH_METRICS_ACTION = "/redfish/v1/Actions/Oem/IoTFoundry.PushMetrics"
+
+
+def push_metrics(server_url: str, logger, token: str = '') -> bool:
+    """Send this process's METRICS to the Redfish server, which serves them at /metrics."""
+    try:
+        response = requests.post(f"{server_url}{PUSH_METRICS_ACTION}",
+                                 json={"Process": "agent", "Metrics": METRICS.snapshot()},
+                                 headers={AGENT_TOKEN_HEADER: token} if token else None, timeout=2)
+        if response.status_code != 200:
+            logger.debug(f"[METRICS] PushMetrics → {response.status_code}")
+            return False
+        return True
+    except Exception as e:
+        logger.debug(f"[METRICS] PushMetrics failed: {e}")
+        return False
+
+
 async def run_agent(config: ConfigManager, logger):
     """Run the runtime agent monitoring loop (async)."""
     logger.info("Starting runtime agent...")
     
     poll_interval = config.getint('agent', 'poll_interval', 2)
-    pdr_file = Path(config.get('configurator', 'pdr_output', '/tmp/pdr_and_fru_records.json'))
+    metrics_interval = float(config.get('agent', 'metrics_interval', '10'))
+    hotplug_backend = config.get('agent', 'hotplug_backend', 'auto')
+    resync_interval = config.getint('agent', 'hotplug_resync_interval', 60)
+    pdr_file = Path(config.get('configurator', 'pdr_output', '/tmp/pdr_and_fru_records.db'))
     
     logger.info(f"Poll interval: {poll_interval}s")
     logger.info(f"PDR file: {pdr_file}")
@@ -891,13 +1417,27 @@ async def run_agent(config: ConfigManager, logger):
     shutdown = GracefulShutdown(logger)
     logger.info(f"GracefulShutdown initialized")
     
+    # One open port per device, shared by FRU matching and sensor sampling
+    transport = TransportBroker(config, logger)
+
     # Initialize USB monitor
-    monitor = USBPortMonitor(logger)
+    monitor = USBPortMonitor(logger, transport)
+    monitor.port_filter = PortFilter(config.get('agent', 'ports', ''))
+    if monitor.port_filter:
+        logger.info(f"Shard ports: {monitor.port_filter}")
+    monitor.start_hotplug(hotplug_backend, resync_interval)
     logger.info(f"USBPortMonitor initialized")
     
     known_endpoints = monitor.load_pdr_endpoints(pdr_file)
     logger.info(f"Loaded endpoints from PDR")
     
+    # Live sensor sampling for connected endpoints
+    sensor_polling = SensorPollManager(config, logger, _server_url(config), transport)
+    
+    # Control PATCHes written through to connected endpoints
+    control_writer = ControlWriter(config, logger, _server_url(config), transport)
+    control_writer.start()
+    
     if known_endpoints:
         logger.info(f"Loaded {len(known_endpoints)} known endpoints from PDR")
         for bus_port, ep_data in known_endpoints.items():
@@ -910,11 +1450,77 @@ async def run_agent(config: ConfigManager, logger):
     poll_count = 0
     port_state = {}  # Track state: {"1-2": "connected", "1-3": "disconnected"}
     
+    # Port → endpoint checkpoint from the previous run, revalidated on the first scan
+    state_file = config.get('agent', 'state_file', '/tmp/runtime_agent_state.json')
+    agent_state = AgentState(Path(state_file) if state_file else None, logger,
+                             float(config.get('agent', 'state_interval', '10')))
+    checkpoint = agent_state.load()
+    
+    async def attach_endpoint(port: str, matched_endpoint: str, ep_data: Dict, server_url: str, enable: bool = True):
+        """Bring a recognised endpoint online on `port`."""
+        resource_id = ep_data.get('resource_id', 'unknown')
+        resource_path = ep_data.get('resource_path', '')
+        device = monitor.port_to_device.get(port)
+        if enable:
+            logger.info(f"  → Recognized as {matched_endpoint} ({resource_id}), re-enabling resources")
+            # Blocking HTTP (a tree walk when SetSubtreeState is missing); keep it off the loop
+            loop = asyncio.get_running_loop()
+            enabling = loop.run_in_executor(
+                None, re_enable_resources, matched_endpoint, resource_id, resource_path, logger, server_url)
+            try:
+                await asyncio.shield(enabling)
+            except asyncio.CancelledError:
+                # Port removed meanwhile: it was not mapped yet, so the removal
+                # disabled nothing. Let the thread finish, then undo it.
+                logger.info(f"  → {port} removed while {matched_endpoint} was being enabled, disabling resources")
+                await asyncio.gather(enabling, return_exceptions=True)
+                await loop.run_in_executor(
+                    None, disable_resources, matched_endpoint, resource_id, resource_path, logger, server_url)
+                port_state[matched_endpoint] = "disconnected"
+                raise
+        else:
+            logger.info(f"  → Restored {port} as {matched_endpoint} ({resource_id}) from checkpoint")
+            ep_data['device'] = device
+        # Remember which known endpoint is mapped to this detected port
+        monitor.endpoint_map[port] = matched_endpoint
+        port_state[matched_endpoint] = "connected"
+        fru = ep_data.get('fru_data')
+        agent_state.set_port(port, matched_endpoint, device, fru_fingerprint(fru) if fru else None,
+                             usb_identity(device, port))
+        # Identified at 115200; move to the rate negotiated at collection
+        if ep_data.get('link'):
+            rate = await asyncio.get_running_loop().run_in_executor(None, transport.apply_link, device, ep_data['link'])
+            logger.debug(f"  → Link for {matched_endpoint}: {rate or 115200} baud")
+        sensor_polling.start(matched_endpoint, device, ep_data['pdrs'].sensors() if ep_data.get('pdrs') else None)
+        control_writer.attach(matched_endpoint, device, ep_data['pdrs'].effecters() if ep_data.get('pdrs') else None)
+    
+    async def on_match(port: str, matched_endpoint: Optional[str]):
+        if matched_endpoint:
+            ep_data = known_endpoints.get(matched_endpoint)
+            if not ep_data:
+                logger.warning(f"Matched endpoint {matched_endpoint} not present in known_endpoints")
+                return
+            await attach_endpoint(port, matched_endpoint, ep_data, _server_url(config))
+        else:
+            logger.debug(f"  → Unknown device on {port}, ignoring")
+            # Don't keep a device we don't manage open
+            transport.release(monitor.port_to_device.get(port))
+    
+    # FRU matches run in the background, [probe] workers at a time, each
+    # within the probe timeout plus fru_timeout, so a burst of added ports
+    # does not hold up the poll loop
+    match_workers = max(1, config.getint('probe', 'workers', 4))
+    match_deadline = config.getint('probe', 'timeout', 1) + float(config.get('probe', 'fru_timeout', '4'))
+    monitor.fru_matcher.executor = ThreadPoolExecutor(max_workers=match_workers, thread_name_prefix='fru-match')
+    matcher = MatchScheduler(lambda port: monitor.match_endpoint_by_fru(port, known_endpoints, config),
+                             on_match, match_workers, match_deadline, logger)
+    
     logger.info("Entering main polling loop...")
     logger.info(f"GracefulShutdown object: {shutdown}")
     logger.info(f"is_running() = {shutdown.is_running()}")
     
     loop_iteration = 0
+    last_metrics_push = 0.0
     while shutdown.is_running():
         loop_iteration += 1
         try:
@@ -926,57 +1532,41 @@ async def run_agent(config: ConfigManager, logger):
             logger.debug(f"detect_changes returned: {changes_result}")
             added, removed = changes_result
             
-            # Get server URL from config. If server is bound to 0.0.0.0 (all
-            # interfaces) use localhost for local agent HTTP requests so we
-            # connect via loopback instead of the wildcard address.
-            server_host = config.get('server', 'host', 'localhost')
-            server_port = config.get('server', 'port', '8000')
-            connect_host = server_host
-            if server_host == '0.0.0.0' or server_host == '::':
-                connect_host = 'localhost'
-            server_url = f"http://{connect_host}:{server_port}"
+            server_url = _server_url(config)
             logger.debug(f"Server URL: {server_url}")
             
-            # Process added ports with async FRU matching
+            # First scan after a restart: ports unchanged since the checkpoint
+            # come back online without a FRU read or re-enabling their
+            # resources; checkpointed ports that are gone are disabled below
+            if checkpoint:
+                checkpoint = None
+                index = monitor.fru_index or FRUIndex(known_endpoints)
+                present = {p: monitor.port_to_device.get(p) for p in monitor.connected_ports}
+                restored, gone = agent_state.revalidate(present, known_endpoints, index.by_fingerprint)
+                logger.info(f"[STATE] {len(restored)} ports restored from checkpoint, {len(gone)} gone")
+                for port, endpoint in restored.items():
+                    added.discard(port)
+                    await attach_endpoint(port, endpoint, known_endpoints[endpoint], server_url, enable=False)
+                for port, endpoint in gone.items():
+                    monitor.endpoint_map[port] = endpoint
+                    removed.add(port)
+            
+            # Queue FRU matches for added ports; results attach as they arrive
             if added:
-                # Use a stable list for ordering so we pair ports with match results correctly
-                added_list = list(added)
+                added_list = sorted(added)
                 logger.info(f"Processing {len(added_list)} added port(s): {added_list}")
                 # Clear per-scan probe failures (exclusions last only until next scan)
                 monitor.probe_failed_ports.clear()
-                matching_tasks = []
                 for port in added_list:
                     logger.info(f"USB port added: {port}")
-                    matching_tasks.append(monitor.match_endpoint_by_fru(port, known_endpoints, config))
-
-                # Run all FRU matches concurrently
-                if matching_tasks:
-                    try:
-                        logger.debug(f"Spawning {len(matching_tasks)} FRU match task(s)...")
-                        matches = await asyncio.gather(*matching_tasks)
-                        logger.debug(f"FRU matching completed: {matches}")
-
-                        for port, matched_endpoint in zip(added_list, matches):
-                            if matched_endpoint:
-                                ep_data = known_endpoints.get(matched_endpoint)
-                                if not ep_data:
-                                    logger.warning(f"Matched endpoint {matched_endpoint} not present in known_endpoints")
-                                    continue
-                                resource_id = ep_data.get('resource_id', 'unknown')
-                                resource_path = ep_data.get('resource_path', '')
-                                logger.info(f"  → Recognized as {matched_endpoint} ({resource_id}), re-enabling resources")
-                                re_enable_resources(matched_endpoint, resource_id, resource_path, logger, server_url)
-                                # Remember which known endpoint is mapped to this detected port
-                                monitor.endpoint_map[port] = matched_endpoint
-                                port_state[matched_endpoint] = "connected"
-                            else:
-                                logger.debug(f"  → Unknown device, ignoring")
-                    except Exception as e:
-                        logger.error(f"Error during FRU matching: {e}", exc_info=True)
+                    matcher.submit(port)
             
             if removed:
                 for port in removed:
                     logger.info(f"USB port removed: {port}")
+                    # A match still queued or running for the port is superseded
+                    matcher.cancel(port)
+                    agent_state.drop_port(port)
 
                     # Prefer mapping of detected port -> known endpoint (set on add)
                     mapped = monitor.endpoint_map.pop(port, None)
@@ -985,7 +1575,11 @@ async def run_agent(config: ConfigManager, logger):
                         resource_id = ep_data.get('resource_id', 'unknown')
                         resource_path = ep_data.get('resource_path', '')
                         logger.info(f"  → Detected port {port} mapped to known endpoint {mapped} ({resource_id}), disabling resources")
-                        disable_resources(mapped, resource_id, resource_path, logger, server_url)
+                        sensor_polling.stop(mapped)
+                        control_writer.detach(mapped)
+                        transport.release(ep_data.get('device'))
+                        await asyncio.get_running_loop().run_in_executor(
+                            None, disable_resources, mapped, resource_id, resource_path, logger, server_url)
                         port_state[mapped] = "disconnected"
                         continue
 
@@ -995,25 +1589,48 @@ async def run_agent(config: ConfigManager, logger):
                         resource_id = ep_data.get('resource_id', 'unknown')
                         resource_path = ep_data.get('resource_path', '')
                         logger.info(f"  → Known endpoint disconnected ({resource_id}), disabling resources")
-                        disable_resources(port, resource_id, resource_path, logger, server_url)
+                        sensor_polling.stop(port)
+                        control_writer.detach(port)
+                        transport.release(ep_data.get('device'))
+                        await asyncio.get_running_loop().run_in_executor(
+                            None, disable_resources, port, resource_id, resource_path, logger, server_url)
                         port_state[port] = "disconnected"
                     else:
                         logger.debug(f"  → Unknown port, no action needed")
             
+            agent_state.maybe_save()
+            
+            # Transport and matching metrics, served by the Redfish server at /metrics
+            if metrics_interval > 0 and time.monotonic() - last_metrics_push >= metrics_interval:
+                last_metrics_push = time.monotonic()
+                asyncio.get_running_loop().run_in_executor(None, push_metrics, server_url, logger, agent_token(config))
+            
             # Periodic status
             if poll_count % max(1, 10 // poll_interval) == 0:  # Every ~10 seconds
                 connected = monitor.connected_ports
                 logger.info(f"Agent status: {len(connected)} USB ports connected")
+                match_metrics = matcher.metrics()
+                if match_metrics['submitted']:
+                    logger.info(f"  FRU matching: {match_metrics['queued']} queued, {match_metrics['running']} running, "
+                                f"p50={match_metrics['p50_ms']}ms p95={match_metrics['p95_ms']}ms, "
+                                f"{match_metrics['timeouts']} timed out, {match_metrics['cancelled']} cancelled")
                 if port_state:
                     logger.debug(f"  Port states: {port_state}")
             
-            await asyncio.sleep(poll_interval)
+            await monitor.wait_for_change(poll_interval)
         
         except Exception as e:
             logger.error(f"Error in poll loop: {e}", exc_info=True)
             logger.info("Continuing despite error...")
             await asyncio.sleep(poll_interval)
     
+    monitor.stop_hotplug()
+    await matcher.close()
+    monitor.fru_matcher.executor.shutdown(wait=False)
+    await asyncio.get_running_loop().run_in_executor(None, sensor_polling.stop_all)
+    control_writer.stop()
+    transport.close_all()
+    agent_state.save()
     logger.info("While loop exited, shutdown.is_running() is now False")
     logger.info("Agent stopped gracefully")
     return True
@@ -1026,7 +1643,7 @@ def main():
         
         # Load config
         demo_root = Path(__file__).parents[1]
-        config_path = demo_root / 'configs' / 'demo.ini'
+        config_path = demo_config_path(demo_root)
         print(f"[MAIN] Config path: {config_path}", file=sys.stderr, flush=True)
         
         config = ConfigManager(config_path)
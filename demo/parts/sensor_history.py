@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+"""
+Bounded reading history for the Redfish server's Sensors.
+
+The runtime agent pushes live readings with IoTFoundry.UpdateReadings, and
+only when they change. HistoryStore keeps, per Sensor, a fixed-capacity ring
+of those raw samples plus two rollups: per-minute and per-hour min/max/avg.
+A reading is taken to hold until the next one, so rollups cover a sensor that
+has not changed, and an average is weighted by how long each value held.
+None (no valid reading) ends the value without starting a new one.
+
+Every series is a set of preallocated array('d') columns, so a sensor's
+memory is fixed when it first reports: HistorySettings.bytes_per_sensor(),
+for at most max_sensors sensors.
+
+The history is served two ways:
+  - TelemetryService, with one OnRequest MetricReportDefinition and
+    MetricReport per resolution, for Redfish clients
+  - TelemetryService/Oem/IoTFoundry/SensorHistory?Sensor=<@odata.id>
+    &Resolution=raw|1min|1h&Since=<epoch seconds>, a columnar answer for
+    one sensor, for the dashboard
+"""
+import math
+import threading
+import time
+from array import array
+from datetime import datetime, timezone
+from typing import Dict, Optional
+
+TELEMETRY_SERVICE = 'redfish/v1/TelemetryService'
+DEFINITIONS = f'{TELEMETRY_SERVICE}/MetricReportDefinitions'
+REPORTS = f'{TELEMETRY_SERVICE}/MetricReports'
+SENSOR_HISTORY = f'{TELEMETRY_SERVICE}/Oem/IoTFoundry/SensorHistory'
+
+# Resolution -> (report Id, report Name, rollup period in seconds or None
+# for raw samples, report timespan in seconds)
+RESOLUTIONS = {
+    'raw': ('SensorReadings', 'Sensor readings as sampled', None, 300),
+    '1min': ('SensorReadings1Min', 'Sensor readings per minute', 60, 3600),
+    '1h': ('SensorReadings1Hour', 'Sensor readings per hour', 3600, 86400),
+}
+ROLLUP_FUNCTIONS = (('Min', 'Minimum'), ('Max', 'Maximum'), ('Avg', 'Average'))
+
+
+def _iso_duration(seconds: int) -> str:
+    if seconds % 86400 == 0:
+        return f'P{seconds // 86400}D'
+    if seconds % 3600 == 0:
+        return f'PT{seconds // 3600}H'
+    if seconds % 60 == 0:
+        return f'PT{seconds // 60}M'
+    return f'PT{seconds}S'
+
+
+def _timestamp(t: float) -> str:
+    return datetime.fromtimestamp(t, timezone.utc).isoformat(timespec='milliseconds')
+
+
+def _number(value) -> Optional[float]:
+    """A reading as a float, or None for anything that is not a finite number."""
+    if isinstance(value, bool) or not isinstance(value, (int, float)):
+        return None
+    value = float(value)
+    return value if math.isfinite(value) else None
+
+
+class _Ring:
+    """Fixed-capacity columns of doubles; the oldest row is overwritten."""
+
+    def __init__(self, capacity: int, columns: int):
+        self.capacity = capacity
+        self.columns = [array('d', bytes(8 * capacity)) for _ in range(columns)]
+        self.start = 0
+        self.count = 0
+
+    @property
+    def nbytes(self) -> int:
+        return sum(c.itemsize * len(c) for c in self.columns)
+
+    def append(self, *row: float):
+        i = (self.start + self.count) % self.capacity
+        for column, value in zip(self.columns, row):
+            column[i] = value
+        if self.count < self.capacity:
+            self.count += 1
+        else:
+            self.start = (self.start + 1) % self.capacity
+
+    def rows(self, since: float = -math.inf):
+        """Rows oldest first whose first column (the time) is >= since."""
+        for n in range(self.count):
+            i = (self.start + n) % self.capacity
+            if self.columns[0][i] >= since:
+                yield tuple(c[i] for c in self.columns)
+
+
+class _Rollup:
+    """Time-weighted min/max/avg per `period`-second bucket."""
+
+    def __init__(self, period: int, capacity: int):
+        self.period = period
+        self.ring = _Ring(capacity, 4)   # bucket start, min, max, avg
+        self.bucket = None               # start of the open bucket
+        self._reset()
+
+    def _reset(self):
+        self.lo, self.hi, self.area, self.span = math.inf, -math.inf, 0.0, 0.0
+
+    def _accumulate(self, value: float, seconds: float):
+        self.lo = min(self.lo, value)
+        self.hi = max(self.hi, value)
+        self.area += value * seconds
+        self.span += seconds
+
+    def _close(self):
+        if self.span > 0:
+            self.ring.append(self.bucket, self.lo, self.hi, self.area / self.span)
+        self._reset()
+
+    def add(self, value: float, t0: float, t1: float):
+        """Account `value` as held from t0 to t1."""
+        p = self.period
+        while t0 < t1:
+            if self.bucket is None or t0 >= self.bucket + p:
+                self._close()
+                self.bucket = t0 - t0 % p
+            end = self.bucket + p
+            if t1 >= end + p:
+                # The rest of this bucket and whole buckets after it; more
+                # than the ring holds would only be overwritten
+                self._accumulate(value, end - t0)
+                self._close()
+                whole = int((t1 - end) // p)
+                for n in range(max(0, whole - self.ring.capacity), whole):
+                    self.ring.append(end + n * p, value, value, value)
+                self.bucket = t0 = end + whole * p
+                continue
+            step = min(t1, end)
+            self._accumulate(value, step - t0)
+            t0 = step
+
+    def rows(self, since: float):
+        """Closed buckets, then the open one, starting at or after `since`."""
+        yield from self.ring.rows(since)
+        if self.span > 0 and self.bucket >= since:
+            yield self.bucket, self.lo, self.hi, self.area / self.span
+
+
+class SensorHistory:
+    """Raw samples and rollups of one sensor."""
+
+    def __init__(self, raw_points: int, minute_points: int, hour_points: int):
+        self.raw = _Ring(raw_points, 2)   # time, value (NaN: no valid reading)
+        self.rollups = {'1min': _Rollup(60, minute_points), '1h': _Rollup(3600, hour_points)}
+        self.last_time = None
+        self.last_value = None
+
+    @property
+    def nbytes(self) -> int:
+        return self.raw.nbytes + sum(r.ring.nbytes for r in self.rollups.values())
+
+    def advance(self, now: float):
+        """Carry the held value forward to `now`."""
+        if self.last_value is not None and now > self.last_time:
+            for rollup in self.rollups.values():
+                rollup.add(self.last_value, self.last_time, now)
+        if self.last_time is None or now > self.last_time:
+            self.last_time = now
+
+    def record(self, now: float, value: Optional[float]):
+        self.advance(now)
+        self.raw.append(now, math.nan if value is None else value)
+        self.last_value = value
+
+    def query(self, resolution: str, since: float) -> dict:
+        if resolution == 'raw':
+            rows = list(self.raw.rows(since))
+            return {
+                'Timestamps': [round(t, 3) for t, _ in rows],
+                'Values': [None if math.isnan(v) else round(v, 6) for _, v in rows],
+            }
+        rows = list(self.rollups[resolution].rows(since))
+        result = {'Timestamps': [t for t, *_ in rows]}
+        for n, (name, _) in enumerate(ROLLUP_FUNCTIONS, 1):
+            result[name] = [round(row[n], 6) for row in rows]
+        return result
+
+
+class HistorySettings:
+    """[history] configuration."""
+
+    def __init__(self, config=None):
+        getint = (lambda key, default: config.getint('history', key, default)) if config else (lambda key, default: default)
+        self.enabled = config.getbool('history', 'enabled', True) if config else True
+        self.raw_points = max(1, getint('raw_points', 300))
+        self.minute_points = max(1, getint('minute_points', 120))
+        self.hour_points = max(1, getint('hour_points', 168))
+        self.max_sensors = max(0, getint('max_sensors', 4096))
+
+    def bytes_per_sensor(self) -> int:
+        return 8 * (2 * self.raw_points + 4 * (self.minute_points + self.hour_points))
+
+
+class HistoryStore:
+    """SensorHistory per Sensor @odata.id, for at most max_sensors sensors."""
+
+    def __init__(self, settings: HistorySettings, logger=None):
+        self.settings = settings
+        self.logger = logger
+        self._lock = threading.Lock()
+        self._sensors: Dict[str, SensorHistory] = {}
+        self._refused = 0
+
+    @property
+    def sensor_count(self) -> int:
+        return len(self._sensors)
+
+    def record(self, readings: dict, now: Optional[float] = None) -> int:
+        """Add {"<Sensor @odata.id>": value} samples; returns how many sensors are tracked."""
+        now = time.time() if now is None else now
+        s = self.settings
+        with self._lock:
+            for path, value in readings.items():
+                history = self._sensors.get(path)
+                if history is None:
+                    if len(self._sensors) >= s.max_sensors:
+                        self._refused += 1
+                        if self._refused == 1 and self.logger:
+                            self.logger.warning(f"Sensor history is full ({s.max_sensors} sensors); "
+                                                f"{path} and later sensors are not recorded")
+                        continue
+                    history = self._sensors[path] = SensorHistory(s.raw_points, s.minute_points, s.hour_points)
+                history.record(now, _number(value))
+            return len(self._sensors)
+
+    def query(self, path: str, resolution: str = 'raw', since: float = 0.0, now: Optional[float] = None):
+        """Columnar history of one sensor, or None if it has none."""
+        now = time.time() if now is None else now
+        with self._lock:
+            history = self._sensors.get(path)
+            if history is None:
+                return None
+            history.advance(now)
+            result = history.query(resolution, since)
+        period = RESOLUTIONS[resolution][2]
+        return {'Sensor': path, 'Resolution': resolution, **({'Period': period} if period else {}), **result}
+
+    def report_values(self, resolution: str, now: Optional[float] = None) -> list:
+        """MetricValues of every sensor within the resolution's report timespan."""
+        now = time.time() if now is None else now
+        since = now - RESOLUTIONS[resolution][3]
+        values = []
+        with self._lock:
+            for path in sorted(self._sensors):
+                history = self._sensors[path]
+                history.advance(now)
+                series = history.query(resolution, since)
+                prop = f'{path}/Reading'
+                if resolution == 'raw':
+                    columns = (('Reading', series['Values']),)
+                else:
+                    columns = tuple((f'Reading{name}', series[name]) for name, _ in ROLLUP_FUNCTIONS)
+                for metric_id, column in columns:
+                    for t, value in zip(series['Timestamps'], column):
+                        if value is not None:
+                            values.append({'MetricId': metric_id, 'MetricProperty': prop,
+                                           'MetricValue': str(value), 'Timestamp': _timestamp(t)})
+        return values
+
+
+def telemetry_route(key: str) -> Optional[str]:
+    """Route template of a TelemetryService URL for metrics, or None."""
+    for prefix in (DEFINITIONS, REPORTS):
+        if key.startswith(prefix + '/'):
+            return f'/{prefix}/{{id}}'
+    if key in (TELEMETRY_SERVICE, DEFINITIONS, REPORTS, SENSOR_HISTORY):
+        return '/' + key
+    return None
+
+
+def _link(key: str) -> dict:
+    return {'@odata.id': '/' + key}
+
+
+def _collection(key: str, odata_type: str, name: str, ids) -> dict:
+    members = [_link(f'{key}/{i}') for i in ids]
+    return {
+        '@odata.id': '/' + key,
+        '@odata.type': odata_type,
+        'Name': name,
+        'Members': members,
+        'Members@odata.count': len(members),
+    }
+
+
+def _definition(resolution: str) -> dict:
+    report_id, name, period, timespan = RESOLUTIONS[resolution]
+    properties = ['/redfish/v1/Chassis/{ChassisId}/Sensors/{SensorId}/Reading']
+    if period is None:
+        metrics = [{'MetricId': 'Reading', 'MetricProperties': properties}]
+    else:
+        metrics = [{'MetricId': f'Reading{column}', 'MetricProperties': properties, 'CollectionFunction': function,
+                    'CollectionDuration': _iso_duration(period), 'CollectionTimeScope': 'Interval'}
+                   for column, function in ROLLUP_FUNCTIONS]
+    return {
+        '@odata.id': f'/{DEFINITIONS}/{report_id}',
+        '@odata.type': '#MetricReportDefinition.v1_4_2.MetricReportDefinition',
+        'Id': report_id,
+        'Name': name,
+        'MetricReportDefinitionType': 'OnRequest',
+        'MetricReportDefinitionEnabled': True,
+        'ReportActions': ['LogToMetricReportsCollection'],
+        'ReportUpdates': 'Overwrite',
+        'ReportTimespan': _iso_duration(timespan),
+        'Metrics': metrics,
+        'MetricReport': _link(f'{REPORTS}/{report_id}'),
+        'Status': {'State': 'Enabled', 'Health': 'OK'},
+    }
+
+
+def telemetry_resource(key: str, history: HistoryStore, now: Optional[float] = None) -> Optional[dict]:
+    """The TelemetryService resource at store key `key`, or None if there is none."""
+    by_id = {report_id: resolution for resolution, (report_id, *_) in RESOLUTIONS.items()}
+    if key == TELEMETRY_SERVICE:
+        s = history.settings
+        return {
+            '@odata.id': '/' + key,
+            '@odata.type': '#TelemetryService.v1_3_2.TelemetryService',
+            'Id': 'TelemetryService',
+            'Name': 'Sensor Reading History',
+            'ServiceEnabled': True,
+            'SupportedCollectionFunctions': [function for _, function in ROLLUP_FUNCTIONS],
+            'MetricReportDefinitions': _link(DEFINITIONS),
+            'MetricReports': _link(REPORTS),
+            'Status': {'State': 'Enabled', 'Health': 'OK'},
+            'Oem': {'IoTFoundry': {
+                'SensorHistory': _link(SENSOR_HISTORY),
+                'RawPoints': s.raw_points,
+                'MinutePoints': s.minute_points,
+                'HourPoints': s.hour_points,
+                'BytesPerSensor': s.bytes_per_sensor(),
+                'MaxSensors': s.max_sensors,
+                'Sensors': history.sensor_count,
+            }},
+        }
+    if key == DEFINITIONS:
+        return _collection(key, '#MetricReportDefinitionCollection.MetricReportDefinitionCollection',
+                           'Metric Report Definitions', by_id)
+    if key == REPORTS:
+        return _collection(key, '#MetricReportCollection.MetricReportCollection', 'Metric Reports', by_id)
+    parent, _, report_id = key.rpartition('/')
+    resolution = by_id.get(report_id)
+    if resolution is None:
+        return None
+    if parent == DEFINITIONS:
+        return _definition(resolution)
+    if parent == REPORTS:
+        now = time.time() if now is None else now
+        return {
+            '@odata.id': '/' + key,
+            '@odata.type': '#MetricReport.v1_4_2.MetricReport',
+            'Id': report_id,
+            'Name': RESOLUTIONS[resolution][1],
+            'MetricReportDefinition': _link(f'{DEFINITIONS}/{report_id}'),
+            'Timestamp': _timestamp(now),
+            'MetricValues': history.report_values(resolution, now),
+        }
+    return None
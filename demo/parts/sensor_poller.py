@@ -0,0 +1,372 @@
+#!/usr/bin/env python3
+"""
+Live sensor sampling for the runtime agent.
+
+One SensorSampler thread per connected endpoint polls its numeric sensors
+(GetSensorReading) and state sensors (GetStateSensorReadings) at per-sensor
+intervals derived from the PDR updateInterval field. Sensors that fall due
+together are sent as one pipelined batch over the endpoint's serial link.
+Only values that changed are pushed to the Redfish server, in a single
+IoTFoundry.UpdateReadings call per batch.
+
+The serial port belongs to the agent's TransportBroker; a sampler leases it
+for each batch at sensor priority and stops issuing requests as soon as a
+control write is waiting for the port, so writes only ever queue behind the
+requests already in flight.
+
+The per-endpoint request rate is capped (max_requests_per_second); when the
+PDR intervals ask for more than that, all intervals on the endpoint are
+stretched proportionally so link utilization stays bounded.
+"""
+import sys
+import math
+import heapq
+import threading
+import time
+from collections import deque
+from pathlib import Path
+from typing import Dict, List, Optional
+
+import requests
+
+from port_broker import PRIORITY_SENSOR
+from shared import AGENT_TOKEN_HEADER, agent_token
+
+
+UPDATE_READINGS_ACTION = "/redfish/v1/Actions/Oem/IoTFoundry.UpdateReadings"
+
+# DSP0248 PDR types
+PDR_TYPE_NUMERIC_SENSOR = 2
+PDR_TYPE_STATE_SENSOR = 4
+SENSOR_PDR_TYPES = (PDR_TYPE_NUMERIC_SENSOR, PDR_TYPE_STATE_SENSOR)
+
+# sensorOperationalState: 0 = enabled; anything else has no valid reading
+SENSOR_ENABLED = 0
+
+
+def sensor_specs_from_pdrs(pdr_records, resource_id: str) -> List[dict]:
+    """Build sampling specs from an endpoint's PDR records.
+
+    Records are either {'decoded': {...}} dicts (collector output) or
+    pdr_decoder.LazyPDR objects, of which only the sensor fields are read.
+    Sensor resources are created by generate_sensors.create_sensor at
+    /redfish/v1/Chassis/<resource_id>/Sensors/SENSOR_ID_<sensorID>.
+    """
+    specs = []
+    if not isinstance(pdr_records, list) or not resource_id:
+        return specs
+    for rec in pdr_records:
+        if hasattr(rec, 'field'):
+            pdr_type, get = rec.pdr_type, rec.field
+        else:
+            dec = rec.get('decoded') if isinstance(rec, dict) else None
+            if not isinstance(dec, dict):
+                continue
+            pdr_type, get = dec.get('PDRType'), dec.get
+        if pdr_type == PDR_TYPE_NUMERIC_SENSOR:
+            kind = 'numeric'
+        elif pdr_type == PDR_TYPE_STATE_SENSOR:
+            kind = 'state'
+        else:
+            continue
+        sid = get('sensorID')
+        if sid is None:
+            continue
+        sid = int(sid)
+        numeric = kind == 'numeric'
+        specs.append({
+            'sensor_id': sid,
+            'kind': kind,
+            'path': f'/redfish/v1/Chassis/{resource_id}/Sensors/SENSOR_ID_{sid}',
+            # State sensor PDRs carry no update interval or conversion
+            'interval': get('updateInterval') if numeric else None,
+            'resolution': get('resolution') if numeric else None,
+            'offset': get('offset') if numeric else None,
+        })
+    return specs
+
+
+def _finite(value) -> Optional[float]:
+    try:
+        value = float(value)
+    except (TypeError, ValueError):
+        return None
+    return value if math.isfinite(value) else None
+
+
+class SamplerSettings:
+    """[sensors] configuration shared by all samplers."""
+
+    def __init__(self, config=None):
+        get = (lambda key, default: float(config.get('sensors', key, str(default)))) if config else (lambda key, default: default)
+        self.enabled = config.getbool('sensors', 'enabled', True) if config else True
+        self.default_interval = get('default_interval', 1.0)
+        self.min_interval = get('min_interval', 0.1)
+        self.max_interval = get('max_interval', 60.0)
+        self.max_requests_per_second = get('max_requests_per_second', 50.0)
+        self.timeout = get('timeout', 0.5)
+        self.max_outstanding = config.getint('sensors', 'max_outstanding', 2) if config else 2
+        self.retries = config.getint('sensors', 'retries', 1) if config else 1
+        self.batch_size = config.getint('sensors', 'batch_size', 32) if config else 32
+        self.batch_window = get('batch_window', 0.05)
+
+    def interval_for(self, spec: dict) -> float:
+        """Sampling interval for a sensor, clamped to [min_interval, max_interval]."""
+        interval = _finite(spec.get('interval'))
+        if not interval or interval <= 0:
+            interval = self.default_interval
+        return min(max(interval, self.min_interval), self.max_interval)
+
+
+class SensorSampler(threading.Thread):
+    """Polls the sensors of one endpoint and pushes changed readings."""
+
+    # Consecutive batches with no successful reading before warning
+    FAILURE_WARN_BATCHES = 5
+
+    def __init__(self, name: str, device: str, sensors: List[dict], settings: SamplerSettings,
+                 transport, engine_cls, encoder, server_url: str, logger, token: str = ''):
+        super().__init__(name=f'sensors-{name}', daemon=True)
+        self.endpoint = name
+        self.device = device
+        self.settings = settings
+        self.transport = transport
+        self.engine_cls = engine_cls
+        self.encoder = encoder
+        self.server_url = server_url
+        self.logger = logger
+        self._stop_event = threading.Event()
+        self._last: Dict[str, object] = {}
+        self._session = requests.Session()
+        if token:
+            # UpdateReadings is an agent-only action
+            self._session.headers[AGENT_TOKEN_HEADER] = token
+        self.stats = {'batches': 0, 'readings': 0, 'errors': 0, 'pushed': 0}
+
+        self.sensors = list(sensors)
+        self.intervals = {s['path']: settings.interval_for(s) for s in self.sensors}
+        demand = sum(1.0 / i for i in self.intervals.values())
+        self.scale = 1.0
+        if settings.max_requests_per_second > 0 and demand > settings.max_requests_per_second:
+            self.scale = demand / settings.max_requests_per_second
+            self.intervals = {p: i * self.scale for p, i in self.intervals.items()}
+
+    def stop(self):
+        self._stop_event.set()
+
+    def run(self):
+        if self.scale > 1.0:
+            self.logger.info(f"[SENSORS] {self.endpoint}: intervals stretched x{self.scale:.2f} "
+                             f"to stay within {self.settings.max_requests_per_second:g} req/s")
+        with self.transport.lease(self.device, PRIORITY_SENSOR, timeout=self.settings.timeout) as port:
+            if port is None:
+                self.logger.warning(f"[SENSORS] {self.endpoint}: cannot open {self.device}, sampling disabled")
+                return
+        self.logger.info(f"[SENSORS] {self.endpoint}: sampling {len(self.sensors)} sensors on {self.device}")
+        try:
+            # The engine is rebound to the leased port for every batch
+            engine = self.engine_cls(
+                None,
+                max_outstanding=self.settings.max_outstanding,
+                timeout=self.settings.timeout,
+                retries=self.settings.retries,
+            )
+            self._loop(engine)
+        except Exception as e:
+            self.logger.error(f"[SENSORS] {self.endpoint}: sampler failed: {e}", exc_info=True)
+        finally:
+            self._session.close()
+            self.logger.info(f"[SENSORS] {self.endpoint}: sampling stopped ({self.stats})")
+
+    def _loop(self, engine):
+        # Stagger first samples across each sensor's interval to avoid bursts
+        now = time.monotonic()
+        heap = []
+        for seq, spec in enumerate(self.sensors):
+            interval = self.intervals[spec['path']]
+            heapq.heappush(heap, (now + interval * seq / max(1, len(self.sensors)), seq, spec))
+
+        failed_batches = 0
+        while heap and not self._stop_event.is_set():
+            wait = heap[0][0] - time.monotonic()
+            if wait > 0:
+                self._stop_event.wait(wait)
+                continue
+
+            # Pull in sensors due within batch_window so they share one round trip
+            now = time.monotonic()
+            horizon = now + self.settings.batch_window
+            batch = []
+            while heap and heap[0][0] <= horizon and len(batch) < self.settings.batch_size:
+                batch.append(heapq.heappop(heap))
+
+            results = self._sample(engine, [spec for _, _, spec in batch])
+            if self._stop_event.is_set():
+                # Stopped mid-batch: the endpoint may already be disabled
+                break
+            self.stats['batches'] += 1
+            failed_batches = 0 if results else failed_batches + 1
+            if failed_batches == self.FAILURE_WARN_BATCHES:
+                self.logger.warning(f"[SENSORS] {self.endpoint}: no readings in {failed_batches} consecutive batches")
+
+            unknown = self._push(results)
+            for due, seq, spec in batch:
+                if spec['path'] in unknown:
+                    # No Redfish resource for this sensor; stop spending link time on it
+                    self.logger.debug(f"[SENSORS] {self.endpoint}: dropping {spec['path']} (not in mockup)")
+                    continue
+                # Keep the cadence, but never schedule into the past after a stall
+                heapq.heappush(heap, (max(due + self.intervals[spec['path']], now), seq, spec))
+
+    def _sample(self, engine, specs: List[dict]) -> Dict[str, object]:
+        results = {}
+        pending = deque(specs)
+        while pending and not self._stop_event.is_set():
+            with self.transport.lease(self.device, PRIORITY_SENSOR, timeout=self.settings.timeout) as port:
+                if port is None:
+                    break
+                engine.serial = port
+                self._submit(engine, pending, results)
+                engine.run()
+            # Requests still pending were held back for a control write;
+            # the rest of the batch continues under a new lease
+        return results
+
+    def _submit(self, engine, pending: deque, results: Dict[str, object]):
+        """Keep the engine window full from `pending` until it is empty or preempted."""
+        def submit_next():
+            if not pending or self.transport.preempted(self.device, PRIORITY_SENSOR):
+                return
+            spec = pending.popleft()
+            if spec['kind'] == 'numeric':
+                msg = self.encoder.encode_get_sensor_reading(sensor_id=spec['sensor_id'])
+            else:
+                msg = self.encoder.encode_get_state_sensor_readings(sensor_id=spec['sensor_id'])
+            engine.submit(msg, on_done=lambda req, spec=spec: self._on_done(req, spec, results, submit_next))
+
+        for _ in range(engine.max_outstanding):
+            submit_next()
+
+    def _on_done(self, req, spec: dict, results: Dict[str, object], submit_next):
+        self._on_reading(req, spec, results)
+        submit_next()
+
+    def _on_reading(self, req, spec: dict, results: Dict[str, object]):
+        if not req.ok:
+            self.stats['errors'] += 1
+            return
+        payload = req.response.get('extra', b'')
+        if spec['kind'] == 'numeric':
+            decoded = self.encoder.decode_get_sensor_reading_response(payload)
+            if 'error' in decoded:
+                self.stats['errors'] += 1
+                return
+            if decoded['operational_state'] != SENSOR_ENABLED:
+                value = None
+            else:
+                value = self.convert(decoded['present_reading'], spec)
+        else:
+            decoded = self.encoder.decode_get_state_sensor_readings_response(payload)
+            if 'error' in decoded or not decoded['fields']:
+                self.stats['errors'] += 1
+                return
+            field = decoded['fields'][0]
+            value = field['present_state'] if field['operational_state'] == SENSOR_ENABLED else None
+        self.stats['readings'] += 1
+        results[spec['path']] = value
+
+    @staticmethod
+    def convert(raw, spec: dict):
+        """Apply the PDR linear conversion Y = resolution * X + offset.
+
+        The unitModifier power is already carried by ReadingUnits (see
+        pdr_units_to_ucum), so it is not applied here.
+        """
+        resolution = _finite(spec.get('resolution'))
+        offset = _finite(spec.get('offset')) or 0.0
+        if resolution is None or (resolution == 1.0 and offset == 0.0):
+            return raw
+        return round(raw * resolution + offset, 6)
+
+    def _push(self, results: Dict[str, object]) -> set:
+        """POST changed readings; returns paths the server does not know."""
+        changed = {p: v for p, v in results.items() if p not in self._last or self._last[p] != v}
+        if not changed:
+            return set()
+        try:
+            response = self._session.post(
+                f"{self.server_url}{UPDATE_READINGS_ACTION}",
+                json={'Readings': changed},
+                timeout=2,
+            )
+            if response.status_code != 200:
+                self.logger.debug(f"[SENSORS] {self.endpoint}: UpdateReadings → {response.status_code}")
+                return set()
+            self._last.update(changed)
+            self.stats['pushed'] += len(changed)
+            return set(response.json().get('Unknown', []))
+        except Exception as e:
+            self.logger.debug(f"[SENSORS] {self.endpoint}: UpdateReadings failed: {e}")
+            return set()
+
+
+class SensorPollManager:
+    """Starts and stops a SensorSampler per connected endpoint."""
+
+    def __init__(self, config, logger, server_url: str, transport):
+        self.logger = logger
+        self.server_url = server_url
+        self.transport = transport
+        self.token = agent_token(config)
+        self.settings = SamplerSettings(config)
+        self.samplers: Dict[str, SensorSampler] = {}
+        self._stopping: List[SensorSampler] = []
+        self._classes = None
+
+    def _load_classes(self):
+        if self._classes is None:
+            pldm_tools_dir = str(Path(__file__).parents[1] / 'pldm_tools')
+            if pldm_tools_dir not in sys.path:
+                sys.path.insert(0, pldm_tools_dir)
+            from pldm_mapping_wizard.discovery.request_engine import PLDMRequestEngine
+            from pldm_mapping_wizard.discovery.pldm_commands import PDLMCommandEncoder
+            self._classes = (PLDMRequestEngine, PDLMCommandEncoder)
+        return self._classes
+
+    def start(self, endpoint: str, device: Optional[str], sensors: List[dict]):
+        """Begin sampling an endpoint (no-op if disabled, running, or sensorless)."""
+        if not self.settings.enabled or not device or not sensors:
+            return
+        current = self.samplers.get(endpoint)
+        if current is not None and current.is_alive():
+            return
+        try:
+            engine_cls, encoder = self._load_classes()
+        except ImportError as e:
+            self.logger.warning(f"[SENSORS] Sensor sampling unavailable: {e}")
+            self.settings.enabled = False
+            return
+        sampler = SensorSampler(endpoint, device, sensors, self.settings, self.transport, engine_cls,
+                                encoder, self.server_url, self.logger, self.token)
+        self.samplers[endpoint] = sampler
+        sampler.start()
+
+    def stop(self, endpoint: str):
+        """Signal an endpoint's sampler to stop; does not wait for it.
+
+        Called from the agent's event loop, so the sampler winds down on its
+        own thread; stop_all() joins whatever is still running.
+        """
+        sampler = self.samplers.pop(endpoint, None)
+        if sampler is not None:
+            sampler.stop()
+            self._stopping = [s for s in self._stopping if s.is_alive()] + [sampler]
+
+    def stop_all(self, timeout: float = 2.0):
+        """Stop every sampler and wait up to `timeout` seconds in total (blocking)."""
+        for endpoint in list(self.samplers):
+            self.stop(endpoint)
+        deadline = time.monotonic() + timeout
+        for sampler in self._stopping:
+            sampler.join(timeout=max(0.0, deadline - time.monotonic()))
+        self._stopping = [s for s in self._stopping if s.is_alive()]
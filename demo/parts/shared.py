@@ -13,6 +13,24 @@ from configparser import ConfigParser
 from typing import Optional, Dict, Any
 
 
+# Request header carrying [server] agent_token on the server's agent-only actions
+AGENT_TOKEN_HEADER = 'X-IoTFoundry-Agent-Token'
+
+
+def agent_token(config) -> str:
+    """Shared secret the runtime agent presents to its Redfish server ('' if unset)."""
+    return config.get('server', 'agent_token', '').strip() if config else ''
+
+
+def demo_config_path(demo_root: Path) -> Path:
+    """The config file for this process: $DEMO_CONFIG if set, else configs/demo.ini.
+
+    Each shard of a sharded deployment runs its parts with its own file.
+    """
+    override = os.environ.get('DEMO_CONFIG')
+    return Path(override) if override else demo_root / 'configs' / 'demo.ini'
+
+
 class ConfigManager:
     """Manages demo configuration from INI file."""
     
@@ -26,10 +26,14 @@ import shutil
 import json
 import glob
 import click
+import itertools
+import tempfile
 from pathlib import Path
 from typing import Any, Tuple
 
 import generate_automation_node
+from endpoint_db import load_endpoints
+from mockup_tree import MockupTree, endpoint_digest, endpoint_key, load_manifest, metadata_digest, write_manifest
 from utils import extract_schema_version
 
 
@@ -259,27 +263,49 @@ def process_node(dest: Path, name: str, report: dict) -> None:
 @click.command()
 @click.option('--source', '-s', default='samples/mockup', help='Source mockup folder')
 @click.option('--dest', '-d', default='output/mockup', help='Destination mockup folder')
-@click.option('--pdr-file', '-p', default=None, help='Path to pdr_file JSON for resource generation')
-def main(source: str, dest: str, pdr_file: str | None):
+@click.option('--pdr-file', '-p', default=None, help='Path to the endpoint store (or pdr_file JSON) for resource generation')
+@click.option('--incremental/--no-incremental', default=False, help='Update an existing dest in place, regenerating only changed endpoints')
+@click.option('--workers', '-j', default=8, show_default=True, type=int, help='Parallel file writers')
+def main(source: str, dest: str, pdr_file: str | None, incremental: bool, workers: int):
     src = Path(source).expanduser()
     dst = Path(dest).expanduser()
     if not src.exists():
         click.echo(f'Source {src} does not exist')
         raise click.Abort()
 
-    try:
-        dst = prompt_dest(dst)
-    except click.Abort:
-        click.echo('Cancelled')
-        return
+    staging = None
+    if incremental and dst.exists():
+        # Build beside the existing mockup, then publish only what changed
+        staging = Path(tempfile.mkdtemp(prefix=f'.{dst.name}-', dir=str(dst.parent))) / 'mockup'
+    else:
+        try:
+            dst = prompt_dest(dst)
+        except click.Abort:
+            click.echo('Cancelled')
+            return
+    work = staging or dst
 
     # Copy
     try:
-        shutil.copytree(src, dst)
+        shutil.copytree(src, work)
     except Exception as e:
-        click.echo(f'Error copying {src} -> {dst}: {e}', err=True)
+        click.echo(f'Error copying {src} -> {work}: {e}', err=True)
         raise click.Abort()
 
+    try:
+        generate_mockup(work, dst, pdr_file, workers)
+    finally:
+        if staging is not None:
+            shutil.rmtree(staging.parent, ignore_errors=True)
+
+
+def generate_mockup(dst: Path, final_dst: Path, pdr_file: str | None, workers: int) -> None:
+    """Clean the mockup copy in `dst`, generate endpoint resources and publish.
+
+    When `final_dst` is a different (existing) directory, `dst` is a staging
+    copy: endpoints whose inputs match the previous run's manifest keep their
+    resources from `final_dst`, and only changed files are written there.
+    """
     report = {}
 
     # --- Preparation phase (Step 2 in how_to.md) ---
@@ -525,110 +551,162 @@ def main(source: str, dest: str, pdr_file: str | None):
                 click.echo(str(e), err=True)
 
     # --- Resource Generation (Step 3, including 3.1 and 3.2) ---
+    # Resources are staged in memory and written in one pass at the end
+    tree = MockupTree(dst)
+    previous = load_manifest(final_dst)
+    manifest: dict[str, dict] = {}
+    automation_manager = report.get('preparation', [{}])[-1].get('automation_manager', '')
+    context = {'automation_manager': automation_manager, 'metadata': metadata_digest(dst)}
+
+    def describe_endpoint(ep: dict):
+        """Return (entityIDName, devpath, model, serial) for an endpoint."""
+        entityIDName = None
+        devpath = None
+        model = None
+        serial = None
+        if isinstance(ep, dict):
+            # common locations
+            devpath = ep.get('dev') or ep.get('device')
+            # FRU data in our collected JSON is stored under 'fru_records'
+            # as parsed_records -> fields (list of dicts with typeName/value).
+            def _fru_field(ep_dict: dict, type_name: str):
+                if not isinstance(ep_dict, dict):
+                    return None
+                for fru_set in ep_dict.get('fru_records', []) or []:
+                    for parsed in fru_set.get('parsed_records', []) or []:
+                        for f in parsed.get('fields', []) or []:
+                            if f.get('typeName') == type_name and 'value' in f:
+                                return f.get('value')
+                return None
+
+            # Try FRU parsed_fields first, then fall back to top-level PDR keys.
+            model = _fru_field(ep, 'Model') or ep.get('Model')
+            # FRU uses 'Serial Number' as the typeName in parsed fields
+            serial = _fru_field(ep, 'Serial Number') or ep.get('SerialNumber')
+            # search for entityIDName
+            if 'entityIDName' in ep:
+                entityIDName = ep.get('entityIDName')
+            else:
+                # maybe inside entityNames or pdr list
+                en = ep.get('entityNames')
+                if isinstance(en, dict):
+                    # try OEM Entity ID PDR key
+                    for k, v in en.items():
+                        if isinstance(v, dict) and 'entityIDName' in v:
+                            entityIDName = v.get('entityIDName')
+                            break
+                # fallback: search nested for entityIDName
+                if entityIDName is None:
+                    def find_entity(x):
+                        if isinstance(x, dict):
+                            if 'entityIDName' in x:
+                                return x.get('entityIDName')
+                            for vv in x.values():
+                                r = find_entity(vv)
+                                if r:
+                                    return r
+                        if isinstance(x, list):
+                            for vv in x:
+                                r = find_entity(vv)
+                                if r:
+                                    return r
+                        return None
+                    entityIDName = find_entity(ep)
+        return entityIDName, devpath, model, serial
+
+    def add_member(coll: str, oid: str):
+        idx = dst / 'redfish' / 'v1' / coll / 'index.json'
+        data = tree.load(idx) if tree.exists(idx) else {'@odata.id': f'/redfish/v1/{coll}', 'Members': [], 'Members@odata.count': 0}
+        members = data.get('Members', [])
+        members.append({'@odata.id': oid})
+        data['Members'] = members
+        data['Members@odata.count'] = len(members)
+        tree.write(idx, data)
+
+    def generate_endpoint(ep: dict, info: tuple, key: str | None, prev: dict | None):
+        entityIDName, devpath, model, serial = info
+        click.echo('\nEndpoint:')
+        click.echo(f'  device: {devpath}')
+        click.echo(f'  entityIDName: {entityIDName}')
+        click.echo(f'  Model: {model}')
+        click.echo(f'  Serial: {serial}')
+
+        if prev:
+            # Known device: keep the names given on an earlier run
+            short_name = prev.get('short_name')
+            short_description = prev.get('short_description')
+            click.echo(f'  short_name: {short_name} (from previous run)')
+        else:
+            # Prompt user for short_name and description as specified in how_to.md
+            short_name = click.prompt('short_name (e.g. XMover)')
+            short_description = click.prompt('short_description', default=f'Automation node for {short_name}')
+
+        digest = endpoint_digest(ep, short_name, short_description, context)
+        rid = prev.get('resource_id') if prev else None
+        node_rel = f'redfish/v1/AutomationNodes/{rid}'
+        chassis_rel = f'redfish/v1/Chassis/{rid}'
+        if (prev and prev.get('digest') == digest and rid
+                and rid not in tree.children(dst / 'redfish' / 'v1' / 'AutomationNodes')
+                and (final_dst / node_rel / 'index.json').exists()
+                and (final_dst / chassis_rel / 'index.json').exists()):
+            # Same PDRs, FRU and names as last time: carry the subtrees over
+            tree.adopt(final_dst, node_rel)
+            tree.adopt(final_dst, chassis_rel)
+            oid = f'/redfish/v1/AutomationNodes/{rid}'
+            add_member('AutomationNodes', oid)
+            add_member('Chassis', f'/redfish/v1/Chassis/{rid}')
+            report.setdefault('nodes_unchanged', []).append(oid)
+            click.echo(f'Unchanged AutomationNode {oid}')
+        else:
+            try:
+                oid = generate_automation_node.create_automation_node(dst, ep, short_name, short_description, report, automation_manager, tree=tree)
+                click.echo(f'Created AutomationNode {oid}')
+            except Exception as e:
+                click.echo(f'Failed to create AutomationNode: {e}')
+                return
+            rid = oid.rstrip('/').split('/')[-1]
+        if key:
+            manifest[key] = {'digest': digest, 'resource_id': rid,
+                             'short_name': short_name, 'short_description': short_description}
+
     if pdr_file:
         pdr_path = Path(pdr_file).expanduser()
         if not pdr_path.exists():
             click.echo(f'PDR file {pdr_path} does not exist; skipping resource generation')
         else:
+            # Streams one endpoint at a time from an endpoint store; a legacy
+            # JSON file is still loaded whole
+            endpoints = load_endpoints(pdr_path)
             try:
-                pdr_data = load_json(pdr_path)
+                first = next(endpoints, None)
             except Exception:
                 click.echo(f'Failed to load PDR file {pdr_path}; skipping generation')
-                pdr_data = None
-
-            endpoints = []
-            if isinstance(pdr_data, dict):
-                for key in ('endpoints', 'pdrs', 'devices'):
-                    if key in pdr_data and isinstance(pdr_data[key], list):
-                        endpoints = pdr_data[key]
-                        break
-                if not endpoints:
-                    # if top-level dict contains numeric-indexed map, try values
-                    vals = [v for v in pdr_data.values() if isinstance(v, dict) or isinstance(v, list)]
-                    # no reliable fallback — try root list
-            if isinstance(pdr_data, list):
-                endpoints = pdr_data
-
-            if not endpoints:
+                first = None
+
+            if first is None:
                 click.echo('No endpoints found in pdr_file; skipping generation')
             else:
-                for ep in endpoints:
-                    # Extract entityIDName from endpoint
-                    entityIDName = None
-                    devpath = None
-                    model = None
-                    serial = None
-                    if isinstance(ep, dict):
-                        # common locations
-                        devpath = ep.get('dev') or ep.get('device')
-                        # FRU data in our collected JSON is stored under 'fru_records'
-                        # as parsed_records -> fields (list of dicts with typeName/value).
-                        def _fru_field(ep_dict: dict, type_name: str):
-                            if not isinstance(ep_dict, dict):
-                                return None
-                            for fru_set in ep_dict.get('fru_records', []) or []:
-                                for parsed in fru_set.get('parsed_records', []) or []:
-                                    for f in parsed.get('fields', []) or []:
-                                        if f.get('typeName') == type_name and 'value' in f:
-                                            return f.get('value')
-                            return None
-
-                        # Try FRU parsed_fields first, then fall back to top-level PDR keys.
-                        model = _fru_field(ep, 'Model') or ep.get('Model')
-                        # FRU uses 'Serial Number' as the typeName in parsed fields
-                        serial = _fru_field(ep, 'Serial Number') or ep.get('SerialNumber')
-                        # search for entityIDName
-                        if 'entityIDName' in ep:
-                            entityIDName = ep.get('entityIDName')
-                        else:
-                            # maybe inside entityNames or pdr list
-                            en = ep.get('entityNames')
-                            if isinstance(en, dict):
-                                # try OEM Entity ID PDR key
-                                for k, v in en.items():
-                                    if isinstance(v, dict) and 'entityIDName' in v:
-                                        entityIDName = v.get('entityIDName')
-                                        break
-                            # fallback: search nested for entityIDName
-                            if entityIDName is None:
-                                def find_entity(x):
-                                    if isinstance(x, dict):
-                                        if 'entityIDName' in x:
-                                            return x.get('entityIDName')
-                                        for vv in x.values():
-                                            r = find_entity(vv)
-                                            if r:
-                                                return r
-                                    if isinstance(x, list):
-                                        for vv in x:
-                                            r = find_entity(vv)
-                                            if r:
-                                                return r
-                                    return None
-                                entityIDName = find_entity(ep)
-
-                    if not entityIDName:
+                pending = []
+                for ep in itertools.chain([first], endpoints):
+                    info = describe_endpoint(ep)
+                    if not info[0]:
                         click.echo('Endpoint missing entityIDName; skipping this endpoint')
                         continue
-
-                    click.echo('\nEndpoint:')
-                    click.echo(f'  device: {devpath}')
-                    click.echo(f'  entityIDName: {entityIDName}')
-                    click.echo(f'  Model: {model}')
-                    click.echo(f'  Serial: {serial}')
-
-                    # Prompt user for short_name and description as specified in how_to.md
-                    short_name = click.prompt('short_name (e.g. XMover)')
-                    short_description = click.prompt('short_description', default=f'Automation node for {short_name}')
-
-                    try:
-                        oid = generate_automation_node.create_automation_node(dst, ep, short_name, short_description, report, report.get('preparation', [{}])[-1].get('automation_manager', ''))
-                        click.echo(f'Created AutomationNode {oid}')
-                    except Exception as e:
-                        click.echo(f'Failed to create AutomationNode: {e}')
+                    key = endpoint_key(ep)
+                    prev = previous.get(key) if key else None
+                    if previous and prev is None:
+                        # New device: generate after the known ones so their
+                        # resource IDs stay stable
+                        pending.append((ep, info, key))
                         continue
-
-
+                    generate_endpoint(ep, info, key, prev)
+                for ep, info, key in pending:
+                    generate_endpoint(ep, info, key, None)
+
+    stats = tree.flush(final_dst, workers=workers, prune=True)
+    write_manifest(final_dst, manifest)
+    click.echo(f"Mockup written to {final_dst}: {stats['written']} files written, "
+               f"{stats['unchanged']} unchanged, {stats['removed']} removed")
 
 if __name__ == '__main__':
     main()
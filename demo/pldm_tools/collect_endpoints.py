@@ -6,8 +6,9 @@ Usage:
 
 This script scans /dev for ttyUSB* and ttyACM* devices, prompts the user to
 select which to query, then runs the extraction logic for each selected
-endpoint and writes a JSON file `pdr_and_fru_records.json` with a top-level
-`endpoints` array.
+endpoint and writes the results. An output path ending in `.db` gets an
+indexed endpoint store (see endpoint_db.py); any other path gets a JSON file
+with a top-level `endpoints` array.
 """
 import os
 import sys
@@ -25,6 +26,10 @@ import concurrent.futures
 from typing import List, Optional
 import base64
 import subprocess
+from pdr_cache import PDRCache
+from endpoint_db import write_endpoint_db
+from port_filter import PortFilter
+from pldm_mapping_wizard.discovery.link_negotiation import BAUD_RATES, TRANSFER_SIZES, default_link, negotiate_link
 
 console = Console()
 
@@ -91,10 +96,12 @@ def is_device_busy(dev_path: str) -> bool:
     return False
 
 
-def discover_devices() -> List[dict]:
+def discover_devices(port_filter: Optional[PortFilter] = None) -> List[dict]:
     """Return list of candidate serial devices (ttyUSB* only).
     
     Note: pts devices can be added manually by entering their path directly.
+    With a port_filter (a shard's [agent] ports), USB devices on other ports
+    are left to the shards that own them.
     """
 
     devs = []
@@ -107,13 +114,15 @@ def discover_devices() -> List[dict]:
             console.print(f"[yellow]Skipping busy device: {p}[/yellow]")
             continue
         usb = get_usb_address(p)
+        if port_filter and not port_filter.owns(os.path.basename(usb['sysfs_path']) if usb else None):
+            continue
         devs.append({'path': p, 'usb_addr': usb, 'valid': True})
 
     # Quick FRU metadata probe to filter non-PLDM devices (configurable)
     try:
         # Locate demo config (repo layout: demo/configs/demo.ini)
         demo_root = Path(__file__).parents[1]
-        config_path = demo_root / 'configs' / 'demo.ini'
+        config_path = Path(os.environ.get('DEMO_CONFIG') or demo_root / 'configs' / 'demo.ini')
         cfg = ConfigParser()
         probe_enabled = False
         probe_timeout = 1
@@ -329,11 +338,186 @@ def load_export_module():
     return mod
 
 
+def _int_list(value: str) -> List[int]:
+    return [int(v) for v in str(value or '').replace(' ', '').split(',') if v]
+
+
+def fetch_endpoint(dev: dict, mod, SerialPort, pdr_cache, progress=None, link_options=None):
+    """Run all serial I/O for one endpoint on its own transport.
+
+    With link_options ({'baud_rates': [...], 'transfer_sizes': [...]}) the
+    link is negotiated first (see link_negotiation) and the result kept in
+    ep['link']; otherwise the endpoint is read at 115200 with 255-byte parts.
+
+    Returns (ep, pdrs, fru) where `ep` is the partially filled endpoint dict,
+    `pdrs` the raw get_pdr()-style records and `fru` the parsed FRU state
+    consumed by decode_endpoint().
+    """
+    ep = {'dev': dev['path'], 'usb_addr': dev.get('usb_addr'), 'pdr_records': [], 'fru_records': [], 'error': None}
+    fru = {'metadata': None, 'fru_sets': [], 'actual_table': None, 'parsed_records': [], 'raw_fru_b64': None}
+    pdrs = []
+    timing = {'link_s': 0.0, 'fru_s': 0.0, 'pdr_s': 0.0, 'total_s': 0.0}
+    ep['timing'] = timing
+    started = time.monotonic()
+    subtask = progress.add_task(dev['path'], total=1) if progress else None
+    port = None
+    try:
+        port = SerialPort(dev['path'], baudrate=115200)
+        if not port.open():
+            ep['error'] = 'Failed to open port'
+            console.print(f"[red]Failed to open {dev['path']}[/red]")
+            return ep, pdrs, None
+
+        t0 = time.monotonic()
+        link = default_link()
+        if link_options:
+            link = negotiate_link(port, link_options.get('baud_rates', BAUD_RATES),
+                                  link_options.get('transfer_sizes', TRANSFER_SIZES))
+            mod.export_debug_log(f"[collect_endpoints] {dev['path']} link: {link}")
+        ep['link'] = link
+        timing['link_s'] = time.monotonic() - t0
+
+        # Retrieve FRU metadata and table first: the stripped table
+        # identifies the endpoint for the PDR cache
+        t0 = time.monotonic()
+        metadata, ferr = mod.get_fru_record_table_metadata(port)
+        fru['metadata'] = metadata
+        if not ferr and metadata:
+            expected_len = None
+            try:
+                expected_len = int(metadata.get('fru_table_length')) if isinstance(metadata, dict) and metadata.get('fru_table_length') is not None else None
+            except Exception:
+                expected_len = None
+            table_data, ferr2 = mod.get_fru_record_table(port, transfer_context=0, expected_length=expected_len)
+            if not ferr2 and table_data:
+                # Robust parse: let parser report how many bytes it consumed
+                try:
+                    # Prefer authoritative metadata length to avoid parsing CRC/padding
+                    if isinstance(metadata, dict) and isinstance(metadata.get('fru_table_length'), int):
+                        parsed_records, consumed = mod.parse_fru_record_table(table_data, metadata.get('fru_table_length'))
+                    else:
+                        parsed_records, consumed = mod.parse_fru_record_table(table_data)
+                except Exception:
+                    parsed_records, consumed = [], 0
+
+                # Fallback: if parser consumed nothing, optionally try metadata length
+                if consumed == 0:
+                    try:
+                        if isinstance(metadata, dict) and isinstance(metadata.get('fru_table_length'), int):
+                            fru_len = int(metadata.get('fru_table_length'))
+                            if len(table_data) >= fru_len:
+                                consumed = fru_len
+                    except Exception:
+                        consumed = len(table_data)
+
+                # Trim table to parser-consumed bytes (removes padding and CRC)
+                actual_table = table_data[:consumed]
+                fru['actual_table'] = actual_table
+                fru['parsed_records'] = parsed_records
+
+                # Save stripped raw FRU (no CRC/padding) as base64 per your preference
+                try:
+                    fru['raw_fru_b64'] = base64.b64encode(actual_table).decode('ascii')
+                except Exception:
+                    fru['raw_fru_b64'] = None
+
+                # Debug: log how many bytes were trimmed (padding + CRC)
+                try:
+                    trimmed_len = len(table_data) - len(actual_table)
+                    mod.export_debug_log(f"[collect_endpoints] device={dev['path']} table_bytes={len(table_data)} consumed={consumed} trimmed={trimmed_len}")
+                except Exception:
+                    pass
+            else:
+                fru['fru_sets'].append({'metadata': metadata, 'note': 'GetFRURecordTable not supported or failed', 'error': ferr2})
+        timing['fru_s'] = time.monotonic() - t0
+
+        # Retrieve PDRs: warm start from the cache when the repository
+        # signature is unchanged, otherwise walk the chain (pipelined),
+        # bounded by the repository's RecordCount
+        t0 = time.monotonic()
+        actual_table = fru['actual_table']
+        cached = None
+        repo_info, rerr = mod.get_pdr_repository_info(port)
+        if rerr:
+            mod.export_debug_log(f"[collect_endpoints] {dev['path']} GetPDRRepositoryInfo ERROR: {rerr}")
+        if pdr_cache is not None and actual_table:
+            cached = pdr_cache.lookup(actual_table, repo_info)
+            if cached is not None:
+                console.print(f"[green]{dev['path']}: PDR cache hit ({len(cached)} records)[/green]")
+        if cached is not None:
+            pdrs = cached
+        else:
+            record_count = repo_info.get('record_count') if repo_info else None
+            largest_record = repo_info.get('largest_record_size') if repo_info else None
+            pdrs, err = mod.get_pdr_chain(port, expected_records=record_count or None,
+                                          request_count=link['pdr_request_count'],
+                                          largest_record=largest_record or None)
+            if err:
+                mod.export_debug_log(f"[collect_endpoints] {dev['path']} get_pdr_chain ERROR: {err}")
+            elif pdr_cache is not None and actual_table and repo_info:
+                pdr_cache.store(actual_table, repo_info, pdrs)
+        timing['pdr_s'] = time.monotonic() - t0
+        mod.export_debug_log(f"[collect_endpoints] {dev['path']} get_pdr: total PDRs collected: {len(pdrs)}")
+    except Exception as e:
+        ep['error'] = str(e)
+    finally:
+        if port is not None:
+            try:
+                port.close()
+            except Exception:
+                pass
+        timing['total_s'] = time.monotonic() - started
+        for key in timing:
+            timing[key] = round(timing[key], 3)
+        if subtask is not None:
+            progress.update(subtask, advance=1)
+    return ep, pdrs, fru
+
+
+def decode_endpoint(ep: dict, pdrs: list, fru: Optional[dict], mod) -> dict:
+    """Decode PDRs and FRU for an endpoint fetched by fetch_endpoint()."""
+    if fru is None:
+        # Port never opened; keep the error-only record
+        return ep
+    try:
+        # Each PDR is decoded once; OEM State Sets go first so state names resolve
+        decoded_pdrs = []
+        for r, decoded in zip(pdrs, mod.decode_pdrs(r.get('pdr_data', b'') for r in pdrs)):
+            if 'error' in decoded:
+                mod.export_debug_log(f"[collect_endpoints] ERROR decoding PDR: handle=0x{r.get('handle'):08x}, error={decoded['error']}")
+            decoded_pdrs.append({
+                'handle': r.get('handle'),
+                'next_handle': r.get('next_handle'),
+                'pdr_data': r.get('pdr_data', b''),
+                'decoded': decoded,
+            })
+        ep['pdr_records'] = decoded_pdrs
+
+        # Convert parsed FRU portion to spec (needs the PDRs)
+        fru_sets = list(fru['fru_sets'])
+        actual_table = fru['actual_table']
+        if actual_table is not None:
+            spec_parsed = mod.convert_parsed_to_spec(fru['parsed_records'], pdrs)
+            fru_sets.append({'metadata': fru['metadata'], 'data_length': len(actual_table), 'parsed_records': spec_parsed})
+        ep['fru_records'] = fru_sets
+        # Add raw FRU data (base64) at endpoint level; keep None if unavailable
+        ep['raw_fru_data'] = fru['raw_fru_b64']
+    except Exception as e:
+        ep['error'] = str(e)
+    return ep
+
+
 @click.command()
-@click.option('--output', '-o', default='pdr_and_fru_records.json', help='Output JSON file')
-def main(output):
+@click.option('--output', '-o', default='pdr_and_fru_records.db', help='Output endpoint store (.db) or JSON file')
+@click.option('--cache-dir', default=None, type=click.Path(), help='PDR repository cache directory (disabled if omitted)')
+@click.option('--workers', '-j', default=8, show_default=True, type=int, help='Endpoints to query in parallel')
+@click.option('--link-negotiation/--no-link-negotiation', default=True, help='Negotiate baud rate and transfer sizes per endpoint')
+@click.option('--baud-rates', default=','.join(map(str, BAUD_RATES)), show_default=True, help='Baud rates to try above 115200')
+@click.option('--transfer-sizes', default=','.join(map(str, TRANSFER_SIZES)), show_default=True, help='GetPDR / FRU part sizes to try')
+@click.option('--ports', default='', help="USB port ids to collect, as fnmatch patterns (e.g. '1-*,3-5.*'); default all")
+def main(output, cache_dir, workers, link_negotiation, baud_rates, transfer_sizes, ports):
     try:
-        devs = discover_devices()
+        devs = discover_devices(PortFilter(ports))
         if not devs:
             console.print('[yellow]No /dev/ttyUSB* devices found.[/yellow]')
             sel = click.prompt("Enter a custom device path like '/dev/pts/1', or 'none' to cancel", default='none')
@@ -392,7 +576,8 @@ def main(output):
                 console.print('[red]Invalid selection[/red]')
                 return
 
-        console.print(f'Processing {len(selected)} endpoints...')
+        workers = max(1, min(workers, len(selected))) if selected else 1
+        console.print(f'Processing {len(selected)} endpoints ({workers} in parallel)...')
 
         mod = load_export_module()
         SerialPort = None
@@ -402,145 +587,48 @@ def main(output):
             # Fall back to module's SerialPort if package import fails
             SerialPort = getattr(mod, 'SerialPort', None)
 
-        endpoints = []
+        pdr_cache = PDRCache(cache_dir) if cache_dir else None
+        link_options = None
+        if link_negotiation:
+            link_options = {'baud_rates': _int_list(baud_rates), 'transfer_sizes': _int_list(transfer_sizes)}
 
+        # Serial I/O fans out across ports, one transport per port; decoding
+        # runs afterwards in selection order because OEM state set PDRs
+        # populate module-level tables shared by all endpoints.
+        started = time.monotonic()
         with Progress(SpinnerColumn(), TextColumn("{task.description}"), BarColumn(), TimeElapsedColumn()) as progress:
             task = progress.add_task('Overall', total=len(selected))
-            for dev in selected:
-                desc = f"{dev['path']}"
-                progress.start_task(task)
-                subtask = progress.add_task(desc, total=1)
-                ep = {'dev': dev['path'], 'usb_addr': dev.get('usb_addr'), 'pdr_records': [], 'fru_records': [], 'error': None}
-                try:
-                    port = SerialPort(dev['path'], baudrate=115200)
-                    if not port.open():
-                        ep['error'] = 'Failed to open port'
-                        console.print(f"[red]Failed to open {dev['path']}[/red]")
-                        endpoints.append(ep)
-                        progress.update(subtask, advance=1)
-                        progress.update(task, advance=1)
-                        continue
-
-                    # Retrieve PDRs
-                    pdrs = []
-                    handle = 0
-                    max_pdrs = 500
-                    for _ in range(max_pdrs):
-                        mod.export_debug_log(f"[collect_endpoints] get_pdr: handle=0x{handle:08x}")
-                        res, err = mod.get_pdr(port, handle)
-                        if err:
-                            mod.export_debug_log(f"[collect_endpoints] get_pdr ERROR: handle=0x{handle:08x}, err={err}")
-                            # If no response for first handle, stop
-                            if handle == 0:
-                                mod.export_debug_log(f"[collect_endpoints] get_pdr: break on first handle error")
-                                break
-                            else:
-                                mod.export_debug_log(f"[collect_endpoints] get_pdr: break on error, handle=0x{handle:08x}")
-                                break
-                        pdrs.append(res)
-                        next_handle = res.get('next_handle', 0)
-                        mod.export_debug_log(f"[collect_endpoints] get_pdr: handle=0x{handle:08x} -> next_handle=0x{next_handle:08x}")
-                        handle = next_handle
-                        if not handle:
-                            mod.export_debug_log(f"[collect_endpoints] get_pdr: break, next_handle=0")
-                            break
-                    mod.export_debug_log(f"[collect_endpoints] get_pdr: total PDRs collected: {len(pdrs)}")
-
-                    # Two-pass decode: first decode all OEM State Set PDRs to populate OEM_STATE_SET_VALUES
-                    for r in pdrs:
-                        pdr_data = r.get('pdr_data', b'')
-                        if len(pdr_data) > 5 and pdr_data[5] == 8:  # OEM State Set PDR type
-                            try:
-                                mod.decode_oem_state_set_pdr(pdr_data)
-                            except Exception as e:
-                                mod.export_debug_log(f"[collect_endpoints] ERROR decoding OEM State Set PDR: handle=0x{r.get('handle'):08x}, error={e}")
-
-                    # Second pass: decode all PDRs
-                    decoded_pdrs = []
-                    for r in pdrs:
-                        handle = r.get('handle')
-                        pdr_data = r.get('pdr_data', b'')
-                        try:
-                            mod.export_debug_log(f"[collect_endpoints] Decoding PDR: handle=0x{handle:08x}, len={len(pdr_data)}")
-                            decoded = mod.decode_pdr(pdr_data)
-                            mod.export_debug_log(f"[collect_endpoints] Decoded PDR: handle=0x{handle:08x}, type={pdr_data[5] if len(pdr_data) > 5 else 'N/A'}")
-                        except Exception as e:
-                            mod.export_debug_log(f"[collect_endpoints] ERROR decoding PDR: handle=0x{handle:08x}, error={e}")
-                            decoded = {'error': f'decode error: {e}'}
-                        decoded_pdrs.append({
-                            'handle': handle,
-                            'next_handle': r.get('next_handle'),
-                            'pdr_data': pdr_data,
-                            'decoded': decoded,
-                        })
-                    ep['pdr_records'] = decoded_pdrs
-
-                    # Retrieve FRU metadata and table; capture raw binary as base64 in `raw_fru_data`
-                    fru_sets = []
-                    raw_fru_b64 = None
-                    metadata, ferr = mod.get_fru_record_table_metadata(port)
-                    if not ferr and metadata:
-                        expected_len = None
-                        try:
-                            expected_len = int(metadata.get('fru_table_length')) if isinstance(metadata, dict) and metadata.get('fru_table_length') is not None else None
-                        except Exception:
-                            expected_len = None
-                        table_data, ferr2 = mod.get_fru_record_table(port, transfer_context=0, expected_length=expected_len)
-                        if not ferr2 and table_data:
-                            # Robust parse: let parser report how many bytes it consumed
-                            try:
-                                # Prefer authoritative metadata length to avoid parsing CRC/padding
-                                if isinstance(metadata, dict) and isinstance(metadata.get('fru_table_length'), int):
-                                    parsed_records, consumed = mod.parse_fru_record_table(table_data, metadata.get('fru_table_length'))
-                                else:
-                                    parsed_records, consumed = mod.parse_fru_record_table(table_data)
-                            except Exception:
-                                parsed_records, consumed = [], 0
-
-                            # Fallback: if parser consumed nothing, optionally try metadata length
-                            if consumed == 0:
-                                try:
-                                    if isinstance(metadata, dict) and isinstance(metadata.get('fru_table_length'), int):
-                                        fru_len = int(metadata.get('fru_table_length'))
-                                        if len(table_data) >= fru_len:
-                                            consumed = fru_len
-                                except Exception:
-                                    consumed = len(table_data)
-
-                            # Trim table to parser-consumed bytes (removes padding and CRC)
-                            actual_table = table_data[:consumed]
-
-                            # Convert parsed portion to spec
-                            spec_parsed = mod.convert_parsed_to_spec(parsed_records, pdrs)
-                            fru_sets.append({'metadata': metadata, 'data_length': len(actual_table), 'parsed_records': spec_parsed})
-
-                            # Save stripped raw FRU (no CRC/padding) as base64 per your preference
-                            try:
-                                raw_fru_b64 = base64.b64encode(actual_table).decode('ascii')
-                            except Exception:
-                                raw_fru_b64 = None
-
-                            # Debug: log how many bytes were trimmed (padding + CRC)
-                            try:
-                                trimmed_len = len(table_data) - len(actual_table)
-                                mod.export_debug_log(f"[collect_endpoints] device={dev['path']} table_bytes={len(table_data)} consumed={consumed} trimmed={trimmed_len}")
-                            except Exception:
-                                pass
-                        else:
-                            fru_sets.append({'metadata': metadata, 'note': 'GetFRURecordTable not supported or failed', 'error': ferr2})
-                    elif ferr:
-                        # No metadata support
-                        ep['fru_records'] = []
-                    ep['fru_records'] = fru_sets
-                    # Add raw FRU data (base64) at endpoint level; keep None if unavailable
-                    ep['raw_fru_data'] = raw_fru_b64
-
-                    port.close()
-                except Exception as e:
-                    ep['error'] = str(e)
-                endpoints.append(ep)
-                progress.update(subtask, advance=1)
-                progress.update(task, advance=1)
+            with concurrent.futures.ThreadPoolExecutor(max_workers=workers) as pool:
+                futures = [
+                    pool.submit(fetch_endpoint, dev, mod, SerialPort, pdr_cache, progress, link_options)
+                    for dev in selected
+                ]
+                for _ in concurrent.futures.as_completed(futures):
+                    progress.update(task, advance=1)
+            fetched = [f.result() for f in futures]
+        wall_time = time.monotonic() - started
+
+        endpoints = [decode_endpoint(ep, pdrs, fru, mod) for ep, pdrs, fru in fetched]
+
+        timing_table = Table(title='Per-endpoint timing (s)')
+        timing_table.add_column('Device')
+        timing_table.add_column('Baud', justify='right')
+        timing_table.add_column('FRU', justify='right')
+        timing_table.add_column('PDR', justify='right')
+        timing_table.add_column('Total', justify='right')
+        timing_table.add_column('PDRs', justify='right')
+        for ep in endpoints:
+            t = ep.get('timing', {})
+            timing_table.add_row(
+                ep['dev'],
+                str((ep.get('link') or {}).get('baudrate', '-')),
+                f"{t.get('fru_s', 0):.2f}",
+                f"{t.get('pdr_s', 0):.2f}",
+                f"{t.get('total_s', 0):.2f}",
+                str(len(ep.get('pdr_records', []))),
+            )
+        console.print(timing_table)
+        console.print(f'Discovery wall time: {wall_time:.2f}s')
 
         out = {'endpoints': endpoints}
         def make_json_serializable(obj):
@@ -556,8 +644,11 @@ def main(output):
 
         ser = make_json_serializable(out)
         try:
-            with open(output, 'w') as f:
-                json.dump(ser, f, indent=2)
+            if str(output).endswith('.db'):
+                write_endpoint_db(output, ser['endpoints'])
+            else:
+                with open(output, 'w') as f:
+                    json.dump(ser, f, indent=2)
             console.print(f'[green]Saved results to {output}[/green]')
         except Exception as e:
             console.print(f'[red]Failed to write output: {e}[/red]')
@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+"""Indexed on-disk store of collected endpoints (PDRs and FRU data).
+
+Replaces the monolithic pdr_and_fru_records.json for large fleets. The
+collector writes it, and the runtime agent, configurator and mockup generator
+read it. Readers pull only what they need: the agent reads the small
+per-endpoint index and fetches an endpoint's raw PDRs when it first
+connects, the configurator updates resource IDs one row at a time, and the
+generator streams one endpoint at a time.
+
+Layout (SQLite):
+  endpoints    one row per endpoint; indexed by bus_port, fru_sha256 and
+               resource_id. `link` holds the negotiated link parameters
+               (baud rate, transfer sizes) as JSON and `meta` the remaining
+               JSON fields (usb_addr, timing, error, parsed fru_records, ...).
+  pdr_blobs    raw PDR bytes keyed by SHA-256, so identical PDRs shared by
+               several endpoints (same device model) are stored once.
+  pdr_records  one row per PDR: handle, next_handle, PDR type, blob reference
+               and the decoded fields as JSON.
+
+Endpoints read back in full have the same shape as the JSON file: pdr_data
+as a hex string and raw_fru_data as base64. load_endpoints() accepts either
+format, so existing JSON files keep working.
+"""
+import os
+import base64
+import hashlib
+import json
+import sqlite3
+import tempfile
+from pathlib import Path
+from typing import Iterator, List, Optional
+
+SQLITE_MAGIC = b'SQLite format 3\x00'
+
+# Endpoint keys that have their own columns or tables
+_COLUMN_KEYS = ('dev', 'bus_port', 'resource_id', 'resource_path', 'raw_fru_data', 'pdr_records', 'link')
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS endpoints (
+    id INTEGER PRIMARY KEY,
+    dev TEXT,
+    bus_port TEXT,
+    fru_sha256 TEXT,
+    resource_id TEXT,
+    resource_path TEXT,
+    raw_fru BLOB,
+    link TEXT,
+    meta TEXT NOT NULL
+);
+CREATE INDEX IF NOT EXISTS endpoints_bus_port ON endpoints(bus_port);
+CREATE INDEX IF NOT EXISTS endpoints_fru ON endpoints(fru_sha256);
+CREATE INDEX IF NOT EXISTS endpoints_resource ON endpoints(resource_id);
+CREATE TABLE IF NOT EXISTS pdr_blobs (
+    sha256 TEXT PRIMARY KEY,
+    data BLOB NOT NULL
+);
+CREATE TABLE IF NOT EXISTS pdr_records (
+    endpoint_id INTEGER NOT NULL REFERENCES endpoints(id) ON DELETE CASCADE,
+    seq INTEGER NOT NULL,
+    handle INTEGER,
+    next_handle INTEGER,
+    pdr_type INTEGER,
+    blob TEXT REFERENCES pdr_blobs(sha256),
+    decoded TEXT,
+    PRIMARY KEY (endpoint_id, seq)
+);
+CREATE INDEX IF NOT EXISTS pdr_records_type ON pdr_records(pdr_type);
+"""
+
+# Columns added after the first release of the store: (table, column, type).
+# Stores written before them are upgraded in place when opened.
+_ADDED_COLUMNS = (
+    ('endpoints', 'link', 'TEXT'),
+)
+
+
+def is_endpoint_db(path) -> bool:
+    """True if `path` is an SQLite endpoint store (rather than JSON)."""
+    try:
+        with open(path, 'rb') as f:
+            return f.read(len(SQLITE_MAGIC)) == SQLITE_MAGIC
+    except OSError:
+        return False
+
+
+def endpoint_bus_port(ep: dict) -> Optional[str]:
+    """Stable port key for an endpoint, as the runtime agent derives it.
+
+    Explicit bus_port/USBAddress first, then the USB port ID in the sysfs
+    path, then the device path (for example /dev/pts/8).
+    """
+    bus_port = ep.get('bus_port') or ep.get('USBAddress')
+    if bus_port:
+        return bus_port
+    usb_addr = ep.get('usb_addr')
+    sysfs_path = usb_addr.get('sysfs_path') if isinstance(usb_addr, dict) else None
+    if sysfs_path:
+        for part in reversed(sysfs_path.strip().split('/')):
+            if part and part[0].isdigit() and '-' in part:
+                return part.split(':', 1)[0]
+    return ep.get('dev') or ep.get('device')
+
+
+def _raw_fru(ep: dict) -> Optional[bytes]:
+    fru_b64 = ep.get('raw_fru_data')
+    if not fru_b64:
+        fru_records = ep.get('fru_records') or []
+        if isinstance(fru_records, list) and fru_records and isinstance(fru_records[0], dict):
+            fru_b64 = fru_records[0].get('raw_fru_data')
+    if not fru_b64:
+        return None
+    try:
+        return base64.b64decode(fru_b64)
+    except Exception:
+        return None
+
+
+def endpoint_fru_sha256(ep: dict) -> Optional[str]:
+    """SHA-256 of an endpoint's raw FRU record table (the fru_sha256 index key)."""
+    raw_fru = _raw_fru(ep)
+    return hashlib.sha256(raw_fru).hexdigest() if raw_fru else None
+
+
+def _pdr_bytes(value) -> bytes:
+    if isinstance(value, (bytes, bytearray)):
+        return bytes(value)
+    if isinstance(value, str):
+        try:
+            return bytes.fromhex(value)
+        except ValueError:
+            return b''
+    return b''
+
+
+class EndpointDB:
+    """SQLite-backed endpoint store."""
+
+    def __init__(self, path):
+        self.path = Path(path).expanduser()
+        self._conn = sqlite3.connect(str(self.path))
+        self._conn.row_factory = sqlite3.Row
+        self._conn.execute('PRAGMA foreign_keys = ON')
+        self._conn.executescript(_SCHEMA)
+        self._migrate()
+
+    def _migrate(self):
+        with self._conn:
+            for table, column, decl in _ADDED_COLUMNS:
+                present = {row['name'] for row in self._conn.execute(f'PRAGMA table_info({table})')}
+                if column not in present:
+                    self._conn.execute(f'ALTER TABLE {table} ADD COLUMN {column} {decl}')
+
+    def close(self):
+        self._conn.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def write_endpoints(self, endpoints: List[dict]) -> int:
+        """Replace the stored endpoints with `endpoints` (collector output).
+
+        Returns the number of endpoints written.
+        """
+        with self._conn:
+            self._conn.execute('DELETE FROM pdr_records')
+            self._conn.execute('DELETE FROM endpoints')
+            self._conn.execute('DELETE FROM pdr_blobs')
+            for ep in endpoints:
+                self._insert(ep)
+        return len(endpoints)
+
+    def _insert(self, ep: dict) -> int:
+        raw_fru = _raw_fru(ep)
+        meta = {k: v for k, v in ep.items() if k not in _COLUMN_KEYS}
+        cur = self._conn.execute(
+            'INSERT INTO endpoints (dev, bus_port, fru_sha256, resource_id, resource_path, raw_fru, link, meta) '
+            'VALUES (?, ?, ?, ?, ?, ?, ?, ?)',
+            (
+                ep.get('dev'),
+                endpoint_bus_port(ep),
+                hashlib.sha256(raw_fru).hexdigest() if raw_fru else None,
+                ep.get('resource_id'),
+                ep.get('resource_path'),
+                raw_fru,
+                json.dumps(ep['link']) if ep.get('link') is not None else None,
+                json.dumps(meta),
+            ),
+        )
+        endpoint_id = cur.lastrowid
+        rows = []
+        for seq, rec in enumerate(ep.get('pdr_records') or []):
+            if not isinstance(rec, dict):
+                continue
+            data = _pdr_bytes(rec.get('pdr_data'))
+            sha = hashlib.sha256(data).hexdigest()
+            self._conn.execute('INSERT OR IGNORE INTO pdr_blobs (sha256, data) VALUES (?, ?)', (sha, data))
+            decoded = rec.get('decoded')
+            pdr_type = decoded.get('PDRType') if isinstance(decoded, dict) else None
+            if pdr_type is None and len(data) > 5:
+                pdr_type = data[5]
+            rows.append((endpoint_id, seq, rec.get('handle'), rec.get('next_handle'), pdr_type, sha,
+                         json.dumps(decoded) if decoded is not None else None))
+        self._conn.executemany(
+            'INSERT INTO pdr_records (endpoint_id, seq, handle, next_handle, pdr_type, blob, decoded) '
+            'VALUES (?, ?, ?, ?, ?, ?, ?)',
+            rows,
+        )
+        return endpoint_id
+
+    def index(self, with_meta: bool = False) -> List[dict]:
+        """Per-endpoint summary rows, without PDRs.
+
+        Each row has id, dev, bus_port, fru_sha256, resource_id,
+        resource_path, link (dict or None) and fru_data (raw bytes or None);
+        with_meta adds the remaining JSON fields under 'meta'.
+        """
+        cols = 'id, dev, bus_port, fru_sha256, resource_id, resource_path, link, raw_fru'
+        if with_meta:
+            cols += ', meta'
+        out = []
+        for row in self._conn.execute(f'SELECT {cols} FROM endpoints ORDER BY id'):
+            item = {
+                'id': row['id'],
+                'dev': row['dev'],
+                'bus_port': row['bus_port'],
+                'fru_sha256': row['fru_sha256'],
+                'resource_id': row['resource_id'],
+                'resource_path': row['resource_path'],
+                'link': json.loads(row['link']) if row['link'] else None,
+                'fru_data': bytes(row['raw_fru']) if row['raw_fru'] is not None else None,
+            }
+            if with_meta:
+                item['meta'] = json.loads(row['meta'])
+            out.append(item)
+        return out
+
+    def find(self, bus_port: Optional[str] = None, fru_sha256: Optional[str] = None,
+             resource_id: Optional[str] = None) -> List[int]:
+        """Endpoint ids matching every given key."""
+        clauses, args = [], []
+        for column, value in (('bus_port', bus_port), ('fru_sha256', fru_sha256), ('resource_id', resource_id)):
+            if value is not None:
+                clauses.append(f'{column} = ?')
+                args.append(value)
+        where = f" WHERE {' AND '.join(clauses)}" if clauses else ''
+        return [r[0] for r in self._conn.execute(f'SELECT id FROM endpoints{where} ORDER BY id', args)]
+
+    def decoded_pdrs(self, endpoint_id: int, pdr_types=None) -> List[dict]:
+        """Decoded PDR records of one endpoint, optionally only some PDR types.
+
+        Records are {'handle', 'decoded'}; raw bytes are not loaded.
+        """
+        sql = 'SELECT handle, decoded FROM pdr_records WHERE endpoint_id = ?'
+        args = [endpoint_id]
+        if pdr_types:
+            pdr_types = list(pdr_types)
+            sql += f" AND pdr_type IN ({', '.join('?' * len(pdr_types))})"
+            args += pdr_types
+        sql += ' ORDER BY seq'
+        return [
+            {'handle': r['handle'], 'decoded': json.loads(r['decoded']) if r['decoded'] else None}
+            for r in self._conn.execute(sql, args)
+        ]
+
+    def raw_pdrs(self, endpoint_id: int, pdr_types=None) -> List[bytes]:
+        """Raw PDR bytes of one endpoint in chain order; nothing is decoded."""
+        sql = ('SELECT b.data FROM pdr_records r JOIN pdr_blobs b ON b.sha256 = r.blob '
+               'WHERE r.endpoint_id = ?')
+        args = [endpoint_id]
+        if pdr_types:
+            pdr_types = list(pdr_types)
+            sql += f" AND r.pdr_type IN ({', '.join('?' * len(pdr_types))})"
+            args += pdr_types
+        sql += ' ORDER BY r.seq'
+        return [bytes(r[0]) for r in self._conn.execute(sql, args)]
+
+    def get_endpoint(self, endpoint_id: int) -> Optional[dict]:
+        """One endpoint in full, in the JSON file's shape."""
+        row = self._conn.execute('SELECT * FROM endpoints WHERE id = ?', (endpoint_id,)).fetchone()
+        if row is None:
+            return None
+        ep = json.loads(row['meta'])
+        for key in ('dev', 'bus_port', 'resource_id', 'resource_path'):
+            if row[key] is not None:
+                ep[key] = row[key]
+        ep['raw_fru_data'] = base64.b64encode(row['raw_fru']).decode('ascii') if row['raw_fru'] is not None else None
+        if row['link']:
+            ep['link'] = json.loads(row['link'])
+        ep['pdr_records'] = [
+            {
+                'handle': r['handle'],
+                'next_handle': r['next_handle'],
+                'pdr_data': bytes(r['data']).hex() if r['data'] is not None else '',
+                'decoded': json.loads(r['decoded']) if r['decoded'] else None,
+            }
+            for r in self._conn.execute(
+                'SELECT r.handle, r.next_handle, r.decoded, b.data FROM pdr_records r '
+                'LEFT JOIN pdr_blobs b ON b.sha256 = r.blob WHERE r.endpoint_id = ? ORDER BY r.seq',
+                (endpoint_id,),
+            )
+        ]
+        return ep
+
+    def iter_endpoints(self) -> Iterator[dict]:
+        """Yield every endpoint in full, one at a time."""
+        for endpoint_id in [r[0] for r in self._conn.execute('SELECT id FROM endpoints ORDER BY id')]:
+            ep = self.get_endpoint(endpoint_id)
+            if ep is not None:
+                yield ep
+
+    def set_resource(self, endpoint_id: int, resource_id: str, resource_path: Optional[str]) -> None:
+        """Record the Redfish resource an endpoint maps to."""
+        with self._conn:
+            self._conn.execute(
+                'UPDATE endpoints SET resource_id = ?, resource_path = ? WHERE id = ?',
+                (resource_id, resource_path, endpoint_id),
+            )
+
+
+def load_endpoints(path) -> Iterator[dict]:
+    """Yield the endpoints of an endpoint store or a legacy JSON file."""
+    path = Path(path).expanduser()
+    if is_endpoint_db(path):
+        with EndpointDB(path) as db:
+            yield from db.iter_endpoints()
+        return
+    with open(path, 'r') as f:
+        data = json.load(f)
+    if isinstance(data, dict):
+        for key in ('endpoints', 'pdrs', 'devices'):
+            if isinstance(data.get(key), list):
+                yield from data[key]
+                return
+    elif isinstance(data, list):
+        yield from data
+
+
+def write_endpoint_db(path, endpoints: List[dict]) -> int:
+    """Write a fresh endpoint store at `path`, replacing any existing file.
+
+    The store is built next to the target and moved into place, so readers
+    never see a half-written file.
+    """
+    path = Path(path).expanduser()
+    path.parent.mkdir(parents=True, exist_ok=True)
+    fd, tmp = tempfile.mkstemp(dir=str(path.parent), suffix='.tmp')
+    os.close(fd)
+    try:
+        with EndpointDB(tmp) as db:
+            count = db.write_endpoints(endpoints)
+        os.replace(tmp, path)
+        return count
+    except Exception:
+        try:
+            os.unlink(tmp)
+        except OSError:
+            pass
+        raise
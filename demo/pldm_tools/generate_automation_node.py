@@ -1,26 +1,17 @@
 from __future__ import annotations
-import json
 from pathlib import Path
-from typing import Any, Optional
+from typing import Optional
 
+from mockup_tree import MockupTree
 from utils import extract_schema_version
 from generate_chassis import create_chassis
 from generate_sensors import create_sensor
 from generate_controls import create_control
 
 
-def _write_json(path: Path, obj: Any) -> None:
-    path.parent.mkdir(parents=True, exist_ok=True)
-    with open(path, 'w') as f:
-        json.dump(obj, f, indent=2)
-
-
-def _unique_resource_id(base_dir: Path, coll: str, short_name: str) -> str:
+def _unique_resource_id(base_dir: Path, coll: str, short_name: str, tree: MockupTree) -> str:
     rid = short_name.replace(' ', '_').lower()
-    coll_dir = base_dir / 'redfish' / 'v1' / coll
-    if not coll_dir.exists():
-        return rid
-    existing = {p.name for p in coll_dir.iterdir() if p.is_dir()}
+    existing = tree.children(base_dir / 'redfish' / 'v1' / coll)
     if rid not in existing:
         return rid
     # append _2, _3 ...
@@ -32,17 +23,21 @@ def _unique_resource_id(base_dir: Path, coll: str, short_name: str) -> str:
         i += 1
 
 
-def create_automation_node(dst: Path, ep: dict, short_name: str, short_description: str, report: dict, automation_manager_oid: str) -> str:
+def create_automation_node(dst: Path, ep: dict, short_name: str, short_description: str, report: dict, automation_manager_oid: str, tree: Optional[MockupTree] = None) -> str:
     """Create an AutomationNode resource and add it to the AutomationNodes collection.
 
     `ep` is the endpoint dict from the pdr_file; the function inspects `ep` for
     `entityIDName` and PDR records to include PID/Profiled-specific fields.
+    The node, its Chassis subtree and collection updates are staged in
+    `tree`; without one they are written when the node is complete.
 
     Returns the created resource @odata.id
     """
+    own_tree = tree is None
+    tree = tree or MockupTree(dst)
     schema = extract_schema_version(dst, 'AutomationNode')
     base = dst / 'redfish' / 'v1'
-    resource_id = _unique_resource_id(dst, 'AutomationNodes', short_name)
+    resource_id = _unique_resource_id(dst, 'AutomationNodes', short_name, tree)
 
     # determine entityIDName from endpoint
     entityIDName = None
@@ -114,20 +109,20 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
     }
 
     node_path = base / 'AutomationNodes' / resource_id / 'index.json'
-    _write_json(node_path, node)
+    tree.write(node_path, node)
     report.setdefault('nodes_created', []).append(str(node_path))
 
     # Update AutomationNodes collection
     idx_path = base / 'AutomationNodes' / 'index.json'
-    if idx_path.exists():
-        data = json.loads(idx_path.read_text())
+    if tree.exists(idx_path):
+        data = tree.load(idx_path)
     else:
         data = { '@odata.id': '/redfish/v1/AutomationNodes', 'Members': [], 'Members@odata.count': 0 }
     members = data.get('Members', [])
     members.append({'@odata.id': f'/redfish/v1/AutomationNodes/{resource_id}'})
     data['Members'] = members
     data['Members@odata.count'] = len(members)
-    _write_json(idx_path, data)
+    tree.write(idx_path, data)
     report.setdefault('collections_fixed', []).append({'collection': 'AutomationNodes', 'added': [f'/redfish/v1/AutomationNodes/{resource_id}']})
 
     # Step 3.3: create chassis and subordinate resources referenced by the node
@@ -135,7 +130,7 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
     if isinstance(ep, dict):
         has_assembly = bool(ep.get('fru_records') or ep.get('fru') or ep.get('fru_info'))
 
-    create_chassis(dst, resource_id, short_name, f'{short_description} chassis', report, ep=ep, automation_manager_oid=automation_manager_oid, has_sensors=bool(sensor_pdrs), has_controls=bool(effecter_pdrs), has_assembly=has_assembly)
+    create_chassis(dst, resource_id, short_name, f'{short_description} chassis', report, ep=ep, automation_manager_oid=automation_manager_oid, has_sensors=bool(sensor_pdrs), has_controls=bool(effecter_pdrs), has_assembly=has_assembly, tree=tree)
 
     # Normalize entity name for table matching (treat 'Profiled' as 'Position')
     norm_entity = entityIDName
@@ -184,7 +179,7 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
             continue
         # pass percent info as a tuple in sensor_kind so create_sensor can
         # detect and emit the reduced percent-style sensor structure
-        s_oid = create_sensor(dst, resource_id, sid, (kind, is_percent), report, sensor_pdr=sensor_pdrs.get(sid), short_name=short_name, entityIDName=entityIDName)
+        s_oid = create_sensor(dst, resource_id, sid, (kind, is_percent), report, sensor_pdr=sensor_pdrs.get(sid), short_name=short_name, entityIDName=entityIDName, tree=tree)
         sensors_by_id[sid] = {'DataSourceUri': s_oid, 'Reading': None}
 
     # Create all effecters/controls and map referenced sensors according to CONTROL_DATA table
@@ -218,7 +213,7 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
         if ref_sid and ref_sid in sensors_by_id:
             effecter_sensor_map[eid] = sensors_by_id[ref_sid]
         # Pass percent flag to create_control via a tuple control_kind
-        create_control(dst, resource_id, eid, (func, is_percent), report, effecter_pdr=effecter_pdrs.get(eid), short_name=short_name, entityIDName=entityIDName, sensor_lookup=effecter_sensor_map)
+        create_control(dst, resource_id, eid, (func, is_percent), report, effecter_pdr=effecter_pdrs.get(eid), short_name=short_name, entityIDName=entityIDName, sensor_lookup=effecter_sensor_map, tree=tree)
 
     # Now set AutomationNode Links that refer to specific sensors/effecters per how_to rules
     # OutputControl: include only if PID or Profiled and find a matching effecter (SetPoint for PID, Position for Profiled)
@@ -248,7 +243,7 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
     node['Links'] = links
 
     # rewrite the AutomationNode resource to include updated Links
-    _write_json(node_path, node)
+    tree.write(node_path, node)
 
     # Step 3.4: create AutomationInstrumentation resource under the node
     # Determine schema for AutomationInstrumentation
@@ -286,9 +281,8 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
                     ch_id = parts[ci + 1]
                     ctrl_id = parts[ci + 3]
                     ctrl_path = base / 'Chassis' / ch_id / 'Controls' / ctrl_id / 'index.json'
-                    if ctrl_path.exists():
-                        import json as _json
-                        ctrl_obj = _json.loads(ctrl_path.read_text())
+                    if tree.exists(ctrl_path):
+                        ctrl_obj = tree.load(ctrl_path)
         except Exception:
             ctrl_obj = None
 
@@ -330,7 +324,9 @@ def create_automation_node(dst: Path, ep: dict, short_name: str, short_descripti
     # Write AutomationInstrumentation resource
     base = dst / 'redfish' / 'v1'
     inst_path = base / 'AutomationNodes' / resource_id / 'AutomationInstrumentation' / 'index.json'
-    _write_json(inst_path, inst)
+    tree.write(inst_path, inst)
     report.setdefault('instrumentation_created', []).append(str(inst_path))
+    if own_tree:
+        tree.flush()
 
     return node['@odata.id']
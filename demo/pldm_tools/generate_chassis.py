@@ -1,18 +1,11 @@
 from __future__ import annotations
-import json
 from pathlib import Path
-from typing import Any
 from typing import Optional
 
+from mockup_tree import MockupTree
 from utils import extract_schema_version
 
 
-def _write_json(path: Path, obj: Any) -> None:
-    path.parent.mkdir(parents=True, exist_ok=True)
-    with open(path, 'w') as f:
-        json.dump(obj, f, indent=2)
-
-
 def _collect_fru_fields(ep: Optional[dict]) -> dict:
     fields = {}
     if not isinstance(ep, dict):
@@ -57,11 +50,14 @@ def _collect_fru_fields(ep: Optional[dict]) -> dict:
     return fields
 
 
-def create_chassis(dst: Path, resource_id: str, short_name: str, description: str, report: dict, ep: Optional[dict] = None, automation_manager_oid: Optional[str] = None, has_sensors: bool = False, has_controls: bool = False, has_assembly: bool = False) -> str:
+def create_chassis(dst: Path, resource_id: str, short_name: str, description: str, report: dict, ep: Optional[dict] = None, automation_manager_oid: Optional[str] = None, has_sensors: bool = False, has_controls: bool = False, has_assembly: bool = False, tree: Optional[MockupTree] = None) -> str:
     """Create a Chassis resource following the how_to template.
 
     Non-hardcoded: uses `ep` for FRU data and includes links conditionally.
+    Resources are staged in `tree`; without one they are written immediately.
     """
+    own_tree = tree is None
+    tree = tree or MockupTree(dst)
     schema = extract_schema_version(dst, 'Chassis')
     base = dst / 'redfish' / 'v1'
 
@@ -95,13 +91,13 @@ def create_chassis(dst: Path, resource_id: str, short_name: str, description: st
     chassis['Links'] = links
 
     chassis_path = base / 'Chassis' / resource_id / 'index.json'
-    _write_json(chassis_path, chassis)
+    tree.write(chassis_path, chassis)
     report.setdefault('chassis_created', []).append(str(chassis_path))
 
     # Ensure Sensors and Controls collections under this chassis exist
     sensors_idx = base / 'Chassis' / resource_id / 'Sensors' / 'index.json'
     controls_idx = base / 'Chassis' / resource_id / 'Controls' / 'index.json'
-    if not sensors_idx.exists():
+    if not tree.exists(sensors_idx):
         # Collections in reference mockups typically use the unversioned
         # collection namespace (e.g. #SensorCollection.SensorCollection). Use
         # the unversioned form to match existing mockup files.
@@ -112,8 +108,8 @@ def create_chassis(dst: Path, resource_id: str, short_name: str, description: st
             'Members': [],
             'Members@odata.count': 0
         }
-        _write_json(sensors_idx, sdata)
-    if not controls_idx.exists():
+        tree.write(sensors_idx, sdata)
+    if not tree.exists(controls_idx):
         cdata = {
             '@odata.type': '#ControlCollection.ControlCollection',
             '@odata.context': '/redfish/v1/$metadata#ControlCollection.ControlCollection',
@@ -121,7 +117,7 @@ def create_chassis(dst: Path, resource_id: str, short_name: str, description: st
             'Members': [],
             'Members@odata.count': 0
         }
-        _write_json(controls_idx, cdata)
+        tree.write(controls_idx, cdata)
 
     # Create Assembly resource if FRU/assembly data exists for this endpoint
     if has_assembly:
@@ -166,14 +162,14 @@ def create_chassis(dst: Path, resource_id: str, short_name: str, description: st
             asm['Assemblies'].append(entry)
         # Write assembly resource
         asm_path = base / 'Chassis' / resource_id / 'Assembly' / 'index.json'
-        _write_json(asm_path, asm)
+        tree.write(asm_path, asm)
         report.setdefault('assembly_created', []).append(str(asm_path))
 
     # Update top-level Chassis collection index
     top_idx = base / 'Chassis' / 'index.json'
-    if top_idx.exists():
+    if tree.exists(top_idx):
         try:
-            data = json.loads(top_idx.read_text())
+            data = tree.load(top_idx)
         except Exception:
             data = {'@odata.id': '/redfish/v1/Chassis', 'Members': [], 'Members@odata.count': 0}
     else:
@@ -182,7 +178,9 @@ def create_chassis(dst: Path, resource_id: str, short_name: str, description: st
     members.append({'@odata.id': f'/redfish/v1/Chassis/{resource_id}'})
     data['Members'] = members
     data['Members@odata.count'] = len(members)
-    _write_json(top_idx, data)
+    tree.write(top_idx, data)
     report.setdefault('collections_fixed', []).append({'collection': 'Chassis', 'added': [f'/redfish/v1/Chassis/{resource_id}']})
+    if own_tree:
+        tree.flush()
 
     return f'/redfish/v1/Chassis/{resource_id}'
@@ -1,23 +1,20 @@
 from __future__ import annotations
-import json
 from pathlib import Path
 from typing import Any, Optional
 
+from mockup_tree import MockupTree
 from utils import extract_schema_version
 from pdr_units_to_ucum import pdr_units_to_ucum
 
 
-def _write_json(path: Path, obj: Any) -> None:
-    path.parent.mkdir(parents=True, exist_ok=True)
-    with open(path, 'w') as f:
-        json.dump(obj, f, indent=2)
-
-
-def create_control(dst: Path, chassis_id: str, effecter_id: int, control_kind: Any, report: dict, effecter_pdr: Optional[dict] = None, short_name: Optional[str] = None, entityIDName: Optional[str] = None, sensor_lookup: Optional[dict] = None) -> str:
+def create_control(dst: Path, chassis_id: str, effecter_id: int, control_kind: Any, report: dict, effecter_pdr: Optional[dict] = None, short_name: Optional[str] = None, entityIDName: Optional[str] = None, sensor_lookup: Optional[dict] = None, tree: Optional[MockupTree] = None) -> str:
     """Create a Control resource following how_to.md template.
 
     effecter_pdr is the parsed PDR dict for this effecter; sensor_lookup maps sensor_id->info to populate Sensor section.
+    Resources are staged in `tree`; without one they are written immediately.
     """
+    own_tree = tree is None
+    tree = tree or MockupTree(dst)
     schema = extract_schema_version(dst, 'Control')
     base = dst / 'redfish' / 'v1'
     eid = f'EFFECTER_ID_{effecter_id}'
@@ -76,14 +73,14 @@ def create_control(dst: Path, chassis_id: str, effecter_id: int, control_kind: A
     control['@odata.id'] = f'/redfish/v1/Chassis/{chassis_id}/Controls/{eid}'
 
     path = base / 'Chassis' / chassis_id / 'Controls' / eid / 'index.json'
-    _write_json(path, control)
+    tree.write(path, control)
     report.setdefault('controls_created', []).append(str(path))
 
     # Add to chassis Controls collection
     idx = base / 'Chassis' / chassis_id / 'Controls' / 'index.json'
-    if idx.exists():
+    if tree.exists(idx):
         try:
-            data = json.loads(idx.read_text())
+            data = tree.load(idx)
         except Exception:
             data = {'@odata.id': f'/redfish/v1/Chassis/{chassis_id}/Controls', 'Members': [], 'Members@odata.count': 0}
     else:
@@ -92,7 +89,9 @@ def create_control(dst: Path, chassis_id: str, effecter_id: int, control_kind: A
     members.append({'@odata.id': f'/redfish/v1/Chassis/{chassis_id}/Controls/{eid}'})
     data['Members'] = members
     data['Members@odata.count'] = len(members)
-    _write_json(idx, data)
+    tree.write(idx, data)
     report.setdefault('collections_fixed', []).append({'collection': f'Chassis/{chassis_id}/Controls', 'added': [f'/redfish/v1/Chassis/{chassis_id}/Controls/{eid}']})
+    if own_tree:
+        tree.flush()
 
     return f'/redfish/v1/Chassis/{chassis_id}/Controls/{eid}'
@@ -1,23 +1,20 @@
 from __future__ import annotations
-import json
 from pathlib import Path
 from typing import Any, Optional
 
+from mockup_tree import MockupTree
 from utils import extract_schema_version
 from pdr_units_to_ucum import pdr_units_to_ucum
 
 
-def _write_json(path: Path, obj: Any) -> None:
-    path.parent.mkdir(parents=True, exist_ok=True)
-    with open(path, 'w') as f:
-        json.dump(obj, f, indent=2)
-
-
-def create_sensor(dst: Path, chassis_id: str, sensor_id: int, sensor_kind: Any, report: dict, sensor_pdr: Optional[dict] = None, short_name: Optional[str] = None, entityIDName: Optional[str] = None) -> str:
+def create_sensor(dst: Path, chassis_id: str, sensor_id: int, sensor_kind: Any, report: dict, sensor_pdr: Optional[dict] = None, short_name: Optional[str] = None, entityIDName: Optional[str] = None, tree: Optional[MockupTree] = None) -> str:
     """Create a Sensor resource following how_to.md template.
 
     sensor_pdr is the parsed PDR dict for this sensor (decoded). short_name used for descriptions.
+    Resources are staged in `tree`; without one they are written immediately.
     """
+    own_tree = tree is None
+    tree = tree or MockupTree(dst)
     schema = extract_schema_version(dst, 'Sensor')
     base = dst / 'redfish' / 'v1'
     sid = f'SENSOR_ID_{sensor_id}'
@@ -101,14 +98,14 @@ def create_sensor(dst: Path, chassis_id: str, sensor_id: int, sensor_kind: Any,
     sensor['Links'] = {'Chassis': {'@odata.id': f'/redfish/v1/Chassis/{chassis_id}'}}
 
     path = base / 'Chassis' / chassis_id / 'Sensors' / sid / 'index.json'
-    _write_json(path, sensor)
+    tree.write(path, sensor)
     report.setdefault('sensors_created', []).append(str(path))
 
     # Add to chassis Sensors collection
     idx = base / 'Chassis' / chassis_id / 'Sensors' / 'index.json'
-    if idx.exists():
+    if tree.exists(idx):
         try:
-            data = json.loads(idx.read_text())
+            data = tree.load(idx)
         except Exception:
             data = {'@odata.id': f'/redfish/v1/Chassis/{chassis_id}/Sensors', 'Members': [], 'Members@odata.count': 0}
     else:
@@ -117,7 +114,9 @@ def create_sensor(dst: Path, chassis_id: str, sensor_id: int, sensor_kind: Any,
     members.append({'@odata.id': f'/redfish/v1/Chassis/{chassis_id}/Sensors/{sid}'})
     data['Members'] = members
     data['Members@odata.count'] = len(members)
-    _write_json(idx, data)
+    tree.write(idx, data)
     report.setdefault('collections_fixed', []).append({'collection': f'Chassis/{chassis_id}/Sensors', 'added': [f'/redfish/v1/Chassis/{chassis_id}/Sensors/{sid}']})
+    if own_tree:
+        tree.flush()
 
     return f'/redfish/v1/Chassis/{chassis_id}/Sensors/{sid}'
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""In-memory staging of generated mockup resources.
+
+The generate_* modules build their resources into a MockupTree instead of
+writing each index.json (and re-reading collection indexes) as they go. The
+finished tree is then written out in one parallel pass, and only files whose
+content changed are touched.
+
+For incremental runs the generator also keeps a manifest next to the mockup:
+
+  <dest>/.generation.json
+  {
+    "version": 1,
+    "endpoints": {
+      "<endpoint key>": {"digest": "...", "resource_id": "...",
+                         "short_name": "...", "short_description": "..."}
+    }
+  }
+
+An endpoint key is the SHA-256 of its FRU record table (the endpoint store's
+fru_sha256), so a device keeps its entry when it moves to another port. The
+digest covers every generator input for that endpoint. When it matches, the
+previous AutomationNode and Chassis subtrees are carried over as they are
+instead of being regenerated.
+"""
+import hashlib
+import json
+import os
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Any, Dict, Iterable, Optional, Set
+
+from endpoint_db import endpoint_fru_sha256
+
+
+MANIFEST_NAME = '.generation.json'
+MANIFEST_VERSION = 1
+# Service root; the Redfish server reloads the tree when this file changes
+ROOT_INDEX = Path('redfish', 'v1', 'index.json')
+
+# Endpoint fields the generators read; anything else (dev, timing, resource_id
+# written back by the configurator) does not affect the generated resources
+DIGEST_FIELDS = ('entityIDName', 'entityNames', 'fru_records', 'fru', 'fru_info', 'raw_fru_data', 'Model', 'SerialNumber')
+
+
+def _dumps(obj: Any) -> bytes:
+    # Same formatting the generators have always used
+    return json.dumps(obj, indent=2).encode()
+
+
+class MockupTree:
+    """Resources staged over a mockup directory, flushed in one pass."""
+
+    def __init__(self, root: Path):
+        self.root = Path(root)
+        self._docs: Dict[Path, Any] = {}  # path -> JSON object, or raw bytes carried over
+
+    def exists(self, path: Path) -> bool:
+        return Path(path) in self._docs or Path(path).exists()
+
+    def load(self, path: Path) -> Any:
+        """Current content of `path`: the staged object if any, else from disk."""
+        path = Path(path)
+        doc = self._docs.get(path)
+        if doc is None:
+            return json.loads(path.read_text())
+        return json.loads(doc) if isinstance(doc, bytes) else doc
+
+    def write(self, path: Path, obj: Any) -> None:
+        self._docs[Path(path)] = obj
+
+    def children(self, directory: Path) -> Set[str]:
+        """Names of the subdirectories of `directory`, on disk or staged."""
+        directory = Path(directory)
+        names = {p.name for p in directory.iterdir() if p.is_dir()} if directory.is_dir() else set()
+        for path in self._docs:
+            try:
+                rel = path.relative_to(directory)
+            except ValueError:
+                continue
+            if len(rel.parts) > 1:
+                names.add(rel.parts[0])
+        return names
+
+    def adopt(self, source_root: Path, rel_dir: str) -> int:
+        """Stage every file under source_root/rel_dir verbatim. Returns the count."""
+        src = Path(source_root) / rel_dir
+        count = 0
+        for path in src.rglob('*'):
+            if path.is_file():
+                self._docs[self.root / path.relative_to(source_root)] = path.read_bytes()
+                count += 1
+        return count
+
+    def flush(self, dest: Optional[Path] = None, workers: int = 8, prune: bool = False,
+              keep: Iterable[str] = (MANIFEST_NAME,)) -> Dict[str, int]:
+        """Write the tree to `dest` (default: its own root).
+
+        When dest is another directory, the files already under root are
+        published too, and with prune=True files in dest that are no longer
+        part of the mockup are removed. Files whose bytes are unchanged are
+        left alone, so their mtimes survive re-runs.
+
+        Every file is replaced atomically, so a reader never sees one half
+        written. When anything was written or removed the root index is
+        touched last, which is what a running server watches to reload.
+        """
+        dest = Path(dest) if dest is not None else self.root
+        publish = dest.resolve() != self.root.resolve()
+        sources: Dict[Path, Any] = {}
+        if publish:
+            for path in self.root.rglob('*'):
+                if path.is_file():
+                    sources[path.relative_to(self.root)] = path
+        for path, doc in self._docs.items():
+            sources[path.relative_to(self.root)] = doc
+
+        def _put(item) -> bool:
+            rel, src = item
+            if isinstance(src, Path):
+                data = src.read_bytes()
+            elif isinstance(src, bytes):
+                data = src
+            else:
+                data = _dumps(src)
+            target = dest / rel
+            try:
+                if target.stat().st_size == len(data) and target.read_bytes() == data:
+                    return False
+            except OSError:
+                pass
+            target.parent.mkdir(parents=True, exist_ok=True)
+            fd, tmp = tempfile.mkstemp(dir=str(target.parent), prefix='.', suffix='.tmp')
+            try:
+                with os.fdopen(fd, 'wb') as f:
+                    f.write(data)
+                os.replace(tmp, target)
+            except BaseException:
+                try:
+                    os.unlink(tmp)
+                except OSError:
+                    pass
+                raise
+            return True
+
+        with ThreadPoolExecutor(max_workers=max(1, workers)) as pool:
+            changed = sum(pool.map(_put, sources.items()))
+        stats = {'written': changed, 'unchanged': len(sources) - changed, 'removed': 0}
+
+        if publish and prune and dest.exists():
+            keep = set(keep)
+            for path in sorted(dest.rglob('*'), reverse=True):
+                rel = path.relative_to(dest)
+                if path.is_dir():
+                    if not any(path.iterdir()):
+                        path.rmdir()
+                elif rel not in sources and str(rel) not in keep:
+                    path.unlink()
+                    stats['removed'] += 1
+        if stats['written'] or stats['removed']:
+            try:
+                os.utime(dest / ROOT_INDEX)
+            except OSError:
+                pass
+        self._docs.clear()
+        return stats
+
+
+def endpoint_key(ep: dict) -> Optional[str]:
+    """Manifest key for an endpoint; None if it has no FRU to identify it by."""
+    return endpoint_fru_sha256(ep) if isinstance(ep, dict) else None
+
+
+def endpoint_digest(ep: dict, short_name: str, short_description: str, context: dict) -> str:
+    """Digest of everything the generators read for one endpoint.
+
+    `context` holds the run-wide inputs (automation manager, schema
+    metadata) so that changing them regenerates every endpoint.
+    """
+    pdrs = [r.get('decoded') for r in ep.get('pdr_records') or [] if isinstance(r, dict)]
+    inputs = {
+        'version': MANIFEST_VERSION,
+        'fields': {k: ep.get(k) for k in DIGEST_FIELDS},
+        'pdrs': pdrs,
+        'short_name': short_name,
+        'short_description': short_description,
+        'context': context,
+    }
+    return hashlib.sha256(json.dumps(inputs, sort_keys=True, default=str).encode()).hexdigest()
+
+
+def metadata_digest(mockup: Path) -> Optional[str]:
+    """Digest of the mockup's $metadata, which fixes the schema versions used."""
+    for rel in (('$metadata', 'index.xml'), ('$metadata.xml',)):
+        path = Path(mockup, 'redfish', 'v1', *rel)
+        if path.exists():
+            return hashlib.sha256(path.read_bytes()).hexdigest()
+    return None
+
+
+def load_manifest(dest: Path) -> Dict[str, dict]:
+    """Endpoint entries from a previous run, or {} when there is none."""
+    try:
+        data = json.loads((Path(dest) / MANIFEST_NAME).read_text())
+    except Exception:
+        return {}
+    if not isinstance(data, dict) or data.get('version') != MANIFEST_VERSION:
+        return {}
+    endpoints = data.get('endpoints')
+    return endpoints if isinstance(endpoints, dict) else {}
+
+
+def write_manifest(dest: Path, endpoints: Dict[str, dict]) -> None:
+    path = Path(dest) / MANIFEST_NAME
+    tmp = path.with_suffix('.tmp')
+    tmp.write_text(json.dumps({'version': MANIFEST_VERSION, 'endpoints': endpoints}, indent=2))
+    os.replace(tmp, path)
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Persistent on-disk cache of PDR repositories.
+
+Entries are keyed by FRU identity (SHA-256 of the stripped FRU record table,
+the same bytes the runtime agent's FRUMatcher compares) and validated against
+the endpoint's GetPDRRepositoryInfo signature. On a warm start the collector
+sends a single RepositoryInfo query and, if the signature is unchanged, reuses
+the cached records instead of walking the GetPDR chain.
+
+Layout: <cache_dir>/<fru_sha256>.json
+  {
+    "fru_sha256": "...",
+    "repository_info": {"update_time": "<hex>", "oem_update_time": "<hex>",
+                        "record_count": .., "repository_size": ..},
+    "records": [{"handle": .., "next_handle": .., "pdr_data": "<hex>"}, ...]
+  }
+"""
+import hashlib
+import json
+import os
+import tempfile
+from pathlib import Path
+from typing import List, Optional
+
+
+# GetPDRRepositoryInfo fields that identify an unchanged repository. An
+# endpoint without a clock may report a constant UpdateTime, so the record
+# count and repository size are compared as well.
+SIGNATURE_FIELDS = ('update_time', 'oem_update_time', 'record_count', 'repository_size')
+
+
+def fru_key(fru_data: bytes) -> str:
+    """Return the cache key for a FRU record table."""
+    return hashlib.sha256(bytes(fru_data)).hexdigest()
+
+
+def repository_signature(repo_info: Optional[dict]) -> Optional[dict]:
+    """Reduce decoded GetPDRRepositoryInfo to the fields used for validation."""
+    if not isinstance(repo_info, dict) or 'error' in repo_info:
+        return None
+    if repo_info.get('repository_state', 0) != 0:
+        # Update in progress or failed: the records are not settled
+        return None
+    sig = {k: repo_info.get(k) for k in SIGNATURE_FIELDS}
+    if any(v is None for v in sig.values()):
+        return None
+    return sig
+
+
+class PDRCache:
+    """Directory-backed PDR repository cache."""
+
+    def __init__(self, cache_dir):
+        self.cache_dir = Path(cache_dir).expanduser()
+
+    def _path(self, fru_data: bytes) -> Path:
+        return self.cache_dir / f'{fru_key(fru_data)}.json'
+
+    def lookup(self, fru_data: bytes, repo_info: Optional[dict]) -> Optional[List[dict]]:
+        """Return cached records if the repository signature still matches.
+
+        Records are in get_pdr() form: {'handle', 'next_handle', 'pdr_data'}.
+        Returns None on miss, mismatch or unreadable entry.
+        """
+        if not fru_data:
+            return None
+        sig = repository_signature(repo_info)
+        if sig is None:
+            return None
+        path = self._path(fru_data)
+        try:
+            with open(path, 'r') as f:
+                entry = json.load(f)
+        except Exception:
+            return None
+
+        if entry.get('repository_info') != sig:
+            return None
+        try:
+            records = [
+                {
+                    'handle': int(r['handle']),
+                    'next_handle': int(r['next_handle']),
+                    'pdr_data': bytes.fromhex(r['pdr_data']),
+                }
+                for r in entry.get('records', [])
+            ]
+        except Exception:
+            return None
+        return records or None
+
+    def store(self, fru_data: bytes, repo_info: Optional[dict], records: List[dict]) -> bool:
+        """Write (or replace) the entry for this FRU. Returns True on success."""
+        sig = repository_signature(repo_info)
+        if not fru_data or sig is None or not records:
+            return False
+        entry = {
+            'fru_sha256': fru_key(fru_data),
+            'repository_info': sig,
+            'records': [
+                {
+                    'handle': r.get('handle'),
+                    'next_handle': r.get('next_handle'),
+                    'pdr_data': bytes(r.get('pdr_data', b'')).hex(),
+                }
+                for r in records
+            ],
+        }
+        tmp = None
+        try:
+            self.cache_dir.mkdir(parents=True, exist_ok=True)
+            # Write atomically so a crash never leaves a truncated entry
+            fd, tmp = tempfile.mkstemp(dir=str(self.cache_dir), suffix='.tmp')
+            with os.fdopen(fd, 'w') as f:
+                json.dump(entry, f)
+            os.replace(tmp, self._path(fru_data))
+            return True
+        except Exception:
+            if tmp:
+                try:
+                    os.unlink(tmp)
+                except Exception:
+                    pass
+            return False
+
+    def invalidate(self, fru_data: bytes) -> None:
+        """Remove the entry for this FRU, if any."""
+        try:
+            self._path(fru_data).unlink()
+        except FileNotFoundError:
+            pass
@@ -6,9 +6,11 @@ from pldm_mapping_wizard.redfish import SchemaLoader
 from pldm_mapping_wizard.discovery import PortMonitor
 from pldm_mapping_wizard.discovery.pdr_retriever import PDRRetriever
 from pldm_mapping_wizard.mapping import MappingAccumulator, DeviceMapping
+import shlex
 import subprocess
 import sys
 from pathlib import Path
+from typing import Optional
 
 __version__ = "0.1.0"
 
@@ -167,7 +169,7 @@ def setup(output, local_eid, remote_eid, baud, debug):
                 other_count = 0
                 
                 for pdr in pdrs:
-                    pdr_type = pdr.get("type_name", "UNKNOWN")
+                    pdr_type = pdr.get("type_name", "UNKNOWN").upper()
                     if "SENSOR" in pdr_type:
                         sensor_count += 1
                     elif "EFFECTER" in pdr_type:
@@ -240,11 +242,19 @@ def validate(mappings):
 
 
 @cli.command('scan-and-generate')
-@click.option('--collect-output', '-c', type=click.Path(), default='/tmp/pdr_and_fru_records.json', help='Temporary output from device collection')
+@click.option('--collect-output', '-c', type=click.Path(), default='/tmp/pdr_and_fru_records.db', help='Temporary output from device collection')
 @click.option('--source-mockup', '-s', type=click.Path(), default='samples/mockup', help='Reference mockup source')
 @click.option('--dest-mockup', '-d', type=click.Path(), default='output/generated_mockup', help='Destination mockup folder')
 @click.option('--auto-select/--no-auto-select', default=True, help='Auto-select discovered devices (non-interactive)')
-def scan_and_generate(collect_output: str, source_mockup: str, dest_mockup: str, auto_select: bool):
+@click.option('--pdr-cache', type=click.Path(), default=None, help='PDR repository cache directory (disabled if omitted)')
+@click.option('--workers', '-j', type=int, default=8, help='Endpoints to query in parallel during collection')
+@click.option('--incremental/--full', default=True, help='Regenerate only endpoints whose PDRs or FRU changed (--full rebuilds the mockup)')
+@click.option('--link-negotiation/--no-link-negotiation', default=True, help='Negotiate baud rate and transfer sizes per endpoint')
+@click.option('--baud-rates', type=str, default=None, help='Comma-separated baud rates to try above 115200')
+@click.option('--transfer-sizes', type=str, default=None, help='Comma-separated GetPDR / FRU part sizes to try')
+@click.option('--ports', type=str, default=None, help='Comma-separated USB port id patterns to collect (a shard\'s ports)')
+def scan_and_generate(collect_output: str, source_mockup: str, dest_mockup: str, auto_select: bool, pdr_cache: Optional[str], workers: int, incremental: bool,
+                      link_negotiation: bool, baud_rates: Optional[str], transfer_sizes: Optional[str], ports: Optional[str]):
     """Run device collection (front-end) then run the mockup generator (backend).
 
     This command runs the serial device collector to produce a JSON file of PDRs/FRUs,
@@ -269,12 +279,23 @@ def scan_and_generate(collect_output: str, source_mockup: str, dest_mockup: str,
 
     # Run collector (non-interactive if auto_select)
     console.print(f"Running collector -> {collect_output_path}")
+    collector_cmd = [sys.executable, str(collector), '-o', str(collect_output_path), '-j', str(workers)]
+    if pdr_cache:
+        collector_cmd += ['--cache-dir', str(Path(pdr_cache).expanduser())]
+    if not link_negotiation:
+        collector_cmd.append('--no-link-negotiation')
+    if baud_rates:
+        collector_cmd += ['--baud-rates', baud_rates.replace(' ', '')]
+    if transfer_sizes:
+        collector_cmd += ['--transfer-sizes', transfer_sizes.replace(' ', '')]
+    if ports:
+        collector_cmd += ['--ports', ports.replace(' ', '')]
     try:
         if auto_select:
             # pipe the word 'all' to the collector to auto-select discovered devices
-            subprocess.run("echo all | " + ' '.join([sys.executable, str(collector), '-o', str(collect_output_path)]), shell=True, check=True)
+            subprocess.run("echo all | " + ' '.join(shlex.quote(c) for c in collector_cmd), shell=True, check=True)
         else:
-            subprocess.run([sys.executable, str(collector), '-o', str(collect_output_path)], check=True)
+            subprocess.run(collector_cmd, check=True)
     except subprocess.CalledProcessError as e:
         console.print(f"[red]Collector failed: {e}[/red]")
         return
@@ -289,7 +310,10 @@ def scan_and_generate(collect_output: str, source_mockup: str, dest_mockup: str,
 
     console.print(f"Running generator: clean_mockup -> dest={dest_path}")
     try:
-        subprocess.run([sys.executable, str(generator), '-s', str(source_path), '-d', str(dest_path), '-p', str(collect_output_path)], check=True)
+        generator_cmd = [sys.executable, str(generator), '-s', str(source_path), '-d', str(dest_path), '-p', str(collect_output_path), '-j', str(workers)]
+        if incremental:
+            generator_cmd.append('--incremental')
+        subprocess.run(generator_cmd, check=True)
     except subprocess.CalledProcessError as e:
         console.print(f"[red]Generator failed: {e}[/red]")
         return
@@ -0,0 +1,307 @@
+"""Incremental DSP0257 FRU Record Table parser.
+
+FRUTableStream is fed the GetFRURecordTable transfer one part at a time and
+indexes records and fields as soon as their bytes have arrived. Fields are
+kept as (start, end) offsets into the received bytes rather than copied out.
+A stream created with `want` reports done as soon as those fields are
+complete, so a caller that only needs, say, the serial number can abandon the
+transfer there.
+
+Field dicts in the collector's JSON layout (raw_hex, value, names) are only
+built when parsed_records() or value() asks for them, and are decoded
+straight from a memoryview of the received bytes.
+"""
+
+import codecs
+import struct
+from typing import Dict, Iterable, List, Optional, Tuple
+
+# DSP0257 record types
+FRU_RECORD_TYPE_GENERAL = 1
+FRU_RECORD_TYPE_OEM = 254
+
+# DSP0257 General FRU record field types
+FRU_FIELD_SERIAL_NUMBER = 4
+
+# (record type, field type) of the General record's Serial Number
+SERIAL_NUMBER = (FRU_RECORD_TYPE_GENERAL, FRU_FIELD_SERIAL_NUMBER)
+
+FIELD_TYPE_NAMES = {
+    1: 'Chassis Type',
+    2: 'Model',
+    3: 'Part Number',
+    4: 'Serial Number',
+    5: 'Manufacturer',
+    6: 'Manufacture Date',
+    7: 'Vendor',
+    8: 'Name',
+    9: 'SKU',
+    10: 'Version',
+    11: 'Asset Tag',
+    12: 'Description',
+    13: 'Engineering Change Level',
+    14: 'Other Information',
+    15: 'Vendor IANA',
+    16: 'Spare Part Number',
+}
+
+# Friendly short names for common FRU field types (for JSON keys)
+FRIENDLY_FIELD_NAMES = {
+    1: 'chassisType',
+    2: 'model',
+    3: 'partNumber',
+    4: 'serialNumber',
+    5: 'manufacturer',
+    6: 'manufactureDate',
+    7: 'vendor',
+    8: 'name',
+    9: 'sku',
+    10: 'version',
+    11: 'assetTag',
+    12: 'description',
+    13: 'engineeringChangeLevel',
+    14: 'otherInfo',
+    15: 'vendorIANA',
+    16: 'sparePartNumber',
+}
+
+# DSP0257 encoding tokens for string-like fields
+ENCODING_TOKENS = {
+    0: 'Unspecified',
+    1: 'strASCII',
+    2: 'strUTF-8',
+    3: 'strUTF-16',
+    4: 'strUTF-16LE',
+    5: 'strUTF-16BE',
+}
+
+# Decoders that read a memoryview in place (bytes.decode would need a copy)
+TEXT_DECODERS = {
+    'strASCII': lambda v: codecs.ascii_decode(v, 'replace')[0],
+    'strUTF-8': lambda v: codecs.utf_8_decode(v, 'replace', True)[0],
+    'strUTF-16': lambda v: codecs.utf_16_decode(v, 'replace', True)[0],
+    'strUTF-16LE': lambda v: codecs.utf_16_le_decode(v, 'replace', True)[0],
+    'strUTF-16BE': lambda v: codecs.utf_16_be_decode(v, 'replace', True)[0],
+}
+
+STRING_FIELD_TYPES = frozenset((1, 2, 3, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 16))
+
+# RecordSetID, RecordType, NumberOfFields, Encoding
+RECORD_HEADER = struct.Struct('<HBBB')
+UINT32 = struct.Struct('<I')
+
+
+def _octets(value) -> list:
+    return value.tolist() if isinstance(value, memoryview) else list(value)
+
+
+def interpret_field(record_type: int, encoding: int, field_type: int, field_length: int, value) -> dict:
+    """Field dict for one TLV; `value` is a memoryview (or bytes) of its data."""
+    field = {
+        'field_type': field_type,
+        'field_length': field_length,
+        'field_type_name': FIELD_TYPE_NAMES.get(field_type, f'Unknown(0x{field_type:02x})'),
+        'raw_hex': value.hex(),
+    }
+
+    # Interpret per DSP0257 Table 4/5
+    # OEM records (type 254) have special rule: field type 1 => Vendor IANA (uint32)
+    if record_type == FRU_RECORD_TYPE_OEM:
+        if field_type == 1 and len(value) == 4:
+            field['format'] = 'uint32'
+            field['value'] = UINT32.unpack_from(value, 0)[0]
+        else:
+            # OEM-specific types: leave as raw bytes unless the code knows otherwise
+            field['format'] = 'bytes'
+            field['value'] = _octets(value)
+    elif field_type == 15 and len(value) == 4:
+        field['format'] = 'uint32'
+        field['value'] = UINT32.unpack_from(value, 0)[0]
+    elif field_type == 6 and len(value) == 13:
+        # timestamp104: expose raw bytes as array (spec expects timestamp104 type)
+        field['format'] = 'timestamp104'
+        field['value'] = _octets(value)
+        field['value_components'] = {
+            'year_le': struct.unpack_from('<H', value, 0)[0],
+            'year_be': struct.unpack_from('>H', value, 0)[0],
+            'month': value[2],
+            'day': value[3],
+            'hour': value[4],
+            'minute': value[5],
+            'second': value[6],
+            'remainder_hex': value[7:].hex(),
+        }
+    elif field_type in STRING_FIELD_TYPES:
+        token = ENCODING_TOKENS.get(encoding)
+        if token is None:
+            # Reserved encodings (6-255) -> treat as reserved octet data
+            field['format'] = 'reserved'
+            field['value'] = _octets(value)
+        elif token == 'Unspecified':
+            field['format'] = 'Unspecified'
+            field['value'] = _octets(value)
+        else:
+            field['format'] = token
+            try:
+                field['value'] = TEXT_DECODERS[token](value)
+            except Exception:
+                field['format'] = 'reserved'
+                field['value'] = _octets(value)
+    else:
+        # Reserved/unknown field types -> raw bytes
+        field['format'] = 'bytes'
+        field['value'] = _octets(value)
+
+    # Attach a friendly name (if available) for easier JSON access
+    friendly = FRIENDLY_FIELD_NAMES.get(field_type)
+    if friendly:
+        field['friendly_name'] = friendly
+    return field
+
+
+class FRUTableStream:
+    """FRU Record Table parsed part by part as a transfer arrives.
+
+    `want` lists (record type, field type) pairs the caller needs; feed()
+    returns True once the first occurrence of each is complete. Parsing
+    stops at `total_length` (from GetFRURecordTableMetadata) so trailing
+    padding or CRC bytes are never taken for records.
+
+    Memoryviews returned by field() pin the buffer: release them before
+    feeding more data.
+    """
+
+    def __init__(self, want: Iterable[Tuple[int, int]] = (), total_length: Optional[int] = None):
+        self.want = frozenset(want)
+        self._missing = set(self.want)
+        self.total_length = None if total_length is None else int(total_length)
+        # [record set ID, record type, field count, encoding, [(field type, length, start, end), ...]]
+        self.records: List[list] = []
+        self.fields: Dict[Tuple[int, int], Tuple[int, int]] = {}  # first occurrence -> (start, end)
+        self._buf = bytearray()
+        self._pos = 0
+        self._fields_left = 0
+        self._finished = False
+
+    @property
+    def done(self) -> bool:
+        """True once every wanted field has arrived (never, without `want`)."""
+        return bool(self.want) and not self._missing
+
+    @property
+    def consumed(self) -> int:
+        """Bytes of the table taken by the records parsed so far."""
+        return self._pos
+
+    @property
+    def data(self) -> bytes:
+        return bytes(self._buf)
+
+    def _limit(self) -> int:
+        n = len(self._buf)
+        return n if self.total_length is None else min(n, self.total_length)
+
+    def feed(self, chunk) -> bool:
+        """Add the next part of the transfer; returns `done`."""
+        if not self._buf and isinstance(chunk, bytes):
+            # A whole table handed over at once is parsed where it lies
+            self._buf = chunk
+        else:
+            if isinstance(self._buf, bytes):
+                self._buf = bytearray(self._buf)
+            self._buf += chunk
+        self._index()
+        return self.done
+
+    def _index(self):
+        # Index whole records and fields from `_pos`; stops early once the
+        # last wanted field arrives, and resumes on the next call
+        buf, pos, limit = self._buf, self._pos, self._limit()
+        while True:
+            if not self._fields_left:
+                if pos + RECORD_HEADER.size > limit:
+                    break
+                set_id, record_type, num_fields, encoding = RECORD_HEADER.unpack_from(buf, pos)
+                pos += RECORD_HEADER.size
+                self.records.append([set_id, record_type, num_fields, encoding, []])
+                self._fields_left = num_fields
+                continue
+            if pos + 2 > limit:
+                break
+            field_type, field_len = buf[pos], buf[pos + 1]
+            end = pos + 2 + field_len
+            if end > limit:
+                break
+            record = self.records[-1]
+            record[4].append((field_type, field_len, pos + 2, end))
+            key = (record[1], field_type)
+            if key not in self.fields:
+                self.fields[key] = (pos + 2, end)
+            self._fields_left -= 1
+            pos = end
+            if key in self._missing:
+                self._missing.discard(key)
+                if not self._missing:
+                    break
+        self._pos = pos
+
+    def finish(self) -> int:
+        """End of transfer: keep a truncated last field, clamped, and return `consumed`."""
+        if not self._finished:
+            self._finished = True
+            self._index()
+            limit = self._limit()
+            if self._fields_left and self._pos + 2 <= limit:
+                record = self.records[-1]
+                field_type, field_len = self._buf[self._pos], self._buf[self._pos + 1]
+                record[4].append((field_type, field_len, self._pos + 2, limit))
+                self.fields.setdefault((record[1], field_type), (self._pos + 2, limit))
+                self._missing.discard((record[1], field_type))
+                self._pos = limit
+        return self._pos
+
+    def end_of(self, key: Tuple[int, int]) -> Optional[int]:
+        """Offset just past field `key`, or None if it has not arrived."""
+        span = self.fields.get(key)
+        return span[1] if span else None
+
+    def field(self, key: Tuple[int, int]) -> Optional[memoryview]:
+        """Raw bytes of field `key` as a memoryview of the received data."""
+        span = self.fields.get(key)
+        return memoryview(self._buf)[span[0]:span[1]] if span else None
+
+    def value(self, key: Tuple[int, int]):
+        """Interpreted value of field `key` (e.g. the serial number string)."""
+        span = self.fields.get(key)
+        if span is None:
+            return None
+        for _, record_type, _, encoding, fields in self.records:
+            if record_type != key[0]:
+                continue
+            for field_type, field_len, start, end in fields:
+                if (start, end) == span:
+                    with memoryview(self._buf) as view:
+                        return interpret_field(record_type, encoding, field_type, field_len, view[start:end])['value']
+        return None
+
+    def parsed_records(self) -> List[dict]:
+        """Records in the layout of export_pdrs_to_json.parse_fru_record_table()."""
+        out = []
+        with memoryview(self._buf) as view:
+            for set_id, record_type, num_fields, encoding, fields in self.records:
+                out.append({
+                    'fru_record_set_id': set_id,
+                    'fru_record_type': record_type,
+                    'number_of_fields': num_fields,
+                    'encoding': encoding,
+                    'fields': [interpret_field(record_type, encoding, ft, fl, view[s:e]) for ft, fl, s, e in fields],
+                })
+        return out
+
+
+def parse_fru_record_table(data, total_length: Optional[int] = None):
+    """Parse a whole FRU Record Table: (records, bytes consumed)."""
+    stream = FRUTableStream(total_length=total_length)
+    stream.feed(data)
+    consumed = stream.finish()
+    return stream.parsed_records(), consumed
@@ -0,0 +1,129 @@
+"""Connect-time link negotiation for MCTP serial endpoints.
+
+DSP0253 leaves the serial line speed to configuration, so the baud rate is
+found by trial: the requester switches its side of the link to each candidate
+(fastest first) and keeps the first one at which the endpoint answers GetTID
+reliably. Endpoints that auto-baud, or that sit behind a USB bridge with a
+faster fixed UART, move to the higher rate; everything else falls back to
+115200 after one short timeout per candidate.
+
+Transfer sizes are negotiated per command:
+
+- GetPDR: the largest requestCount for which the first record comes back
+  intact. Larger parts mean fewer round trips for long PDRs; responses above
+  one serial packet arrive as multi-packet MCTP messages.
+- GetFRURecordTable: the part size comes from the endpoint, so it is agreed
+  with NegotiateTransferParameters (DSP0240) when the endpoint supports it.
+
+The result is a plain dict that the collector stores with the endpoint:
+
+  {"baudrate": 921600, "pdr_request_count": 1024, "fru_part_size": 512}
+"""
+
+from typing import Iterable, Optional
+
+from pldm_mapping_wizard.discovery.pldm_commands import PDLMCommandEncoder
+from pldm_mapping_wizard.discovery.request_engine import PLDMRequestEngine
+
+BASE_BAUDRATE = 115200
+BAUD_RATES = (921600, 460800, 230400)
+TRANSFER_SIZES = (1024, 512, 255)
+
+# GetTID replies required before a baud rate is trusted
+PING_COUNT = 2
+
+
+def default_link() -> dict:
+    """Link parameters every endpoint supports."""
+    return {"baudrate": BASE_BAUDRATE, "pdr_request_count": 255, "fru_part_size": None}
+
+
+def _engine(port, timeout: float) -> PLDMRequestEngine:
+    return PLDMRequestEngine(port, local_eid=16, remote_eid=0, max_outstanding=1, timeout=timeout, retries=0)
+
+
+def ping(port, timeout: float = 0.25, count: int = PING_COUNT) -> bool:
+    """True if the endpoint answers `count` consecutive GetTID requests."""
+    engine = _engine(port, timeout)
+    for _ in range(count):
+        req = engine.request(PDLMCommandEncoder.encode_get_tid())
+        if not req.ok or req.response.get("resp_code") != 0:
+            return False
+    return True
+
+
+def negotiate_baudrate(port, candidates: Iterable[int] = BAUD_RATES, timeout: float = 0.25) -> int:
+    """Move the port to the fastest candidate rate the endpoint answers at.
+
+    The port is left at the chosen rate; if none works (or the endpoint does
+    not answer at the current rate to begin with) it stays where it was.
+    """
+    base = port.baudrate
+    if not ping(port, timeout, count=1):
+        return base
+    for rate in sorted({int(r) for r in candidates if int(r) > base}, reverse=True):
+        if port.set_baudrate(rate) and ping(port, timeout):
+            return rate
+    port.set_baudrate(base)
+    return base
+
+
+def negotiate_pdr_request_count(port, candidates: Iterable[int] = TRANSFER_SIZES, timeout: float = 0.5) -> int:
+    """Largest GetPDR requestCount for which the first PDR arrives intact."""
+    engine = _engine(port, timeout)
+    sizes = sorted({int(c) for c in candidates if 0 < int(c) <= 0xFFFF}, reverse=True)
+    for size in sizes:
+        req = engine.request(PDLMCommandEncoder.encode_get_pdr(record_handle=0, request_count=size))
+        if not req.ok:
+            continue
+        result = PDLMCommandEncoder.decode_get_pdr_response(req.response.get("extra", b""))
+        if "error" in result:
+            continue
+        count = result["response_count"]
+        if count <= size and len(result["record_data"]) == count:
+            return size
+    return min(sizes) if sizes else 255
+
+
+def negotiate_fru_part_size(port, candidates: Iterable[int] = TRANSFER_SIZES, timeout: float = 0.5) -> Optional[int]:
+    """Agree a GetFRURecordTable part size; None if the endpoint does not negotiate."""
+    sizes = [int(c) for c in candidates if 0 < int(c) <= 0xFFFF]
+    if not sizes:
+        return None
+    engine = _engine(port, timeout)
+    req = engine.request(PDLMCommandEncoder.encode_negotiate_transfer_parameters(
+        part_size=max(sizes), pldm_types=(PDLMCommandEncoder.PLDM_TYPE_FRU,)))
+    if not req.ok:
+        return None
+    result = PDLMCommandEncoder.decode_negotiate_transfer_parameters_response(req.response.get("extra", b""))
+    if "error" in result or PDLMCommandEncoder.PLDM_TYPE_FRU not in result["pldm_types"]:
+        return None
+    return min(result["part_size"], max(sizes)) or None
+
+
+def negotiate_link(port, baud_rates: Iterable[int] = BAUD_RATES,
+                   transfer_sizes: Iterable[int] = TRANSFER_SIZES, timeout: float = 0.25) -> dict:
+    """Run all negotiation steps on an open port; the port keeps the chosen rate."""
+    link = default_link()
+    link["baudrate"] = negotiate_baudrate(port, baud_rates, timeout)
+    transfer_sizes = list(transfer_sizes)
+    if transfer_sizes:
+        link["pdr_request_count"] = negotiate_pdr_request_count(port, transfer_sizes, timeout * 2)
+        link["fru_part_size"] = negotiate_fru_part_size(port, transfer_sizes, timeout * 2)
+    return link
+
+
+def apply_link(port, link: Optional[dict], timeout: float = 0.25) -> int:
+    """Switch an open port to a previously negotiated baud rate.
+
+    The rate is confirmed with GetTID; on failure the port goes back to its
+    current rate. Returns the rate in use.
+    """
+    base = port.baudrate
+    rate = (link or {}).get("baudrate") or base
+    if rate == base:
+        return base
+    if port.set_baudrate(rate) and ping(port, timeout):
+        return rate
+    port.set_baudrate(base)
+    return base
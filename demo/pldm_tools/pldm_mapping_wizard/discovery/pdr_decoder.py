@@ -0,0 +1,1145 @@
+"""Type-dispatched PDR decoder shared by the collector, the wizard and the agent.
+
+Field names follow DSP0248. Each PDR type has a decoder registered in
+DECODERS; decoders read fixed-layout runs with precompiled struct.Struct
+objects (unpack_from) over a single memoryview of the record, so no
+intermediate slices are copied. Variable-width fields (sensor/effecter data
+sizes, range formats) use the per-format Structs in DATA_SIZE_STRUCTS and
+RANGE_FIELD_STRUCTS.
+
+OEM State Set PDRs register their value names in OEM_STATE_SET_VALUES as a
+side effect, so state sensor/effecter PDRs that reference them must be
+decoded afterwards; decode_pdrs() takes care of that ordering.
+
+Long-lived consumers (the runtime agent) keep records as LazyPDR instead:
+the raw bytes plus memoized decoding. The few fields they need (sensor and
+effecter IDs, sampling parameters) are read straight from their offsets,
+and the full dict is only built if some other field is asked for.
+"""
+
+import logging
+import struct
+import sys
+import threading
+import weakref
+from functools import lru_cache
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, List, Optional, Union
+
+try:
+    from entity_types_dsp0249 import ENTITY_TYPES
+except ImportError:
+    # Imported through the package without pldm_tools on sys.path
+    sys.path.insert(0, str(Path(__file__).resolve().parents[2]))
+    from entity_types_dsp0249 import ENTITY_TYPES
+
+logger = logging.getLogger(__name__)
+
+# State Set definitions (DSP0249) for commonly used sets in this repo.
+# Maps stateSetID -> {"name": str, "values": {stateValue: stateName}}
+STATE_SET_DEFINITIONS = {
+    64: {
+        "name": "Smoke State",
+        "values": {
+            0: "Unknown",
+            1: "Normal",
+            2: "Smoke",
+        },
+    },
+    65: {
+        "name": "Humidity State",
+        "values": {
+            0: "Unknown",
+            1: "Normal",
+            2: "Humid",
+        },
+    },
+    66: {
+        "name": "Door State",
+        "values": {
+            0: "Unknown",
+            1: "Open",
+            2: "Closed",
+        },
+    },
+    67: {
+        "name": "Switch State",
+        "values": {
+            0: "Unknown",
+            1: "Pressed/On",
+            2: "Released/Off",
+        },
+    },
+    96: {
+        "name": "Lock State",
+        "values": {
+            0: "Unknown",
+            1: "Locked",
+            2: "Unlocked",
+            3: "Locked Out",
+        },
+    },
+}
+
+# OEM state sets populated from OEM State Set PDRs at decode time.
+OEM_STATE_SET_VALUES = {}
+OEM_STATE_SET_NAMES = {}
+
+def get_state_set_info(state_set_id):
+    """Return (state_set_name, value_map) for standard or OEM state sets."""
+    if state_set_id in OEM_STATE_SET_VALUES:
+        name = OEM_STATE_SET_NAMES.get(state_set_id, f"OEM State Set (0x{state_set_id:04x})")
+        return name, OEM_STATE_SET_VALUES[state_set_id]
+
+    definition = STATE_SET_DEFINITIONS.get(state_set_id)
+    if definition:
+        return definition["name"], definition["values"]
+
+    return f"Unknown State Set (0x{state_set_id:04x})", {}
+
+RATE_UNIT_NAMES = {
+    0x00: "None",
+    0x01: "Per MicroSecond",
+    0x02: "Per MilliSecond",
+    0x03: "Per Second",
+    0x04: "Per Minute",
+    0x05: "Per Hour",
+    0x06: "Per Day",
+    0x07: "Per Week",
+    0x08: "Per Month",
+    0x09: "Per Year",
+}
+
+# Table 75 – sensorUnits enumeration (DSP0248 Section 27.4)
+UNIT_NAMES = {
+    0: "None",
+    1: "Unspecified",
+    2: "Degrees C",
+    3: "Degrees F",
+    4: "Kelvins",
+    5: "Volts",
+    6: "Amps",
+    7: "Watts",
+    8: "Joules",
+    9: "Coulombs",
+    10: "VA",
+    11: "Nits",
+    12: "Lumens",
+    13: "Lux",
+    14: "Candelas",
+    15: "kPa",
+    16: "PSI",
+    17: "Newtons",
+    18: "CFM",
+    19: "RPM",
+    20: "Hertz",
+    21: "Seconds",
+    22: "Minutes",
+    23: "Hours",
+    24: "Days",
+    25: "Weeks",
+    26: "Mils",
+    27: "Inches",
+    28: "Feet",
+    29: "Cubic Inches",
+    30: "Cubic Feet",
+    31: "Meters",
+    32: "Cubic Centimeters",
+    33: "Cubic Meters",
+    34: "Liters",
+    35: "Fluid Ounces",
+    36: "Radians",
+    37: "Steradians",
+    38: "Revolutions",
+    39: "Cycles",
+    40: "Gravities",
+    41: "Ounces",
+    42: "Pounds",
+    43: "Foot-Pounds",
+    44: "Ounce-Inches",
+    45: "Gauss",
+    46: "Gilberts",
+    47: "Henries",
+    48: "Farads",
+    49: "Ohms",
+    50: "Siemens",
+    51: "Moles",
+    52: "Becquerels",
+    53: "PPM (parts/million)",
+    54: "Decibels",
+    55: "DbA",
+    56: "DbC",
+    57: "Grays",
+    58: "Sieverts",
+    59: "Color Temperature Degrees K",
+    60: "Bits",
+    61: "Bytes",
+    62: "Words (data)",
+    63: "DoubleWords",
+    64: "QuadWords",
+    65: "Percentage",
+    66: "Pascals",
+    67: "Counts",
+    68: "Grams",
+    69: "Newton-meters",
+    70: "Hits",
+    71: "Misses",
+    72: "Retries",
+    73: "Overruns/Overflows",
+    74: "Underruns",
+    75: "Collisions",
+    76: "Packets",
+    77: "Messages",
+    78: "Characters",
+    79: "Errors",
+    80: "Corrected Errors",
+    81: "Uncorrectable Errors",
+    82: "Square Mils",
+    83: "Square Inches",
+    84: "Square Feet",
+    85: "Square Centimeters",
+    86: "Square Meters",
+    255: "OEMUnit",
+}
+
+EFFECTER_DATA_SIZE_FORMATS = {
+    0x00: ("uint8", 1, "<B"),
+    0x01: ("sint8", 1, "<b"),
+    0x02: ("uint16", 2, "<H"),
+    0x03: ("sint16", 2, "<h"),
+    0x04: ("uint32", 4, "<I"),
+    0x05: ("sint32", 4, "<i"),
+    0x06: ("uint64", 8, "<Q"),
+    0x07: ("sint64", 8, "<q"),
+}
+
+RANGE_FIELD_FORMATS = {
+    0x00: ("uint8", 1, "<B"),
+    0x01: ("sint8", 1, "<b"),
+    0x02: ("uint16", 2, "<H"),
+    0x03: ("sint16", 2, "<h"),
+    0x04: ("uint32", 4, "<I"),
+    0x05: ("sint32", 4, "<i"),
+    0x06: ("real32", 4, "<f"),
+    0x07: ("uint64", 8, "<Q"),
+    0x08: ("sint64", 8, "<q"),
+}
+
+def read_typed_value(data: bytes, offset: int, fmt_info: tuple):
+    """Read a value from data using (name, size, struct_fmt)."""
+    _, size, struct_fmt = fmt_info
+    if offset + size > len(data):
+        return None, offset
+    value = struct.unpack_from(struct_fmt, data, offset)[0]
+    return value, offset + size
+
+# PDR Type to Name mapping (from Table 77 - DSP0248)
+PDR_TYPE_NAMES = {
+    1: "Terminus Locator PDR",
+    2: "Numeric Sensor PDR",
+    3: "Numeric Sensor Initialization PDR",
+    4: "State Sensor PDR",
+    5: "State Sensor Initialization PDR",
+    6: "Sensor Auxiliary Names PDR",
+    7: "OEM Unit PDR",
+    8: "OEM State Set PDR",
+    9: "Numeric Effecter PDR",
+    10: "Numeric Effecter Initialization PDR",
+    11: "State Effecter PDR",
+    12: "State Effecter Initialization PDR",
+    13: "Effecter Auxiliary Names PDR",
+    14: "Effecter OEM Semantic PDR",
+    15: "Entity Association PDR",
+    16: "Entity Auxiliary Names PDR",
+    17: "OEM Entity ID PDR",
+    18: "Interrupt Association PDR",
+    19: "PLDM Event Log PDR",
+    20: "FRU Record Set PDR",
+    21: "Compact Numeric Sensor PDR",
+    22: "Redfish Resource PDR",
+    23: "Redfish Entity Association PDR",
+    24: "Redfish Action PDR",
+}
+
+@lru_cache(maxsize=None)
+def get_entity_type_name(entity_type):
+    """Get human-readable name for entity type, handling P/L bit."""
+    # Bit 15 is P/L flag (0=physical, 1=logical)
+    is_logical = bool(entity_type & 0x8000)
+    entity_id = entity_type & 0x7FFF
+    
+    # Look up entity name from DSP0249
+    entity_name = ENTITY_TYPES.get(entity_id)
+    
+    if entity_name is None:
+        # Check OEM ranges
+        if 192 <= entity_id <= 16383:
+            entity_name = f"Chassis-specific (0x{entity_id:04x})"
+        elif 16384 <= entity_id <= 24575:
+            entity_name = f"Board-set specific (0x{entity_id:04x})"
+        elif 24576 <= entity_id <= 32767:
+            entity_name = f"OEM System Integrator (0x{entity_id:04x})"
+        else:
+            entity_name = f"Reserved (0x{entity_id:04x})"
+    
+    pl_prefix = "Logical " if is_logical else ""
+    return f"{pl_prefix}{entity_name}"
+
+
+# --- Precompiled layouts (offsets are relative to the end of the header) ---
+
+HEADER = struct.Struct('<IBBHH')
+HEADER_SIZE = HEADER.size
+
+DATA_SIZE_STRUCTS = {k: struct.Struct(v[2]) for k, v in EFFECTER_DATA_SIZE_FORMATS.items()}
+RANGE_FIELD_STRUCTS = {k: struct.Struct(v[2]) for k, v in RANGE_FIELD_FORMATS.items()}
+
+_REAL32 = struct.Struct('<f')
+_U8X2 = struct.Struct('<BB')
+_U16 = struct.Struct('<H')
+_STATE_SET = struct.Struct('<HB')            # stateSetID, possibleStatesSize
+_ENTITY = struct.Struct('<HHH')              # entityType, instance, containerID
+
+_TERMINUS_LOCATOR = struct.Struct('<HBBHBB')
+_ENTITY_ASSOCIATION = struct.Struct('<HBHHHB')
+_ENTITY_AUX_NAMES = struct.Struct('<HH')
+_OEM_ENTITY_ID = struct.Struct('<HHIHB')
+_FRU_RECORD_SET = struct.Struct('<HHHHH')
+_OEM_STATE_SET = struct.Struct('<HHIHBB')
+_OEM_STATE_VALUE = struct.Struct('<BBB')
+_STATE_SENSOR = struct.Struct('<HHHHHBBB')
+_STATE_EFFECTER = struct.Struct('<HHHHHHBBB')
+_COMPACT_NUMERIC_SENSOR = struct.Struct('<BHHH')
+# terminus handle .. sensorDataSize
+_NUMERIC_SENSOR = struct.Struct('<HHHHHBBBbBBBbBBBBB')
+_NUMERIC_SENSOR_ACCURACY = struct.Struct('<HBB')
+# terminus handle .. transitionInterval
+_NUMERIC_EFFECTER = struct.Struct('<HHHHHHBBBbBBBbBBBBffHBBff')
+
+SENSOR_INIT_NAMES = {
+    0x00: 'noInit',
+    0x01: 'useInitPDR',
+    0x02: 'enableSensor',
+    0x03: 'disableSensor',
+}
+EFFECTER_INIT_NAMES = {
+    0x00: 'noInit',
+    0x01: 'useInitPDR',
+    0x02: 'enableEffecter',
+    0x03: 'disableEffecter',
+}
+ASSOCIATION_TYPE_NAMES = {
+    0x00: "physicalToPhysicalContainment",
+    0x01: "logicalContainment",
+}
+VALIDITY_NAMES = {
+    0x00: 'notValid',
+    0x01: 'valid',
+}
+TERMINUS_LOCATOR_TYPE_NAMES = {
+    0x00: 'UID',
+    0x01: 'MCTP_EID',
+    0x02: 'SMBusRelative',
+    0x03: 'systemSoftware',
+    0x04: 'NC_SI',
+}
+SOFTWARE_CLASS_NAMES = {
+    0x00: 'unspecified',
+    0x01: 'other',
+    0x02: 'systemFirmware',
+    0x03: 'OSloader',
+    0x04: 'OS',
+    0x05: 'CIMprovider',
+    0x06: 'otherProvider',
+    0x07: 'virtualMachineManager',
+}
+AUX_UNIT_RELATIONSHIP_NAMES = {0x00: 'dividedBy', 0x01: 'multipliedBy'}
+UNSPECIFIED_VALUE_HINT_NAMES = {0: "treatAsUnspecified", 1: "treatAsError"}
+
+# Set bit positions of every byte value, for possible-states bitfields
+_SET_BITS = tuple(tuple(bit for bit in range(8) if value & (1 << bit)) for value in range(256))
+
+
+def _read(view, offset, layout):
+    """Read one value with `layout`; (None, offset) when the view is too short."""
+    end = offset + layout.size
+    if end > len(view):
+        return None, offset
+    return layout.unpack_from(view, offset)[0], end
+
+
+def _utf16_nul(raw, start):
+    """Index of the UTF-16 NUL (two zero bytes, 2-aligned from start), or -1."""
+    pos = raw.find(b'\x00\x00', start)
+    while pos != -1 and (pos - start) % 2:
+        pos = raw.find(b'\x00\x00', pos + 1)
+    return pos
+
+
+def _language_string(raw, view, start):
+    """Read a NUL-terminated ASCII language tag followed by a UTF-16BE string.
+
+    Returns (tag, string, next_offset); string is None when it is not
+    terminated. Returns None when the tag itself is not terminated.
+    """
+    tag_end = raw.find(b'\x00', start)
+    if tag_end == -1:
+        return None
+    tag = str(view[start:tag_end], 'ascii', 'replace')
+    start = tag_end + 1
+    name_end = _utf16_nul(raw, start)
+    if name_end == -1:
+        return tag, None, start
+    return tag, str(view[start:name_end], 'utf-16-be', 'replace'), name_end + 2
+
+
+def _possible_states(body, offset, count, unavailable_note):
+    """Decode `count` stateSetID/possibleStates entries starting at offset."""
+    possible_states = []
+    for _ in range(count):
+        if offset + 3 > len(body):
+            break
+        state_set_id, possible_states_size = _STATE_SET.unpack_from(body, offset)
+        offset += 3
+        if possible_states_size > 0 and offset + possible_states_size <= len(body):
+            bitfield = body[offset:offset + possible_states_size]
+            state_set_name, value_map = get_state_set_info(state_set_id)
+            supported_state_values = []
+            for byte_idx, byte_val in enumerate(bitfield):
+                for bit_idx in _SET_BITS[byte_val]:
+                    # Per spec: bit0 => state 1, bit1 => state 2, etc.
+                    state_value = byte_idx * 8 + bit_idx + 1
+                    supported_state_values.append({
+                        'stateValue': state_value,
+                        'stateName': value_map.get(state_value, f'Unknown(0x{state_value:02x})'),
+                    })
+            possible_states.append({
+                'stateSetID': state_set_id,
+                'stateSetName': state_set_name,
+                'possibleStatesSize': possible_states_size,
+                'possibleStateValues': supported_state_values,
+                'possibleStates_hex': bitfield.hex(),
+            })
+            offset += possible_states_size
+        elif possible_states_size == 0:
+            possible_states.append({
+                'stateSetID': state_set_id,
+                'possibleStatesSize': 0,
+                'note': unavailable_note,
+            })
+    return possible_states
+
+
+def _unit_fields(decoded, base_unit, unit_modifier, rate_unit, base_oem_unit_handle,
+                 aux_unit, aux_unit_modifier, aux_rate_unit):
+    decoded['baseUnit'] = base_unit
+    decoded['baseUnitName'] = UNIT_NAMES.get(base_unit, f"Unknown(0x{base_unit:02x})")
+    decoded['unitModifier'] = unit_modifier
+    decoded['rateUnit'] = rate_unit
+    decoded['rateUnitName'] = RATE_UNIT_NAMES.get(rate_unit, f"Unknown(0x{rate_unit:02x})")
+    decoded['baseOEMUnitHandle'] = base_oem_unit_handle
+    decoded['auxUnit'] = aux_unit
+    decoded['auxUnitName'] = UNIT_NAMES.get(aux_unit, f"Unknown(0x{aux_unit:02x})")
+    decoded['auxUnitModifier'] = aux_unit_modifier
+    decoded['auxRateUnit'] = aux_rate_unit
+    decoded['auxRateUnitName'] = RATE_UNIT_NAMES.get(aux_rate_unit, f"Unknown(0x{aux_rate_unit:02x})")
+
+
+# --- Registry ---
+
+# PDRType -> decode(data) for every type with a body decoder
+DECODERS: Dict[int, Callable[[bytes], dict]] = {}
+# PDRType -> shortest record (header included) that gets its body decoded
+MIN_LENGTHS: Dict[int, int] = {}
+
+
+def _buffer(data):
+    """(raw, view) for a PDR given as bytes, bytearray or memoryview."""
+    raw = data if isinstance(data, (bytes, bytearray)) else bytes(data)
+    return raw, memoryview(raw)
+
+
+def _decode_header(view):
+    record_handle, version, pdr_type, change_number, record_length = HEADER.unpack_from(view)
+    return {
+        'recordHandle': record_handle,
+        'PDRHeaderVersion': version,
+        'PDRType': pdr_type,
+        'recordChangeNumber': change_number,
+        'recordLength': record_length,
+    }
+
+
+def decode_pdr_header(data):
+    """Decode PDR header (first 10 bytes per Table 76)."""
+    if len(data) < HEADER_SIZE:
+        return None
+    return _decode_header(_buffer(data)[1])
+
+
+def register(pdr_type: int, min_length: int):
+    """Register a body decoder for pdr_type.
+
+    The decorated function is called as fn(raw, body, decoded) with the
+    record bytes, a memoryview of the body after the header, and the decoded
+    header dict to fill in. Records shorter than min_length (header
+    included) decode to the header only. Returns the public decode(data).
+    """
+    def wrap(fn):
+        def decode(data):
+            if len(data) < HEADER_SIZE:
+                return None
+            raw, view = _buffer(data)
+            decoded = _decode_header(view)
+            if len(raw) < min_length:
+                return decoded
+            return fn(raw, view[HEADER_SIZE:], decoded)
+        decode.__name__ = fn.__name__
+        decode.__qualname__ = fn.__qualname__
+        decode.__doc__ = fn.__doc__
+        DECODERS[pdr_type] = decode
+        MIN_LENGTHS[pdr_type] = min_length
+        return decode
+    return wrap
+
+
+@register(1, 18)
+def decode_terminus_locator_pdr(raw, body, decoded):
+    """Decode Terminus Locator PDR (Type 1, Table 78)."""
+    (pldm_terminus_handle, validity, tid, container_id,
+     terminus_locator_type, terminus_locator_value_size) = _TERMINUS_LOCATOR.unpack_from(body)
+    value = body[8:8 + terminus_locator_value_size]
+
+    decoded['PDRTypeName'] = 'Terminus Locator PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['validity'] = validity
+    decoded['validityName'] = VALIDITY_NAMES.get(validity, f'Unknown(0x{validity:02x})')
+    decoded['TID'] = tid
+    decoded['containerID'] = container_id
+    decoded['terminusLocatorType'] = terminus_locator_type
+    decoded['terminusLocatorTypeName'] = TERMINUS_LOCATOR_TYPE_NAMES.get(
+        terminus_locator_type,
+        f'Unknown(0x{terminus_locator_type:02x})'
+    )
+    decoded['terminusLocatorValueSize'] = terminus_locator_value_size
+
+    # Decode terminusLocatorValue by type
+    locator = None
+    if terminus_locator_type == 0x00 and len(value) >= 17:  # UID
+        locator = {
+            'terminusInstance': value[0],
+            'deviceUID': value[1:17].hex(),
+        }
+    elif terminus_locator_type == 0x01 and len(value) >= 1:  # MCTP_EID
+        locator = {'EID': value[0]}
+    elif terminus_locator_type == 0x02 and len(value) >= 18:  # SMBusRelative
+        locator = {
+            'UID': value[0:16].hex(),
+            'busNumber': value[16],
+            'slaveAddress': value[17],
+        }
+    elif terminus_locator_type == 0x03 and len(value) >= 17:  # systemSoftware
+        software_class = value[0]
+        locator = {
+            'softwareClass': software_class,
+            'softwareClassName': SOFTWARE_CLASS_NAMES.get(software_class, f'Unknown(0x{software_class:02x})'),
+            'UUID': value[1:17].hex(),
+        }
+    if locator is not None:
+        decoded['terminusLocatorValue'] = locator
+    else:
+        decoded['terminusLocatorValue_hex'] = value.hex()
+
+    return decoded
+
+
+@register(15, 25)
+def decode_entity_association_pdr(raw, body, decoded):
+    """Decode Entity Association PDR (Type 15, Table 95)."""
+    (container_id, association_type, container_entity_type, container_entity_instance,
+     container_entity_container_id, contained_entity_count) = _ENTITY_ASSOCIATION.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'Entity Association PDR'
+    decoded['containerID'] = container_id
+    decoded['associationType'] = association_type
+    decoded['associationTypeName'] = ASSOCIATION_TYPE_NAMES.get(association_type, f"Unknown (0x{association_type:02x})")
+    decoded['containerEntityType'] = container_entity_type
+    decoded['containerEntityTypeName'] = get_entity_type_name(container_entity_type)
+    decoded['containerEntityInstanceNumber'] = container_entity_instance
+    decoded['containerEntityContainerID'] = container_entity_container_id
+    decoded['numberOfContainedEntities'] = contained_entity_count
+
+    start = _ENTITY_ASSOCIATION.size
+    count = min(contained_entity_count, (len(body) - start) // _ENTITY.size)
+    if count > 0:
+        decoded['containedEntities'] = [
+            {
+                'containedEntityType': entity_type,
+                'containedEntityTypeName': get_entity_type_name(entity_type),
+                'containedEntityInstanceNumber': entity_instance,
+                'containedEntityContainerID': entity_container_id,
+            }
+            for entity_type, entity_instance, entity_container_id
+            in _ENTITY.iter_unpack(body[start:start + count * _ENTITY.size])
+        ]
+
+    return decoded
+
+
+@register(16, 13)
+def decode_entity_auxiliary_names_pdr(raw, body, decoded):
+    """Decode Entity Auxiliary Names PDR (Type 16, Table 96)."""
+    entity_type, entity_instance = _ENTITY_AUX_NAMES.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'Entity Auxiliary Names PDR'
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+
+    if len(body) > 4:
+        decoded['entityNameLanguageTag'] = str(body[4:10], 'ascii', 'replace').rstrip('\x00')
+        if len(body) > 10:
+            # UTF-16BE encoded name
+            decoded['entityName'] = str(body[10:], 'utf-16-be', 'replace').rstrip('\x00')
+
+    return decoded
+
+
+@register(17, 19)
+def decode_oem_entity_id_pdr(raw, body, decoded):
+    """Decode OEM Entity ID PDR (Type 17, Table 97)."""
+    (pldm_terminus_handle, oem_entity_id_handle, vendor_iana,
+     vendor_entity_id, string_count) = _OEM_ENTITY_ID.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'OEM Entity ID PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['OEMEntityIDHandle'] = oem_entity_id_handle
+    decoded['vendorIANA'] = vendor_iana
+    decoded['vendorEntityID'] = vendor_entity_id
+    decoded['stringCount'] = string_count
+
+    # entityIDLanguageTag / entityIDName pairs; offsets are into the whole record
+    view = memoryview(raw)
+    entity_names = []
+    offset = HEADER_SIZE + _OEM_ENTITY_ID.size
+    for _ in range(string_count):
+        entry = _language_string(raw, view, offset)
+        if entry is None:
+            break
+        lang_tag, name, offset = entry
+        if name is None:
+            entity_names.append({'entityIDLanguageTag': lang_tag})
+            break
+        entity_names.append({'entityIDLanguageTag': lang_tag, 'entityIDName': name})
+
+    if entity_names:
+        decoded['entityNames'] = entity_names
+
+    return decoded
+
+
+@register(20, 20)
+def decode_fru_record_set_pdr(raw, body, decoded):
+    """Decode FRU Record Set PDR (Type 20, Table 100)."""
+    (pldm_terminus_handle, fru_record_set_id, entity_type,
+     entity_instance, container_id) = _FRU_RECORD_SET.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'FRU Record Set PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['FRURecordSetIdentifier'] = fru_record_set_id
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+    decoded['containerID'] = container_id
+
+    return decoded
+
+
+@register(2, 20)
+def decode_numeric_sensor_pdr(raw, body, decoded):
+    """Decode Numeric Sensor PDR (Type 2, Table 79)."""
+    # Table 79 fields start directly after common header (no sensorType field!)
+    (pldm_terminus_handle, sensor_id, entity_type, entity_instance, container_id,
+     sensor_init, sensor_aux_names_pdr,
+     base_unit, unit_modifier, rate_unit, base_oem_unit_handle,
+     aux_unit, aux_unit_modifier, aux_rate_unit, rel, aux_oem_unit_handle,
+     is_linear, sensor_data_size) = _NUMERIC_SENSOR.unpack_from(body)
+    offset = _NUMERIC_SENSOR.size
+
+    resolution, offset = _read(body, offset, _REAL32)
+    offset_value, offset = _read(body, offset, _REAL32)
+    accuracy, plus_tolerance, minus_tolerance = _NUMERIC_SENSOR_ACCURACY.unpack_from(body, offset)
+    offset += _NUMERIC_SENSOR_ACCURACY.size
+
+    # Hysteresis and readable ranges are sized per sensorDataSize
+    data_fmt = EFFECTER_DATA_SIZE_FORMATS.get(sensor_data_size)
+    data_struct = DATA_SIZE_STRUCTS.get(sensor_data_size)
+    if data_struct is None:
+        raise ValueError(f"unsupported sensorDataSize {sensor_data_size}")
+    hysteresis, offset = _read(body, offset, data_struct)
+    supported_thresholds, threshold_volatility = _U8X2.unpack_from(body, offset)
+    offset += 2
+    state_transition_interval, offset = _read(body, offset, _REAL32)
+    update_interval, offset = _read(body, offset, _REAL32)
+    max_readable, offset = _read(body, offset, data_struct)
+    min_readable, offset = _read(body, offset, data_struct)
+    range_field_format, range_field_support = _U8X2.unpack_from(body, offset)
+    offset += 2
+
+    # Range fields are present when rangeFieldFormat is valid
+    range_fmt = RANGE_FIELD_FORMATS.get(range_field_format)
+    ranges = [None] * 9
+    if range_fmt:
+        range_struct = RANGE_FIELD_STRUCTS[range_field_format]
+        for i in range(9):
+            ranges[i], offset = _read(body, offset, range_struct)
+
+    decoded['PDRTypeName'] = 'Numeric Sensor PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['sensorID'] = sensor_id
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+    decoded['containerID'] = container_id
+    decoded['sensorInit'] = sensor_init
+    decoded['sensorInitName'] = SENSOR_INIT_NAMES.get(sensor_init, f'Unknown(0x{sensor_init:02x})')
+    decoded['sensorAuxiliaryNamesPDR'] = bool(sensor_aux_names_pdr)
+
+    _unit_fields(decoded, base_unit, unit_modifier, rate_unit, base_oem_unit_handle,
+                 aux_unit, aux_unit_modifier, aux_rate_unit)
+    decoded['auxUnitRelationship'] = AUX_UNIT_RELATIONSHIP_NAMES.get(rel, f"Unknown(0x{rel:02x})")
+    decoded['auxOEMUnitHandle'] = aux_oem_unit_handle
+
+    decoded['isLinear'] = bool(is_linear)
+    decoded['sensorDataSize'] = sensor_data_size
+    decoded['sensorDataSizeName'] = data_fmt[0]
+
+    decoded['resolution'] = resolution
+    decoded['offset'] = offset_value
+    decoded['accuracy'] = accuracy
+    decoded['plusTolerance'] = plus_tolerance
+    decoded['minusTolerance'] = minus_tolerance
+    decoded['hysteresis'] = hysteresis
+
+    decoded['supportedThresholds'] = supported_thresholds
+    decoded['supportedThresholdsFlags'] = {
+        'upperThresholdWarning': bool(supported_thresholds & 0x01),
+        'upperThresholdCritical': bool(supported_thresholds & 0x02),
+        'upperThresholdFatal': bool(supported_thresholds & 0x04),
+        'lowerThresholdWarning': bool(supported_thresholds & 0x08),
+        'lowerThresholdCritical': bool(supported_thresholds & 0x10),
+        'lowerThresholdFatal': bool(supported_thresholds & 0x20),
+    }
+
+    decoded['thresholdVolatility'] = threshold_volatility
+    decoded['thresholdVolatilityFlags'] = {
+        'initAgentRestart': bool(threshold_volatility & 0x01),
+        'subsystemPowerUp': bool(threshold_volatility & 0x02),
+        'hardReset': bool(threshold_volatility & 0x04),
+        'warmReset': bool(threshold_volatility & 0x10),
+        'terminusOnline': bool(threshold_volatility & 0x20),
+    }
+
+    decoded['stateTransitionInterval'] = state_transition_interval
+    decoded['updateInterval'] = update_interval
+    decoded['maxReadable'] = max_readable
+    decoded['minReadable'] = min_readable
+
+    decoded['rangeFieldFormat'] = range_field_format
+    if range_fmt:
+        decoded['rangeFieldFormatName'] = range_fmt[0]
+    decoded['rangeFieldSupport'] = range_field_support
+    decoded['rangeFieldSupportFlags'] = {
+        'nominalValueSupported': bool(range_field_support & 0x01),
+        'normalMaxSupported': bool(range_field_support & 0x02),
+        'normalMinSupported': bool(range_field_support & 0x04),
+        'criticalHighSupported': bool(range_field_support & 0x08),
+        'criticalLowSupported': bool(range_field_support & 0x10),
+        'fatalHighSupported': bool(range_field_support & 0x20),
+        'fatalLowSupported': bool(range_field_support & 0x40),
+    }
+
+    (decoded['nominalValue'], decoded['normalMax'], decoded['normalMin'],
+     decoded['warningHigh'], decoded['warningLow'],
+     decoded['criticalHigh'], decoded['criticalLow'],
+     decoded['fatalHigh'], decoded['fatalLow']) = ranges
+
+    return decoded
+
+
+@register(4, 25)
+def decode_state_sensor_pdr(raw, body, decoded):
+    """Decode State Sensor PDR (Type 4, Table 81)."""
+    (pldm_terminus_handle, sensor_id, entity_type, entity_instance, container_id,
+     sensor_init, sensor_aux_names_pdr, composite_sensor_count) = _STATE_SENSOR.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'State Sensor PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['sensorID'] = sensor_id
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+    decoded['containerID'] = container_id
+    decoded['sensorInit'] = sensor_init
+    decoded['sensorInitName'] = SENSOR_INIT_NAMES.get(sensor_init, f'Unknown(0x{sensor_init:02x})')
+    decoded['sensorAuxiliaryNamesPDR'] = bool(sensor_aux_names_pdr)
+    decoded['compositeSensorCount'] = composite_sensor_count
+
+    possible_states = _possible_states(body, _STATE_SENSOR.size, composite_sensor_count,
+                                       'Sensor unavailable or disabled')
+    if possible_states:
+        decoded['stateSetPossibleStates'] = possible_states
+
+    return decoded
+
+
+@register(9, 44)
+def decode_numeric_effecter_pdr(raw, body, decoded):
+    """Decode Numeric Effecter PDR (Type 9, Table 88)."""
+    (pldm_terminus_handle, effecter_id, entity_type, entity_instance, container_id,
+     effecter_semantic_id, effecter_init, effecter_aux_names_pdr,
+     base_unit, unit_modifier, rate_unit, base_oem_unit_handle,
+     aux_unit, aux_unit_modifier, aux_rate_unit, aux_oem_unit_handle,
+     is_linear, effecter_data_size,
+     resolution, offset_value, accuracy, plus_tolerance, minus_tolerance,
+     state_transition_interval, transition_interval) = _NUMERIC_EFFECTER.unpack_from(body)
+    offset = _NUMERIC_EFFECTER.size
+
+    data_fmt = EFFECTER_DATA_SIZE_FORMATS.get(effecter_data_size)
+    max_settable = min_settable = None
+    if data_fmt:
+        data_struct = DATA_SIZE_STRUCTS[effecter_data_size]
+        max_settable, offset = _read(body, offset, data_struct)
+        min_settable, offset = _read(body, offset, data_struct)
+
+    range_field_format = body[offset] if offset < len(body) else 0
+    range_field_support = body[offset + 1] if offset + 1 < len(body) else 0
+    offset += 2
+
+    range_fmt = RANGE_FIELD_FORMATS.get(range_field_format)
+    ranges = [None] * 5
+    if range_fmt:
+        range_struct = RANGE_FIELD_STRUCTS[range_field_format]
+        for i in range(5):
+            ranges[i], offset = _read(body, offset, range_struct)
+
+    decoded['PDRTypeName'] = 'Numeric Effecter PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['effecterID'] = effecter_id
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+    decoded['containerID'] = container_id
+    decoded['effecterSemanticID'] = effecter_semantic_id
+    decoded['effecterInit'] = effecter_init
+    decoded['effecterInitName'] = EFFECTER_INIT_NAMES.get(effecter_init, f'Unknown(0x{effecter_init:02x})')
+    decoded['effecterAuxiliaryNamesPDR'] = bool(effecter_aux_names_pdr)
+
+    _unit_fields(decoded, base_unit, unit_modifier, rate_unit, base_oem_unit_handle,
+                 aux_unit, aux_unit_modifier, aux_rate_unit)
+    decoded['auxOEMUnitHandle'] = aux_oem_unit_handle
+
+    decoded['isLinear'] = bool(is_linear)
+    decoded['effecterDataSize'] = effecter_data_size
+    if data_fmt:
+        decoded['effecterDataSizeName'] = data_fmt[0]
+
+    decoded['resolution'] = resolution
+    decoded['offset'] = offset_value
+    decoded['accuracy'] = accuracy
+    decoded['plusTolerance'] = plus_tolerance
+    decoded['minusTolerance'] = minus_tolerance
+    decoded['stateTransitionInterval'] = state_transition_interval
+    decoded['transitionInterval'] = transition_interval
+    decoded['maxSettable'] = max_settable
+    decoded['minSettable'] = min_settable
+
+    decoded['rangeFieldFormat'] = range_field_format
+    if range_fmt:
+        decoded['rangeFieldFormatName'] = range_fmt[0]
+    decoded['rangeFieldSupport'] = range_field_support
+    decoded['rangeFieldSupportFlags'] = {
+        'nominalValueSupported': bool(range_field_support & 0x01),
+        'normalMaxSupported': bool(range_field_support & 0x02),
+        'normalMinSupported': bool(range_field_support & 0x04),
+        'ratedMaxSupported': bool(range_field_support & 0x08),
+        'ratedMinSupported': bool(range_field_support & 0x10),
+    }
+
+    (decoded['nominalValue'], decoded['normalMax'], decoded['normalMin'],
+     decoded['ratedMax'], decoded['ratedMin']) = ranges
+
+    return decoded
+
+
+@register(11, 27)
+def decode_state_effecter_pdr(raw, body, decoded):
+    """Decode State Effecter PDR (Type 11, Table 90)."""
+    (pldm_terminus_handle, effecter_id, entity_type, entity_instance, container_id,
+     effecter_semantic_id, effecter_init, effecter_description_pdr,
+     composite_effecter_count) = _STATE_EFFECTER.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'State Effecter PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['effecterID'] = effecter_id
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+    decoded['containerID'] = container_id
+    decoded['effecterSemanticID'] = effecter_semantic_id
+    decoded['effecterInit'] = effecter_init
+    decoded['effecterInitName'] = EFFECTER_INIT_NAMES.get(effecter_init, f'Unknown(0x{effecter_init:02x})')
+    decoded['effecterDescriptionPDR'] = bool(effecter_description_pdr)
+    decoded['compositeEffecterCount'] = composite_effecter_count
+
+    possible_states = _possible_states(body, _STATE_EFFECTER.size, composite_effecter_count,
+                                       'Effecter unavailable or disabled')
+    if possible_states:
+        decoded['stateSetPossibleStates'] = possible_states
+
+    return decoded
+
+
+@register(21, 20)
+def decode_compact_numeric_sensor_pdr(raw, body, decoded):
+    """Decode Compact Numeric Sensor PDR (Type 21, Table 103)."""
+    sensor_type, sensor_number, entity_type, entity_instance = _COMPACT_NUMERIC_SENSOR.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'Compact Numeric Sensor PDR'
+    decoded['sensorType'] = sensor_type
+    decoded['sensorNumber'] = sensor_number
+    decoded['entityType'] = entity_type
+    decoded['entityTypeName'] = get_entity_type_name(entity_type)
+    decoded['entityInstanceNumber'] = entity_instance
+
+    if len(body) > 7:
+        decoded['remainingFields_hex'] = body[7:].hex()
+
+    return decoded
+
+
+@register(8, 22)
+def decode_oem_state_set_pdr(raw, body, decoded):
+    """Decode OEM State Set PDR (Type 8, Table 86) and register its value names."""
+    (pldm_terminus_handle, oem_state_set_id_handle, vendor_iana, oem_state_set_id,
+     unspecified_value_hint, state_count) = _OEM_STATE_SET.unpack_from(body)
+
+    decoded['PDRTypeName'] = 'OEM State Set PDR'
+    decoded['PLDMTerminusHandle'] = pldm_terminus_handle
+    decoded['OEMStateSetIDHandle'] = oem_state_set_id_handle
+    decoded['vendorIANA'] = vendor_iana
+    decoded['OEMStateSetID'] = oem_state_set_id
+    decoded['unspecifiedValueHint'] = UNSPECIFIED_VALUE_HINT_NAMES.get(
+        unspecified_value_hint, f"Unknown(0x{unspecified_value_hint:02x})")
+    decoded['stateCount'] = state_count
+
+    # OEM State Value Records (Table 87); string offsets are into the whole record
+    view = memoryview(raw)
+    end = len(raw)
+    oem_state_records = []
+    offset = HEADER_SIZE + _OEM_STATE_SET.size
+    for _ in range(state_count):
+        if offset + 3 > end:
+            break
+        min_state, max_state, string_count = _OEM_STATE_VALUE.unpack_from(view, offset)
+        offset += 3
+        state_record = {
+            'minStateValue': min_state,
+            'maxStateValue': max_state,
+            'stringCount': string_count,
+            'stateNames': []
+        }
+        for _ in range(string_count):
+            entry = _language_string(raw, view, offset)
+            if entry is None:
+                break
+            lang_tag, name, offset = entry
+            if name is None:
+                state_record['stateNames'].append({'languageTag': lang_tag})
+                break
+            state_record['stateNames'].append({'languageTag': lang_tag, 'stateName': name})
+        oem_state_records.append(state_record)
+
+    if oem_state_records:
+        decoded['OEMStateValueRecords'] = oem_state_records
+
+        # Build OEM state set value map for later use by sensor/effecter decoding
+        state_value_map = {}
+        for record in oem_state_records:
+            min_val = record.get('minStateValue')
+            max_val = record.get('maxStateValue')
+            names = record.get('stateNames', [])
+            # If there are as many names as values, map each value to its name
+            if len(names) == (max_val - min_val + 1):
+                for idx, v in enumerate(range(min_val, max_val + 1)):
+                    name = names[idx].get('stateName')
+                    if name is not None:
+                        state_value_map[v] = name
+            else:
+                # Otherwise, map all values in the range to the first name (legacy behavior)
+                name = names[0].get('stateName') if names else None
+                if name is not None:
+                    for v in range(min_val, max_val + 1):
+                        state_value_map[v] = name
+
+        if state_value_map:
+            OEM_STATE_SET_VALUES[oem_state_set_id_handle] = state_value_map
+            OEM_STATE_SET_NAMES[oem_state_set_id_handle] = f"OEM State Set {oem_state_set_id}"
+            logger.debug(f"OEM_STATE_SET_VALUES[{oem_state_set_id_handle}] = {state_value_map}")
+
+    return decoded
+
+
+PDR_TYPE_OEM_STATE_SET = 8
+
+
+def decode_pdr(pdr_data):
+    """Decode a PDR based on its type."""
+    if len(pdr_data) < HEADER_SIZE:
+        return {'error': 'PDR too short'}
+
+    pdr_type = pdr_data[5]
+    decoder = DECODERS.get(pdr_type, decode_pdr_header)
+    decoded = decoder(pdr_data)
+
+    if decoded and 'PDRTypeName' not in decoded:
+        decoded['PDRTypeName'] = PDR_TYPE_NAMES.get(pdr_type, f'PDR Type 0x{pdr_type:02x}')
+
+    return decoded
+
+
+def decode_pdrs(pdrs: Iterable[bytes]) -> List[dict]:
+    """Decode a repository's PDRs, each exactly once, in their original order.
+
+    OEM State Set PDRs are decoded first so that state sensors and effecters
+    referencing them resolve their state names. A record that fails to decode
+    yields {'error': 'decode error: ...'} instead of aborting the batch.
+    """
+    pdrs = list(pdrs)
+    results: List[dict] = [None] * len(pdrs)
+    oem_first = sorted(range(len(pdrs)),
+                       key=lambda i: not (len(pdrs[i]) > 5 and pdrs[i][5] == PDR_TYPE_OEM_STATE_SET))
+    for i in oem_first:
+        try:
+            results[i] = decode_pdr(pdrs[i])
+        except Exception as e:
+            logger.debug(f"PDR decode failed (index {i}): {e}")
+            results[i] = {'error': f'decode error: {e}'}
+    return results
+
+
+# --- Lazy records ---
+
+def _entity_fields(body, id_name):
+    id_value, entity_type, entity_instance, container_id = struct.unpack_from('<HHHH', body, 2)
+    return {
+        id_name: id_value,
+        'entityType': entity_type,
+        'entityInstanceNumber': entity_instance,
+        'containerID': container_id,
+    }
+
+
+def _numeric_sensor_fields(body):
+    # Only when decode_numeric_sensor_pdr would read every fixed field
+    if len(body) < _NUMERIC_SENSOR.size:
+        return None
+    data_struct = DATA_SIZE_STRUCTS.get(body[22])
+    # ... through hysteresis, maxReadable and minReadable to rangeFieldSupport
+    if data_struct is None or len(body) < 47 + 3 * data_struct.size:
+        return None
+    fields = _entity_fields(body, 'sensorID')
+    fields['resolution'] = _REAL32.unpack_from(body, 23)[0]
+    fields['offset'] = _REAL32.unpack_from(body, 27)[0]
+    # accuracy..minusTolerance, hysteresis, threshold bytes, stateTransitionInterval
+    fields['updateInterval'] = _REAL32.unpack_from(body, 41 + data_struct.size)[0]
+    return fields
+
+
+def _numeric_effecter_fields(body):
+    if len(body) < _NUMERIC_EFFECTER.size:
+        return None
+    return _entity_fields(body, 'effecterID')
+
+
+# PDRType -> fields(body) for the cheap subset a consumer usually needs. A
+# reader returns None when the record is too short for that shortcut to agree
+# with the full decoder, and LazyPDR then decodes the whole record instead.
+FIELD_READERS: Dict[int, Callable[[memoryview], Optional[dict]]] = {
+    2: _numeric_sensor_fields,
+    4: lambda body: _entity_fields(body, 'sensorID'),
+    9: _numeric_effecter_fields,
+    11: lambda body: _entity_fields(body, 'effecterID'),
+}
+
+
+class LazyPDR:
+    """One PDR held as raw bytes; decoded per field or in full on first access."""
+
+    __slots__ = ('raw', '_fields', '_decoded', '__weakref__')
+
+    def __init__(self, raw: bytes):
+        self.raw = bytes(raw)
+        self._fields: Optional[dict] = None
+        self._decoded: Optional[dict] = None
+
+    @property
+    def pdr_type(self) -> Optional[int]:
+        return self.raw[5] if len(self.raw) >= HEADER_SIZE else None
+
+    @property
+    def record_handle(self) -> Optional[int]:
+        return struct.unpack_from('<I', self.raw)[0] if len(self.raw) >= HEADER_SIZE else None
+
+    def field(self, name: str, default: Any = None) -> Any:
+        """One decoded field, without building the full record when possible."""
+        if self._decoded is None:
+            if self._fields is None:
+                self._fields = self._read_fields()
+            if name in self._fields:
+                return self._fields[name]
+        return self.decoded.get(name, default)
+
+    def _read_fields(self) -> dict:
+        reader = FIELD_READERS.get(self.pdr_type)
+        if reader is None or len(self.raw) < MIN_LENGTHS.get(self.pdr_type, HEADER_SIZE):
+            return {}
+        return reader(memoryview(self.raw)[HEADER_SIZE:]) or {}
+
+    @property
+    def decoded(self) -> dict:
+        """The full decode_pdr() dict, built once."""
+        if self._decoded is None:
+            try:
+                self._decoded = decode_pdr(self.raw)
+            except Exception as e:
+                self._decoded = {'error': f'decode error: {e}'}
+            self._fields = None
+        return self._decoded
+
+
+class PDRCache:
+    """Interns LazyPDRs by content.
+
+    Endpoints of the same device model carry identical PDRs; interning gives
+    them one blob and one memoized decode. Entries are weak, so records of
+    endpoints that are no longer loaded are freed.
+    """
+
+    def __init__(self):
+        self._records: "weakref.WeakValueDictionary[bytes, LazyPDR]" = weakref.WeakValueDictionary()
+        self._lock = threading.Lock()
+
+    def __len__(self) -> int:
+        return len(self._records)
+
+    def intern(self, raw: Union[bytes, LazyPDR]) -> LazyPDR:
+        if isinstance(raw, LazyPDR):
+            raw = raw.raw
+        raw = bytes(raw)
+        with self._lock:
+            record = self._records.get(raw)
+            if record is None:
+                record = LazyPDR(raw)
+                self._records[record.raw] = record
+            return record
@@ -1,7 +1,7 @@
-"""PLDM command encoding for PDR discovery."""
+"""PLDM command encoding for PDR discovery, sensor monitoring and effecter control."""
 
 import struct
-from typing import Tuple
+from typing import Optional, Tuple
 from rich.console import Console
 
 console = Console()
@@ -10,6 +10,11 @@ console = Console()
 class PDLMCommandEncoder:
     """Encode PLDM commands for PDR discovery."""
 
+    # PLDM Type 0 (Messaging Control and Discovery) commands, DSP0240 Table 11
+    PLDM_TYPE_BASE = 0
+    GET_TID = 0x02
+    NEGOTIATE_TRANSFER_PARAMETERS = 0x07
+
     # PLDM Type 2 (Platform Monitoring and Control) commands
     PLDM_TYPE = 2
     
@@ -17,9 +22,30 @@ class PDLMCommandEncoder:
     PLDM_TYPE_FRU = 4
 
     # Commands (per DSP0248 Table 110)
+    GET_SENSOR_READING = 0x11
+    GET_STATE_SENSOR_READINGS = 0x21
+    SET_NUMERIC_EFFECTER_VALUE = 0x31
+    SET_STATE_EFFECTER_STATES = 0x39
     GET_PDR_REPOSITORY_INFO = 0x50
     GET_PDR = 0x51
+
+    # sensorDataSize enum (DSP0248 Table 79) -> struct format
+    SENSOR_DATA_SIZE_FORMATS = {
+        0x00: "<B",  # uint8
+        0x01: "<b",  # sint8
+        0x02: "<H",  # uint16
+        0x03: "<h",  # sint16
+        0x04: "<I",  # uint32
+        0x05: "<i",  # sint32
+    }
     
+    # effecterDataSize enum (DSP0248 Table 88) uses the same encoding
+    EFFECTER_DATA_SIZE_FORMATS = SENSOR_DATA_SIZE_FORMATS
+
+    # SetStateEffecterStates setRequest values (DSP0248 Table 76)
+    EFFECTER_NO_CHANGE = 0
+    EFFECTER_REQUEST_SET = 1
+
     # FRU commands (per DSP0257 Table 7)
     GET_FRU_RECORD_TABLE_METADATA = 0x01  # (Type 4)
     GET_FRU_RECORD_TABLE = 0x02  # (Type 4)
@@ -40,6 +66,91 @@ class PDLMCommandEncoder:
         third = command & 0xFF
         return bytes([first, second, third])
 
+    @staticmethod
+    def encode_get_tid(instance_id: int = 0) -> bytes:
+        """
+        Encode GetTID command (DSP0240 10.2).
+
+        Request has no payload; every PLDM terminus must support it.
+
+        Args:
+            instance_id: Instance ID (0-31).
+
+        Returns:
+            Encoded PLDM message.
+        """
+        return PDLMCommandEncoder._build_pldm_header(
+            PDLMCommandEncoder.GET_TID,
+            PDLMCommandEncoder.PLDM_TYPE_BASE,
+            instance_id,
+            request=1,
+        )
+
+    @staticmethod
+    def encode_negotiate_transfer_parameters(
+        instance_id: int = 0,
+        part_size: int = 256,
+        pldm_types: Tuple[int, ...] = (4,),
+    ) -> bytes:
+        """
+        Encode NegotiateTransferParameters command (DSP0240 10.7).
+
+        Args:
+            instance_id: Instance ID (0-31).
+            part_size: RequesterPartSize, the largest multipart transfer part
+                the requester can receive.
+            pldm_types: PLDM types for which multipart transfers are used;
+                encoded as the 64-bit RequesterProtocolSupport bitfield.
+
+        Returns:
+            Encoded PLDM message.
+        """
+        msg = bytearray(
+            PDLMCommandEncoder._build_pldm_header(
+                PDLMCommandEncoder.NEGOTIATE_TRANSFER_PARAMETERS,
+                PDLMCommandEncoder.PLDM_TYPE_BASE,
+                instance_id,
+                request=1,
+            )
+        )
+        support = 0
+        for pldm_type in pldm_types:
+            support |= 1 << (pldm_type & 0x3F)
+        msg.extend(struct.pack("<HQ", part_size, support))
+        return bytes(msg)
+
+    @staticmethod
+    def decode_negotiate_transfer_parameters_response(response: bytes) -> dict:
+        """
+        Decode NegotiateTransferParameters response.
+
+        Response format:
+          [0] Completion Code
+          [1-2] ResponderPartSize (uint16, LE)
+          [3-10] ResponderProtocolSupport (bitfield8[8])
+
+        Args:
+            response: Raw PLDM response bytes.
+
+        Returns:
+            Dictionary with part size and supported PLDM types, or error.
+        """
+        if len(response) < 1:
+            return {"error": "Response too short"}
+
+        cc = response[0]
+        if cc != 0:
+            return {"error": f"Command failed with CC={cc}"}
+
+        if len(response) < 11:
+            return {"error": "Invalid response length"}
+
+        part_size, support = struct.unpack("<HQ", response[1:11])
+        return {
+            "part_size": part_size,
+            "pldm_types": [t for t in range(64) if support & (1 << t)],
+        }
+
     @staticmethod
     def encode_get_pdr_repository_info(instance_id: int = 0) -> bytes:
         """
@@ -109,13 +220,20 @@ class PDLMCommandEncoder:
         response: bytes,
     ) -> dict:
         """
-        Decode GetPDRRepositoryInfo response.
+        Decode GetPDRRepositoryInfo response (DSP0248 Table 68).
 
         Response format:
           [0] Completion Code
-          [1-4] Repository Change Count (little-endian)
-          [5-8] Total PDR Record Count (little-endian)
-          [9-12] Repository Size in bytes (little-endian)
+          [1] RepositoryState (0 = available, 1 = update in progress, 2 = failed)
+          [2-14] UpdateTime (timestamp104)
+          [15-27] OEMUpdateTime (timestamp104)
+          [28-31] RecordCount (little-endian)
+          [32-35] RepositorySize in bytes (little-endian)
+          [36-39] LargestRecordSize in bytes (little-endian)
+          [40] DataTransferHandleTimeout in seconds
+
+        The timestamps are returned as hex strings, which compare (and
+        serialize) as opaque values.
 
         Args:
             response: Raw PLDM response bytes.
@@ -130,18 +248,20 @@ class PDLMCommandEncoder:
         if cc != 0:
             return {"error": f"Command failed with CC={cc}"}
 
-        if len(response) < 13:
+        if len(response) < 41:
             return {"error": "Invalid response length"}
 
         try:
-            repo_change_count = struct.unpack("<I", response[1:5])[0]
-            total_pdr_records = struct.unpack("<I", response[5:9])[0]
-            repository_size = struct.unpack("<I", response[9:13])[0]
+            record_count, repository_size, largest_record_size = struct.unpack("<III", response[28:40])
 
             return {
-                "repository_change_count": repo_change_count,
-                "total_pdr_records": total_pdr_records,
+                "repository_state": response[1],
+                "update_time": bytes(response[2:15]).hex(),
+                "oem_update_time": bytes(response[15:28]).hex(),
+                "record_count": record_count,
                 "repository_size": repository_size,
+                "largest_record_size": largest_record_size,
+                "data_transfer_handle_timeout": response[40],
             }
         except Exception as e:
             return {"error": f"Decode failed: {e}"}
@@ -201,6 +321,244 @@ class PDLMCommandEncoder:
         except Exception as e:
             return {"error": f"Decode failed: {e}"}
 
+    @staticmethod
+    def encode_get_sensor_reading(instance_id: int = 0, sensor_id: int = 0, rearm_event_state: bool = False) -> bytes:
+        """
+        Encode GetSensorReading command (DSP0248 18.2).
+
+        Args:
+            instance_id: Instance ID (0-31).
+            sensor_id: Numeric sensor ID from the Numeric Sensor PDR.
+            rearm_event_state: Re-arm the sensor's event state.
+
+        Returns:
+            Encoded PLDM message.
+        """
+        msg = bytearray(
+            PDLMCommandEncoder._build_pldm_header(
+                PDLMCommandEncoder.GET_SENSOR_READING,
+                PDLMCommandEncoder.PLDM_TYPE,
+                instance_id,
+                request=1,
+            )
+        )
+        msg.extend(struct.pack("<H", sensor_id))  # 2 bytes: sensorID
+        msg.append(1 if rearm_event_state else 0)  # 1 byte: rearmEventState
+        return bytes(msg)
+
+    @staticmethod
+    def decode_get_sensor_reading_response(response: bytes) -> dict:
+        """
+        Decode GetSensorReading response (DSP0248 Table 39).
+
+        Response format:
+          [0] Completion Code
+          [1] sensorDataSize (enum8)
+          [2] sensorOperationalState (enum8): 0=enabled, 1=disabled, 2=unavailable, ...
+          [3] sensorEventMessageEnable (enum8)
+          [4] presentState (enum8)
+          [5] previousState (enum8)
+          [6] eventState (enum8)
+          [7+] presentReading (size per sensorDataSize, LE)
+
+        Args:
+            response: Raw PLDM response bytes.
+
+        Returns:
+            Dictionary with the raw reading or error.
+        """
+        if len(response) < 1:
+            return {"error": "Response too short"}
+
+        cc = response[0]
+        if cc != 0:
+            return {"error": f"Command failed with CC=0x{cc:02x}"}
+
+        if len(response) < 8:
+            return {"error": "Invalid response length"}
+
+        fmt = PDLMCommandEncoder.SENSOR_DATA_SIZE_FORMATS.get(response[1])
+        if fmt is None:
+            return {"error": f"Unknown sensorDataSize 0x{response[1]:02x}"}
+        if len(response) < 7 + struct.calcsize(fmt):
+            return {"error": "Invalid response length"}
+
+        try:
+            return {
+                "sensor_data_size": response[1],
+                "operational_state": response[2],
+                "event_message_enable": response[3],
+                "present_state": response[4],
+                "previous_state": response[5],
+                "event_state": response[6],
+                "present_reading": struct.unpack_from(fmt, response, 7)[0],
+            }
+        except Exception as e:
+            return {"error": f"Decode failed: {e}"}
+
+    @staticmethod
+    def encode_get_state_sensor_readings(instance_id: int = 0, sensor_id: int = 0, sensor_rearm: int = 0) -> bytes:
+        """
+        Encode GetStateSensorReadings command (DSP0248 18.4).
+
+        Args:
+            instance_id: Instance ID (0-31).
+            sensor_id: State sensor ID from the State Sensor PDR.
+            sensor_rearm: Bitfield of composite sensors to re-arm.
+
+        Returns:
+            Encoded PLDM message.
+        """
+        msg = bytearray(
+            PDLMCommandEncoder._build_pldm_header(
+                PDLMCommandEncoder.GET_STATE_SENSOR_READINGS,
+                PDLMCommandEncoder.PLDM_TYPE,
+                instance_id,
+                request=1,
+            )
+        )
+        msg.extend(struct.pack("<H", sensor_id))  # 2 bytes: sensorID
+        msg.append(sensor_rearm & 0xFF)  # 1 byte: sensorRearm
+        msg.append(0)  # 1 byte: reserved
+        return bytes(msg)
+
+    @staticmethod
+    def decode_get_state_sensor_readings_response(response: bytes) -> dict:
+        """
+        Decode GetStateSensorReadings response (DSP0248 Table 41).
+
+        Response format:
+          [0] Completion Code
+          [1] compositeSensorCount (uint8, 1-8)
+          [2+] per composite sensor: sensorOperationalState, presentState,
+               previousState, eventState (enum8 each)
+
+        Args:
+            response: Raw PLDM response bytes.
+
+        Returns:
+            Dictionary with a "fields" list or error.
+        """
+        if len(response) < 1:
+            return {"error": "Response too short"}
+
+        cc = response[0]
+        if cc != 0:
+            return {"error": f"Command failed with CC=0x{cc:02x}"}
+
+        if len(response) < 2:
+            return {"error": "Invalid response length"}
+
+        count = response[1]
+        if len(response) < 2 + 4 * count:
+            return {"error": "Invalid response length"}
+
+        fields = []
+        for i in range(count):
+            op, present, previous, event = response[2 + 4 * i:6 + 4 * i]
+            fields.append({
+                "operational_state": op,
+                "present_state": present,
+                "previous_state": previous,
+                "event_state": event,
+            })
+        return {"composite_sensor_count": count, "fields": fields}
+
+    @staticmethod
+    def encode_set_numeric_effecter_value(
+        instance_id: int = 0,
+        effecter_id: int = 0,
+        effecter_data_size: int = 0x00,
+        value: int = 0,
+    ) -> bytes:
+        """
+        Encode SetNumericEffecterValue command (DSP0248 22.2).
+
+        Args:
+            instance_id: Instance ID (0-31).
+            effecter_id: Effecter ID from the Numeric Effecter PDR.
+            effecter_data_size: effecterDataSize from the same PDR.
+            value: Raw effecter value (before the PDR conversion).
+
+        Returns:
+            Encoded PLDM message.
+
+        Raises:
+            ValueError: Unknown data size, or value outside its range.
+        """
+        fmt = PDLMCommandEncoder.EFFECTER_DATA_SIZE_FORMATS.get(effecter_data_size)
+        if fmt is None:
+            raise ValueError(f"Unknown effecterDataSize 0x{effecter_data_size:02x}")
+        msg = bytearray(
+            PDLMCommandEncoder._build_pldm_header(
+                PDLMCommandEncoder.SET_NUMERIC_EFFECTER_VALUE,
+                PDLMCommandEncoder.PLDM_TYPE,
+                instance_id,
+                request=1,
+            )
+        )
+        msg.extend(struct.pack("<HB", effecter_id, effecter_data_size))
+        try:
+            msg.extend(struct.pack(fmt, int(value)))  # effecterValue, sized per effecterDataSize
+        except struct.error as e:
+            raise ValueError(f"Value {value} does not fit effecterDataSize 0x{effecter_data_size:02x}") from e
+        return bytes(msg)
+
+    @staticmethod
+    def encode_set_state_effecter_states(
+        instance_id: int = 0,
+        effecter_id: int = 0,
+        states: Tuple[Optional[int], ...] = (),
+    ) -> bytes:
+        """
+        Encode SetStateEffecterStates command (DSP0248 22.5).
+
+        Args:
+            instance_id: Instance ID (0-31).
+            effecter_id: Effecter ID from the State Effecter PDR.
+            states: One entry per composite effecter (1-8); None leaves that
+                effecter unchanged.
+
+        Returns:
+            Encoded PLDM message.
+
+        Raises:
+            ValueError: Composite count outside 1-8.
+        """
+        if not 1 <= len(states) <= 8:
+            raise ValueError(f"compositeEffecterCount {len(states)} outside 1-8")
+        msg = bytearray(
+            PDLMCommandEncoder._build_pldm_header(
+                PDLMCommandEncoder.SET_STATE_EFFECTER_STATES,
+                PDLMCommandEncoder.PLDM_TYPE,
+                instance_id,
+                request=1,
+            )
+        )
+        msg.extend(struct.pack("<HB", effecter_id, len(states)))
+        for state in states:
+            if state is None:
+                msg.extend((PDLMCommandEncoder.EFFECTER_NO_CHANGE, 0))
+            else:
+                msg.extend((PDLMCommandEncoder.EFFECTER_REQUEST_SET, int(state) & 0xFF))
+        return bytes(msg)
+
+    @staticmethod
+    def decode_completion_code_response(response: bytes) -> dict:
+        """
+        Decode a response that carries only a completion code
+        (SetNumericEffecterValue, SetStateEffecterStates).
+
+        Args:
+            response: Raw PLDM response bytes.
+
+        Returns:
+            Dictionary with completion_code (0 = success) or error.
+        """
+        if len(response) < 1:
+            return {"error": "Response too short"}
+        return {"completion_code": response[0]}
+
     @staticmethod
     def encode_get_fru_record_table_metadata(instance_id: int = 0) -> bytes:
         """
@@ -0,0 +1,550 @@
+"""Pipelined PLDM request/response engine over MCTP serial.
+
+Keeps several PLDM requests in flight per endpoint and matches responses to
+requests by the 5-bit PLDM instance ID (plus PLDM type and command code), with
+per-request timeouts and retries. Retries reuse the original instance ID, as
+required by DSP0240, so a late response to the first attempt still completes
+the request.
+"""
+
+import struct
+import time
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, List, Optional, Tuple
+from rich.console import Console
+from pldm_mapping_wizard.serial_transport import MCTPFramer
+from pldm_mapping_wizard.discovery.pldm_commands import PDLMCommandEncoder
+from pldm_mapping_wizard.metrics import METRICS
+
+console = Console()
+
+# PLDM instance IDs are 5 bits wide (DSP0240)
+MAX_INSTANCE_IDS = 32
+
+
+@dataclass
+class PLDMRequest:
+    """A single PLDM request tracked by the engine."""
+
+    pldm_msg: bytes
+    timeout: float
+    retries: int
+    on_done: Optional[Callable[["PLDMRequest"], None]] = None
+    instance_id: Optional[int] = None
+    attempts: int = 0
+    deadline: float = 0.0
+    first_sent: float = 0.0
+    rtt: Optional[float] = None
+    response: Optional[Dict[str, Any]] = None
+    error: Optional[str] = None
+    done: bool = False
+    cancelled: bool = False
+
+    @property
+    def pldm_type(self) -> int:
+        return self.pldm_msg[1] & 0x3F
+
+    @property
+    def cmd_code(self) -> int:
+        return self.pldm_msg[2]
+
+    @property
+    def ok(self) -> bool:
+        return self.done and self.error is None and self.response is not None
+
+
+class PLDMRequestEngine:
+    """Multi-outstanding PLDM requester for one MCTP serial endpoint."""
+
+    def __init__(
+        self,
+        serial,
+        local_eid: int = 16,
+        remote_eid: int = 0,
+        max_outstanding: int = 4,
+        timeout: float = 2.0,
+        retries: int = 2,
+        msg_type: int = 0x01,
+        debug: bool = False,
+    ):
+        """
+        Initialize the request engine.
+
+        Args:
+            serial: Open SerialPort used for the endpoint.
+            local_eid: Local endpoint ID (source EID of requests).
+            remote_eid: Remote endpoint ID (destination EID of requests).
+            max_outstanding: Maximum requests in flight (1-32).
+            timeout: Default per-attempt timeout in seconds.
+            retries: Default number of retransmissions after the first attempt.
+            msg_type: MCTP message type (0x01 = PLDM).
+            debug: Print TX/RX frames.
+        """
+        self.serial = serial
+        self.local_eid = local_eid
+        self.remote_eid = remote_eid
+        self.max_outstanding = max(1, min(int(max_outstanding), MAX_INSTANCE_IDS))
+        self.timeout = timeout
+        self.retries = retries
+        self.msg_type = msg_type
+        self.debug = debug
+
+        self._queue: List[PLDMRequest] = []
+        self._outstanding: Dict[int, PLDMRequest] = {}
+        self._fragments: List[Dict[str, Any]] = []
+        self._next_iid = 0
+        self.stats = {
+            "sent": 0,
+            "retries": 0,
+            "timeouts": 0,
+            "completed": 0,
+            "fcs_errors": 0,
+            "unmatched": 0,
+        }
+
+    @property
+    def endpoint(self) -> str:
+        """Metrics label: device path of the (possibly rebound) SerialPort."""
+        return str(getattr(self.serial, "port", None) or "unknown")
+
+    def submit(
+        self,
+        pldm_msg: bytes,
+        timeout: Optional[float] = None,
+        retries: Optional[int] = None,
+        on_done: Optional[Callable[[PLDMRequest], None]] = None,
+    ) -> PLDMRequest:
+        """
+        Queue a PLDM request; it is sent once a window slot is free.
+
+        The instance ID bits of pldm_msg are overwritten by the engine.
+
+        Args:
+            pldm_msg: Encoded PLDM request message.
+            timeout: Per-attempt timeout (defaults to the engine timeout).
+            retries: Retransmissions after the first attempt.
+            on_done: Callback invoked with the request once it completes; it
+                may submit further requests.
+
+        Returns:
+            The tracked request.
+        """
+        req = PLDMRequest(
+            pldm_msg=bytes(pldm_msg),
+            timeout=self.timeout if timeout is None else timeout,
+            retries=self.retries if retries is None else retries,
+            on_done=on_done,
+        )
+        self._queue.append(req)
+        return req
+
+    def request(
+        self,
+        pldm_msg: bytes,
+        timeout: Optional[float] = None,
+        retries: Optional[int] = None,
+    ) -> PLDMRequest:
+        """Submit a single request and drive the engine until it completes."""
+        req = self.submit(pldm_msg, timeout=timeout, retries=retries)
+        self.run(until=req)
+        return req
+
+    def in_flight(self) -> int:
+        """Number of requests queued or awaiting a response."""
+        return len(self._queue) + len(self._outstanding)
+
+    def cancel_queued(self) -> None:
+        """Drop requests that have not been sent yet."""
+        for req in self._queue:
+            req.cancelled = True
+            req.done = True
+            req.error = "Cancelled"
+        self._queue.clear()
+
+    def run(self, until: Optional[PLDMRequest] = None) -> None:
+        """
+        Drive sends, receives and timeouts.
+
+        Args:
+            until: Stop once this request completes; otherwise run until no
+                requests remain queued or outstanding.
+        """
+        while self._queue or self._outstanding:
+            if until is not None and until.done:
+                return
+            self._fill_window()
+            self._poll()
+
+    def _alloc_instance_id(self) -> Optional[int]:
+        for _ in range(MAX_INSTANCE_IDS):
+            iid = self._next_iid
+            self._next_iid = (self._next_iid + 1) % MAX_INSTANCE_IDS
+            if iid not in self._outstanding:
+                return iid
+        return None
+
+    def _send(self, req: PLDMRequest) -> None:
+        msg = bytearray(req.pldm_msg)
+        msg[0] = (msg[0] & 0xE0) | (req.instance_id & 0x1F)
+        frame = MCTPFramer.build_frame(
+            pldm_msg=bytes(msg),
+            dest=self.remote_eid,
+            src=self.local_eid,
+            msg_type=self.msg_type,
+        )
+        if self.debug:
+            console.print(f"[dim]TX iid={req.instance_id} raw: {frame.hex()}[/dim]")
+
+        now = time.monotonic()
+        if req.attempts == 0:
+            req.first_sent = now
+        req.attempts += 1
+        req.deadline = now + req.timeout
+        self.stats["sent"] += 1
+        if not self.serial.write(frame):
+            # Leave it outstanding; the deadline drives the retry
+            console.print(f"[yellow]⚠️  Write failed for iid={req.instance_id}[/yellow]")
+
+    def _fill_window(self) -> None:
+        while self._queue and len(self._outstanding) < self.max_outstanding:
+            iid = self._alloc_instance_id()
+            if iid is None:
+                return
+            req = self._queue.pop(0)
+            req.instance_id = iid
+            self._outstanding[iid] = req
+            self._send(req)
+
+    def _poll(self) -> None:
+        if not self._outstanding:
+            return
+        earliest = min(req.deadline for req in self._outstanding.values())
+        wait = earliest - time.monotonic()
+        if wait > 0:
+            for raw in self.serial.read_frames(timeout=wait, until_eom=False):
+                self._handle_frame(raw)
+        self._expire(time.monotonic())
+
+    def _handle_frame(self, raw: bytes) -> None:
+        parsed = MCTPFramer.parse_frame(raw)
+        if not parsed:
+            return
+        if self.debug:
+            console.print(f"[dim]RX raw: {raw.hex()}[/dim]")
+        if not parsed.get("fcs_ok"):
+            self.stats["fcs_errors"] += 1
+            METRICS.inc("pldm_fcs_errors_total", endpoint=self.endpoint)
+            self._fragments = []
+            return
+
+        if parsed.get("som"):
+            self._fragments = [parsed]
+        elif self._fragments:
+            self._fragments.append(parsed)
+        else:
+            return
+        if not parsed.get("eom"):
+            return
+        message = MCTPFramer.reassemble_frames(self._fragments)
+        self._fragments = []
+        if not message:
+            return
+
+        req = self._outstanding.get(message.get("instance"))
+        if (
+            req is None
+            or message.get("msg_type") != self.msg_type
+            or message.get("resp_code") is None
+            or message.get("type") != req.pldm_type
+            or message.get("cmd_code") != req.cmd_code
+        ):
+            self.stats["unmatched"] += 1
+            METRICS.inc("pldm_unmatched_responses_total", endpoint=self.endpoint)
+            return
+        self._complete(req, message, None)
+
+    def _expire(self, now: float) -> None:
+        for req in list(self._outstanding.values()):
+            if req.deadline > now:
+                continue
+            if req.attempts <= req.retries:
+                self.stats["retries"] += 1
+                METRICS.inc("pldm_retries_total", endpoint=self.endpoint)
+                self._send(req)
+            else:
+                self.stats["timeouts"] += 1
+                self._complete(req, None, "Timeout")
+
+    def _complete(self, req: PLDMRequest, response: Optional[Dict[str, Any]], error: Optional[str]) -> None:
+        self._outstanding.pop(req.instance_id, None)
+        req.response = response
+        req.error = error
+        req.done = True
+        req.rtt = time.monotonic() - req.first_sent
+        if error is None:
+            self.stats["completed"] += 1
+        command = f"0x{req.pldm_type:02x}/0x{req.cmd_code:02x}"
+        METRICS.inc("pldm_requests_total", endpoint=self.endpoint, command=command,
+                    outcome="ok" if error is None else "timeout")
+        if error is None:
+            METRICS.observe("pldm_request_rtt_seconds", req.rtt, endpoint=self.endpoint, command=command)
+        if req.on_done:
+            req.on_done(req)
+
+
+class PDRChainWalker:
+    """
+    Walk the GetPDR record chain with pipelined, speculative requests.
+
+    The chain is inherently sequential (each response names the next record
+    handle), so once the handle stride is learned from the chain the walker
+    speculatively requests the following handles to keep the engine window
+    full. Mispredicted handles fail harmlessly and disable speculation; the
+    returned chain is always the one the endpoint reported.
+
+    Endpoints commonly keep a single GetPDR transfer context, which any
+    GetFirstPart resets. Only single-part records are therefore taken from a
+    speculative request; a record needing GetNextPart is fetched on its own
+    and is restarted once from its first part if a speculative request had
+    overtaken it. A speculative first part of a multi-part record is wasted,
+    so speculation is used only while every record fits in one part: it is
+    off from the start when LargestRecordSize exceeds the part size, and
+    stops for good at the first multi-part record otherwise.
+    """
+
+    GET_FIRST_PART = 0x01
+    GET_NEXT_PART = 0x00
+    MAX_PARTS = 50
+    MAX_MISPREDICTIONS = 2
+    # Chain length limit when GetPDRRepositoryInfo gave no record count
+    MAX_RECORDS = 0x10000
+
+    def __init__(
+        self,
+        engine: PLDMRequestEngine,
+        max_records: Optional[int] = None,
+        request_count: int = 255,
+        expected_records: Optional[int] = None,
+        speculate: bool = True,
+        largest_record: Optional[int] = None,
+    ):
+        """
+        Args:
+            engine: Request engine bound to the endpoint.
+            max_records: Limit on chain length (default: expected_records,
+                or MAX_RECORDS without it). A chain still going at the
+                limit is an error, never a silently shortened result.
+            request_count: Max record bytes per GetPDR response.
+            expected_records: RecordCount from GetPDRRepositoryInfo, used
+                to bound the chain and speculation.
+            speculate: Enable speculative prefetch of predicted handles.
+            largest_record: LargestRecordSize from GetPDRRepositoryInfo;
+                speculation is skipped when it exceeds request_count.
+        """
+        self.engine = engine
+        self.max_records = max_records
+        self.request_count = request_count
+        self.expected_records = expected_records
+        self.speculate = speculate and not (largest_record and largest_record > request_count)
+
+        self.chain: List[Dict[str, Any]] = []
+        self.error: Optional[str] = None
+        self._records: Dict[int, Dict[str, Any]] = {}
+        self._state: Dict[int, Dict[str, Any]] = {}
+        self._cursor = 0
+        self._stride = 0
+        self._mispredictions = 0
+        self._finished = False
+        self._transfer: Optional[int] = None  # handle of a multi-part transfer in progress
+        self._submitted = 0
+        self._seen = set()
+
+    def run(self) -> Tuple[List[Dict[str, Any]], Optional[str]]:
+        """
+        Retrieve the whole chain.
+
+        Returns:
+            Tuple of (records in chain order, error string or None). Each record
+            is {'handle', 'next_handle', 'pdr_data'}; on error the records
+            retrieved before the failure are returned.
+        """
+        self._fetch(0, speculative=False)
+        self.engine.run()
+        return self.chain, self.error
+
+    def _limit(self) -> int:
+        limits = [n for n in (self.max_records, self.expected_records) if n]
+        return min(limits) if limits else self.MAX_RECORDS
+
+    def _fetch(self, handle: int, speculative: bool) -> None:
+        self._state[handle] = {
+            "speculative": speculative,
+            "data": bytearray(),
+            "change": 0,
+            "parts": 0,
+            "failed": False,
+            "seq": 0,
+            "overtaken": False,
+            "restarted": False,
+        }
+        self._submit_part(handle, 0, self.GET_FIRST_PART)
+
+    def _submit_part(self, handle: int, transfer_handle: int, op_flag: int) -> None:
+        state = self._state[handle]
+        state["parts"] += 1
+        self._submitted += 1
+        state["seq"] = self._submitted
+        cmd = PDLMCommandEncoder.encode_get_pdr(
+            instance_id=0,
+            record_handle=handle,
+            data_transfer_handle=transfer_handle,
+            transfer_operation_flag=op_flag,
+            request_count=self.request_count,
+            record_change_number=state["change"],
+        )
+        # Speculative requests are cheap to lose; don't spend retries on them
+        retries = 0 if state["speculative"] else None
+        state["req"] = self.engine.submit(cmd, retries=retries, on_done=lambda req, h=handle: self._on_part(h, req))
+
+    def _on_part(self, handle: int, req: PLDMRequest) -> None:
+        if self._finished or req.cancelled:
+            return
+        state = self._state[handle]
+        if not req.ok:
+            self._fail(handle, req.error or "No response")
+            return
+
+        result = PDLMCommandEncoder.decode_get_pdr_response(req.response.get("extra", b""))
+        if "error" in result:
+            # An error completion code on a guessed handle means the guess was wrong
+            self._fail(handle, result["error"], mispredicted=True)
+            return
+
+        first_part = not state["data"]
+        state["data"].extend(result.get("record_data", b""))
+        # Capture recordChangeNumber from first part (PDR header bytes 6-7)
+        if first_part and len(state["data"]) >= 8:
+            state["change"] = struct.unpack("<H", state["data"][6:8])[0]
+
+        transfer_flag = result.get("transfer_flag", 0)
+        transfer_handle = result.get("next_data_transfer_handle", 0)
+        # 0x04 = End, 0x05 = StartAndEnd; a zero transfer handle also ends it
+        if transfer_flag not in (0x04, 0x05) and transfer_handle != 0:
+            if transfer_flag not in (0x00, 0x01, 0x02):
+                self._fail(handle, f"Unknown transfer flag: 0x{transfer_flag:02x}")
+                return
+            if state["parts"] >= self.MAX_PARTS:
+                self._fail(handle, "Max iterations reached in multi-part transfer")
+                return
+            # Further guesses would mostly cost a wasted first part each
+            self.speculate = False
+            if state["speculative"]:
+                # Continuing would share the transfer context with other guesses
+                self._fail(handle, "Multi-part record")
+                return
+            self._begin_transfer(handle)
+            self._submit_part(handle, transfer_handle, self.GET_NEXT_PART)
+            return
+
+        if self._transfer == handle:
+            self._transfer = None
+
+        self._records[handle] = {
+            "handle": handle,
+            "next_handle": result.get("next_record_handle", 0),
+            "pdr_data": bytes(state["data"]),
+        }
+        self._advance()
+
+    def _fail(self, handle: int, error: str, mispredicted: bool = False) -> None:
+        state = self._state[handle]
+        state["failed"] = True
+        if state["speculative"]:
+            if mispredicted:
+                self.speculate = False
+            if handle == self._cursor:
+                # The guess was right but the attempt was lost; fetch for real
+                self._fetch(handle, speculative=False)
+            return
+        if handle != self._cursor:
+            return
+        if self._transfer == handle:
+            self._transfer = None
+            if state["overtaken"] and not state["restarted"]:
+                # A speculative GetFirstPart reset the transfer; start it over alone
+                self._fetch(handle, speculative=False)
+                self._state[handle]["restarted"] = True
+                return
+        self.error = f"handle=0x{handle:08x}: {error}"
+        self._finish()
+
+    def _begin_transfer(self, handle: int) -> None:
+        """Hold speculation while `handle` is fetched part by part."""
+        state = self._state[handle]
+        if self._submitted != state["seq"]:
+            # Some request went out after this record's last part
+            state["overtaken"] = True
+        if self._transfer is None:
+            self._transfer = handle
+            self.engine.cancel_queued()
+            for other in self._state.values():
+                req = other.get("req")
+                if req is not None and req.cancelled:
+                    other["failed"] = True
+
+    def _finish(self) -> None:
+        self._finished = True
+        self.engine.cancel_queued()
+
+    def _advance(self) -> None:
+        while True:
+            rec = self._records.get(self._cursor)
+            if rec is None:
+                break
+            self.chain.append(rec)
+            self._seen.add(rec["handle"])
+            next_handle = rec["next_handle"]
+            if next_handle == 0:
+                self._finish()
+                return
+            if next_handle in self._seen:
+                self.error = f"handle=0x{rec['handle']:08x}: next handle 0x{next_handle:08x} loops back"
+                self._finish()
+                return
+            if len(self.chain) >= self._limit():
+                self.error = f"PDR chain continues past {self._limit()} records (next handle 0x{next_handle:08x})"
+                self._finish()
+                return
+            self._learn_stride(rec, next_handle)
+            self._cursor = next_handle
+
+        state = self._state.get(self._cursor)
+        if state is None or (state["failed"] and state["speculative"]):
+            self._fetch(self._cursor, speculative=False)
+        self._prefetch()
+
+    def _learn_stride(self, rec: Dict[str, Any], next_handle: int) -> None:
+        handle = rec["handle"]
+        pdr_data = rec["pdr_data"]
+        if handle == 0:
+            # First record: use the actual handle from the PDR header if present
+            if len(pdr_data) < 10 or pdr_data[4] != 0x01:
+                return
+            handle = struct.unpack("<I", pdr_data[0:4])[0]
+        stride = next_handle - handle
+        if self._stride and stride != self._stride:
+            self._mispredictions += 1
+            if self._mispredictions >= self.MAX_MISPREDICTIONS:
+                self.speculate = False
+        self._stride = stride
+
+    def _prefetch(self) -> None:
+        if not self.speculate or self._stride <= 0 or self._transfer is not None:
+            return
+        handle = self._cursor
+        while self.engine.in_flight() < self.engine.max_outstanding and len(self._state) < self._limit():
+            handle += self._stride
+            if handle > 0xFFFFFFFF:
+                return
+            if handle not in self._state:
+                self._fetch(handle, speculative=True)
@@ -0,0 +1,148 @@
+"""FCS-16 and byte-stuffing codecs for MCTP serial framing (DSP0253).
+
+Two FCS backends produce identical results:
+
+- "native": the reflected CRC (poly 0x8408) is computed with the C-level
+  binascii.crc_hqx, which implements the non-reflected form (poly 0x1021).
+  A reflected CRC equals the bit-reversed non-reflected CRC of bit-reversed
+  input with a bit-reversed initial value, and 0xFFFF reverses to itself.
+- "python": the classic RFC1662 table-driven loop over a module-level table.
+
+The native backend is used unless MCTP_CODEC=python is set in the
+environment (useful when debugging the codec itself).
+
+Stuffing escapes 0x7D then 0x7E with bytes.replace, and unstuffing uses a
+single regex substitution. Both match the original per-byte loops exactly,
+including dropping a trailing lone escape byte.
+"""
+
+import os
+import re
+import binascii
+from typing import Tuple
+
+FRAME_CHAR = 0x7E
+ESCAPE_CHAR = 0x7D
+INITFCS = 0xFFFF
+
+# FCS lookup table for polynomial 0x8408 (reflected 0x1021), RFC1662
+FCS_TABLE = (
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
+)
+
+# Bit-reversal of every byte value, as a bytes.translate() table
+_REVERSE8 = bytes(int(f"{i:08b}"[::-1], 2) for i in range(256))
+
+
+def _reverse16(value: int) -> int:
+    return (_REVERSE8[value & 0xFF] << 8) | _REVERSE8[value >> 8]
+
+
+def fcs16_python(data: bytes, fcs: int = INITFCS) -> int:
+    """Table-driven FCS-16 (RFC1662 / DSP0237 Annex A)."""
+    table = FCS_TABLE
+    for b in data:
+        fcs = (fcs >> 8) ^ table[(fcs ^ b) & 0xFF]
+    return fcs
+
+
+def fcs16_native(data: bytes, fcs: int = INITFCS) -> int:
+    """FCS-16 via binascii.crc_hqx on bit-reversed input."""
+    return _reverse16(binascii.crc_hqx(bytes(data).translate(_REVERSE8), _reverse16(fcs)))
+
+
+BACKEND = "python" if os.environ.get("MCTP_CODEC", "").lower() == "python" else "native"
+fcs16 = fcs16_python if BACKEND == "python" else fcs16_native
+
+
+def escape(body: bytes) -> bytes:
+    """Byte-stuff a frame body: 0x7D -> 7D 5D, 0x7E -> 7D 5E."""
+    body = bytes(body)
+    if b"\x7d" in body:
+        body = body.replace(b"\x7d", b"\x7d\x5d")
+    if b"\x7e" in body:
+        body = body.replace(b"\x7e", b"\x7d\x5e")
+    return body
+
+
+_ESCAPED = re.compile(rb"\x7d(.)", re.DOTALL)
+_UNESCAPED = {bytes([b]): bytes([(b + 0x20) & 0xFF]) for b in range(256)}
+
+
+def _unescape_match(m) -> bytes:
+    return _UNESCAPED[m.group(1)]
+
+
+def unescape(raw: bytes) -> bytes:
+    """Undo byte stuffing; a trailing lone escape byte is dropped."""
+    raw = bytes(raw)
+    if b"\x7d" not in raw:
+        return raw
+    # An odd run of escape bytes at the end leaves the final one unpaired
+    run = len(raw) - len(raw.rstrip(b"\x7d"))
+    if run % 2:
+        raw = raw[:-1]
+    return _ESCAPED.sub(_unescape_match, raw)
+
+
+def unescape_counted(raw: bytes, offset: int, count: int) -> Tuple[bytes, int]:
+    """
+    Unescape bytes from raw[offset:] until count output bytes are produced.
+
+    Returns:
+        Tuple of (unescaped bytes, index in raw just past the consumed input).
+    """
+    window = raw[offset:offset + count]
+    if b"\x7d" not in window:
+        # No escapes: output is the input window itself
+        return bytes(window), offset + len(window)
+
+    out = bytearray()
+    i = offset
+    n = len(raw)
+    while i < n and len(out) < count:
+        # Copy the run up to the next escape (bounded by what is still needed)
+        j = raw.find(b"\x7d", i, min(n, i + count - len(out)))
+        if j < 0:
+            take = count - len(out)
+            out += raw[i:i + take]
+            i = min(n, i + take)
+            break
+        out += raw[i:j]
+        i = j + 1
+        if i >= n:
+            break
+        out.append((raw[i] + 0x20) & 0xFF)
+        i += 1
+    return bytes(out), i
@@ -0,0 +1,208 @@
+"""Process-wide counters, gauges and latency histograms.
+
+The transport, the request engine, the runtime agent and the Redfish server
+record into the METRICS registry of their own process. Each series is a
+metric name plus a set of labels, usually including the endpoint's device
+path; recording is one dict update under a lock.
+
+snapshot() returns the registry as JSON-safe data, which the runtime agent
+pushes to the Redfish server; the server checks pushed snapshots with
+check_snapshot() before keeping them. render_prometheus() formats snapshots
+in the Prometheus text exposition format (version 0.0.4), as served at
+GET /metrics.
+"""
+
+import math
+import re
+import threading
+from typing import Dict, Iterable, Tuple
+
+# Histogram upper bounds in seconds, from one 115200-baud byte to a stalled link
+LATENCY_BUCKETS = (0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0)
+
+# name -> (type, help) for every metric recorded in this tree
+METRIC_HELP = {
+    'pldm_requests_total': ('counter', 'PLDM requests completed, by outcome'),
+    'pldm_request_rtt_seconds': ('histogram', 'PLDM request round trip, first send to response'),
+    'pldm_retries_total': ('counter', 'PLDM request retransmissions'),
+    'pldm_fcs_errors_total': ('counter', 'MCTP frames received with a bad FCS'),
+    'pldm_unmatched_responses_total': ('counter', 'PLDM responses matching no outstanding request'),
+    'pldm_serial_bytes_total': ('counter', 'Bytes on the serial line'),
+    'pldm_port_wait_seconds': ('histogram', 'Time a lease waited for its serial port, by priority'),
+    'agent_fru_match_seconds': ('histogram', 'Time from a port being added to its FRU match result'),
+    'agent_fru_match_queued': ('gauge', 'Added ports waiting for a FRU match worker'),
+    'agent_fru_match_running': ('gauge', 'FRU matches in progress'),
+    'redfish_http_requests_total': ('counter', 'HTTP requests served, by route and status'),
+    'redfish_http_request_seconds': ('histogram', 'HTTP handler latency, by route'),
+    'redfish_http_busy_rejections_total': ('counter', 'Connections answered 503 because every worker was busy'),
+    'redfish_history_sensors': ('gauge', 'Sensors with reading history in the Redfish server'),
+    'redfish_aggregator_shard_seconds': ('histogram', 'Aggregator requests to a shard, by shard'),
+    'redfish_aggregator_shard_errors_total': ('counter', 'Aggregator requests a shard did not answer'),
+}
+
+Labels = Tuple[Tuple[str, str], ...]
+
+# Upper bound on the series one pushed snapshot may carry
+MAX_PUSHED_SERIES = 10000
+
+_METRIC_NAME = re.compile(r'[a-zA-Z_:][a-zA-Z0-9_:]*')
+_LABEL_NAME = re.compile(r'[a-zA-Z_][a-zA-Z0-9_]*')
+
+
+def _labels(labels: dict) -> Labels:
+    return tuple(sorted((k, str(v)) for k, v in labels.items()))
+
+
+class MetricsRegistry:
+    """Thread-safe store of labelled series."""
+
+    def __init__(self, buckets=LATENCY_BUCKETS):
+        self.buckets = tuple(buckets)
+        self._lock = threading.Lock()
+        self._counters: Dict[Tuple[str, Labels], float] = {}
+        self._gauges: Dict[Tuple[str, Labels], float] = {}
+        self._histograms: Dict[Tuple[str, Labels], list] = {}  # [bucket counts..., +Inf count, sum]
+
+    def inc(self, name: str, value: float = 1, **labels):
+        key = (name, _labels(labels))
+        with self._lock:
+            self._counters[key] = self._counters.get(key, 0) + value
+
+    def set(self, name: str, value: float, **labels):
+        with self._lock:
+            self._gauges[(name, _labels(labels))] = value
+
+    def observe(self, name: str, seconds: float, **labels):
+        key = (name, _labels(labels))
+        with self._lock:
+            hist = self._histograms.get(key)
+            if hist is None:
+                hist = self._histograms[key] = [0] * (len(self.buckets) + 1) + [0.0]
+            for i, bound in enumerate(self.buckets):
+                if seconds <= bound:
+                    hist[i] += 1
+                    break
+            else:
+                hist[len(self.buckets)] += 1
+            hist[-1] += seconds
+
+    def snapshot(self) -> dict:
+        """{"buckets": [...], "counters"/"gauges": [[name, labels, value]], "histograms": [[name, labels, counts, sum]]}."""
+        with self._lock:
+            return {
+                'buckets': list(self.buckets),
+                'counters': [[n, dict(l), v] for (n, l), v in self._counters.items()],
+                'gauges': [[n, dict(l), v] for (n, l), v in self._gauges.items()],
+                'histograms': [[n, dict(l), h[:-1], h[-1]] for (n, l), h in self._histograms.items()],
+            }
+
+    def clear(self):
+        with self._lock:
+            self._counters.clear()
+            self._gauges.clear()
+            self._histograms.clear()
+
+
+METRICS = MetricsRegistry()
+
+
+def _is_number(value) -> bool:
+    return isinstance(value, (int, float)) and not isinstance(value, bool)
+
+
+def _check_series(kind: str, entry, width: int):
+    if not isinstance(entry, list) or len(entry) != (4 if kind == 'histograms' else 3):
+        raise ValueError(f"{kind} entries must be [name, labels, {'counts, sum' if kind == 'histograms' else 'value'}]")
+    name, labels = entry[0], entry[1]
+    if not isinstance(name, str) or not _METRIC_NAME.fullmatch(name):
+        raise ValueError(f"invalid metric name {name!r}")
+    if not isinstance(labels, dict) or not all(isinstance(k, str) and _LABEL_NAME.fullmatch(k) for k in labels):
+        raise ValueError(f"{name}: labels must be an object with valid label names")
+    # snapshot() stringifies label values; mixed types would not sort in render_prometheus()
+    if not all(isinstance(v, str) for v in labels.values()):
+        raise ValueError(f"{name}: label values must be strings")
+    if kind != 'histograms':
+        if not _is_number(entry[2]):
+            raise ValueError(f"{name}: value must be a number")
+        return
+    counts, total = entry[2], entry[3]
+    if not isinstance(counts, list) or len(counts) != width or \
+            not all(isinstance(c, int) and not isinstance(c, bool) and c >= 0 for c in counts):
+        raise ValueError(f"{name}: counts must be {width} non-negative integers")
+    if not _is_number(total):
+        raise ValueError(f"{name}: sum must be a number")
+
+
+def check_snapshot(snap) -> None:
+    """Raise ValueError unless `snap` has the shape snapshot() produces.
+
+    render_prometheus() trusts its input, so pushed snapshots are checked
+    here once instead of failing every later GET /metrics.
+    """
+    if not isinstance(snap, dict):
+        raise ValueError("snapshot must be an object")
+    buckets = snap.get('buckets', [])
+    if not isinstance(buckets, list) or not all(_is_number(b) for b in buckets):
+        raise ValueError("buckets must be an array of numbers")
+    count = 0
+    for kind in ('counters', 'gauges', 'histograms'):
+        entries = snap.get(kind, [])
+        if not isinstance(entries, list):
+            raise ValueError(f"{kind} must be an array")
+        count += len(entries)
+        if count > MAX_PUSHED_SERIES:
+            raise ValueError(f"more than {MAX_PUSHED_SERIES} series")
+        for entry in entries:
+            _check_series(kind, entry, len(buckets) + 1)
+
+
+def _escape(value: str) -> str:
+    return value.replace('\\', '\\\\').replace('\n', '\\n').replace('"', '\\"')
+
+
+def _series(name: str, labels: dict, extra: Iterable[Tuple[str, str]] = ()) -> str:
+    pairs = list(labels.items()) + list(extra)
+    if not pairs:
+        return name
+    return name + '{' + ','.join(f'{k}="{_escape(str(v))}"' for k, v in pairs) + '}'
+
+
+def _number(value: float) -> str:
+    if isinstance(value, float) and math.isinf(value):
+        return '+Inf' if value > 0 else '-Inf'
+    return repr(value) if isinstance(value, float) else str(value)
+
+
+def render_prometheus(snapshots: Dict[str, dict]) -> str:
+    """Prometheus text for {process name: snapshot}; each series gets a `process` label."""
+    by_name: Dict[str, list] = {}
+    for process, snap in snapshots.items():
+        if not isinstance(snap, dict):
+            continue
+        buckets = snap.get('buckets') or []
+        for kind in ('counters', 'gauges', 'histograms'):
+            for entry in snap.get(kind) or []:
+                name = entry[0]
+                labels = {k: str(v) for k, v in entry[1].items()}
+                labels['process'] = process
+                by_name.setdefault(name, []).append((kind, labels, entry[2:], buckets))
+
+    lines = []
+    for name in sorted(by_name):
+        series = by_name[name]
+        default_type = {'counters': 'counter', 'gauges': 'gauge', 'histograms': 'histogram'}[series[0][0]]
+        kind, help_text = METRIC_HELP.get(name, (default_type, name))
+        lines.append(f'# HELP {name} {help_text}')
+        lines.append(f'# TYPE {name} {kind}')
+        for kind, labels, values, buckets in sorted(series, key=lambda s: sorted(s[1].items())):
+            if kind != 'histograms':
+                lines.append(f'{_series(name, labels)} {_number(values[0])}')
+                continue
+            counts, total = values
+            cumulative = 0
+            for bound, count in zip(list(buckets) + [math.inf], counts):
+                cumulative += count
+                lines.append(f'{_series(name + "_bucket", labels, [("le", _number(float(bound)))])} {cumulative}')
+            lines.append(f'{_series(name + "_sum", labels)} {_number(float(total))}')
+            lines.append(f'{_series(name + "_count", labels)} {cumulative}')
+    return '\n'.join(lines) + '\n'
@@ -5,6 +5,8 @@ import serial
 from typing import Optional, List, Dict, Any
 from dataclasses import dataclass
 from rich.console import Console
+from pldm_mapping_wizard import mctp_codec
+from pldm_mapping_wizard.metrics import METRICS
 
 console = Console()
 
@@ -22,7 +24,7 @@ class MCTPMessage:
 class SerialPort:
     """Low-level serial port communication."""
 
-    def __init__(self, port: str, baudrate: int = 115200, timeout: float = 5.0):
+    def __init__(self, port: str, baudrate: int = 115200, timeout: float = 5.0, exclusive: bool = False):
         """
         Initialize serial port.
 
@@ -30,11 +32,16 @@ class SerialPort:
             port: Serial device path (e.g., "/dev/ttyUSB0").
             baudrate: Serial communication speed.
             timeout: Read/write timeout in seconds.
+            exclusive: Lock the device (POSIX flock) so no other process can
+                open it while this port is open.
         """
         self.port = port
         self.baudrate = baudrate
         self.timeout = timeout
+        self.exclusive = exclusive
         self.serial = None
+        self.decoder = MCTPFrameDecoder()
+        self._pending: List[bytes] = []
 
     def open(self) -> bool:
         """
@@ -44,6 +51,7 @@ class SerialPort:
             True if successful, False otherwise.
         """
         try:
+            options = {'exclusive': True} if self.exclusive else {}
             self.serial = serial.Serial(
                 self.port,
                 baudrate=self.baudrate,
@@ -51,6 +59,7 @@ class SerialPort:
                 bytesize=serial.EIGHTBITS,
                 parity=serial.PARITY_NONE,
                 stopbits=serial.STOPBITS_ONE,
+                **options,
             )
             return True
         except Exception as e:
@@ -62,6 +71,34 @@ class SerialPort:
         if self.serial:
             self.serial.close()
             self.serial = None
+        self.decoder.reset()
+        self._pending.clear()
+
+    def set_timeout(self, timeout: float) -> None:
+        """Change the read timeout without reopening the port."""
+        self.timeout = timeout
+        if self.serial:
+            try:
+                self.serial.timeout = timeout
+            except Exception:
+                pass
+
+    def set_baudrate(self, baudrate: int) -> bool:
+        """
+        Switch the line speed of the open port, discarding pending input.
+
+        Returns:
+            True if the port accepted the new rate.
+        """
+        try:
+            if self.serial:
+                self.serial.baudrate = baudrate
+            self.baudrate = baudrate
+        except Exception as e:
+            console.print(f"[yellow]⚠️  {self.port} rejected {baudrate} baud: {e}[/yellow]")
+            return False
+        self.reset_input()
+        return True
 
     def write(self, data: bytes) -> bool:
         """
@@ -78,6 +115,7 @@ class SerialPort:
         try:
             self.serial.write(data)
             self.serial.flush()
+            METRICS.inc('pldm_serial_bytes_total', len(data), endpoint=self.port, direction='tx')
             return True
         except Exception as e:
             console.print(f"[red]✗ Write failed: {e}[/red]")
@@ -97,11 +135,75 @@ class SerialPort:
             return None
         try:
             data = self.serial.read(size)
+            if data:
+                METRICS.inc('pldm_serial_bytes_total', len(data), endpoint=self.port, direction='rx')
             return data if data else None
         except Exception as e:
             console.print(f"[red]✗ Read failed: {e}[/red]")
             return None
 
+    def read_frames(self, timeout: float = 2.0, until_eom: bool = True) -> List[bytes]:
+        """
+        Read MCTP frames as they arrive, returning as soon as a message completes.
+
+        Bytes are fed through a persistent MCTPFrameDecoder, so there is no
+        idle-gap wait: the call returns the moment the closing FRAME_CHAR of
+        the last needed frame is received. Frames completed beyond that point
+        are kept for the next call.
+
+        Args:
+            timeout: Overall timeout in seconds.
+            until_eom: If True, keep reading until a frame with the EOM bit set
+                has been received; otherwise return after the first frame.
+
+        Returns:
+            List of raw (still escaped) frames, suitable for parse_frame().
+            Empty on timeout or when the port is closed.
+        """
+        if not self.serial or not self.serial.is_open:
+            return []
+
+        frames: List[bytes] = []
+        deadline = time.monotonic() + timeout
+        saved_timeout = self.serial.timeout
+        try:
+            while True:
+                while self._pending:
+                    frame = self._pending.pop(0)
+                    frames.append(frame)
+                    if not until_eom or MCTPFrameDecoder.frame_has_eom(frame):
+                        return frames
+
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    return frames
+
+                # Block for at least one byte, then drain whatever is buffered
+                self.serial.timeout = remaining
+                chunk = self.serial.read(max(1, self.serial.in_waiting))
+                if not chunk:
+                    return frames
+                METRICS.inc('pldm_serial_bytes_total', len(chunk), endpoint=self.port, direction='rx')
+                self._pending.extend(self.decoder.feed(chunk))
+        except Exception as e:
+            console.print(f"[red]✗ Read failed: {e}[/red]")
+            return frames
+        finally:
+            try:
+                self.serial.timeout = saved_timeout
+            except Exception:
+                pass
+
+    def reset_input(self) -> None:
+        """Discard buffered input and any partially decoded frame."""
+        self.decoder.reset()
+        self._pending.clear()
+        if self.serial and self.serial.is_open:
+            try:
+                self.serial.reset_input_buffer()
+            except Exception:
+                pass
+
     def read_until_idle(self, timeout: float = 2.0, idle: float = 0.2) -> bytes:
         """
         Read until the line is idle or timeout expires.
@@ -128,6 +230,8 @@ class SerialPort:
                 if data and (time.time() - last) > idle:
                     break
                 time.sleep(0.001)
+        if data:
+            METRICS.inc('pldm_serial_bytes_total', len(data), endpoint=self.port, direction='rx')
         return bytes(data)
 
     def is_open(self) -> bool:
@@ -145,6 +249,11 @@ class MCTPFramer:
     # SOM/EOM flags in the flags byte (bits 7-6)
     SOM_BIT = 0x80  # Start of Message (bit 7)
     EOM_BIT = 0x40  # End of Message (bit 6)
+    TO_BIT = 0x08  # Tag Owner (bit 3)
+
+    # byte_count is one byte and covers the 4-byte MCTP header, so a single
+    # serial packet carries at most 251 message bytes
+    MAX_PACKET_PAYLOAD = 0xFF - 4
 
     # Frame layout (escaped between frame chars):
     # [FRAME][protocol_v][byte_count][body...][fcs_hi][fcs_lo][FRAME]
@@ -159,62 +268,21 @@ class MCTPFramer:
     @staticmethod
     def _calc_fcs(data: bytes) -> int:
         """PPP FCS-16 per RFC1662 / DSP0237 Annex A (reflected polynomial 0x8408)."""
-        # FCS lookup table for polynomial 0x8408 (reflected 0x1021)
-        fcstab = [
-            0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
-            0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
-            0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
-            0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
-            0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
-            0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
-            0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
-            0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
-            0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
-            0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
-            0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
-            0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
-            0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
-            0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
-            0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
-            0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
-            0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
-            0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
-            0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
-            0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
-            0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
-            0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
-            0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
-            0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
-            0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
-            0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
-            0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
-            0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
-            0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
-            0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
-            0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
-            0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
-        ]
-        
-        fcs = MCTPFramer.INITFCS
-        for b in data:
-            fcs = (fcs >> 8) ^ fcstab[(fcs ^ b) & 0xff]
-        return fcs
+        return mctp_codec.fcs16(data)
 
     @staticmethod
     def _unescape_body(raw: bytes) -> bytes:
-        out = bytearray()
-        i = 0
-        while i < len(raw):
-            b = raw[i]
-            if b == MCTPFramer.ESCAPE_CHAR:
-                i += 1
-                if i >= len(raw):
-                    break
-                out.append((raw[i] + 0x20) & 0xFF)
-            else:
-                out.append(b)
-            i += 1
-        return bytes(out)
+        return mctp_codec.unescape(raw)
+
+    @staticmethod
+    def _unescape_counted(raw: bytes, offset: int, count: int):
+        """
+        Unescape bytes from raw[offset:] until count output bytes are produced.
+
+        Returns:
+            Tuple of (unescaped bytes, index in raw just past the consumed input).
+        """
+        return mctp_codec.unescape_counted(raw, offset, count)
 
     @staticmethod
     def build_frame(
@@ -226,7 +294,7 @@ class MCTPFramer:
         protocol_version: int = 0x01,
         flags: int = 0xC8,
     ) -> bytes:
-        """Wrap PLDM message bytes into MCTP serial frame."""
+        """Wrap PLDM message bytes into a single MCTP serial frame."""
         body = bytearray()
         body.append(header_version)
         body.append(dest & 0xFF)
@@ -234,30 +302,56 @@ class MCTPFramer:
         body.append(flags & 0xFF)
         body.append(msg_type & 0xFF)
         body.extend(pldm_msg)
+        return MCTPFramer._frame(body, protocol_version)
 
+    @staticmethod
+    def build_frames(
+        pldm_msg: bytes,
+        dest: int,
+        src: int,
+        msg_type: int = 0x01,
+        mtu: int = MAX_PACKET_PAYLOAD,
+        tag: int = 0,
+        tag_owner: bool = True,
+        header_version: int = 0x01,
+        protocol_version: int = 0x01,
+    ) -> List[bytes]:
+        """
+        Split a message into MCTP packets of at most `mtu` message bytes.
+
+        The first packet carries the message type; SOM/EOM and the 2-bit
+        packet sequence number are set per DSP0236 8.8.
+        """
+        mtu = max(1, min(int(mtu), MCTPFramer.MAX_PACKET_PAYLOAD))
+        message = bytes([msg_type & 0xFF]) + bytes(pldm_msg)
+        chunks = [message[i:i + mtu] for i in range(0, len(message), mtu)] or [message]
+        frames = []
+        for seq, chunk in enumerate(chunks):
+            flags = (tag & 0x07) | (MCTPFramer.TO_BIT if tag_owner else 0) | ((seq & 0x03) << 4)
+            if seq == 0:
+                flags |= MCTPFramer.SOM_BIT
+            if seq == len(chunks) - 1:
+                flags |= MCTPFramer.EOM_BIT
+            body = bytes([header_version, dest & 0xFF, src & 0xFF, flags]) + chunk
+            frames.append(MCTPFramer._frame(body, protocol_version))
+        return frames
+
+    @staticmethod
+    def _frame(body: bytes, protocol_version: int = 0x01) -> bytes:
         byte_count = len(body)
-        frame = bytearray()
-        frame.append(MCTPFramer.FRAME_CHAR)
-        frame.append(protocol_version & 0xFF)
-        frame.append(byte_count & 0xFF)
-        frame.extend(body)
-        fcs = MCTPFramer._calc_fcs(bytes(frame[1:]))
-        frame.append((fcs >> 8) & 0xFF)
-        frame.append(fcs & 0xFF)
-        frame.append(MCTPFramer.FRAME_CHAR)
-
-        tx = bytearray()
-        payload_start = 3
-        payload_end = 3 + byte_count
-        for i, b in enumerate(frame):
-            # Only escape FRAME_CHAR and ESCAPE_CHAR in the body (payload_start to payload_end-1)
-            if (i >= payload_start and i < payload_end) and (b in (MCTPFramer.FRAME_CHAR, MCTPFramer.ESCAPE_CHAR)):
-                tx.append(MCTPFramer.ESCAPE_CHAR)
-                tx.append((b - 0x20) & 0xFF)
-            else:
-                tx.append(b)
-        # FCS and end flag must never be escaped
-        return bytes(tx)
+        if byte_count > 0xFF:
+            raise ValueError(f"MCTP packet body of {byte_count} bytes exceeds byte_count; use build_frames()")
+        header = bytes([protocol_version & 0xFF, byte_count])
+        fcs = MCTPFramer._calc_fcs(header + body)
+
+        # Only the body is escaped; protocol, byte count, FCS and the flags
+        # are sent as-is
+        return b"".join((
+            bytes([MCTPFramer.FRAME_CHAR]),
+            header,
+            mctp_codec.escape(body),
+            bytes([(fcs >> 8) & 0xFF, fcs & 0xFF, MCTPFramer.FRAME_CHAR]),
+        ))
 
     @staticmethod
     def parse_frame(data: bytes) -> Optional[Dict[str, Any]]:
@@ -276,20 +370,22 @@ class MCTPFramer:
             return None
         protocol = raw_payload[0]
         byte_count = raw_payload[1]
-        header_version = raw_payload[2]
-        dest = raw_payload[3]
-        src = raw_payload[4]
-        flags = raw_payload[5]
-        msg_type = raw_payload[6] if len(raw_payload) > 6 else None
-
-        # Unescape only the body (payload) region
-        body_start = 0
-        body_end = 2 + byte_count
-        unescaped_body = MCTPFramer._unescape_body(raw_payload[body_start:body_end])
+
+        # Unescape until byte_count body bytes are produced; the raw (escaped)
+        # region is longer than byte_count whenever the body contained 0x7D/0x7E
+        unescaped_body, body_end = MCTPFramer._unescape_counted(raw_payload, 2, byte_count)
         # FCS and end sync are not unescaped
         fcs_and_end = raw_payload[body_end:]
-        payload = unescaped_body + fcs_and_end
-        
+        payload = raw_payload[0:2] + unescaped_body + fcs_and_end
+        if len(payload) < 6:
+            return None
+
+        header_version = payload[2]
+        dest = payload[3]
+        src = payload[4]
+        flags = payload[5]
+        msg_type = payload[6] if len(payload) > 6 else None
+
         # PLDM header bit-field parsing (if msg_type == 1 = PLDM)
         instance = None
         pldm_type = None
@@ -330,6 +426,10 @@ class MCTPFramer:
         if len(payload) > pldm_payload_start and body_end > pldm_payload_start:
             extra = payload[pldm_payload_start:body_end]
 
+        # MCTP message bytes carried by this packet (msg_type onwards for SOM
+        # packets, raw continuation data for middle/end fragments)
+        mctp_payload = payload[6:body_end] if body_end > 6 else b""
+
         # Extract SOM and EOM bits
         som = (flags & MCTPFramer.SOM_BIT) != 0
         eom = (flags & MCTPFramer.EOM_BIT) != 0
@@ -349,6 +449,7 @@ class MCTPFramer:
             "cmd_code": command_code,
             "resp_code": response_code,
             "extra": extra,
+            "mctp_payload": mctp_payload,
             "fcs_ok": (fcs_calc == msg_fcs),
             "raw_fcs": msg_fcs,
             "fcs_calc": fcs_calc,
@@ -358,44 +459,15 @@ class MCTPFramer:
     def extract_frames(data: bytes) -> List[bytes]:
         """
         Split a buffer into individual MCTP frames delimited by FRAME_CHAR.
-        
+
         Per RFC1662, FCS bytes are NOT escaped, so 0x7E can appear in the FCS.
-        We must calculate the expected frame length from the byte_count field
-        and only look for the end flag at the correct position.
+        The buffer is run through a fresh MCTPFrameDecoder, which tracks the
+        byte_count and escape state and only accepts the end flag at the correct
+        position. Frames with escaped body bytes are returned as well.
         """
-        frames: List[bytes] = []
         if not data:
-            return frames
-
-        i = 0
-        while i < len(data):
-            # Find start flag
-            if data[i] != MCTPFramer.FRAME_CHAR:
-                i += 1
-                continue
-            start = i
-            i += 1
-            # Need at least: protocol(1) + byte_count(1) + FCS(2) + end_flag(1) = 5 more bytes
-            if i + 4 >= len(data):
-                break
-            protocol = data[i]
-            byte_count = data[i + 1]
-            # Calculate expected end position:
-            expected_end = start + 1 + 1 + 1 + byte_count + 2 + 1
-            # Only count end flag if it's not escaped (should be literal 0x7E)
-            if expected_end <= len(data) and data[expected_end - 1] == MCTPFramer.FRAME_CHAR:
-                # Check for any escaped 0x7E in the body (payload_start to payload_end-1)
-                payload_start = start + 3
-                payload_end = payload_start + byte_count
-                # Only check for ESCAPE_CHAR in the payload region
-                if MCTPFramer.ESCAPE_CHAR in data[payload_start:payload_end]:
-                    i = start + 1
-                    continue
-                frames.append(data[start:expected_end])
-                i = expected_end - 1
-            else:
-                i = start + 1
-        return frames
+            return []
+        return MCTPFrameDecoder().feed(data)
 
     @staticmethod
     def reassemble_frames(frames: List[Dict[str, Any]]) -> Optional[Dict[str, Any]]:
@@ -417,6 +489,8 @@ class MCTPFramer:
         """
         reassembly_buffer = bytearray()
         assembling = False
+        first_frame: Optional[Dict[str, Any]] = None
+        fcs_ok = True
         
         for frame in frames:
             if not frame:
@@ -434,6 +508,8 @@ class MCTPFramer:
             if som and not eom:
                 reassembly_buffer = bytearray(extra)
                 assembling = True
+                first_frame = frame
+                fcs_ok = frame.get("fcs_ok", False)
                 continue
             
             # Middle or end fragment
@@ -443,13 +519,18 @@ class MCTPFramer:
                     reassembly_buffer = bytearray(extra)
                     continue
                 
-                # Append fragment
-                reassembly_buffer.extend(extra)
+                # Append fragment; continuation packets carry no msg_type or
+                # PLDM header, so take their whole message payload
+                reassembly_buffer.extend(frame.get("mctp_payload", extra))
+                fcs_ok = fcs_ok and frame.get("fcs_ok", False)
                 
                 # End of message - return reassembled frame
                 if eom:
-                    # Copy frame structure and update extra with reassembled data
-                    result = dict(frame)
+                    # Keep the PLDM header fields from the SOM packet and update
+                    # extra with the reassembled data
+                    result = dict(first_frame or frame)
+                    result["eom"] = True
+                    result["fcs_ok"] = fcs_ok
                     result["extra"] = bytes(reassembly_buffer)
                     assembling = False
                     reassembly_buffer = bytearray()
@@ -457,3 +538,153 @@ class MCTPFramer:
         
         # Incomplete reassembly
         return None
+
+
+class MCTPFrameDecoder:
+    """
+    Incremental MCTP serial frame decoder.
+
+    Bytes are fed as they arrive from the port; each complete frame is returned
+    the moment its closing FRAME_CHAR is seen. State carries over between feed()
+    calls, so a frame split across several reads is reassembled transparently.
+
+    The decoder tracks:
+    - HUNT: waiting for an opening FRAME_CHAR
+    - PROTOCOL / BYTE_COUNT: the two unescaped header bytes (byte_count may
+      itself be 0x7E, so it is taken by position rather than by value)
+    - BODY: byte_count unescaped body bytes (0x7D escapes are resolved here)
+    - FCS_HI / FCS_LO: the two FCS bytes, never escaped (may be 0x7E)
+    - END: the closing FRAME_CHAR
+    """
+
+    HUNT = 0
+    PROTOCOL = 1
+    BYTE_COUNT = 2
+    BODY = 3
+    FCS_HI = 4
+    FCS_LO = 5
+    END = 6
+
+    def __init__(self):
+        """Initialize decoder state."""
+        self.reset()
+
+    def reset(self) -> None:
+        """Drop any partially received frame and wait for the next FRAME_CHAR."""
+        self.state = self.HUNT
+        self.raw = bytearray()
+        self.byte_count = 0
+        self.body_len = 0
+        self.escaped = False
+
+    def _start(self) -> None:
+        self.state = self.PROTOCOL
+        self.raw = bytearray((MCTPFramer.FRAME_CHAR,))
+        self.byte_count = 0
+        self.body_len = 0
+        self.escaped = False
+
+    def feed(self, data: bytes) -> List[bytes]:
+        """
+        Consume received bytes.
+
+        Args:
+            data: Bytes read from the serial port.
+
+        Returns:
+            List of complete raw frames (as received, still escaped), in order.
+        """
+        frames: List[bytes] = []
+        frame_char = MCTPFramer.FRAME_CHAR
+        escape_char = MCTPFramer.ESCAPE_CHAR
+        data = bytes(data)
+        n = len(data)
+        i = 0
+
+        while i < n:
+            state = self.state
+
+            if state == self.BODY and not self.escaped:
+                # Copy a run of ordinary body bytes in one step
+                need = self.byte_count - self.body_len
+                run = data[i:i + need]
+                stop = len(run)
+                for special in (b"\x7e", b"\x7d"):
+                    k = run.find(special, 0, stop)
+                    if k >= 0:
+                        stop = k
+                if stop:
+                    self.raw += run[:stop]
+                    self.body_len += stop
+                    i += stop
+                    if self.body_len >= self.byte_count:
+                        self.state = self.FCS_HI
+                    continue
+
+            b = data[i]
+            i += 1
+
+            if state == self.HUNT:
+                if b == frame_char:
+                    self._start()
+                continue
+
+            if state == self.PROTOCOL:
+                # Back-to-back flags (or a shared end/start flag) keep us here
+                if b == frame_char:
+                    continue
+                self.raw.append(b)
+                self.state = self.BYTE_COUNT
+                continue
+
+            if state == self.BYTE_COUNT:
+                # byte_count is sent unescaped and may legitimately be 0x7E/0x7D
+                self.raw.append(b)
+                self.byte_count = b
+                self.state = self.BODY if b else self.FCS_HI
+                continue
+
+            if state == self.BODY:
+                if b == frame_char:
+                    # Unescaped flag inside the body: truncated frame, resync on it
+                    self._start()
+                    continue
+                self.raw.append(b)
+                if self.escaped:
+                    self.escaped = False
+                    self.body_len += 1
+                elif b == escape_char:
+                    self.escaped = True
+                else:
+                    self.body_len += 1
+                if self.body_len >= self.byte_count:
+                    self.state = self.FCS_HI
+                continue
+
+            if state == self.FCS_HI:
+                self.raw.append(b)
+                self.state = self.FCS_LO
+                continue
+
+            if state == self.FCS_LO:
+                self.raw.append(b)
+                self.state = self.END
+                continue
+
+            # END
+            if b == frame_char:
+                self.raw.append(b)
+                frames.append(bytes(self.raw))
+                # The closing flag may double as the next frame's opening flag
+                self._start()
+            else:
+                # Length/flag mismatch: discard and hunt for the next frame
+                self.reset()
+
+        return frames
+
+    @staticmethod
+    def frame_has_eom(frame: bytes) -> bool:
+        """Return True if a raw frame from feed() carries the EOM flag."""
+        parsed = MCTPFramer.parse_frame(frame)
+        return bool(parsed and parsed.get("eom"))
@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+"""USB ports owned by one shard of a sharded deployment.
+
+A port is named by its leaf-most sysfs USB id, such as "3-5.4" (bus 3, hub
+port 5, port 4 behind it), as in the endpoint store and the runtime agent.
+A shard lists fnmatch patterns for the ports it owns: "1-*" is everything on
+bus 1, "3-5.*" the ports behind the hub on 3-5. With no patterns every port
+is owned, which is the unsharded setup.
+"""
+from fnmatch import fnmatchcase
+from typing import Optional
+
+
+class PortFilter:
+    """Decides whether a USB port id belongs to this shard."""
+
+    def __init__(self, patterns: Optional[str] = None):
+        self.patterns = [p.strip() for p in (patterns or '').split(',') if p.strip()]
+
+    def __bool__(self) -> bool:
+        """True if the filter restricts ports at all."""
+        return bool(self.patterns)
+
+    def __str__(self) -> str:
+        return ', '.join(self.patterns) or '*'
+
+    def owns(self, port_id: Optional[str]) -> bool:
+        if not self.patterns:
+            return True
+        return bool(port_id) and any(fnmatchcase(port_id, p) for p in self.patterns)
@@ -1,5 +1,6 @@
 from __future__ import annotations
 import re
+from functools import lru_cache
 from pathlib import Path
 from typing import Optional
 
@@ -11,6 +12,8 @@ def extract_schema_version(dst: Path, resource_name: Optional[str] = None) -> Op
     to find a Namespace entry for that resource (e.g. AutomationNode.v1_0_0) and return
     the matching version token. Otherwise it falls back to selecting the numerically
     largest v1_x_y token found in the file.
+
+    Results are cached per metadata file until it changes on disk.
     """
     meta_path = dst / 'redfish' / 'v1' / '$metadata' / 'index.xml'
     if not meta_path.exists():
@@ -19,7 +22,16 @@ def extract_schema_version(dst: Path, resource_name: Optional[str] = None) -> Op
         if not meta_path.exists():
             return None
     try:
-        text = meta_path.read_text()
+        st = meta_path.stat()
+    except OSError:
+        return None
+    return _schema_version(str(meta_path), st.st_mtime_ns, st.st_size, resource_name)
+
+
+@lru_cache(maxsize=256)
+def _schema_version(meta_path: str, mtime_ns: int, size: int, resource_name: Optional[str]) -> Optional[str]:
+    try:
+        text = Path(meta_path).read_text()
     except Exception:
         return None
     # If a specific resource is requested, try to find its Namespace include